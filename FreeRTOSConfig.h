@@ -0,0 +1,65 @@
+/**
+ * @file FreeRTOSConfig.h
+ * @brief FreeRTOS内核配置 (OS_RTOS_ENABLE 为1时使用, 见 os_port.c)
+ * @author Jason
+ * @date 2026-10-18
+ */
+
+#ifndef FREERTOS_CONFIG_H
+#define FREERTOS_CONFIG_H
+
+/* 汇编文件 (port的上下文切换) 也包含本文件, 只能有宏定义 */
+#if defined(__ICCARM__) || defined(__GNUC__)
+#include "at32f403a_407.h"
+extern void Error_Handler(void);
+#endif
+
+/* 调度 */
+#define configUSE_PREEMPTION                    1
+#define configUSE_PORT_OPTIMISED_TASK_SELECTION 1
+#define configCPU_CLOCK_HZ                      (system_core_clock)
+#define configTICK_RATE_HZ                      1000
+#define configMAX_PRIORITIES                    5
+#define configMINIMAL_STACK_SIZE                128
+#define configMAX_TASK_NAME_LEN                 8
+#define configUSE_16_BIT_TICKS                  0
+#define configIDLE_SHOULD_YIELD                 1
+
+/* 内核对象全部静态分配, 不使用堆 */
+#define configSUPPORT_STATIC_ALLOCATION         1
+#define configSUPPORT_DYNAMIC_ALLOCATION        0
+
+/* 功能 */
+#define configUSE_MUTEXES                       1
+#define configUSE_RECURSIVE_MUTEXES             1
+#define configUSE_TASK_NOTIFICATIONS            1
+#define configUSE_COUNTING_SEMAPHORES           0
+#define configUSE_TIMERS                        0
+#define configUSE_IDLE_HOOK                     0
+#define configUSE_TICK_HOOK                     0
+#define configCHECK_FOR_STACK_OVERFLOW          0
+#define configQUEUE_REGISTRY_SIZE               0
+
+#define INCLUDE_vTaskDelay                      1
+#define INCLUDE_uxTaskPriorityGet               1
+#define INCLUDE_xTaskGetSchedulerState          1
+#define INCLUDE_xTaskGetCurrentTaskHandle       1
+
+/*
+ * 中断优先级 (分组4, 4位抢占优先级): 内核和PendSV/SysTick在最低级15;
+ * 进入临界区时屏蔽4级及更低 (main.h 的 IRQ_PRIO_SYSTICK 之下), 这些中断可调用 FromISR 函数.
+ * RS485接收、控制引脚波形、RS485发送DMA、自动波特率 (0~3级) 不被内核屏蔽, 不能调用内核
+ */
+#define configPRIO_BITS                         4
+#define configLIBRARY_LOWEST_INTERRUPT_PRIORITY 15
+#define configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY 4
+#define configKERNEL_INTERRUPT_PRIORITY         (configLIBRARY_LOWEST_INTERRUPT_PRIORITY << (8 - configPRIO_BITS))
+#define configMAX_SYSCALL_INTERRUPT_PRIORITY    (configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY << (8 - configPRIO_BITS))
+
+#define configASSERT(x)                         do { if((x) == 0) { Error_Handler(); } } while(0)
+
+/* 内核的异常处理函数; SysTick_Handler 在 main.c 中, 经 os_tick 调用 xPortSysTickHandler */
+#define vPortSVCHandler                         SVC_Handler
+#define xPortPendSVHandler                      PendSV_Handler
+
+#endif /* FREERTOS_CONFIG_H */
@@ -0,0 +1,211 @@
+/**
+ * @file boot.c
+ * @brief 分阶段快速启动模块实现
+ * @author Jason
+ * @date 2026-10-18
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "boot.h"
+#include "main.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/**
+ * @brief  后台启动状态
+ */
+typedef enum
+{
+    BOOT_STATE_CLOCK = 0,       /*!< 等待HEXT/PLL */
+    BOOT_STATE_DISPLAY,         /*!< 等待显示板应答 */
+    BOOT_STATE_DONE
+} boot_state_t;
+
+/* Private define ------------------------------------------------------------*/
+#define BOOT_TIMELINE_HEADER_SIZE   4
+#define BOOT_TIMELINE_SIZE          (BOOT_TIMELINE_HEADER_SIZE + 4 * BOOT_STAGE_NUM)
+
+/* Private macro -------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+static uint32_t boot_stage_us[BOOT_STAGE_NUM];
+static uint8_t boot_flags = 0;
+static boot_state_t boot_state = BOOT_STATE_CLOCK;
+
+/* 时钟切换时把已计周期折算为us, 之后按新频率继续计 */
+static uint32_t boot_us_base = 0;
+static uint32_t boot_cycles_base = 0;
+
+/* Private function prototypes -----------------------------------------------*/
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief  启动计时初始化, 须在 dwt_init 之后尽早调用
+ * @param  None
+ * @retval None
+ */
+void boot_init(void)
+{
+    uint8_t i;
+
+    for(i = 0; i < BOOT_STAGE_NUM; i++)
+    {
+        boot_stage_us[i] = BOOT_STAGE_PENDING;
+    }
+
+    boot_flags = 0;
+    boot_state = BOOT_STATE_CLOCK;
+    boot_us_base = 0;
+    boot_cycles_base = DWT->CYCCNT;
+
+    boot_mark(BOOT_STAGE_MAIN);
+}
+
+/**
+ * @brief  系统时钟切换前折算已用时间, 由时钟切换代码调用
+ * @param  None
+ * @retval None
+ */
+void boot_clock_rebase(void)
+{
+    uint32_t now = DWT->CYCCNT;
+
+    boot_us_base += (now - boot_cycles_base) / (system_core_clock / 1000000);
+    boot_cycles_base = now;
+}
+
+/**
+ * @brief  获取自进入main以来的时间
+ * @param  None
+ * @retval 时间 (us)
+ */
+uint32_t boot_elapsed_us(void)
+{
+    return boot_us_base + (DWT->CYCCNT - boot_cycles_base) / (system_core_clock / 1000000);
+}
+
+/**
+ * @brief  记录启动阶段时间戳 (每个阶段只记录第一次)
+ * @param  stage: 启动阶段
+ * @retval None
+ */
+void boot_mark(boot_stage_t stage)
+{
+    if((stage < BOOT_STAGE_NUM) && (boot_stage_us[stage] == BOOT_STAGE_PENDING))
+    {
+        boot_stage_us[stage] = boot_elapsed_us();
+    }
+}
+
+/**
+ * @brief  设置启动标志
+ * @param  flag: BOOT_FLAG_xxx
+ * @retval None
+ */
+void boot_set_flag(uint8_t flag)
+{
+    boot_flags |= flag;
+}
+
+/**
+ * @brief  获取启动阶段时间戳
+ * @param  stage: 启动阶段
+ * @retval 时间 (us), 未到达时返回 BOOT_STAGE_PENDING
+ */
+uint32_t boot_get_stage_us(boot_stage_t stage)
+{
+    if(stage >= BOOT_STAGE_NUM)
+    {
+        return BOOT_STAGE_PENDING;
+    }
+
+    return boot_stage_us[stage];
+}
+
+/**
+ * @brief  后台启动任务: 切换PLL、重新配置外设、初始化蜂鸣器和显示板
+ * @note   每步都不阻塞, 在主循环中与RS485命令处理交替调用
+ * @param  None
+ * @retval None
+ */
+void boot_poll(void)
+{
+    switch(boot_state)
+    {
+        case BOOT_STATE_CLOCK:
+            if(system_clock_poll() != SYSTEM_CLOCK_PLL)
+            {
+                return;
+            }
+
+            /* RS485已通过时钟切换通知按新APB1时钟重算分频值 */
+            boot_mark(BOOT_STAGE_PLL_READY);
+
+            /* Flash等待周期在240MHz下最多, 此时对比两种向量表的中断延迟 */
+            memmap_latency_measure();
+
+            /* 蜂鸣器、控制引脚波形和I2C的分频都由当前时钟计算, 放到PLL之后初始化 */
+            buzzer_pwm_init();
+            ctrl_seq_init();
+            boot_mark(BOOT_STAGE_BUZZER_READY);
+
+            i2c_display_init();
+            boot_state = BOOT_STATE_DISPLAY;
+            break;
+
+        case BOOT_STATE_DISPLAY:
+            switch(i2c_display_ready_poll())
+            {
+                case I2C_DISPLAY_STATE_READY:
+                    break;
+
+                case I2C_DISPLAY_STATE_ABSENT:
+                    boot_set_flag(BOOT_FLAG_DISPLAY_ABSENT);
+                    break;
+
+                default:
+                    return;
+            }
+
+            boot_mark(BOOT_STAGE_DISPLAY_READY);
+            boot_state = BOOT_STATE_DONE;
+            watchdog_unregister(WATCHDOG_TASK_BOOT);
+            break;
+
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief  后台启动是否全部完成
+ * @param  None
+ * @retval 1: 完成, 0: 进行中
+ */
+uint8_t boot_is_done(void)
+{
+    return (boot_state == BOOT_STATE_DONE) ? 1 : 0;
+}
+
+/**
+ * @brief  通过RS485发送启动时间线 (单帧)
+ * @note   帧格式: 命令字, 版本, 阶段数, 标志, 各阶段时间 (u32 LE, us)
+ * @param  None
+ * @retval None
+ */
+void boot_send_timeline(void)
+{
+    uint8_t frame[BOOT_TIMELINE_SIZE];
+    uint8_t* p = &frame[BOOT_TIMELINE_HEADER_SIZE];
+    uint8_t i;
+
+    frame[0] = RS485_CMD_BOOT_TIMELINE;
+    frame[1] = BOOT_TIMELINE_VERSION;
+    frame[2] = BOOT_STAGE_NUM;
+    frame[3] = boot_flags;
+
+    for(i = 0; i < BOOT_STAGE_NUM; i++, p += 4)
+    {
+        rs485_put_u32(p, boot_stage_us[i]);
+    }
+
+    rs485_frame_send(frame, sizeof(frame));
+}
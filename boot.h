@@ -0,0 +1,116 @@
+/**
+ * @file boot.h
+ * @brief 分阶段快速启动模块头文件
+ * @author Jason
+ * @date 2026-10-18
+ */
+
+#ifndef __BOOT_H
+#define __BOOT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "at32f403a_407.h"
+
+/* Exported types ------------------------------------------------------------*/
+/**
+ * @brief  启动阶段 (时间线按此顺序上报)
+ */
+typedef enum
+{
+    BOOT_STAGE_MAIN = 0,            /*!< 进入main */
+    BOOT_STAGE_CLOCK_HICK,          /*!< 以HICK运行, HEXT开始起振 */
+    BOOT_STAGE_RS485_READY,         /*!< RS485可接收命令 */
+    BOOT_STAGE_FIRST_RESPONSE,      /*!< 发出第一个命令回复 */
+    BOOT_STAGE_PLL_START,           /*!< HEXT稳定 (或超时回退HICK), PLL开始锁定 */
+    BOOT_STAGE_PLL_READY,           /*!< 切换到PLL, 外设已按新时钟重新配置 */
+    BOOT_STAGE_BUZZER_READY,        /*!< 蜂鸣器初始化完成 */
+    BOOT_STAGE_DISPLAY_READY,       /*!< 显示板应答 (或等待超时) */
+    BOOT_STAGE_NUM
+} boot_stage_t;
+
+/* Exported constants --------------------------------------------------------*/
+/* 时间线帧格式版本 */
+#define BOOT_TIMELINE_VERSION       1
+
+/* 阶段未到达时上报的时间 */
+#define BOOT_STAGE_PENDING          0xFFFFFFFF
+
+/* 启动标志 (时间线帧中上报) */
+#define BOOT_FLAG_HEXT_FAILED       0x01    /*!< HEXT起振超时, PLL使用HICK */
+#define BOOT_FLAG_DISPLAY_ABSENT    0x02    /*!< 显示板在超时内无应答 */
+
+/* Exported macro ------------------------------------------------------------*/
+/* Exported functions prototypes ---------------------------------------------*/
+
+/**
+ * @brief  启动计时初始化, 须在 dwt_init 之后尽早调用
+ * @param  None
+ * @retval None
+ */
+void boot_init(void);
+
+/**
+ * @brief  记录启动阶段时间戳 (每个阶段只记录第一次)
+ * @param  stage: 启动阶段
+ * @retval None
+ */
+void boot_mark(boot_stage_t stage);
+
+/**
+ * @brief  设置启动标志
+ * @param  flag: BOOT_FLAG_xxx
+ * @retval None
+ */
+void boot_set_flag(uint8_t flag);
+
+/**
+ * @brief  系统时钟切换前折算已用时间, 由时钟切换代码调用
+ * @param  None
+ * @retval None
+ */
+void boot_clock_rebase(void);
+
+/**
+ * @brief  获取自进入main以来的时间
+ * @param  None
+ * @retval 时间 (us)
+ */
+uint32_t boot_elapsed_us(void);
+
+/**
+ * @brief  获取启动阶段时间戳
+ * @param  stage: 启动阶段
+ * @retval 时间 (us), 未到达时返回 BOOT_STAGE_PENDING
+ */
+uint32_t boot_get_stage_us(boot_stage_t stage);
+
+/**
+ * @brief  后台启动任务: 切换PLL、重新配置外设、初始化蜂鸣器和显示板
+ * @param  None
+ * @retval None
+ */
+void boot_poll(void);
+
+/**
+ * @brief  后台启动是否全部完成
+ * @param  None
+ * @retval 1: 完成, 0: 进行中
+ */
+uint8_t boot_is_done(void);
+
+/**
+ * @brief  通过RS485发送启动时间线 (单帧)
+ * @param  None
+ * @retval None
+ */
+void boot_send_timeline(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BOOT_H */
@@ -0,0 +1,187 @@
+/**
+ * @file bootloader.c
+ * @brief bootloader: 安装暂存区中已提交的新固件, 跳转到应用程序
+ * @author Jason
+ * @date 2026-10-18
+ *
+ * 位于Flash开头16KB, 以HICK运行, 不使用中断. 状态扇区中有提交标记且暂存区CRC正确时,
+ * 逐扇区把暂存区复制到应用区, 校验应用区CRC后才擦除状态扇区. 复制中途掉电或复位,
+ * 下次启动时提交标记仍在, 重新复制; 所以每次启动后应用区要么是旧固件, 要么是
+ * 完整校验过的新固件.
+ *
+ * 应用程序以软件启动的看门狗在复位后停止, 有待安装的固件时bootloader重新启动看门狗:
+ * 安装或擦除状态扇区失败后停在死循环中, 由看门狗复位重试, 不需要重新上电.
+ *
+ * 编译时包含上级目录 (flash_if.c 与应用程序共用), 使用 AT32F403AxC_BOOT.ld 链接.
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "flash_if.h"
+#include "fw_update.h"
+#include "watchdog.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private define ------------------------------------------------------------*/
+#define BOOTLOADER_INSTALL_RETRIES  3
+
+/* Private macro -------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+/* Private function prototypes -----------------------------------------------*/
+static uint8_t bootloader_install_pending(void);
+static void bootloader_wdt_start(void);
+static error_status bootloader_install(uint32_t size, uint32_t crc32);
+static uint8_t bootloader_app_valid(void);
+static void bootloader_jump(void);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief  检查是否有已提交待安装的固件
+ * @param  None
+ * @retval 1: 有, 0: 无
+ */
+static uint8_t bootloader_install_pending(void)
+{
+    const fw_session_t* session = FW_STATE_SESSION;
+
+    return ((session->magic == FW_SESSION_MAGIC) && (session->check == FW_SESSION_CHECK(session)) &&
+            (session->size != 0) && ((session->size & 3) == 0) &&
+            (session->size <= FLASH_IF_APP_SIZE) && (FW_STATE_COMMIT == FW_COMMIT_MAGIC)) ? 1 : 0;
+}
+
+/**
+ * @brief  启动看门狗 (与应用程序相同的超时, 约1s)
+ * @note   应用程序的 watchdog_init 重新设置同样的分频和重载值
+ * @param  None
+ * @retval None
+ */
+static void bootloader_wdt_start(void)
+{
+    debug_periph_mode_set(DEBUG_WDT_PAUSE, TRUE);
+
+    wdt_register_write_enable(TRUE);
+    wdt_divider_set(WATCHDOG_WDT_DIVIDER);
+    wdt_reload_value_set(WATCHDOG_WDT_RELOAD);
+    wdt_counter_reload();
+    wdt_enable();
+}
+
+/**
+ * @brief  把暂存区复制到应用区并校验
+ * @note   调用前须 flash_unlock 并启动看门狗, 每个扇区喂一次
+ * @param  size: 映像大小
+ * @param  crc32: 映像CRC
+ * @retval SUCCESS/ERROR
+ */
+static error_status bootloader_install(uint32_t size, uint32_t crc32)
+{
+    uint32_t offset;
+    uint32_t len;
+
+    for(offset = 0; offset < size; offset += FLASH_IF_SECTOR_SIZE)
+    {
+        wdt_counter_reload();
+
+        len = size - offset;
+        if(len > FLASH_IF_SECTOR_SIZE)
+        {
+            len = FLASH_IF_SECTOR_SIZE;
+        }
+
+        if((flash_if_erase(FLASH_IF_APP_BASE + offset) != SUCCESS) ||
+           (flash_if_program(FLASH_IF_APP_BASE + offset,
+                             (const uint8_t*)(FLASH_IF_STAGING_BASE + offset), len) != SUCCESS))
+        {
+            return ERROR;
+        }
+    }
+
+    wdt_counter_reload();
+
+    return (flash_if_crc32((const uint8_t*)FLASH_IF_APP_BASE, size) == crc32) ? SUCCESS : ERROR;
+}
+
+/**
+ * @brief  检查应用区的向量表
+ * @param  None
+ * @retval 1: 栈顶在SRAM内且复位向量在应用区内, 0: 否
+ */
+static uint8_t bootloader_app_valid(void)
+{
+    uint32_t sp = FLASH_IF_WORD(FLASH_IF_APP_BASE);
+    uint32_t entry = FLASH_IF_WORD(FLASH_IF_APP_BASE + 4);
+
+    return ((sp > FLASH_IF_SRAM_BASE) && (sp <= FLASH_IF_SRAM_BASE + FLASH_IF_SRAM_SIZE) &&
+            (entry & 1) && (entry > FLASH_IF_APP_BASE) &&
+            (entry < FLASH_IF_APP_BASE + FLASH_IF_APP_SIZE)) ? 1 : 0;
+}
+
+/**
+ * @brief  跳转到应用程序 (不返回)
+ * @param  None
+ * @retval None
+ */
+static void bootloader_jump(void)
+{
+    uint32_t sp = FLASH_IF_WORD(FLASH_IF_APP_BASE);
+    void (*entry)(void) = (void (*)(void))FLASH_IF_WORD(FLASH_IF_APP_BASE + 4);
+
+    crm_periph_clock_enable(CRM_CRC_PERIPH_CLOCK, FALSE);
+
+    SCB->VTOR = FLASH_IF_APP_BASE;
+    __DSB();
+    __set_MSP(sp);
+    entry();
+}
+
+/**
+ * @brief  bootloader入口
+ * @param  None
+ * @retval int
+ */
+int main(void)
+{
+    const fw_session_t* session = FW_STATE_SESSION;
+    error_status status = SUCCESS;
+    uint8_t retry;
+
+    if(bootloader_install_pending())
+    {
+        bootloader_wdt_start();
+        flash_unlock();
+
+        if(flash_if_crc32((const uint8_t*)FLASH_IF_STAGING_BASE, session->size) == session->crc32)
+        {
+            for(retry = 0; retry < BOOTLOADER_INSTALL_RETRIES; retry++)
+            {
+                status = bootloader_install(session->size, session->crc32);
+                if(status == SUCCESS)
+                {
+                    break;
+                }
+            }
+        }
+
+        /* 安装成功, 或暂存区已损坏 (放弃这次更新, 应用区未改动, 保留旧固件) 时清除提交标记;
+           擦除失败则提交标记仍在, 不跳转, 看门狗复位后重新执行这一步 */
+        if(status == SUCCESS)
+        {
+            wdt_counter_reload();
+            status = flash_if_erase(FLASH_IF_STATE_BASE);
+        }
+
+        flash_lock();
+    }
+
+    /* 安装失败时应用区只写了一部分, 不能运行 */
+    if((status == SUCCESS) && bootloader_app_valid())
+    {
+        bootloader_jump();
+    }
+
+    /* 安装失败: 提交标记仍在, 看门狗已由本程序启动, 约1s后复位重试.
+       没有待安装的固件且应用区无效 (未烧录应用程序) 时看门狗未启动, 停在这里 */
+    while(1)
+    {
+    }
+}
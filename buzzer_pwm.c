@@ -11,14 +11,105 @@
 
 /* Private typedef -----------------------------------------------------------*/
 /* Private define ------------------------------------------------------------*/
+#define BUZZER_COUNT_FREQ   1000000     // 定时器计数频率 1MHz
+
 /* Private macro -------------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
 static uint32_t buzzer_freq = 0;
 static uint8_t buzzer_duty = 50;
 
+/* 音量和报警音 (启动时从配置存储加载) */
+static uint8_t buzzer_volume = BUZZER_VOLUME_DEFAULT;
+static uint32_t buzzer_alarm_low = ALARM_FREQ_LOW;
+static uint32_t buzzer_alarm_high = ALARM_FREQ_HIGH;
+static uint16_t buzzer_alarm_period = ALARM_PERIOD_MS;
+
+/* 非阻塞鸣叫/报警 (buzzer_poll 推进): 报警每个循环4步 (低音、停、高音、停) */
+static uint8_t buzzer_timed = 0;
+static uint32_t buzzer_next_tick = 0;
+static uint16_t buzzer_alarm_steps = 0;
+
+/* 上面的状态和定时器比较值由此锁保护 (FreeRTOS下多个任务使用蜂鸣器, 裸机为空操作) */
+static os_mutex_t buzzer_mutex;
+
 /* Private function prototypes -----------------------------------------------*/
+static uint32_t buzzer_tmr_div(void);
+static error_status buzzer_clock_notify(clock_event_t event, clock_profile_t profile);
+static void buzzer_config_load(void);
+
 /* Private functions ---------------------------------------------------------*/
 
+/**
+ * @brief  按当前时钟计算1MHz计数所需的预分频值
+ * @note   APB1分频不为1时, 定时器时钟为APB1的2倍
+ * @param  None
+ * @retval 预分频寄存器值
+ */
+static uint32_t buzzer_tmr_div(void)
+{
+    crm_clocks_freq_type clocks;
+    uint32_t tmr_clk;
+    
+    crm_clocks_freq_get(&clocks);
+    
+    tmr_clk = clocks.apb1_freq;
+    if(clocks.apb1_freq != clocks.ahb_freq)
+    {
+        tmr_clk *= 2;
+    }
+    
+    return tmr_clk / BUZZER_COUNT_FREQ - 1;
+}
+
+/**
+ * @brief  系统时钟切换通知
+ * @note   只改预分频值, 在下一个更新事件生效, 不打断当前PWM周期
+ * @param  event: 通知事件
+ * @param  profile: 目标档位
+ * @retval SUCCESS
+ */
+static error_status buzzer_clock_notify(clock_event_t event, clock_profile_t profile)
+{
+    if(event == CLOCK_EVENT_POST_CHANGE)
+    {
+        tmr_div_value_set(BUZZER_TMR, buzzer_tmr_div());
+    }
+    
+    return SUCCESS;
+}
+
+/**
+ * @brief  从配置存储加载音量和报警音, 未保存或无效时使用默认值
+ * @param  None
+ * @retval None
+ */
+static void buzzer_config_load(void)
+{
+    uint8_t volume;
+    uint32_t freq;
+    uint16_t period;
+    
+    if((config_get(CONFIG_KEY_BUZZER_VOLUME, &volume, sizeof(volume)) == SUCCESS) && (volume <= 100))
+    {
+        buzzer_volume = volume;
+    }
+    
+    if((config_get(CONFIG_KEY_ALARM_FREQ_LOW, &freq, sizeof(freq)) == SUCCESS) && (freq != 0))
+    {
+        buzzer_alarm_low = freq;
+    }
+    
+    if((config_get(CONFIG_KEY_ALARM_FREQ_HIGH, &freq, sizeof(freq)) == SUCCESS) && (freq != 0))
+    {
+        buzzer_alarm_high = freq;
+    }
+    
+    if((config_get(CONFIG_KEY_ALARM_PERIOD, &period, sizeof(period)) == SUCCESS) && (period != 0))
+    {
+        buzzer_alarm_period = period;
+    }
+}
+
 /**
  * @brief  蜂鸣器PWM初始化
  * @param  None
@@ -29,6 +120,8 @@ void buzzer_pwm_init(void)
     tmr_output_config_type tmr_output_struct;
     tmr_base_init_type tmr_base_struct;
     
+    os_mutex_init(&buzzer_mutex);
+    
     /* 使能定时器时钟 */
     crm_periph_clock_enable(BUZZER_TMR_CLK, TRUE);
     
@@ -38,7 +131,7 @@ void buzzer_pwm_init(void)
     tmr_base_struct.tmr_count_direction = TMR_COUNT_UP;
     tmr_base_struct.tmr_period = BUZZER_TMR_PERIOD - 1;
     tmr_base_struct.tmr_repetition_counter = 0;
-    tmr_base_struct.tmr_div = (system_core_clock / 2 / 1000000) - 1; // 1MHz计数频率
+    tmr_base_struct.tmr_div = buzzer_tmr_div(); // 1MHz计数频率
     tmr_base_init(BUZZER_TMR, &tmr_base_struct);
     
     /* PWM输出配置 */
@@ -63,6 +156,11 @@ void buzzer_pwm_init(void)
     
     /* 初始化完成，蜂鸣器关闭 */
     buzzer_stop();
+    
+    /* 时钟切换后重算预分频 */
+    clock_profile_register(buzzer_clock_notify);
+    
+    buzzer_config_load();
 }
 
 /**
@@ -80,8 +178,10 @@ void buzzer_set_frequency(uint32_t freq)
         return;
     }
     
+    os_mutex_lock(&buzzer_mutex);
+    
     /* 计算周期值 */
-    period = 1000000 / freq; // 1MHz计数频率
+    period = BUZZER_COUNT_FREQ / freq; // 1MHz计数频率
     
     if(period > 65535)
     {
@@ -99,6 +199,10 @@ void buzzer_set_frequency(uint32_t freq)
     buzzer_set_duty(buzzer_duty);
     
     buzzer_freq = freq;
+    
+    TRACE(TRACE_EVT_BUZZER_NOTE, freq);
+    
+    os_mutex_unlock(&buzzer_mutex);
 }
 
 /**
@@ -115,6 +219,8 @@ void buzzer_set_duty(uint8_t duty)
         duty = 100;
     }
     
+    os_mutex_lock(&buzzer_mutex);
+    
     buzzer_duty = duty;
     
     /* 计算脉冲值 */
@@ -122,6 +228,8 @@ void buzzer_set_duty(uint8_t duty)
     
     /* 设置比较值 */
     tmr_channel_value_set(BUZZER_TMR, BUZZER_TMR_CHANNEL, pulse_value);
+    
+    os_mutex_unlock(&buzzer_mutex);
 }
 
 /**
@@ -131,8 +239,10 @@ void buzzer_set_duty(uint8_t duty)
  */
 void buzzer_start(uint32_t freq)
 {
+    os_mutex_lock(&buzzer_mutex);
     buzzer_set_frequency(freq);
-    buzzer_set_duty(50); // 50%占空比
+    buzzer_set_duty(buzzer_volume); // 占空比即音量
+    os_mutex_unlock(&buzzer_mutex);
 }
 
 /**
@@ -142,8 +252,12 @@ void buzzer_start(uint32_t freq)
  */
 void buzzer_stop(void)
 {
+    os_mutex_lock(&buzzer_mutex);
     tmr_channel_value_set(BUZZER_TMR, BUZZER_TMR_CHANNEL, 0);
     buzzer_freq = 0;
+    
+    TRACE(TRACE_EVT_BUZZER_NOTE, 0);
+    os_mutex_unlock(&buzzer_mutex);
 }
 
 /**
@@ -154,9 +268,11 @@ void buzzer_stop(void)
  */
 void buzzer_beep(uint32_t freq, uint32_t duration)
 {
+    os_mutex_lock(&buzzer_mutex);
     buzzer_start(freq);
     delay_ms(duration);
     buzzer_stop();
+    os_mutex_unlock(&buzzer_mutex);
 }
 
 /**
@@ -188,8 +304,12 @@ uint8_t buzzer_get_duty(void)
  */
 void buzzer_play_melody(const uint32_t* note, const uint32_t* duration, uint8_t count)
 {
+    os_mutex_lock(&buzzer_mutex);
+    
     for(uint8_t i = 0; i < count; i++)
     {
+        METRIC_GAUGE_SET(METRIC_GAUGE_MELODY_LEFT, count - i);
+        
         if(note[i] == 0)
         {
             buzzer_stop();
@@ -202,7 +322,11 @@ void buzzer_play_melody(const uint32_t* note, const uint32_t* duration, uint8_t
         delay_ms(duration[i]);
     }
     
+    METRIC_GAUGE_SET(METRIC_GAUGE_MELODY_LEFT, 0);
+    
     buzzer_stop();
+    
+    os_mutex_unlock(&buzzer_mutex);
 }
 
 /**
@@ -212,11 +336,113 @@ void buzzer_play_melody(const uint32_t* note, const uint32_t* duration, uint8_t
  */
 void buzzer_alarm(uint8_t cycles)
 {
+    os_mutex_lock(&buzzer_mutex);
+    
     for(uint8_t i = 0; i < cycles; i++)
     {
-        buzzer_beep(1000, 200); // 1000Hz, 200ms
-        delay_ms(200);
-        buzzer_beep(1500, 200); // 1500Hz, 200ms
-        delay_ms(200);
+        buzzer_beep(buzzer_alarm_low, buzzer_alarm_period);
+        delay_ms(buzzer_alarm_period);
+        buzzer_beep(buzzer_alarm_high, buzzer_alarm_period);
+        delay_ms(buzzer_alarm_period);
+    }
+    
+    os_mutex_unlock(&buzzer_mutex);
+}
+
+/**
+ * @brief  非阻塞鸣叫
+ * @note   立即返回, 到时由 buzzer_poll 停止; 取消进行中的鸣叫或报警
+ * @param  freq: 频率 (Hz), 0为停止
+ * @param  duration: 持续时间 (ms), 0为一直鸣叫
+ * @retval None
+ */
+void buzzer_beep_start(uint32_t freq, uint32_t duration)
+{
+    os_mutex_lock(&buzzer_mutex);
+    
+    buzzer_alarm_steps = 0;
+    buzzer_timed = 0;
+    
+    if(freq == 0)
+    {
+        buzzer_stop();
+    }
+    else
+    {
+        buzzer_start(freq);
+        
+        if(duration != 0)
+        {
+            buzzer_next_tick = get_tick() + duration;
+            buzzer_timed = 1;
+        }
     }
+    
+    os_mutex_unlock(&buzzer_mutex);
+}
+
+/**
+ * @brief  非阻塞报警音
+ * @note   与 buzzer_alarm 音效相同, 由 buzzer_poll 切换高低音
+ * @param  cycles: 报警循环次数
+ * @retval None
+ */
+void buzzer_alarm_start(uint8_t cycles)
+{
+    os_mutex_lock(&buzzer_mutex);
+    
+    buzzer_alarm_steps = (uint16_t)cycles * 4;
+    buzzer_next_tick = get_tick();
+    buzzer_timed = (cycles != 0) ? 1 : 0;
+    
+    if(cycles == 0)
+    {
+        buzzer_stop();
+    }
+    
+    os_mutex_unlock(&buzzer_mutex);
+}
+
+/**
+ * @brief  推进非阻塞鸣叫和报警, 在主循环中调用
+ * @param  None
+ * @retval None
+ */
+void buzzer_poll(void)
+{
+    os_mutex_lock(&buzzer_mutex);
+    
+    if(!buzzer_timed || ((int32_t)(get_tick() - buzzer_next_tick) < 0))
+    {
+        os_mutex_unlock(&buzzer_mutex);
+        return;
+    }
+    
+    if(buzzer_alarm_steps == 0)
+    {
+        buzzer_stop();
+        buzzer_timed = 0;
+        os_mutex_unlock(&buzzer_mutex);
+        return;
+    }
+    
+    switch(buzzer_alarm_steps & 3)
+    {
+        case 0:
+            buzzer_start(buzzer_alarm_low);
+            break;
+            
+        case 2:
+            buzzer_start(buzzer_alarm_high);
+            break;
+            
+        default:
+            buzzer_stop();
+            break;
+    }
+    
+    buzzer_alarm_steps--;
+    buzzer_next_tick += buzzer_alarm_period;
+    
+    os_mutex_unlock(&buzzer_mutex);
 }
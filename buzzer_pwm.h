@@ -31,9 +31,13 @@ extern "C" {
 /* 预定义的报警频率 */
 #define ALARM_FREQ_LOW      800
 #define ALARM_FREQ_HIGH     1200
+#define ALARM_PERIOD_MS     200     // 报警每个音的时长 (ms)
 #define BEEP_FREQ_NORMAL    1000
 #define BEEP_FREQ_HIGH      2000
 
+/* 默认音量 (占空比 0-100); 音量和报警音可由配置存储覆盖 */
+#define BUZZER_VOLUME_DEFAULT   50
+
 /* Exported macro ------------------------------------------------------------*/
 /* Exported functions prototypes ---------------------------------------------*/
 
@@ -110,6 +114,28 @@ void buzzer_play_melody(const uint32_t* note, const uint32_t* duration, uint8_t
  */
 void buzzer_alarm(uint8_t cycles);
 
+/**
+ * @brief  非阻塞鸣叫, 到时由 buzzer_poll 停止
+ * @param  freq: 频率 (Hz), 0为停止
+ * @param  duration: 持续时间 (ms), 0为一直鸣叫
+ * @retval None
+ */
+void buzzer_beep_start(uint32_t freq, uint32_t duration);
+
+/**
+ * @brief  非阻塞报警音, 由 buzzer_poll 推进
+ * @param  cycles: 报警循环次数, 0为停止
+ * @retval None
+ */
+void buzzer_alarm_start(uint8_t cycles);
+
+/**
+ * @brief  推进非阻塞鸣叫和报警, 在主循环中调用
+ * @param  None
+ * @retval None
+ */
+void buzzer_poll(void);
+
 #ifdef __cplusplus
 }
 #endif
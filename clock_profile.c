@@ -0,0 +1,258 @@
+/**
+ * @file clock_profile.c
+ * @brief 运行时时钟档位切换模块实现
+ * @author Jason
+ * @date 2026-10-18
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "clock_profile.h"
+#include "main.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/**
+ * @brief  档位参数
+ */
+typedef struct
+{
+    uint32_t sclk_hz;                   /*!< 系统时钟 */
+    uint32_t apb1_hz;                   /*!< APB1时钟 */
+    crm_pll_mult_type mult_hext;        /*!< PLL源为HEXT (8MHz) 时的倍频 */
+    crm_pll_mult_type mult_hick;        /*!< PLL源为HICK/2 (4MHz) 时的倍频 */
+    crm_apb1_div_type apb1_div;         /*!< APB1最高120MHz */
+    crm_apb2_div_type apb2_div;         /*!< APB2最高120MHz */
+    flash_latency_type latency;         /*!< 每32MHz一个等待周期 */
+} clock_profile_config_t;
+
+/* Private define ------------------------------------------------------------*/
+/* Private macro -------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+static const clock_profile_config_t clock_profile_table[CLOCK_PROFILE_NUM] =
+{
+    { 240000000, 120000000, CRM_PLL_MULT_30, CRM_PLL_MULT_60, CRM_APB1_DIV_2, CRM_APB2_DIV_2, FLASH_LATENCY_7 },
+    { 120000000, 120000000, CRM_PLL_MULT_15, CRM_PLL_MULT_30, CRM_APB1_DIV_1, CRM_APB2_DIV_1, FLASH_LATENCY_3 },
+    {  48000000,  48000000, CRM_PLL_MULT_6,  CRM_PLL_MULT_12, CRM_APB1_DIV_1, CRM_APB2_DIV_1, FLASH_LATENCY_1 }
+};
+
+static clock_notifier_t clock_notifiers[CLOCK_NOTIFIER_MAX];
+static uint8_t clock_notifier_count = 0;
+
+static crm_pll_clock_source_type clock_pll_source = CRM_PLL_SOURCE_HEXT;
+static clock_profile_t clock_profile_current = CLOCK_PROFILE_NONE;
+
+/* 自动降频 */
+__IO uint8_t clock_profile_activity_flag = 0;
+static uint8_t clock_profile_auto_enable = 0;
+static uint32_t clock_profile_active_tick = 0;
+
+/* Private function prototypes -----------------------------------------------*/
+static error_status clock_profile_notify(clock_event_t event, clock_profile_t profile);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief  通知所有已注册的驱动
+ * @param  event: 通知事件
+ * @param  profile: 目标档位
+ * @retval SUCCESS/ERROR (PRE_CHANGE 时任一回调否决)
+ */
+static error_status clock_profile_notify(clock_event_t event, clock_profile_t profile)
+{
+    error_status status = SUCCESS;
+    uint8_t i;
+
+    for(i = 0; i < clock_notifier_count; i++)
+    {
+        if(clock_notifiers[i](event, profile) != SUCCESS)
+        {
+            status = ERROR;
+            if(event == CLOCK_EVENT_PRE_CHANGE)
+            {
+                break;
+            }
+        }
+    }
+
+    return status;
+}
+
+/**
+ * @brief  设置PLL时钟源 (HEXT稳定或超时后调用一次)
+ * @param  source: CRM_PLL_SOURCE_HEXT 或 CRM_PLL_SOURCE_HICK
+ * @retval None
+ */
+void clock_profile_init(crm_pll_clock_source_type source)
+{
+    clock_pll_source = source;
+    clock_profile_current = CLOCK_PROFILE_NONE;
+    clock_profile_active_tick = get_tick();
+}
+
+/**
+ * @brief  注册时钟切换通知回调 (重复注册同一回调无副作用)
+ * @param  notifier: 回调函数
+ * @retval SUCCESS/ERROR (回调表已满)
+ */
+error_status clock_profile_register(clock_notifier_t notifier)
+{
+    uint8_t i;
+
+    for(i = 0; i < clock_notifier_count; i++)
+    {
+        if(clock_notifiers[i] == notifier)
+        {
+            return SUCCESS;
+        }
+    }
+
+    if(clock_notifier_count >= CLOCK_NOTIFIER_MAX)
+    {
+        return ERROR;
+    }
+
+    clock_notifiers[clock_notifier_count++] = notifier;
+
+    return SUCCESS;
+}
+
+/**
+ * @brief  切换时钟档位
+ * @note   先通知 CLOCK_EVENT_PRE_CHANGE, 任一回调否决则不切换; 全部通过后通知 CLOCK_EVENT_CHANGE_BEGIN.
+ *         切换期间 (PLL重新锁定) 系统以HICK运行, 外设分频值与时钟不符, 直到 CLOCK_EVENT_POST_CHANGE
+ * @param  profile: 目标档位
+ * @retval SUCCESS: 已切换, ERROR: 被否决或参数无效
+ */
+error_status clock_profile_set(clock_profile_t profile)
+{
+    const clock_profile_config_t* config;
+    uint32_t old_mhz = system_core_clock / 1000000;
+
+    if(profile >= CLOCK_PROFILE_NUM)
+    {
+        return ERROR;
+    }
+
+    if(profile == clock_profile_current)
+    {
+        return SUCCESS;
+    }
+
+    if(clock_profile_notify(CLOCK_EVENT_PRE_CHANGE, profile) != SUCCESS)
+    {
+        return ERROR;
+    }
+
+    clock_profile_notify(CLOCK_EVENT_CHANGE_BEGIN, profile);
+
+    config = &clock_profile_table[profile];
+
+    boot_clock_rebase();
+
+    /* 先切到HICK, 才能关闭PLL修改倍频 */
+    crm_sysclk_switch(CRM_SCLK_HICK);
+    while(crm_sysclk_switch_status_get() != CRM_SCLK_HICK);
+
+    crm_clock_source_enable(CRM_CLOCK_SOURCE_PLL, FALSE);
+    crm_pll_config(clock_pll_source, (clock_pll_source == CRM_PLL_SOURCE_HEXT) ?
+                   config->mult_hext : config->mult_hick);
+    crm_apb1_div_set(config->apb1_div);
+    crm_apb2_div_set(config->apb2_div);
+
+    crm_clock_source_enable(CRM_CLOCK_SOURCE_PLL, TRUE);
+    while(crm_flag_get(CRM_PLL_STABLE_FLAG) != SET);
+
+    /* HICK是最低频率, 此时设置等待周期对升频和降频都安全 */
+    flash_latency_set(config->latency);
+
+    crm_sysclk_switch(CRM_SCLK_PLL);
+    while(crm_sysclk_switch_status_get() != CRM_SCLK_PLL);
+
+    /* 更新系统时钟, SysTick按新时钟重新配置 */
+    system_core_clock_update();
+    delay_init();
+
+    clock_profile_current = profile;
+    TRACE(TRACE_EVT_CLOCK_CHANGE, (old_mhz << 8) | (system_core_clock / 1000000));
+
+    clock_profile_notify(CLOCK_EVENT_POST_CHANGE, profile);
+
+    return SUCCESS;
+}
+
+/**
+ * @brief  获取档位的APB1时钟频率 (供驱动在切换前检查分频范围)
+ * @param  profile: 档位
+ * @retval APB1频率 (Hz), 档位无效时返回0
+ */
+uint32_t clock_profile_apb1_freq(clock_profile_t profile)
+{
+    if(profile >= CLOCK_PROFILE_NUM)
+    {
+        return 0;
+    }
+
+    return clock_profile_table[profile].apb1_hz;
+}
+
+/**
+ * @brief  获取当前时钟档位
+ * @param  None
+ * @retval 当前档位
+ */
+clock_profile_t clock_profile_get(void)
+{
+    return clock_profile_current;
+}
+
+/**
+ * @brief  使能/关闭空闲自动降频
+ * @param  enable: 1使能, 0关闭
+ * @retval None
+ */
+void clock_profile_auto(uint8_t enable)
+{
+    clock_profile_auto_enable = enable ? 1 : 0;
+    clock_profile_active_tick = get_tick();
+}
+
+/**
+ * @brief  查询是否使能空闲自动降频
+ * @param  None
+ * @retval 1: 使能, 0: 关闭
+ */
+uint8_t clock_profile_auto_enabled(void)
+{
+    return clock_profile_auto_enable;
+}
+
+/**
+ * @brief  自动降频/升频处理, 在主循环中调用
+ * @note   总线有活动时回到 CLOCK_PROFILE_DEFAULT, 空闲超过
+ *         CLOCK_IDLE_TIMEOUT_MS 后降到 CLOCK_PROFILE_IDLE; 被否决时下次重试
+ * @param  None
+ * @retval None
+ */
+void clock_profile_poll(void)
+{
+    uint32_t now = get_tick();
+
+    if(clock_profile_activity_flag)
+    {
+        clock_profile_activity_flag = 0;
+        clock_profile_active_tick = now;
+    }
+
+    if(!clock_profile_auto_enable || (clock_profile_current == CLOCK_PROFILE_NONE))
+    {
+        return;
+    }
+
+    if((now - clock_profile_active_tick) < CLOCK_IDLE_TIMEOUT_MS)
+    {
+        clock_profile_set(CLOCK_PROFILE_DEFAULT);
+    }
+    else
+    {
+        clock_profile_set(CLOCK_PROFILE_IDLE);
+    }
+}
@@ -0,0 +1,130 @@
+/**
+ * @file clock_profile.h
+ * @brief 运行时时钟档位切换模块头文件
+ * @author Jason
+ * @date 2026-10-18
+ */
+
+#ifndef __CLOCK_PROFILE_H
+#define __CLOCK_PROFILE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "at32f403a_407.h"
+
+/* Exported types ------------------------------------------------------------*/
+/**
+ * @brief  时钟档位
+ */
+typedef enum
+{
+    CLOCK_PROFILE_240MHZ = 0,       /*!< 全速, APB1/APB2 = 120MHz */
+    CLOCK_PROFILE_120MHZ,           /*!< 半速, APB1/APB2 = 120MHz */
+    CLOCK_PROFILE_48MHZ,            /*!< 低速, APB1/APB2 = 48MHz */
+    CLOCK_PROFILE_NUM,
+    CLOCK_PROFILE_NONE = 0xFF       /*!< 尚未切换到PLL (HICK运行) */
+} clock_profile_t;
+
+/**
+ * @brief  时钟切换通知事件
+ */
+typedef enum
+{
+    CLOCK_EVENT_PRE_CHANGE = 0,     /*!< 切换前: 返回ERROR可否决本次切换, 不得改变驱动状态 */
+    CLOCK_EVENT_CHANGE_BEGIN,       /*!< 全部通过PRE_CHANGE, 切到HICK之前: 停止分频值失配时会出错的收发 (不可否决) */
+    CLOCK_EVENT_POST_CHANGE         /*!< 切换后: system_core_clock 已更新, 重算分频值 */
+} clock_event_t;
+
+/**
+ * @brief  时钟切换通知回调
+ * @param  event: 通知事件
+ * @param  profile: 目标档位 (PRE_CHANGE/CHANGE_BEGIN) 或新档位 (POST_CHANGE)
+ */
+typedef error_status (*clock_notifier_t)(clock_event_t event, clock_profile_t profile);
+
+/* Exported constants --------------------------------------------------------*/
+/* 最多注册的通知回调数 */
+#define CLOCK_NOTIFIER_MAX          8
+
+/* 默认档位和自动降频时使用的档位 */
+#define CLOCK_PROFILE_DEFAULT       CLOCK_PROFILE_240MHZ
+#define CLOCK_PROFILE_IDLE          CLOCK_PROFILE_48MHZ
+
+/* 总线无活动多久后自动降频 (ms) */
+#define CLOCK_IDLE_TIMEOUT_MS       2000
+
+/* Exported macro ------------------------------------------------------------*/
+/* 总线活动标记, 可在中断中调用 (只写一个变量) */
+#define CLOCK_PROFILE_ACTIVITY()    (clock_profile_activity_flag = 1)
+
+/* Exported variables --------------------------------------------------------*/
+extern __IO uint8_t clock_profile_activity_flag;
+
+/* Exported functions prototypes ---------------------------------------------*/
+
+/**
+ * @brief  设置PLL时钟源 (HEXT稳定或超时后调用一次)
+ * @param  source: CRM_PLL_SOURCE_HEXT 或 CRM_PLL_SOURCE_HICK
+ * @retval None
+ */
+void clock_profile_init(crm_pll_clock_source_type source);
+
+/**
+ * @brief  注册时钟切换通知回调 (重复注册同一回调无副作用)
+ * @param  notifier: 回调函数
+ * @retval SUCCESS/ERROR (回调表已满)
+ */
+error_status clock_profile_register(clock_notifier_t notifier);
+
+/**
+ * @brief  切换时钟档位
+ * @note   先通知 CLOCK_EVENT_PRE_CHANGE, 任一回调否决则不切换;
+ *         切换期间 (PLL重新锁定) 系统以HICK运行
+ * @param  profile: 目标档位
+ * @retval SUCCESS: 已切换, ERROR: 被否决或参数无效
+ */
+error_status clock_profile_set(clock_profile_t profile);
+
+/**
+ * @brief  获取档位的APB1时钟频率 (供驱动在切换前检查分频范围)
+ * @param  profile: 档位
+ * @retval APB1频率 (Hz), 档位无效时返回0
+ */
+uint32_t clock_profile_apb1_freq(clock_profile_t profile);
+
+/**
+ * @brief  获取当前时钟档位
+ * @param  None
+ * @retval 当前档位
+ */
+clock_profile_t clock_profile_get(void);
+
+/**
+ * @brief  使能/关闭空闲自动降频
+ * @param  enable: 1使能, 0关闭
+ * @retval None
+ */
+void clock_profile_auto(uint8_t enable);
+
+/**
+ * @brief  查询是否使能空闲自动降频
+ * @param  None
+ * @retval 1: 使能, 0: 关闭
+ */
+uint8_t clock_profile_auto_enabled(void);
+
+/**
+ * @brief  自动降频/升频处理, 在主循环中调用
+ * @param  None
+ * @retval None
+ */
+void clock_profile_poll(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CLOCK_PROFILE_H */
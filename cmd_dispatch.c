@@ -0,0 +1,931 @@
+/**
+ * @file cmd_dispatch.c
+ * @brief RS485命令分发模块实现
+ * @author Jason
+ * @date 2026-10-18
+ *
+ * 命令表是编译期确定的常量数组, 以 命令字-CMD_ID_BASE 直接索引, 查找为一次数组访问.
+ * 处理函数直接读取接收帧中的参数; 回复通过 cmd_reply_* 逐字段COBS编码到发送DMA缓冲区,
+ * 不经过中间缓冲区. 各模块自带的转储 (跟踪、统计、故障等) 同样直接写发送缓冲区.
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "cmd_dispatch.h"
+#include "main.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private define ------------------------------------------------------------*/
+/* 控制引脚掩码 */
+#define CMD_CTRL_PIN1               0x01
+#define CMD_CTRL_PIN2               0x02
+
+/* B4 每步: 掩码 电平 时间(u16) */
+#define CMD_CTRL_SEQ_STEP_SIZE      4
+
+/* AD 回复: 命令字 状态 下一个命令字, 每项 命令字 名称长度 名称 */
+#define CMD_LIST_HEADER_SIZE        3
+#define CMD_LIST_ENTRY_OVERHEAD     2
+
+/* Private macro -------------------------------------------------------------*/
+/* 表项: 命令字 -> 处理函数, 名称, 最短帧长度 */
+#define CMD_ENTRY(id, handler, name, min_len) [(id) - CMD_ID_BASE] = { (handler), (name), (min_len) }
+
+/* Private function prototypes -----------------------------------------------*/
+static void cmd_trace(uint8_t* frame, uint16_t len);
+static void cmd_stats(uint8_t* frame, uint16_t len);
+static void cmd_baud(uint8_t* frame, uint16_t len);
+static void cmd_address(uint8_t* frame, uint16_t len);
+static void cmd_boot(uint8_t* frame, uint16_t len);
+static void cmd_clock(uint8_t* frame, uint16_t len);
+static void cmd_config(uint8_t* frame, uint16_t len);
+static void cmd_reset_cause(uint8_t* frame, uint16_t len);
+static void cmd_fault(uint8_t* frame, uint16_t len);
+static void cmd_fw_update(uint8_t* frame, uint16_t len);
+static void cmd_list(uint8_t* frame, uint16_t len);
+static void cmd_buzzer(uint8_t* frame, uint16_t len);
+static void cmd_alarm(uint8_t* frame, uint16_t len);
+static void cmd_display_write(uint8_t* frame, uint16_t len);
+static void cmd_ctrl_pins(uint8_t* frame, uint16_t len);
+static void cmd_echo(uint8_t* frame, uint16_t len);
+static void cmd_display_update(uint8_t* frame, uint16_t len);
+static void cmd_ctrl_seq(uint8_t* frame, uint16_t len);
+static void cmd_ctrl_pwm(uint8_t* frame, uint16_t len);
+static void cmd_display_stats(uint8_t* frame, uint16_t len);
+static void cmd_display_speed(uint8_t* frame, uint16_t len);
+static void cmd_i2c_mode(uint8_t* frame, uint16_t len);
+static void cmd_i2c_bench(uint8_t* frame, uint16_t len);
+static void cmd_irq_stats(uint8_t* frame, uint16_t len);
+static void cmd_os_bench(uint8_t* frame, uint16_t len);
+static void cmd_sniff(uint8_t* frame, uint16_t len);
+static uint8_t cmd_name_len(const char* name);
+
+/* Private variables ---------------------------------------------------------*/
+/* 命令表 (Flash中), 未列出的命令字为空项 */
+static const cmd_entry_t cmd_table[CMD_ID_COUNT] =
+{
+    CMD_ENTRY(RS485_CMD_TRACE_DUMP,     cmd_trace,          "trace",        1),
+    CMD_ENTRY(RS485_CMD_STATS_QUERY,    cmd_stats,          "stats",        1),
+    CMD_ENTRY(RS485_CMD_BAUD_SWITCH,    cmd_baud,           "baud_set",     1),
+    CMD_ENTRY(RS485_CMD_BAUD_CONFIRM,   cmd_baud,           "baud_ok",      1),
+    CMD_ENTRY(RS485_CMD_BAUD_QUERY,     cmd_baud,           "baud_get",     1),
+    CMD_ENTRY(RS485_CMD_AUTOBAUD,       cmd_baud,           "autobaud",     1),
+    CMD_ENTRY(RS485_CMD_SET_ADDRESS,    cmd_address,        "address",      3),
+    CMD_ENTRY(RS485_CMD_BOOT_TIMELINE,  cmd_boot,           "boot_time",    1),
+    CMD_ENTRY(RS485_CMD_CLOCK_PROFILE,  cmd_clock,          "clock",        1),
+    CMD_ENTRY(RS485_CMD_CONFIG,         cmd_config,         "config",       1),
+    CMD_ENTRY(RS485_CMD_RESET_CAUSE,    cmd_reset_cause,    "reset_cause",  1),
+    CMD_ENTRY(RS485_CMD_FAULT_DUMP,     cmd_fault,          "fault",        1),
+    CMD_ENTRY(RS485_CMD_FW_UPDATE,      cmd_fw_update,      "fw_update",    2),
+    CMD_ENTRY(RS485_CMD_LIST,           cmd_list,           "list",         1),
+    CMD_ENTRY(RS485_CMD_BUZZER,         cmd_buzzer,         "beep",         5),
+    CMD_ENTRY(RS485_CMD_ALARM,          cmd_alarm,          "alarm",        2),
+    CMD_ENTRY(RS485_CMD_DISPLAY_WRITE,  cmd_display_write,  "disp_write",   3),
+    CMD_ENTRY(RS485_CMD_CTRL_PINS,      cmd_ctrl_pins,      "ctrl_pins",    1),
+    CMD_ENTRY(RS485_CMD_ECHO,           cmd_echo,           "echo",         1),
+    CMD_ENTRY(RS485_CMD_DISPLAY_UPDATE, cmd_display_update, "disp_update",  DISPLAY_UPD_HEADER_SIZE),
+    CMD_ENTRY(RS485_CMD_CTRL_SEQ,       cmd_ctrl_seq,       "ctrl_seq",     3),
+    CMD_ENTRY(RS485_CMD_CTRL_PWM,       cmd_ctrl_pwm,       "ctrl_pwm",     4),
+    CMD_ENTRY(RS485_CMD_DISPLAY_STATS,  cmd_display_stats,  "disp_stats",   1),
+    CMD_ENTRY(RS485_CMD_DISPLAY_SPEED,  cmd_display_speed,  "disp_speed",   2),
+    CMD_ENTRY(RS485_CMD_I2C_MODE,       cmd_i2c_mode,       "i2c_mode",     2),
+    CMD_ENTRY(RS485_CMD_I2C_BENCH,      cmd_i2c_bench,      "i2c_bench",    5),
+    CMD_ENTRY(RS485_CMD_IRQ_STATS,      cmd_irq_stats,      "irq_stats",    1),
+    CMD_ENTRY(RS485_CMD_OS_BENCH,       cmd_os_bench,       "os_bench",     1),
+    CMD_ENTRY(RS485_CMD_SNIFF,          cmd_sniff,          "sniff",        1),
+};
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief  转储跟踪缓冲区
+ * @param  frame: 命令帧
+ * @param  len: 帧长度
+ * @retval None
+ */
+static void cmd_trace(uint8_t* frame, uint16_t len)
+{
+    trace_dump();
+}
+
+/**
+ * @brief  发送运行统计快照
+ * @param  frame: 命令帧
+ * @param  len: 帧长度
+ * @retval None
+ */
+static void cmd_stats(uint8_t* frame, uint16_t len)
+{
+    metrics_send_snapshot();
+}
+
+/**
+ * @brief  波特率相关命令处理
+ * @note   切换流程: 主机发送 A2+波特率, 本机在旧波特率下回复 A2+状态+实际波特率
+ *         后切换; 主机随后在新波特率下发送 A3, 本机回复 A3+状态. 超时未确认则回退
+ * @param  frame: 命令帧
+ * @param  len: 帧长度
+ * @retval None
+ */
+static void cmd_baud(uint8_t* frame, uint16_t len)
+{
+    rs485_baud_info_t info;
+    uint8_t status = CMD_STATUS_OK;
+
+    switch(frame[0])
+    {
+        case RS485_CMD_BAUD_SWITCH:
+            info.actual = 0;
+            if((len < 5) || (rs485_baud_calc(rs485_get_u32(&frame[1]), &info) != SUCCESS))
+            {
+                status = CMD_STATUS_ERROR;
+            }
+            cmd_reply_begin(frame[0], status);
+            cmd_reply_u32(info.actual);
+            cmd_reply_end();
+
+            if(status == CMD_STATUS_OK)
+            {
+                rs485_baud_switch_begin(info.requested);
+            }
+            break;
+
+        case RS485_CMD_BAUD_CONFIRM:
+            if(rs485_baud_switch_confirm() != SUCCESS)
+            {
+                status = CMD_STATUS_ERROR;
+            }
+            cmd_reply_status(frame[0], status);
+            break;
+
+        case RS485_CMD_BAUD_QUERY:
+            /* A4 状态 请求波特率(u32) 实际波特率(u32) 误差ppm(i32) 分频值(u16) */
+            rs485_get_baud_info(&info);
+            cmd_reply_begin(frame[0], status);
+            cmd_reply_u32(info.requested);
+            cmd_reply_u32(info.actual);
+            cmd_reply_u32((uint32_t)info.error_ppm);
+            cmd_reply_u16(info.div);
+            cmd_reply_end();
+            break;
+
+        default:
+            cmd_reply_status(frame[0], status);
+            rs485_autobaud_start();
+            break;
+    }
+}
+
+/**
+ * @brief  设置本机地址和寻址模式
+ * @note   A6 地址 模式; 先回复 A6+状态, 再切换, 回复仍使用原寻址模式
+ * @param  frame: 命令帧
+ * @param  len: 帧长度
+ * @retval None
+ */
+static void cmd_address(uint8_t* frame, uint16_t len)
+{
+    uint8_t status = CMD_STATUS_OK;
+
+    /* 地址标记模式对地址有限制, 先检查新地址和新模式的组合, 回复前不改变任何设置 */
+    if((frame[2] > RS485_ADDR_MODE_ADDRESS_MARK) ||
+       ((frame[2] == RS485_ADDR_MODE_ADDRESS_MARK) && !RS485_ADDR_MARK_ADDR_OK(frame[1])))
+    {
+        status = CMD_STATUS_ERROR;
+    }
+    else if(rs485_set_node_address(frame[1]) != SUCCESS)
+    {
+        status = CMD_STATUS_ERROR;
+    }
+
+    cmd_reply_status(frame[0], status);
+
+    if(status == CMD_STATUS_OK)
+    {
+        (void)rs485_set_addr_mode((rs485_addr_mode_t)frame[2]);
+    }
+}
+
+/**
+ * @brief  发送启动各阶段时间戳
+ * @param  frame: 命令帧
+ * @param  len: 帧长度
+ * @retval None
+ */
+static void cmd_boot(uint8_t* frame, uint16_t len)
+{
+    boot_send_timeline();
+}
+
+/**
+ * @brief  设置/查询时钟档位
+ * @note   A8 [档位 [自动降频]]; 档位为0xFF或省略时只查询.
+ *         先切换再回复, 回复 A8 状态 档位 自动降频 系统时钟(u32)
+ * @param  frame: 命令帧
+ * @param  len: 帧长度
+ * @retval None
+ */
+static void cmd_clock(uint8_t* frame, uint16_t len)
+{
+    uint8_t status = CMD_STATUS_OK;
+
+    if(len >= 3)
+    {
+        clock_profile_auto(frame[2]);
+    }
+
+    if((len >= 2) && (frame[1] != CLOCK_PROFILE_NONE))
+    {
+        if(clock_profile_set((clock_profile_t)frame[1]) != SUCCESS)
+        {
+            status = CMD_STATUS_ERROR;
+        }
+    }
+
+    cmd_reply_begin(frame[0], status);
+    cmd_reply_u8((uint8_t)clock_profile_get());
+    cmd_reply_u8(clock_profile_auto_enabled());
+    cmd_reply_u32(system_core_clock);
+    cmd_reply_end();
+}
+
+/**
+ * @brief  读写配置项
+ * @note   A9 键 [值]; 不带值时读取. 回复 A9 状态 键 当前值 (未保存时无值).
+ *         写入在后台完成, 多数配置重启后生效
+ * @param  frame: 命令帧
+ * @param  len: 帧长度
+ * @retval None
+ */
+static void cmd_config(uint8_t* frame, uint16_t len)
+{
+    uint8_t value[CONFIG_VALUE_MAX];
+    uint8_t key = (len >= 2) ? frame[1] : 0xFF;
+    uint8_t size = config_key_size((config_key_t)key);
+    uint8_t status = CMD_STATUS_ERROR;
+
+    if((len >= 2) && (size != 0))
+    {
+        if((len == 2) || (config_set((config_key_t)key, &frame[2], (uint8_t)(len - 2)) == SUCCESS))
+        {
+            status = CMD_STATUS_OK;
+        }
+    }
+
+    cmd_reply_begin(frame[0], status);
+    cmd_reply_u8(key);
+    if((status == CMD_STATUS_OK) && (config_get((config_key_t)key, value, size) == SUCCESS))
+    {
+        cmd_reply_data(value, size);
+    }
+    cmd_reply_end();
+}
+
+/**
+ * @brief  查询上次复位原因和看门狗记录
+ * @param  frame: 命令帧
+ * @param  len: 帧长度
+ * @retval None
+ */
+static void cmd_reset_cause(uint8_t* frame, uint16_t len)
+{
+    watchdog_send_report();
+}
+
+/**
+ * @brief  读取故障记录
+ * @note   AB [0x01]; 带 FAULT_DUMP_CLEAR 时发送后立即清除, 不等主机确认 (回复丢失则记录丢失).
+ *         主机先不带参数读取, 收到完整记录后再发带参数的命令清除
+ * @param  frame: 命令帧
+ * @param  len: 帧长度
+ * @retval None
+ */
+static void cmd_fault(uint8_t* frame, uint16_t len)
+{
+    fault_send_dump();
+
+    if((len >= 2) && (frame[1] == FAULT_DUMP_CLEAR))
+    {
+        fault_clear();
+    }
+}
+
+/**
+ * @brief  固件更新
+ * @param  frame: 命令帧
+ * @param  len: 帧长度
+ * @retval None
+ */
+static void cmd_fw_update(uint8_t* frame, uint16_t len)
+{
+    fw_update_command(frame, len);
+}
+
+/**
+ * @brief  列出已定义的命令
+ * @note   AD [起始命令字]; 回复 AD 状态 下一个命令字 {命令字 名称长度 名称}...,
+ *         一帧放不下时下一个命令字非0, 主机从该命令字继续查询
+ * @param  frame: 命令帧
+ * @param  len: 帧长度
+ * @retval None
+ */
+static void cmd_list(uint8_t* frame, uint16_t len)
+{
+    const cmd_entry_t* entry;
+    uint16_t size = CMD_LIST_HEADER_SIZE;
+    uint16_t id = (len >= 2) ? frame[1] : CMD_ID_BASE;
+    uint16_t next;
+    uint8_t name_len;
+
+    /* 先确定本帧放得下的范围, 下一个命令字在名称之前发送 */
+    for(next = id; next <= 0xFF; next++)
+    {
+        entry = cmd_lookup((uint8_t)next);
+        if(entry == NULL)
+        {
+            continue;
+        }
+
+        name_len = cmd_name_len(entry->name);
+        if(size + CMD_LIST_ENTRY_OVERHEAD + name_len > RS485_FRAME_MAX_SIZE)
+        {
+            break;
+        }
+        size += CMD_LIST_ENTRY_OVERHEAD + name_len;
+    }
+
+    cmd_reply_begin(frame[0], CMD_STATUS_OK);
+    cmd_reply_u8((next <= 0xFF) ? (uint8_t)next : 0);
+
+    for(; id < next; id++)
+    {
+        entry = cmd_lookup((uint8_t)id);
+        if(entry != NULL)
+        {
+            name_len = cmd_name_len(entry->name);
+            cmd_reply_u8((uint8_t)id);
+            cmd_reply_u8(name_len);
+            cmd_reply_data((const uint8_t*)entry->name, name_len);
+        }
+    }
+
+    cmd_reply_end();
+}
+
+/**
+ * @brief  蜂鸣器鸣叫 (非阻塞)
+ * @note   AE 频率(u16) 时长(u16); 频率0停止, 时长0一直鸣叫. 启动完成前回复错误
+ * @param  frame: 命令帧
+ * @param  len: 帧长度
+ * @retval None
+ */
+static void cmd_buzzer(uint8_t* frame, uint16_t len)
+{
+    if(!boot_is_done())
+    {
+        cmd_reply_status(frame[0], CMD_STATUS_ERROR);
+        return;
+    }
+
+    buzzer_beep_start(rs485_get_u16(&frame[1]), rs485_get_u16(&frame[3]));
+    cmd_reply_status(frame[0], CMD_STATUS_OK);
+}
+
+/**
+ * @brief  报警音 (非阻塞)
+ * @note   AF 循环次数; 0停止. 音调和节拍取配置项
+ * @param  frame: 命令帧
+ * @param  len: 帧长度
+ * @retval None
+ */
+static void cmd_alarm(uint8_t* frame, uint16_t len)
+{
+    if(!boot_is_done())
+    {
+        cmd_reply_status(frame[0], CMD_STATUS_ERROR);
+        return;
+    }
+
+    buzzer_alarm_start(frame[1]);
+    cmd_reply_status(frame[0], CMD_STATUS_OK);
+}
+
+/**
+ * @brief  写显示板寄存器
+ * @note   B0 寄存器 数据...; 数据直接从接收帧发送. 显示板未就绪或无应答时回复错误
+ * @param  frame: 命令帧
+ * @param  len: 帧长度
+ * @retval None
+ */
+static void cmd_display_write(uint8_t* frame, uint16_t len)
+{
+    uint8_t status = CMD_STATUS_ERROR;
+
+    if(i2c_display_is_ready() && (i2c_display_send_buffer(frame[1], &frame[2], len - 2) == SUCCESS))
+    {
+        status = CMD_STATUS_OK;
+    }
+
+    cmd_reply_status(frame[0], status);
+}
+
+/**
+ * @brief  设置/查询显示板控制引脚
+ * @note   B1 [掩码 电平]; 掩码中的引脚设为对应电平 (停止该引脚的PWM), 省略时只查询.
+ *         回复 B1 状态 当前电平; 引脚正在播放波形时不改变, 状态为错误
+ * @param  frame: 命令帧
+ * @param  len: 帧长度
+ * @retval None
+ */
+static void cmd_ctrl_pins(uint8_t* frame, uint16_t len)
+{
+    uint8_t status = (len == 2) ? CMD_STATUS_ERROR : CMD_STATUS_OK;
+    uint8_t level;
+
+    if(len >= 3)
+    {
+        if((frame[1] & CMD_CTRL_PIN1) &&
+           (ctrl_seq_pwm(CTRL_SEQ_PIN1, (frame[2] & CMD_CTRL_PIN1) ? CTRL_PWM_DUTY_MAX : 0) != SUCCESS))
+        {
+            status = CMD_STATUS_ERROR;
+        }
+        if((frame[1] & CMD_CTRL_PIN2) &&
+           (ctrl_seq_pwm(CTRL_SEQ_PIN2, (frame[2] & CMD_CTRL_PIN2) ? CTRL_PWM_DUTY_MAX : 0) != SUCCESS))
+        {
+            status = CMD_STATUS_ERROR;
+        }
+    }
+
+    level = (i2c_display_get_ctrl1() ? CMD_CTRL_PIN1 : 0) | (i2c_display_get_ctrl2() ? CMD_CTRL_PIN2 : 0);
+
+    cmd_reply_begin(frame[0], status);
+    cmd_reply_u8(level);
+    cmd_reply_end();
+}
+
+/**
+ * @brief  原样回送参数
+ * @note   B2 数据...; 回复 B2 状态 数据..., 用于测试链路和测量往返时间
+ * @param  frame: 命令帧
+ * @param  len: 帧长度
+ * @retval None
+ */
+static void cmd_echo(uint8_t* frame, uint16_t len)
+{
+    cmd_reply_begin(frame[0], CMD_STATUS_OK);
+    cmd_reply_data(&frame[1], len - 1);
+    cmd_reply_end();
+}
+
+/**
+ * @brief  显示帧缓冲区更新 (RLE/XOR差分段, 最后一段回复CRC32)
+ * @param  frame: 命令帧
+ * @param  len: 帧长度
+ * @retval None
+ */
+static void cmd_display_update(uint8_t* frame, uint16_t len)
+{
+    display_update_command(frame, len);
+}
+
+/**
+ * @brief  播放/停止控制引脚波形
+ * @note   B4 重复次数(u16) {掩码 电平 时间us(u16)}...; 无步骤时停止播放.
+ *         回复 B4 状态, 波形由定时器和DMA产生, 回复时已开始播放
+ * @param  frame: 命令帧
+ * @param  len: 帧长度
+ * @retval None
+ */
+static void cmd_ctrl_seq(uint8_t* frame, uint16_t len)
+{
+    ctrl_seq_step_t steps[CTRL_SEQ_MAX_STEPS];
+    uint16_t count = (len - 3) / CMD_CTRL_SEQ_STEP_SIZE;
+    uint8_t status = CMD_STATUS_OK;
+    uint16_t i;
+
+    if(((len - 3) % CMD_CTRL_SEQ_STEP_SIZE) || (count > CTRL_SEQ_MAX_STEPS))
+    {
+        cmd_reply_status(frame[0], CMD_STATUS_ERROR);
+        return;
+    }
+
+    if(count == 0)
+    {
+        ctrl_seq_stop();
+        cmd_reply_status(frame[0], CMD_STATUS_OK);
+        return;
+    }
+
+    for(i = 0; i < count; i++)
+    {
+        steps[i].mask = frame[3 + i * CMD_CTRL_SEQ_STEP_SIZE];
+        steps[i].level = frame[4 + i * CMD_CTRL_SEQ_STEP_SIZE];
+        steps[i].duration_us = rs485_get_u16(&frame[5 + i * CMD_CTRL_SEQ_STEP_SIZE]);
+    }
+
+    if(ctrl_seq_play(steps, count, rs485_get_u16(&frame[1])) != SUCCESS)
+    {
+        status = CMD_STATUS_ERROR;
+    }
+
+    cmd_reply_status(frame[0], status);
+}
+
+/**
+ * @brief  设置控制引脚PWM占空比
+ * @note   B5 引脚 占空比(u16, 0.1%); 回复 B5 状态
+ * @param  frame: 命令帧
+ * @param  len: 帧长度
+ * @retval None
+ */
+static void cmd_ctrl_pwm(uint8_t* frame, uint16_t len)
+{
+    uint8_t status = CMD_STATUS_ERROR;
+
+    if(ctrl_seq_pwm(frame[1], rs485_get_u16(&frame[2])) == SUCCESS)
+    {
+        status = CMD_STATUS_OK;
+    }
+
+    cmd_reply_status(frame[0], status);
+}
+
+/**
+ * @brief  显示设备状态和实际刷新率
+ * @note   B6; 回复 B6 状态 设备数 {编号 状态 优先级 刷新率(u16, 0.1Hz) 帧数(u32)
+ *         最长延迟ms(u16) 超期帧数(u16) 错误数(u16) 待刷新字节数(u16)}...
+ * @param  frame: 命令帧
+ * @param  len: 帧长度
+ * @retval None
+ */
+static void cmd_display_stats(uint8_t* frame, uint16_t len)
+{
+    display_dev_t* dev;
+    uint8_t i;
+
+    cmd_reply_begin(frame[0], CMD_STATUS_OK);
+    cmd_reply_u8(DISPLAY_DEV_COUNT);
+    for(i = 0; i < DISPLAY_DEV_COUNT; i++)
+    {
+        dev = display_dev_get(i);
+        cmd_reply_u8(i);
+        cmd_reply_u8(dev->state);
+        cmd_reply_u8(dev->priority);
+        cmd_reply_u16(dev->fps_x10);
+        cmd_reply_u32(dev->frames);
+        cmd_reply_u16(dev->latency_max_ms);
+        cmd_reply_u16(dev->deadline_miss);
+        cmd_reply_u16(dev->errors);
+        cmd_reply_u16(display_dev_dirty_bytes(dev));
+    }
+    cmd_reply_end();
+}
+
+/**
+ * @brief  显示设备I2C速率查询和速率探测
+ * @note   B7 设备 [最高档]: 带档位时执行速率探测 (0xFF 全部档位), 阻塞约20ms;
+ *         回复 B7 状态 档位 设定速率(u32) 实际SCL速率(u32) 占空比(0: 2:1, 1: 16:9) 时钟延展us(u16)
+ * @param  frame: 命令帧
+ * @param  len: 帧长度
+ * @retval None
+ */
+static void cmd_display_speed(uint8_t* frame, uint16_t len)
+{
+    display_dev_t* dev = display_dev_get(frame[1]);
+    uint8_t status = CMD_STATUS_OK;
+
+    if(dev == NULL)
+    {
+        cmd_reply_status(frame[0], CMD_STATUS_ERROR);
+        return;
+    }
+
+    if((len >= 3) && (display_dev_speed_probe(dev, frame[2]) != SUCCESS))
+    {
+        status = CMD_STATUS_ERROR;
+    }
+
+    cmd_reply_begin(frame[0], status);
+    cmd_reply_u8(dev->speed_step);
+    cmd_reply_u32(display_dev_speed_hz(dev->speed_step));
+    cmd_reply_u32(dev->scl_rate);
+    cmd_reply_u8((dev->duty == I2C_CLOCK_DUTY_16_9) ? 1 : 0);
+    cmd_reply_u16(dev->stretch_us);
+    cmd_reply_end();
+}
+
+/**
+ * @brief  I2C总线硬件/软件模式
+ * @note   B8 总线 [模式]: 带模式时切换 (0硬件 1软件); 回复 B8 状态 模式 SCL速率(u32)
+ * @param  frame: 命令帧
+ * @param  len: 帧长度
+ * @retval None
+ */
+static void cmd_i2c_mode(uint8_t* frame, uint16_t len)
+{
+    i2c_bus_t* bus = i2c_bus_get(frame[1]);
+
+    if((bus == NULL) || ((len >= 3) && (frame[2] > 1)))
+    {
+        cmd_reply_status(frame[0], CMD_STATUS_ERROR);
+        return;
+    }
+
+    if(len >= 3)
+    {
+        i2c_bus_set_soft(bus, frame[2] ? TRUE : FALSE);
+    }
+
+    cmd_reply_begin(frame[0], CMD_STATUS_OK);
+    cmd_reply_u8(bus->soft_active);
+    cmd_reply_u32(i2c_bus_scl_rate(bus));
+    cmd_reply_end();
+}
+
+/**
+ * @brief  硬件与软件I2C对比测试
+ * @note   B9 总线 地址 寄存器 长度; 回复 B9 状态 硬件速率(u32) 硬件每字节CPU周期(u32)
+ *         软件速率(u32) 软件每字节CPU周期(u32). 测试数据会改变显示, 之后该总线上的设备整屏刷新
+ * @param  frame: 命令帧
+ * @param  len: 帧长度
+ * @retval None
+ */
+static void cmd_i2c_bench(uint8_t* frame, uint16_t len)
+{
+    i2c_bus_t* bus = i2c_bus_get(frame[1]);
+    display_dev_t* dev;
+    i2c_bench_t bench;
+    uint8_t status;
+    uint8_t i;
+
+    if(bus == NULL)
+    {
+        cmd_reply_status(frame[0], CMD_STATUS_ERROR);
+        return;
+    }
+
+    status = (i2c_bus_benchmark(bus, frame[2], frame[3], frame[4], &bench) == SUCCESS) ? CMD_STATUS_OK : CMD_STATUS_ERROR;
+
+    for(i = 0; i < DISPLAY_DEV_COUNT; i++)
+    {
+        dev = display_dev_get(i);
+        if((dev->bus == bus) && (dev->state == I2C_DISPLAY_STATE_READY))
+        {
+            display_dev_invalidate(dev);
+            display_dev_commit(dev);
+        }
+    }
+
+    cmd_reply_begin(frame[0], status);
+    cmd_reply_u32(bench.hw_rate);
+    cmd_reply_u32(bench.hw_cycles_per_byte);
+    cmd_reply_u32(bench.soft_rate);
+    cmd_reply_u32(bench.soft_cycles_per_byte);
+    cmd_reply_end();
+}
+
+/**
+ * @brief  各优先级的进入延迟和延迟工作统计
+ * @note   BA [01 读后清除]; 只回复有数据的级别 (在用的优先级和主循环, 级别 16 为主循环),
+ *         回复 BA 状态 级别数 {级别 探测次数(u32) 最长进入延迟(u32) 延迟工作数(u32) 最长等待(u32)}...,
+ *         时间单位为CPU周期
+ * @param  frame: 命令帧
+ * @param  len: 帧长度
+ * @retval None
+ */
+static void cmd_irq_stats(uint8_t* frame, uint16_t len)
+{
+    const irq_level_stats_t* stats;
+    uint8_t count = 0;
+    uint8_t level;
+
+    for(level = 0; level < IRQ_LEVEL_NUM; level++)
+    {
+        stats = irq_defer_stats(level);
+        if((stats->probe_count != 0) || (stats->defer_count != 0))
+        {
+            count++;
+        }
+    }
+
+    cmd_reply_begin(frame[0], CMD_STATUS_OK);
+    cmd_reply_u8(count);
+    for(level = 0; level < IRQ_LEVEL_NUM; level++)
+    {
+        stats = irq_defer_stats(level);
+        if((stats->probe_count == 0) && (stats->defer_count == 0))
+        {
+            continue;
+        }
+        cmd_reply_u8(level);
+        cmd_reply_u32(stats->probe_count);
+        cmd_reply_u32(stats->probe_max_cycles);
+        cmd_reply_u32(stats->defer_count);
+        cmd_reply_u32(stats->defer_max_cycles);
+    }
+    cmd_reply_end();
+
+    if((len >= 2) && (frame[1] == 0x01))
+    {
+        irq_defer_stats_clear();
+    }
+}
+
+/**
+ * @brief  测量任务切换和中断到任务的延迟
+ * @note   BB; 回复 BB 状态 切换最小(u32) 切换最大(u32) 中断到任务最小(u32) 中断到任务最大(u32),
+ *         单位为CPU周期; 裸机 (OS_RTOS_ENABLE 为0) 回复错误
+ * @param  frame: 命令帧
+ * @param  len: 帧长度
+ * @retval None
+ */
+static void cmd_os_bench(uint8_t* frame, uint16_t len)
+{
+    os_bench_t result;
+
+    if(os_benchmark(&result) != SUCCESS)
+    {
+        cmd_reply_status(frame[0], CMD_STATUS_ERROR);
+        return;
+    }
+
+    cmd_reply_begin(frame[0], CMD_STATUS_OK);
+    cmd_reply_u32(result.switch_min);
+    cmd_reply_u32(result.switch_max);
+    cmd_reply_u32(result.isr_min);
+    cmd_reply_u32(result.isr_max);
+    cmd_reply_end();
+}
+
+/**
+ * @brief  总线监听
+ * @note   BC: 回复 BC 状态 监听状态 字节数(u32) 丢失字节数(u32) 丢失标记数(u32) 缓冲区峰值(u16);
+ *         BC 时长(u16): 回复发完后开始捕获, 时长为0时一直捕获到复位, 记录经USART1 (PA9) 输出
+ * @param  frame: 命令帧
+ * @param  len: 帧长度
+ * @retval None
+ */
+static void cmd_sniff(uint8_t* frame, uint16_t len)
+{
+    rs485_sniff_stats_t stats;
+
+    if(len >= 3)
+    {
+        if(rs485_sniff_start(rs485_get_u16(&frame[1])) != SUCCESS)
+        {
+            cmd_reply_status(frame[0], CMD_STATUS_ERROR);
+        }
+        else
+        {
+            cmd_reply_status(frame[0], CMD_STATUS_OK);
+        }
+        return;
+    }
+
+    rs485_sniff_get_stats(&stats);
+    cmd_reply_begin(frame[0], CMD_STATUS_OK);
+    cmd_reply_u8(stats.state);
+    cmd_reply_u32(stats.bytes);
+    cmd_reply_u32(stats.lost_bytes);
+    cmd_reply_u32(stats.marks_lost);
+    cmd_reply_u16(stats.ring_peak);
+    cmd_reply_end();
+}
+
+/**
+ * @brief  名称长度
+ * @param  name: 名称
+ * @retval 长度, 最多 CMD_NAME_MAX
+ */
+static uint8_t cmd_name_len(const char* name)
+{
+    uint8_t len = 0;
+
+    while((len < CMD_NAME_MAX) && (name[len] != '\0'))
+    {
+        len++;
+    }
+
+    return len;
+}
+
+/**
+ * @brief  分发一帧命令
+ * @param  frame: 命令帧
+ * @param  len: 帧长度 (大于0)
+ * @retval None
+ */
+void cmd_dispatch(uint8_t* frame, uint16_t len)
+{
+    const cmd_entry_t* entry = cmd_lookup(frame[0]);
+
+    if(entry == NULL)
+    {
+        cmd_reply_status(frame[0], CMD_STATUS_UNKNOWN);
+        return;
+    }
+
+    if(len < entry->min_len)
+    {
+        cmd_reply_status(frame[0], CMD_STATUS_ERROR);
+        return;
+    }
+
+    entry->handler(frame, len);
+}
+
+/**
+ * @brief  查找命令表项
+ * @param  id: 命令字
+ * @retval 表项指针, 未定义时返回NULL
+ */
+const cmd_entry_t* cmd_lookup(uint8_t id)
+{
+    const cmd_entry_t* entry;
+
+    if((id < CMD_ID_BASE) || (id >= CMD_ID_BASE + CMD_ID_COUNT))
+    {
+        return NULL;
+    }
+
+    entry = &cmd_table[id - CMD_ID_BASE];
+
+    return (entry->handler != NULL) ? entry : NULL;
+}
+
+/**
+ * @brief  开始回复: 命令字和状态直接编码到发送缓冲区
+ * @param  id: 命令字
+ * @param  status: 回复状态
+ * @retval None
+ */
+void cmd_reply_begin(uint8_t id, uint8_t status)
+{
+    rs485_frame_begin();
+    cmd_reply_u8(id);
+    cmd_reply_u8(status);
+}
+
+/**
+ * @brief  追加8位数
+ * @param  value: 数值
+ * @retval None
+ */
+void cmd_reply_u8(uint8_t value)
+{
+    rs485_frame_write(&value, 1);
+}
+
+/**
+ * @brief  追加16位数 (小端)
+ * @param  value: 数值
+ * @retval None
+ */
+void cmd_reply_u16(uint16_t value)
+{
+    cmd_reply_u8((uint8_t)value);
+    cmd_reply_u8((uint8_t)(value >> 8));
+}
+
+/**
+ * @brief  追加32位数 (小端)
+ * @param  value: 数值
+ * @retval None
+ */
+void cmd_reply_u32(uint32_t value)
+{
+    cmd_reply_u16((uint16_t)value);
+    cmd_reply_u16((uint16_t)(value >> 16));
+}
+
+/**
+ * @brief  追加数据
+ * @param  data: 数据
+ * @param  len: 长度
+ * @retval None
+ */
+void cmd_reply_data(const uint8_t* data, uint16_t len)
+{
+    rs485_frame_write(data, len);
+}
+
+/**
+ * @brief  结束回复并启动发送
+ * @param  None
+ * @retval SUCCESS/ERROR (超过帧最大长度时不发送)
+ */
+error_status cmd_reply_end(void)
+{
+    return rs485_frame_end();
+}
+
+/**
+ * @brief  只回复命令字和状态
+ * @param  id: 命令字
+ * @param  status: 回复状态
+ * @retval None
+ */
+void cmd_reply_status(uint8_t id, uint8_t status)
+{
+    cmd_reply_begin(id, status);
+    cmd_reply_end();
+}
@@ -0,0 +1,124 @@
+/**
+ * @file cmd_dispatch.h
+ * @brief RS485命令分发模块头文件 (命令字查表, 回复直接编码到发送缓冲区)
+ * @author Jason
+ * @date 2026-10-18
+ */
+
+#ifndef __CMD_DISPATCH_H
+#define __CMD_DISPATCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "at32f403a_407.h"
+
+/* Exported types ------------------------------------------------------------*/
+/**
+ * @brief  命令处理函数
+ * @param  frame: 命令帧 (frame[0]为命令字, 参数就地解析, 不拷贝)
+ * @param  len: 帧长度, 已检查不小于表项的最短长度
+ */
+typedef void (*cmd_handler_t)(uint8_t* frame, uint16_t len);
+
+/**
+ * @brief  命令表项
+ */
+typedef struct
+{
+    cmd_handler_t handler;          /*!< 处理函数, NULL为未定义 */
+    const char* name;               /*!< 短名称, 主机用 AD 命令列出 */
+    uint8_t min_len;                /*!< 最短帧长度 (含命令字), 不足时回复 CMD_STATUS_ERROR */
+} cmd_entry_t;
+
+/* Exported constants --------------------------------------------------------*/
+/* 回复状态 (命令字之后的第1字节) */
+#define CMD_STATUS_OK               0x00
+#define CMD_STATUS_ERROR            0x01
+#define CMD_STATUS_UNKNOWN          0x02    /*!< 命令字未定义 */
+
+/* 命令表覆盖的命令字范围: 表按 命令字-CMD_ID_BASE 直接索引 */
+#define CMD_ID_BASE                 0xA0
+#define CMD_ID_COUNT                32
+
+/* 名称最大长度 */
+#define CMD_NAME_MAX                15
+
+/* Exported macro ------------------------------------------------------------*/
+/* Exported functions prototypes ---------------------------------------------*/
+
+/**
+ * @brief  分发一帧命令
+ * @note   未定义的命令字回复 命令字+CMD_STATUS_UNKNOWN
+ * @param  frame: 命令帧
+ * @param  len: 帧长度 (大于0)
+ * @retval None
+ */
+void cmd_dispatch(uint8_t* frame, uint16_t len);
+
+/**
+ * @brief  查找命令表项
+ * @param  id: 命令字
+ * @retval 表项指针, 未定义时返回NULL
+ */
+const cmd_entry_t* cmd_lookup(uint8_t id);
+
+/**
+ * @brief  开始回复: 命令字和状态直接编码到发送缓冲区
+ * @param  id: 命令字
+ * @param  status: 回复状态
+ * @retval None
+ */
+void cmd_reply_begin(uint8_t id, uint8_t status);
+
+/**
+ * @brief  追加8位数
+ * @param  value: 数值
+ * @retval None
+ */
+void cmd_reply_u8(uint8_t value);
+
+/**
+ * @brief  追加16位数 (小端)
+ * @param  value: 数值
+ * @retval None
+ */
+void cmd_reply_u16(uint16_t value);
+
+/**
+ * @brief  追加32位数 (小端)
+ * @param  value: 数值
+ * @retval None
+ */
+void cmd_reply_u32(uint32_t value);
+
+/**
+ * @brief  追加数据
+ * @param  data: 数据
+ * @param  len: 长度
+ * @retval None
+ */
+void cmd_reply_data(const uint8_t* data, uint16_t len);
+
+/**
+ * @brief  结束回复并启动发送
+ * @param  None
+ * @retval SUCCESS/ERROR (超过帧最大长度时不发送)
+ */
+error_status cmd_reply_end(void);
+
+/**
+ * @brief  只回复命令字和状态
+ * @param  id: 命令字
+ * @param  status: 回复状态
+ * @retval None
+ */
+void cmd_reply_status(uint8_t id, uint8_t status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CMD_DISPATCH_H */
@@ -0,0 +1,540 @@
+/**
+ * @file config_store.c
+ * @brief 内部Flash配置存储模块实现
+ * @author Jason
+ * @date 2026-10-18
+ *
+ * 两个扇区轮流使用, 每个扇区为只追加的记录日志:
+ *   扇区头: magic(u32) 序号(u32), 序号大的有效扇区为当前扇区
+ *   记录:   key(u8) len(u8) crc16(u16) 数据(按4字节补齐), CRC最后写入
+ * 同一键以最后一条CRC正确的记录为准. 扇区写满时把各键最新值复制到另一扇区,
+ * 最后写扇区头提交; 提交前掉电则旧扇区仍然有效. 擦除前先作废备用扇区的magic.
+ * 掉电测试见 tests/config_store_test.c.
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "config_store.h"
+#include "main.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/**
+ * @brief  后台写入状态
+ */
+typedef enum
+{
+    CONFIG_STATE_IDLE = 0,      /*!< 追加记录 */
+    CONFIG_STATE_ERASE,         /*!< 等待擦除备用扇区 */
+    CONFIG_STATE_COPY,          /*!< 逐条复制最新值到备用扇区 */
+    CONFIG_STATE_COMMIT         /*!< 写扇区头 */
+} config_state_t;
+
+/* Private define ------------------------------------------------------------*/
+#define CONFIG_SECTOR_MAGIC     0x31474643  // "CFG1"
+#define CONFIG_SECTOR_HEADER    8
+#define CONFIG_SECTOR_NONE      0xFF
+#define CONFIG_ERASED_WORD      0xFFFFFFFF
+
+/* Private macro -------------------------------------------------------------*/
+#define CONFIG_SECTOR_ADDR(n)   (CONFIG_FLASH_BASE + (uint32_t)(n) * CONFIG_SECTOR_SIZE)
+#define CONFIG_RECORD_SIZE(len) (4 + (((uint32_t)(len) + 3) & ~3UL))
+#define CONFIG_WORD(addr)       (*(__IO uint32_t*)(addr))
+
+/* Private variables ---------------------------------------------------------*/
+/* 各键的值长度, 与 config_key_t 顺序一致 */
+static const uint8_t config_key_sizes[CONFIG_KEY_NUM] =
+{
+    1,      /* NODE_ADDRESS */
+    1,      /* ADDR_MODE */
+    4,      /* BAUDRATE */
+    1,      /* DISPLAY_ADDRESS */
+    1,      /* BUZZER_VOLUME */
+    4,      /* ALARM_FREQ_LOW */
+    4,      /* ALARM_FREQ_HIGH */
+    2,      /* ALARM_PERIOD */
+    16      /* I2C_SPEED */
+};
+
+/* 索引: 每个键最新记录的地址, 0为不存在 */
+static uint32_t config_index[CONFIG_KEY_NUM];
+
+static uint8_t config_active = CONFIG_SECTOR_NONE;
+static uint32_t config_seq = 0;
+static uint32_t config_tail = 0;            // 当前扇区下一个空闲地址
+static uint8_t config_tail_dirty = 0;       // 日志尾部有损坏的记录, 下次写入前先整理
+
+/* 待写入的值 */
+static uint8_t config_pending_data[CONFIG_KEY_NUM][CONFIG_VALUE_MAX];
+static uint8_t config_pending_len[CONFIG_KEY_NUM];
+static uint32_t config_pending_mask = 0;
+
+/* 整理 */
+static config_state_t config_state = CONFIG_STATE_IDLE;
+static uint8_t config_target = 0;
+static uint8_t config_copy_key = 0;
+static uint32_t config_copy_tail = 0;
+static uint32_t config_new_index[CONFIG_KEY_NUM];
+
+/* Private function prototypes -----------------------------------------------*/
+static uint16_t config_crc16(uint8_t key, uint8_t len, const uint8_t* data);
+static uint8_t config_region_erased(uint32_t addr, uint32_t size);
+static error_status config_record_write(uint32_t addr, uint8_t key, const uint8_t* data, uint8_t len);
+static void config_scan(void);
+static void config_compact_step(void);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief  计算记录CRC (CRC-16/CCITT, 覆盖键、长度和数据)
+ * @note   0xFFFF表示CRC尚未写入 (记录未提交), 计算结果为0xFFFF时改为0
+ * @param  key: 键
+ * @param  len: 长度
+ * @param  data: 数据
+ * @retval CRC
+ */
+static uint16_t config_crc16(uint8_t key, uint8_t len, const uint8_t* data)
+{
+    uint16_t crc = 0xFFFF;
+    uint8_t byte;
+    uint8_t i, j;
+
+    for(i = 0; i < len + 2; i++)
+    {
+        byte = (i == 0) ? key : ((i == 1) ? len : data[i - 2]);
+        crc ^= (uint16_t)byte << 8;
+        for(j = 0; j < 8; j++)
+        {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+
+    return (crc == 0xFFFF) ? 0 : crc;
+}
+
+/**
+ * @brief  检查Flash区域是否为擦除状态
+ * @param  addr: 起始地址
+ * @param  size: 长度 (4的倍数)
+ * @retval 1: 已擦除, 0: 有数据
+ */
+static uint8_t config_region_erased(uint32_t addr, uint32_t size)
+{
+    uint32_t i;
+
+    for(i = 0; i < size; i += 4)
+    {
+        if(CONFIG_WORD(addr + i) != CONFIG_ERASED_WORD)
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * @brief  写一条记录
+ * @note   先写记录头的键和长度, 再写数据, 最后写CRC提交. 中途掉电时长度仍可跳过该记录;
+ *         CRC只写了一部分时不可能与数据相符, 数据写了一部分时CRC尚为0xFFFF (不是有效CRC),
+ *         不会因残缺数据恰好与CRC相符 (CRC-16, 1/65536) 而读出错值
+ * @param  addr: 写入地址 (须已擦除)
+ * @param  key: 键
+ * @param  data: 数据
+ * @param  len: 长度
+ * @retval SUCCESS/ERROR
+ */
+static error_status config_record_write(uint32_t addr, uint8_t key, const uint8_t* data, uint8_t len)
+{
+    uint32_t word;
+    uint8_t i, j;
+    error_status status = SUCCESS;
+
+    flash_unlock();
+
+    if(flash_halfword_program(addr, (uint16_t)(key | ((uint16_t)len << 8))) != FLASH_OPERATE_DONE)
+    {
+        status = ERROR;
+    }
+
+    for(i = 0; (i < len) && (status == SUCCESS); i += 4)
+    {
+        word = CONFIG_ERASED_WORD;
+        for(j = 0; (j < 4) && (i + j < len); j++)
+        {
+            word &= ~((uint32_t)0xFF << (8 * j));
+            word |= (uint32_t)data[i + j] << (8 * j);
+        }
+
+        if(flash_word_program(addr + 4 + i, word) != FLASH_OPERATE_DONE)
+        {
+            status = ERROR;
+        }
+    }
+
+    if((status == SUCCESS) &&
+       (flash_halfword_program(addr + 2, config_crc16(key, len, data)) != FLASH_OPERATE_DONE))
+    {
+        status = ERROR;
+    }
+
+    flash_lock();
+
+    return status;
+}
+
+/**
+ * @brief  选出当前扇区并顺序扫描一次, 建立键索引和日志尾
+ * @param  None
+ * @retval None
+ */
+static void config_scan(void)
+{
+    uint32_t base, end, addr, header, size;
+    uint32_t seq;
+    uint8_t n, key, len;
+
+    config_active = CONFIG_SECTOR_NONE;
+    config_seq = 0;
+    config_tail_dirty = 0;
+
+    for(key = 0; key < CONFIG_KEY_NUM; key++)
+    {
+        config_index[key] = 0;
+    }
+
+    for(n = 0; n < 2; n++)
+    {
+        base = CONFIG_SECTOR_ADDR(n);
+        seq = CONFIG_WORD(base + 4);
+        if((CONFIG_WORD(base) == CONFIG_SECTOR_MAGIC) && (seq != CONFIG_ERASED_WORD) &&
+           ((config_active == CONFIG_SECTOR_NONE) || (seq > config_seq)))
+        {
+            config_active = n;
+            config_seq = seq;
+        }
+    }
+
+    if(config_active == CONFIG_SECTOR_NONE)
+    {
+        return;
+    }
+
+    base = CONFIG_SECTOR_ADDR(config_active);
+    end = base + CONFIG_SECTOR_SIZE;
+    addr = base + CONFIG_SECTOR_HEADER;
+
+    while(addr + 4 <= end)
+    {
+        header = CONFIG_WORD(addr);
+        if(header == CONFIG_ERASED_WORD)
+        {
+            break;
+        }
+
+        key = (uint8_t)header;
+        len = (uint8_t)(header >> 8);
+        size = CONFIG_RECORD_SIZE(len);
+
+        /* 记录头本身损坏, 无法继续定位后面的记录 */
+        if((len > CONFIG_VALUE_MAX) || (addr + size > end))
+        {
+            config_tail_dirty = 1;
+            break;
+        }
+
+        if((key < CONFIG_KEY_NUM) &&
+           ((uint16_t)(header >> 16) == config_crc16(key, len, (const uint8_t*)(addr + 4))))
+        {
+            config_index[key] = addr;
+        }
+
+        addr += size;
+    }
+
+    config_tail = addr;
+}
+
+/**
+ * @brief  整理: 擦除备用扇区, 逐条复制各键最新值, 最后写扇区头提交
+ * @note   每次调用只做一步; 擦除期间主循环停顿 (中断照常), 只在RS485总线空闲时进行
+ * @param  None
+ * @retval None
+ */
+static void config_compact_step(void)
+{
+    error_status status;
+    const uint8_t* data;
+    uint8_t len;
+    uint8_t key;
+
+    switch(config_state)
+    {
+        case CONFIG_STATE_ERASE:
+            if(!rs485_line_idle())
+            {
+                return;
+            }
+
+            config_target = (config_active == 0) ? 1 : 0;
+
+            /* 主循环在擦除期间停顿, 仍只在总线空闲时开始, 避免推迟回复.
+               先把magic写0作废备用扇区: 擦除中途掉电时部分位已变为1, 旧序号可能变大,
+               magic仍完整就会被选为当前扇区 */
+            flash_unlock();
+            flash_word_program(CONFIG_SECTOR_ADDR(config_target), 0);
+            status = flash_if_erase(CONFIG_SECTOR_ADDR(config_target));
+            flash_lock();
+
+            /* 未擦除时下次调用重试, 当前扇区不受影响 */
+            if(status != SUCCESS)
+            {
+                return;
+            }
+
+            for(key = 0; key < CONFIG_KEY_NUM; key++)
+            {
+                config_new_index[key] = 0;
+            }
+            config_copy_key = 0;
+            config_copy_tail = CONFIG_SECTOR_ADDR(config_target) + CONFIG_SECTOR_HEADER;
+            config_state = CONFIG_STATE_COPY;
+            break;
+
+        case CONFIG_STATE_COPY:
+            for(key = config_copy_key; key < CONFIG_KEY_NUM; key++)
+            {
+                if((config_pending_mask & (1UL << key)) || (config_index[key] != 0))
+                {
+                    break;
+                }
+            }
+
+            if(key >= CONFIG_KEY_NUM)
+            {
+                config_state = CONFIG_STATE_COMMIT;
+                return;
+            }
+
+            if(config_pending_mask & (1UL << key))
+            {
+                data = config_pending_data[key];
+                len = config_pending_len[key];
+            }
+            else
+            {
+                data = (const uint8_t*)(config_index[key] + 4);
+                len = (uint8_t)(CONFIG_WORD(config_index[key]) >> 8);
+            }
+
+            if(config_record_write(config_copy_tail, key, data, len) != SUCCESS)
+            {
+                config_state = CONFIG_STATE_ERASE;
+                return;
+            }
+
+            config_pending_mask &= ~(1UL << key);
+            config_new_index[key] = config_copy_tail;
+            config_copy_tail += CONFIG_RECORD_SIZE(len);
+            config_copy_key = key + 1;
+            break;
+
+        case CONFIG_STATE_COMMIT:
+            flash_unlock();
+            flash_word_program(CONFIG_SECTOR_ADDR(config_target) + 4, config_seq + 1);
+            flash_word_program(CONFIG_SECTOR_ADDR(config_target), CONFIG_SECTOR_MAGIC);
+            flash_lock();
+
+            config_active = config_target;
+            config_seq++;
+            config_tail = config_copy_tail;
+            config_tail_dirty = 0;
+            for(key = 0; key < CONFIG_KEY_NUM; key++)
+            {
+                config_index[key] = config_new_index[key];
+            }
+            config_state = CONFIG_STATE_IDLE;
+            break;
+
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief  配置存储初始化: 扫描日志建立索引 (不擦写Flash)
+ * @param  None
+ * @retval None
+ */
+void config_store_init(void)
+{
+    config_pending_mask = 0;
+    config_state = CONFIG_STATE_IDLE;
+
+    config_scan();
+}
+
+/**
+ * @brief  读取配置项 (未写入Flash的新值优先)
+ * @param  key: 键
+ * @param  value: 输出缓冲区
+ * @param  len: 期望长度
+ * @retval SUCCESS: 存在且长度一致, ERROR: 不存在
+ */
+error_status config_get(config_key_t key, void* value, uint8_t len)
+{
+    const uint8_t* data;
+    uint32_t addr;
+    uint8_t i;
+
+    if(key >= CONFIG_KEY_NUM)
+    {
+        return ERROR;
+    }
+
+    if(config_pending_mask & (1UL << key))
+    {
+        if(config_pending_len[key] != len)
+        {
+            return ERROR;
+        }
+        data = config_pending_data[key];
+    }
+    else
+    {
+        /* 整理过程中已复制的键以新扇区为准 */
+        addr = config_index[key];
+        if((config_state == CONFIG_STATE_COPY) || (config_state == CONFIG_STATE_COMMIT))
+        {
+            if(config_new_index[key] != 0)
+            {
+                addr = config_new_index[key];
+            }
+        }
+
+        if((addr == 0) || ((uint8_t)(CONFIG_WORD(addr) >> 8) != len))
+        {
+            return ERROR;
+        }
+        data = (const uint8_t*)(addr + 4);
+    }
+
+    for(i = 0; i < len; i++)
+    {
+        ((uint8_t*)value)[i] = data[i];
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief  写入配置项 (异步, 由 config_store_poll 写入Flash)
+ * @note   只在主循环中调用; 与当前值相同时不产生写入
+ * @param  key: 键
+ * @param  value: 数据
+ * @param  len: 长度 (须等于 config_key_size)
+ * @retval SUCCESS/ERROR
+ */
+error_status config_set(config_key_t key, const void* value, uint8_t len)
+{
+    uint8_t current[CONFIG_VALUE_MAX];
+    uint8_t i;
+
+    if((key >= CONFIG_KEY_NUM) || (len != config_key_sizes[key]))
+    {
+        return ERROR;
+    }
+
+    if(config_get(key, current, len) == SUCCESS)
+    {
+        for(i = 0; i < len; i++)
+        {
+            if(current[i] != ((const uint8_t*)value)[i])
+            {
+                break;
+            }
+        }
+
+        if(i == len)
+        {
+            return SUCCESS;
+        }
+    }
+
+    for(i = 0; i < len; i++)
+    {
+        config_pending_data[key][i] = ((const uint8_t*)value)[i];
+    }
+    config_pending_len[key] = len;
+    config_pending_mask |= (1UL << key);
+
+    return SUCCESS;
+}
+
+/**
+ * @brief  获取配置项的长度
+ * @param  key: 键
+ * @retval 长度 (字节), 键无效时返回0
+ */
+uint8_t config_key_size(config_key_t key)
+{
+    if(key >= CONFIG_KEY_NUM)
+    {
+        return 0;
+    }
+
+    return config_key_sizes[key];
+}
+
+/**
+ * @brief  后台写入/整理, 在主循环中调用
+ * @note   每次调用最多写一条记录或执行一步整理
+ * @param  None
+ * @retval None
+ */
+void config_store_poll(void)
+{
+    uint32_t size;
+    uint8_t key;
+
+    if(config_state != CONFIG_STATE_IDLE)
+    {
+        config_compact_step();
+        return;
+    }
+
+    if(config_pending_mask == 0)
+    {
+        return;
+    }
+
+    for(key = 0; !(config_pending_mask & (1UL << key)); key++);
+    size = CONFIG_RECORD_SIZE(config_pending_len[key]);
+
+    /* 无有效扇区、尾部损坏或空间不足时先整理 */
+    if((config_active == CONFIG_SECTOR_NONE) || config_tail_dirty ||
+       (config_tail + size > CONFIG_SECTOR_ADDR(config_active) + CONFIG_SECTOR_SIZE) ||
+       !config_region_erased(config_tail, size))
+    {
+        config_state = CONFIG_STATE_ERASE;
+        return;
+    }
+
+    if(config_record_write(config_tail, key, config_pending_data[key], config_pending_len[key]) != SUCCESS)
+    {
+        config_tail_dirty = 1;
+        return;
+    }
+
+    config_index[key] = config_tail;
+    config_tail += size;
+    config_pending_mask &= ~(1UL << key);
+}
+
+/**
+ * @brief  是否有尚未写入Flash的配置
+ * @param  None
+ * @retval 1: 有, 0: 无
+ */
+uint8_t config_store_busy(void)
+{
+    return ((config_pending_mask != 0) || (config_state != CONFIG_STATE_IDLE)) ? 1 : 0;
+}
@@ -0,0 +1,93 @@
+/**
+ * @file config_store.h
+ * @brief 内部Flash配置存储模块头文件
+ * @author Jason
+ * @date 2026-10-18
+ */
+
+#ifndef __CONFIG_STORE_H
+#define __CONFIG_STORE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "at32f403a_407.h"
+
+/* Exported types ------------------------------------------------------------*/
+/**
+ * @brief  配置项键值 (值为小端)
+ */
+typedef enum
+{
+    CONFIG_KEY_NODE_ADDRESS = 0,    /*!< u8  RS485本机地址 */
+    CONFIG_KEY_ADDR_MODE,           /*!< u8  RS485寻址模式 */
+    CONFIG_KEY_BAUDRATE,            /*!< u32 RS485波特率 */
+    CONFIG_KEY_DISPLAY_ADDRESS,     /*!< u8  显示板I2C地址 */
+    CONFIG_KEY_BUZZER_VOLUME,       /*!< u8  蜂鸣器音量 (占空比 0-100) */
+    CONFIG_KEY_ALARM_FREQ_LOW,      /*!< u32 报警低音频率 (Hz) */
+    CONFIG_KEY_ALARM_FREQ_HIGH,     /*!< u32 报警高音频率 (Hz) */
+    CONFIG_KEY_ALARM_PERIOD,        /*!< u16 报警每个音的时长 (ms) */
+    CONFIG_KEY_I2C_SPEED,           /*!< 8x{总线<<7|地址, 速率档} 显示设备I2C速率 (地址0为空项) */
+    CONFIG_KEY_NUM
+} config_key_t;
+
+/* Exported constants --------------------------------------------------------*/
+/* 单个配置值最大长度 */
+#define CONFIG_VALUE_MAX            16
+
+/* Exported macro ------------------------------------------------------------*/
+/* Exported functions prototypes ---------------------------------------------*/
+
+/**
+ * @brief  配置存储初始化: 扫描日志建立索引 (不擦写Flash)
+ * @param  None
+ * @retval None
+ */
+void config_store_init(void);
+
+/**
+ * @brief  读取配置项 (未写入Flash的新值优先)
+ * @param  key: 键
+ * @param  value: 输出缓冲区
+ * @param  len: 期望长度
+ * @retval SUCCESS: 存在且长度一致, ERROR: 不存在
+ */
+error_status config_get(config_key_t key, void* value, uint8_t len);
+
+/**
+ * @brief  写入配置项 (异步, 由 config_store_poll 写入Flash)
+ * @param  key: 键
+ * @param  value: 数据
+ * @param  len: 长度 (须等于 config_key_size)
+ * @retval SUCCESS/ERROR
+ */
+error_status config_set(config_key_t key, const void* value, uint8_t len);
+
+/**
+ * @brief  获取配置项的长度
+ * @param  key: 键
+ * @retval 长度 (字节), 键无效时返回0
+ */
+uint8_t config_key_size(config_key_t key);
+
+/**
+ * @brief  后台写入/整理, 在主循环中调用
+ * @param  None
+ * @retval None
+ */
+void config_store_poll(void);
+
+/**
+ * @brief  是否有尚未写入Flash的配置
+ * @param  None
+ * @retval 1: 有, 0: 无
+ */
+uint8_t config_store_busy(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CONFIG_STORE_H */
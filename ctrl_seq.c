@@ -0,0 +1,442 @@
+/**
+ * @file ctrl_seq.c
+ * @brief 显示板控制引脚波形模块实现
+ * @author Jason
+ * @date 2026-10-18
+ *
+ * 波形由TMR6按步计时: 每次更新事件由DMA把下一步的置位/复位字写入 GPIOB->scr,
+ * 引脚翻转时刻只取决于定时器, 与主循环和其他中断无关. 各步时间不同, 更新中断把
+ * 再下一步的周期写入预装载寄存器 (在本步结束时生效), 所以中断只需在一步之内执行完.
+ * DMA缓冲区按步骤错开一位循环: 第k次更新写入第k+1步, 最后一次写入第0步 (重复)
+ * 或0 (不改变引脚, 结束). 背光调光用TMR4_CH3/CH4硬件PWM.
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "ctrl_seq.h"
+#include "main.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private define ------------------------------------------------------------*/
+#define CTRL_SEQ_COUNT_FREQ         1000000     // 定时器计数频率 1MHz, 1步时间单位为1us
+#define CTRL_SEQ_SCR_NONE           0           // 置位/复位字为0时不改变引脚
+
+/* Private macro -------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+DMA_BUFFER static uint32_t ctrl_seq_dma_buf[CTRL_SEQ_MAX_STEPS];
+static uint32_t ctrl_seq_scr[CTRL_SEQ_MAX_STEPS];
+static uint16_t ctrl_seq_period[CTRL_SEQ_MAX_STEPS];
+static uint8_t ctrl_seq_count = 0;
+static __IO uint8_t ctrl_seq_index = 0;         // 正在输出的步
+static __IO uint16_t ctrl_seq_repeat = 0;       // 剩余次数 (含本次), 0为一直重复
+static __IO uint8_t ctrl_seq_active = 0;
+static uint8_t ctrl_seq_pins = 0;               // 正在播放的波形驱动的引脚
+
+/* PWM占空比 (0.1%), 0或满量程时引脚为GPIO输出 */
+static uint16_t ctrl_pwm_duty[2] = {0, 0};
+
+/* Private function prototypes -----------------------------------------------*/
+static uint32_t ctrl_seq_tmr_clk(void);
+static uint32_t ctrl_seq_pin_bits(uint8_t pins);
+static void ctrl_seq_pin_mode(uint8_t pins, gpio_mode_type mode);
+static void ctrl_seq_halt(void);
+static void ctrl_pwm_apply(uint8_t n);
+static error_status ctrl_seq_clock_notify(clock_event_t event, clock_profile_t profile);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief  APB1定时器时钟
+ * @note   APB1分频不为1时, 定时器时钟为APB1的2倍
+ * @param  None
+ * @retval 时钟频率 (Hz)
+ */
+static uint32_t ctrl_seq_tmr_clk(void)
+{
+    crm_clocks_freq_type clocks;
+    uint32_t tmr_clk;
+
+    crm_clocks_freq_get(&clocks);
+
+    tmr_clk = clocks.apb1_freq;
+    if(clocks.apb1_freq != clocks.ahb_freq)
+    {
+        tmr_clk *= 2;
+    }
+
+    return tmr_clk;
+}
+
+/**
+ * @brief  引脚位转换为GPIO引脚
+ * @param  pins: CTRL_SEQ_PIN1/CTRL_SEQ_PIN2 的组合
+ * @retval GPIO_PINS_x 的组合
+ */
+static uint32_t ctrl_seq_pin_bits(uint8_t pins)
+{
+    return ((pins & CTRL_SEQ_PIN1) ? DISPLAY_CTRL1_GPIO_PIN : 0) |
+           ((pins & CTRL_SEQ_PIN2) ? DISPLAY_CTRL2_GPIO_PIN : 0);
+}
+
+/**
+ * @brief  切换引脚模式 (GPIO输出 / 定时器PWM输出)
+ * @param  pins: CTRL_SEQ_PIN1/CTRL_SEQ_PIN2 的组合
+ * @param  mode: GPIO_MODE_OUTPUT/GPIO_MODE_MUX
+ * @retval None
+ */
+static void ctrl_seq_pin_mode(uint8_t pins, gpio_mode_type mode)
+{
+    gpio_init_type gpio_init_struct;
+
+    gpio_default_para_init(&gpio_init_struct);
+    gpio_init_struct.gpio_drive_strength = GPIO_DRIVE_STRENGTH_STRONGER;
+    gpio_init_struct.gpio_out_type = GPIO_OUTPUT_PUSH_PULL;
+    gpio_init_struct.gpio_pull = GPIO_PULL_NONE;
+    gpio_init_struct.gpio_mode = mode;
+    gpio_init_struct.gpio_pins = ctrl_seq_pin_bits(pins);
+    gpio_init(DISPLAY_CTRL1_GPIO_PORT, &gpio_init_struct);
+}
+
+/**
+ * @brief  停止定时器和DMA (可在中断中调用)
+ * @param  None
+ * @retval None
+ */
+static RAMFUNC void ctrl_seq_halt(void)
+{
+    CTRL_SEQ_TMR->ctrl1_bit.tmren = FALSE;
+    CTRL_SEQ_DMA_CHANNEL->ctrl_bit.chen = FALSE;
+    ctrl_seq_active = 0;
+    ctrl_seq_pins = 0;
+}
+
+/**
+ * @brief  按占空比设置一个引脚的PWM或固定电平
+ * @param  n: 0为CTRL1, 1为CTRL2
+ * @retval None
+ */
+static void ctrl_pwm_apply(uint8_t n)
+{
+    uint8_t pin = (n == 0) ? CTRL_SEQ_PIN1 : CTRL_SEQ_PIN2;
+    tmr_channel_select_type channel = (n == 0) ? CTRL_PWM_TMR_CHANNEL1 : CTRL_PWM_TMR_CHANNEL2;
+    uint32_t period = tmr_period_value_get(CTRL_PWM_TMR) + 1;
+    uint16_t duty = ctrl_pwm_duty[n];
+
+    if((duty == 0) || (duty >= CTRL_PWM_DUTY_MAX))
+    {
+        tmr_channel_value_set(CTRL_PWM_TMR, channel, 0);
+        if(duty == 0)
+        {
+            gpio_bits_reset(DISPLAY_CTRL1_GPIO_PORT, ctrl_seq_pin_bits(pin));
+        }
+        else
+        {
+            gpio_bits_set(DISPLAY_CTRL1_GPIO_PORT, ctrl_seq_pin_bits(pin));
+        }
+        ctrl_seq_pin_mode(pin, GPIO_MODE_OUTPUT);
+        return;
+    }
+
+    /* 比较值在下一个PWM周期生效, 改变占空比时没有毛刺 */
+    tmr_channel_value_set(CTRL_PWM_TMR, channel, period * duty / CTRL_PWM_DUTY_MAX);
+    ctrl_seq_pin_mode(pin, GPIO_MODE_MUX);
+}
+
+/**
+ * @brief  系统时钟切换通知
+ * @note   播放中否决切换 (分频改变会拉长或缩短当前步); 切换后重算分频和PWM周期
+ * @param  event: 通知事件
+ * @param  profile: 目标档位
+ * @retval SUCCESS/ERROR
+ */
+static error_status ctrl_seq_clock_notify(clock_event_t event, clock_profile_t profile)
+{
+    uint32_t tmr_clk;
+
+    if(event == CLOCK_EVENT_PRE_CHANGE)
+    {
+        return ctrl_seq_active ? ERROR : SUCCESS;
+    }
+
+    if(event != CLOCK_EVENT_POST_CHANGE)
+    {
+        return SUCCESS;
+    }
+
+    /* 波形定时器的分频值在下次播放开始时由软件更新事件装载 */
+    tmr_clk = ctrl_seq_tmr_clk();
+    tmr_div_value_set(CTRL_SEQ_TMR, tmr_clk / CTRL_SEQ_COUNT_FREQ - 1);
+    tmr_period_value_set(CTRL_PWM_TMR, tmr_clk / CTRL_PWM_FREQ - 1);
+    ctrl_pwm_apply(0);
+    ctrl_pwm_apply(1);
+
+    return SUCCESS;
+}
+
+/**
+ * @brief  控制引脚波形初始化 (定时器、DMA、PWM)
+ * @note   分频值由当前时钟计算, 在切换到PLL之后调用
+ * @param  None
+ * @retval None
+ */
+void ctrl_seq_init(void)
+{
+    tmr_base_init_type tmr_base_struct;
+    tmr_output_config_type tmr_output_struct;
+    dma_init_type dma_init_struct;
+    uint32_t tmr_clk = ctrl_seq_tmr_clk();
+
+    crm_periph_clock_enable(CTRL_SEQ_TMR_CLK, TRUE);
+    crm_periph_clock_enable(CTRL_PWM_TMR_CLK, TRUE);
+    crm_periph_clock_enable(CTRL_SEQ_DMA_CLK, TRUE);
+
+    /* 波形定时器: 1MHz计数, 更新事件请求DMA (播放时使能) */
+    tmr_base_default_para_init(&tmr_base_struct);
+    tmr_base_struct.tmr_count_direction = TMR_COUNT_UP;
+    tmr_base_struct.tmr_period = CTRL_SEQ_STEP_MIN_US - 1;
+    tmr_base_struct.tmr_div = tmr_clk / CTRL_SEQ_COUNT_FREQ - 1;
+    tmr_base_init(CTRL_SEQ_TMR, &tmr_base_struct);
+    tmr_flag_clear(CTRL_SEQ_TMR, TMR_OVF_FLAG);
+    tmr_interrupt_enable(CTRL_SEQ_TMR, TMR_OVF_INT, TRUE);
+
+    /* DMA: 循环模式, 字宽写入 GPIOB->scr */
+    dma_flexible_config(CTRL_SEQ_DMA, CTRL_SEQ_DMA_FLEX_CHANNEL, CTRL_SEQ_DMA_REQUEST);
+    dma_reset(CTRL_SEQ_DMA_CHANNEL);
+    dma_default_para_init(&dma_init_struct);
+    dma_init_struct.buffer_size = 0;
+    dma_init_struct.direction = DMA_DIR_MEMORY_TO_PERIPHERAL;
+    dma_init_struct.memory_base_addr = (uint32_t)ctrl_seq_dma_buf;
+    dma_init_struct.memory_data_width = DMA_MEMORY_DATA_WIDTH_WORD;
+    dma_init_struct.memory_inc_enable = TRUE;
+    dma_init_struct.peripheral_base_addr = (uint32_t)&DISPLAY_CTRL1_GPIO_PORT->scr;
+    dma_init_struct.peripheral_data_width = DMA_PERIPHERAL_DATA_WIDTH_WORD;
+    dma_init_struct.peripheral_inc_enable = FALSE;
+    dma_init_struct.priority = DMA_PRIORITY_VERY_HIGH;
+    dma_init_struct.loop_mode_enable = TRUE;
+    dma_init(CTRL_SEQ_DMA_CHANNEL, &dma_init_struct);
+
+    /* PWM定时器: 不分频, CTRL_PWM_FREQ, 比较值预装载 */
+    tmr_base_default_para_init(&tmr_base_struct);
+    tmr_base_struct.tmr_count_direction = TMR_COUNT_UP;
+    tmr_base_struct.tmr_period = tmr_clk / CTRL_PWM_FREQ - 1;
+    tmr_base_struct.tmr_div = 0;
+    tmr_base_init(CTRL_PWM_TMR, &tmr_base_struct);
+
+    tmr_output_default_para_init(&tmr_output_struct);
+    tmr_output_struct.oc_mode = TMR_OUTPUT_CONTROL_PWM_MODE_A;
+    tmr_output_struct.oc_output_state = TRUE;
+    tmr_output_struct.oc_polarity = TMR_OUTPUT_ACTIVE_HIGH;
+    tmr_output_struct.oc_idle_state = FALSE;
+    tmr_output_channel_config(CTRL_PWM_TMR, CTRL_PWM_TMR_CHANNEL1, &tmr_output_struct);
+    tmr_output_channel_config(CTRL_PWM_TMR, CTRL_PWM_TMR_CHANNEL2, &tmr_output_struct);
+    tmr_output_channel_buffer_enable(CTRL_PWM_TMR, CTRL_PWM_TMR_CHANNEL1, TRUE);
+    tmr_output_channel_buffer_enable(CTRL_PWM_TMR, CTRL_PWM_TMR_CHANNEL2, TRUE);
+    tmr_channel_value_set(CTRL_PWM_TMR, CTRL_PWM_TMR_CHANNEL1, 0);
+    tmr_channel_value_set(CTRL_PWM_TMR, CTRL_PWM_TMR_CHANNEL2, 0);
+    tmr_counter_enable(CTRL_PWM_TMR, TRUE);
+
+    clock_profile_register(ctrl_seq_clock_notify);
+}
+
+/**
+ * @brief  开始播放波形
+ * @note   步骤复制到模块内部, 调用后立即返回; 之后各步的引脚电平和时间由定时器和DMA产生.
+ *         掩码中的引脚若在输出PWM则先切回GPIO输出
+ * @param  steps: 步骤
+ * @param  count: 步数 (1~CTRL_SEQ_MAX_STEPS)
+ * @param  repeat: 重复次数, CTRL_SEQ_REPEAT_FOREVER 为一直重复
+ * @retval SUCCESS/ERROR (正在播放或参数错误)
+ */
+error_status ctrl_seq_play(const ctrl_seq_step_t* steps, uint8_t count, uint16_t repeat)
+{
+    uint8_t pins = 0;
+    uint8_t i;
+    uint16_t duration;
+
+    if(ctrl_seq_active || (count == 0) || (count > CTRL_SEQ_MAX_STEPS))
+    {
+        return ERROR;
+    }
+
+    for(i = 0; i < count; i++)
+    {
+        duration = (steps[i].duration_us < CTRL_SEQ_STEP_MIN_US) ? CTRL_SEQ_STEP_MIN_US : steps[i].duration_us;
+        ctrl_seq_period[i] = duration - 1;
+        ctrl_seq_scr[i] = ctrl_seq_pin_bits(steps[i].mask & steps[i].level) |
+                          (ctrl_seq_pin_bits(steps[i].mask & ~steps[i].level) << 16);
+        pins |= steps[i].mask & CTRL_SEQ_PIN_ALL;
+    }
+
+    /* 第k次更新事件写入第k+1步, 最后一次写入第0步 */
+    for(i = 0; i < count; i++)
+    {
+        ctrl_seq_dma_buf[i] = ctrl_seq_scr[(i + 1 < count) ? (i + 1) : 0];
+    }
+    if((count == 1) && (repeat == 1))
+    {
+        ctrl_seq_dma_buf[0] = CTRL_SEQ_SCR_NONE;
+    }
+
+    /* 被波形驱动的引脚停止PWM */
+    for(i = 0; i < 2; i++)
+    {
+        if((pins & (1 << i)) && (ctrl_pwm_duty[i] != 0) && (ctrl_pwm_duty[i] < CTRL_PWM_DUTY_MAX))
+        {
+            ctrl_pwm_duty[i] = 0;
+            tmr_channel_value_set(CTRL_PWM_TMR, (i == 0) ? CTRL_PWM_TMR_CHANNEL1 : CTRL_PWM_TMR_CHANNEL2, 0);
+        }
+    }
+    ctrl_seq_pin_mode(pins, GPIO_MODE_OUTPUT);
+
+    /*
+     * 第0步周期直接写入 (不经预装载), 软件更新事件装载分频值并清零计数器;
+     * 此时DMA请求关闭, 不会提前写入引脚. 第1步周期写入预装载, 在第0步结束时生效
+     */
+    NVIC_DisableIRQ(CTRL_SEQ_TMR_IRQ);
+    tmr_dma_request_enable(CTRL_SEQ_TMR, TMR_OVERFLOW_DMA_REQUEST, FALSE);
+    tmr_period_buffer_enable(CTRL_SEQ_TMR, FALSE);
+    tmr_period_value_set(CTRL_SEQ_TMR, ctrl_seq_period[0]);
+    tmr_event_sw_trigger(CTRL_SEQ_TMR, TMR_OVERFLOW_SWTRIG);
+    tmr_flag_clear(CTRL_SEQ_TMR, TMR_OVF_FLAG);
+    NVIC_ClearPendingIRQ(CTRL_SEQ_TMR_IRQ);
+    tmr_period_buffer_enable(CTRL_SEQ_TMR, TRUE);
+    tmr_period_value_set(CTRL_SEQ_TMR, ctrl_seq_period[(count > 1) ? 1 : 0]);
+
+    CTRL_SEQ_DMA_CHANNEL->ctrl_bit.chen = FALSE;
+    CTRL_SEQ_DMA_CHANNEL->maddr = (uint32_t)ctrl_seq_dma_buf;
+    CTRL_SEQ_DMA_CHANNEL->dtcnt = count;
+    CTRL_SEQ_DMA_CHANNEL->ctrl_bit.chen = TRUE;
+    tmr_dma_request_enable(CTRL_SEQ_TMR, TMR_OVERFLOW_DMA_REQUEST, TRUE);
+
+    ctrl_seq_count = count;
+    ctrl_seq_index = 0;
+    ctrl_seq_repeat = repeat;
+    ctrl_seq_pins = pins;
+    ctrl_seq_active = 1;
+    NVIC_EnableIRQ(CTRL_SEQ_TMR_IRQ);
+
+    /* 第0步由CPU写入, 与定时器启动相邻 */
+    DISPLAY_CTRL1_GPIO_PORT->scr = ctrl_seq_scr[0];
+    tmr_counter_enable(CTRL_SEQ_TMR, TRUE);
+
+    return SUCCESS;
+}
+
+/**
+ * @brief  停止播放, 引脚保持当前电平
+ * @param  None
+ * @retval None
+ */
+void ctrl_seq_stop(void)
+{
+    NVIC_DisableIRQ(CTRL_SEQ_TMR_IRQ);
+    ctrl_seq_halt();
+    NVIC_EnableIRQ(CTRL_SEQ_TMR_IRQ);
+}
+
+/**
+ * @brief  是否正在播放
+ * @param  None
+ * @retval 1: 播放中, 0: 空闲
+ */
+uint8_t ctrl_seq_busy(void)
+{
+    return ctrl_seq_active;
+}
+
+/**
+ * @brief  输出复位脉冲: 引脚拉低指定时间后拉高, 再等待稳定时间后结束
+ * @note   播放结束 (ctrl_seq_busy 返回0) 时显示板已完成上电复位
+ * @param  pin: CTRL_SEQ_PIN1/CTRL_SEQ_PIN2
+ * @param  low_us: 低电平时间 (us)
+ * @param  settle_us: 拉高后的等待时间 (us)
+ * @retval SUCCESS/ERROR
+ */
+error_status ctrl_seq_reset_pulse(uint8_t pin, uint16_t low_us, uint16_t settle_us)
+{
+    ctrl_seq_step_t steps[2];
+
+    steps[0].mask = pin;
+    steps[0].level = 0;
+    steps[0].duration_us = low_us;
+    steps[1].mask = pin;
+    steps[1].level = pin;
+    steps[1].duration_us = settle_us;
+
+    return ctrl_seq_play(steps, 2, 1);
+}
+
+/**
+ * @brief  设置引脚PWM占空比 (TMR4, CTRL_PWM_FREQ)
+ * @note   0 和 CTRL_PWM_DUTY_MAX 时引脚切回GPIO输出固定低/高电平
+ * @param  pin: CTRL_SEQ_PIN1/CTRL_SEQ_PIN2
+ * @param  duty: 占空比 (0.1%)
+ * @retval SUCCESS/ERROR (参数错误, 或该引脚正在播放波形)
+ */
+error_status ctrl_seq_pwm(uint8_t pin, uint16_t duty)
+{
+    uint8_t n;
+
+    if((pin != CTRL_SEQ_PIN1) && (pin != CTRL_SEQ_PIN2))
+    {
+        return ERROR;
+    }
+    if(ctrl_seq_pins & pin)
+    {
+        return ERROR;
+    }
+
+    n = (pin == CTRL_SEQ_PIN1) ? 0 : 1;
+    ctrl_pwm_duty[n] = (duty > CTRL_PWM_DUTY_MAX) ? CTRL_PWM_DUTY_MAX : duty;
+    ctrl_pwm_apply(n);
+
+    return SUCCESS;
+}
+
+/**
+ * @brief  波形定时器更新中断
+ * @note   此时DMA已写入新一步的引脚电平, 这里把再下一步的周期写入预装载寄存器;
+ *         最后一次重复的最后一步把DMA缓冲区末项改为不改变引脚, 结束时停止定时器
+ * @param  None
+ * @retval None
+ */
+RAMFUNC void CTRL_SEQ_TMR_IRQHandler(void)
+{
+    uint8_t next;
+
+    if(tmr_flag_get(CTRL_SEQ_TMR, TMR_OVF_FLAG) == RESET)
+    {
+        return;
+    }
+    tmr_flag_clear(CTRL_SEQ_TMR, TMR_OVF_FLAG);
+
+    if(!ctrl_seq_active)
+    {
+        return;
+    }
+
+    if(++ctrl_seq_index >= ctrl_seq_count)
+    {
+        if(ctrl_seq_repeat == 1)
+        {
+            ctrl_seq_halt();
+            return;
+        }
+        if(ctrl_seq_repeat != CTRL_SEQ_REPEAT_FOREVER)
+        {
+            ctrl_seq_repeat--;
+        }
+        ctrl_seq_index = 0;
+    }
+
+    next = ctrl_seq_index + 1;
+    if(next >= ctrl_seq_count)
+    {
+        next = 0;
+    }
+    CTRL_SEQ_TMR->pr = ctrl_seq_period[next];
+
+    if((next == 0) && (ctrl_seq_repeat == 1))
+    {
+        ctrl_seq_dma_buf[ctrl_seq_count - 1] = CTRL_SEQ_SCR_NONE;
+    }
+}
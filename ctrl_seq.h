@@ -0,0 +1,112 @@
+/**
+ * @file ctrl_seq.h
+ * @brief 显示板控制引脚波形模块头文件 (定时器DMA写GPIO置位/复位寄存器, 定时器PWM)
+ * @author Jason
+ * @date 2026-10-18
+ */
+
+#ifndef __CTRL_SEQ_H
+#define __CTRL_SEQ_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "at32f403a_407.h"
+
+/* Exported types ------------------------------------------------------------*/
+/**
+ * @brief  波形的一步: 把掩码中的引脚设为对应电平并保持指定时间
+ */
+typedef struct
+{
+    uint8_t mask;                   /*!< 本步驱动的引脚 (CTRL_SEQ_PIN1/CTRL_SEQ_PIN2), 其余引脚不变 */
+    uint8_t level;                  /*!< 电平, 位定义同掩码 */
+    uint16_t duration_us;           /*!< 保持时间 (us), 不小于 CTRL_SEQ_STEP_MIN_US */
+} ctrl_seq_step_t;
+
+/* Exported constants --------------------------------------------------------*/
+/* 引脚位 (与 B1 命令相同) */
+#define CTRL_SEQ_PIN1               0x01    /*!< CTRL1 (PB8, TMR4_CH3) */
+#define CTRL_SEQ_PIN2               0x02    /*!< CTRL2 (PB9, TMR4_CH4) */
+#define CTRL_SEQ_PIN_ALL            (CTRL_SEQ_PIN1 | CTRL_SEQ_PIN2)
+
+/* 波形最多步数 */
+#define CTRL_SEQ_MAX_STEPS          32
+
+/*
+ * 每步最短时间 (us): 引脚电平由DMA在定时器更新事件时写入, 与CPU无关;
+ * 下一步的周期由更新中断写入预装载寄存器, 须在本步结束前完成
+ */
+#define CTRL_SEQ_STEP_MIN_US        5
+
+/* 重复次数: 0为一直重复到 ctrl_seq_stop */
+#define CTRL_SEQ_REPEAT_FOREVER     0
+
+/* PWM频率 (Hz), 高于可闻范围, 背光调光无闪烁 */
+#define CTRL_PWM_FREQ               20000
+
+/* 占空比满量程 (0.1%) */
+#define CTRL_PWM_DUTY_MAX           1000
+
+/* Exported macro ------------------------------------------------------------*/
+/* Exported functions prototypes ---------------------------------------------*/
+
+/**
+ * @brief  控制引脚波形初始化 (定时器、DMA、PWM)
+ * @note   分频值由当前时钟计算, 在切换到PLL之后调用
+ * @param  None
+ * @retval None
+ */
+void ctrl_seq_init(void);
+
+/**
+ * @brief  开始播放波形
+ * @note   步骤复制到模块内部, 调用后立即返回; 之后各步的引脚电平和时间由定时器和DMA产生.
+ *         掩码中的引脚若在输出PWM则先切回GPIO输出
+ * @param  steps: 步骤
+ * @param  count: 步数 (1~CTRL_SEQ_MAX_STEPS)
+ * @param  repeat: 重复次数, CTRL_SEQ_REPEAT_FOREVER 为一直重复
+ * @retval SUCCESS/ERROR (正在播放或参数错误)
+ */
+error_status ctrl_seq_play(const ctrl_seq_step_t* steps, uint8_t count, uint16_t repeat);
+
+/**
+ * @brief  停止播放, 引脚保持当前电平
+ * @param  None
+ * @retval None
+ */
+void ctrl_seq_stop(void);
+
+/**
+ * @brief  是否正在播放
+ * @param  None
+ * @retval 1: 播放中, 0: 空闲
+ */
+uint8_t ctrl_seq_busy(void);
+
+/**
+ * @brief  输出复位脉冲: 引脚拉低指定时间后拉高, 再等待稳定时间后结束
+ * @note   播放结束 (ctrl_seq_busy 返回0) 时显示板已完成上电复位
+ * @param  pin: CTRL_SEQ_PIN1/CTRL_SEQ_PIN2
+ * @param  low_us: 低电平时间 (us)
+ * @param  settle_us: 拉高后的等待时间 (us)
+ * @retval SUCCESS/ERROR
+ */
+error_status ctrl_seq_reset_pulse(uint8_t pin, uint16_t low_us, uint16_t settle_us);
+
+/**
+ * @brief  设置引脚PWM占空比 (TMR4, CTRL_PWM_FREQ)
+ * @note   0 和 CTRL_PWM_DUTY_MAX 时引脚切回GPIO输出固定低/高电平
+ * @param  pin: CTRL_SEQ_PIN1/CTRL_SEQ_PIN2
+ * @param  duty: 占空比 (0.1%)
+ * @retval SUCCESS/ERROR (参数错误, 或该引脚正在播放波形)
+ */
+error_status ctrl_seq_pwm(uint8_t pin, uint16_t duty);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CTRL_SEQ_H */
@@ -0,0 +1,883 @@
+/**
+ * @file display_dev.c
+ * @brief 显示设备模块实现
+ * @author Jason
+ * @date 2026-10-18
+ *
+ * 每个显示屏有自己的帧缓冲区、脏区范围和驱动. 写入方修改帧缓冲区后提交, 仲裁在主循环中
+ * 为每条空闲的I2C总线选一个设备刷新一块 (DMA写传输): 已过期限的设备优先, 其次按优先级,
+ * 同优先级按期限先后. 大屏的整屏刷新分成多块, 期间同一总线上小屏 (状态矩阵) 的更新可以
+ * 插入, 不必等大屏刷完; 不同总线上的设备同时刷新.
+ *
+ * 每个设备有自己的I2C速率档, 仲裁在对设备操作前把所在总线切换到该速率. 速率探测从低到高
+ * 逐档写入测试数据并校验, 在第一个失败的档位退回上一档, 结果按 总线+地址 保存到配置存储.
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "display_dev.h"
+#include "main.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/**
+ * @brief  I2C速率档
+ */
+typedef struct
+{
+    uint32_t speed;                 /*!< 速率 (Hz) */
+    i2c_clock_duty_type duty;       /*!< 优先采用的占空比, 分频取整误差过大时换另一种 */
+} display_speed_step_t;
+
+/* Private define ------------------------------------------------------------*/
+/* SSD1306: 控制字节, 刷新窗口命令 */
+#define SSD1306_CTRL_CMD            0x00
+#define SSD1306_CTRL_DATA           0x40
+#define SSD1306_ADDR_MODE           0x20
+#define SSD1306_COLUMN_ADDR         0x21
+#define SSD1306_PAGE_ADDR           0x22
+#define SSD1306_HORIZONTAL          0x00
+#define SSD1306_WINDOW_CMD_SIZE     8
+#define SSD1306_NOP                 0xE3
+
+/* HT16K33: 单字节命令 (作为寄存器地址发送, 无数据) */
+#define HT16K33_OSC_ON              0x21
+#define HT16K33_DISPLAY_ON          0x81
+#define HT16K33_DIMMING_MAX         0xEF
+
+/* 速率探测每次校验的数据长度 */
+#define DISPLAY_VERIFY_SIZE         16
+
+/* 速率配置项: 项数, 每项 总线<<7|地址, 速率档 */
+#define DISPLAY_SPEED_ENTRIES       8
+
+/* Private macro -------------------------------------------------------------*/
+#define DISPLAY_SPEED_KEY(dev)      ((uint8_t)(((dev)->bus_id << 7) | (dev)->address))
+
+/* Private variables ---------------------------------------------------------*/
+/* SSD1306 128x64 初始化命令: 关显示, 时钟, 64行, 偏移0, 起始行0, 电荷泵, 水平寻址,
+ * 列/行翻转, COM配置, 对比度, 预充电, VCOMH, 按RAM显示, 正常显示, 开显示 */
+static uint8_t ssd1306_init_cmds[] =
+{
+    0xAE, 0xD5, 0x80, 0xA8, 0x3F, 0xD3, 0x00, 0x40, 0x8D, 0x14, 0x20, 0x00, 0xA1, 0xC8,
+    0xDA, 0x12, 0x81, 0xCF, 0xD9, 0xF1, 0xDB, 0x40, 0xA4, 0xA6, 0xAF
+};
+
+/* 速率档: 快速模式以上优先2:1占空比 (APB1 120MHz/48MHz下分频取整误差小) */
+static const display_speed_step_t display_speed_steps[DISPLAY_SPEED_STEP_COUNT] =
+{
+    { I2C_SPEED_STANDARD, I2C_CLOCK_DUTY_2 },
+    { I2C_SPEED_FAST,     I2C_CLOCK_DUTY_2 },
+    { 600000,             I2C_CLOCK_DUTY_2 },
+    { 800000,             I2C_CLOCK_DUTY_2 },
+    { I2C_SPEED_MAX,      I2C_CLOCK_DUTY_2 },
+};
+
+DMA_BUFFER static uint8_t display_oled_fb[DISPLAY_OLED_WIDTH * DISPLAY_OLED_PAGES];
+DMA_BUFFER static uint8_t display_matrix_fb[DISPLAY_MATRIX_SIZE];
+
+static uint32_t display_rate_tick = 0;
+static uint32_t display_probe_tick = 0;
+static uint8_t display_started = 0;
+
+/* Private function prototypes -----------------------------------------------*/
+static error_status ssd1306_init(display_dev_t* dev);
+static error_status ssd1306_flush(display_dev_t* dev, uint8_t block, uint8_t lo, uint8_t hi);
+static error_status ssd1306_verify(display_dev_t* dev, uint8_t round, uint16_t* bytes);
+static error_status ht16k33_init(display_dev_t* dev);
+static error_status ht16k33_flush(display_dev_t* dev, uint8_t block, uint8_t lo, uint8_t hi);
+static error_status ht16k33_verify(display_dev_t* dev, uint8_t round, uint16_t* bytes);
+static error_status display_dev_apply_speed(display_dev_t* dev, uint8_t step);
+static void display_dev_select(display_dev_t* dev);
+static uint8_t display_dev_speed_load(const display_dev_t* dev);
+static void display_dev_speed_save(const display_dev_t* dev);
+static void display_dev_clean(display_dev_t* dev);
+static uint8_t display_dev_before(const display_dev_t* a, const display_dev_t* b, uint32_t now);
+static uint8_t display_dev_probe(display_dev_t* dev, uint32_t now);
+static void display_dev_flush_block(display_dev_t* dev, uint32_t now);
+static void display_dev_flush_done(display_dev_t* dev, error_status result, uint32_t now);
+static void display_dev_rate_update(uint32_t now);
+
+/* 驱动 */
+static const display_driver_t ssd1306_driver = { ssd1306_init, ssd1306_flush, ssd1306_verify };
+static const display_driver_t ht16k33_driver = { ht16k33_init, ht16k33_flush, ht16k33_verify };
+
+/* 设备表: 名称 驱动 帧缓冲区 总线 地址 每块字节数 块数 优先级 期限 */
+static display_dev_t display_devs[DISPLAY_DEV_COUNT] =
+{
+    { "oled",   &ssd1306_driver, display_oled_fb,   I2C_BUS_DISPLAY,  DISPLAY_I2C_ADDRESS,
+      DISPLAY_OLED_WIDTH,  DISPLAY_OLED_PAGES, 1, DISPLAY_OLED_PERIOD_MS },
+    { "matrix", &ht16k33_driver, display_matrix_fb, I2C_BUS_DISPLAY2, LED_MATRIX_I2C_ADDRESS,
+      DISPLAY_MATRIX_SIZE, 1,                  0, DISPLAY_MATRIX_PERIOD_MS },
+};
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief  SSD1306初始化
+ * @param  dev: 设备
+ * @retval SUCCESS/ERROR
+ */
+static error_status ssd1306_init(display_dev_t* dev)
+{
+    return i2c_bus_write_buffer(dev->bus, dev->address, SSD1306_CTRL_CMD, ssd1306_init_cmds, sizeof(ssd1306_init_cmds));
+}
+
+/**
+ * @brief  SSD1306刷新一页的列范围
+ * @note   窗口命令 (8字节) 阻塞发送, 显示数据由DMA发送
+ * @param  dev: 设备
+ * @param  block: 页号
+ * @param  lo: 起始列
+ * @param  hi: 结束列
+ * @retval SUCCESS/ERROR
+ */
+static error_status ssd1306_flush(display_dev_t* dev, uint8_t block, uint8_t lo, uint8_t hi)
+{
+    uint8_t window[SSD1306_WINDOW_CMD_SIZE];
+
+    window[0] = SSD1306_ADDR_MODE;
+    window[1] = SSD1306_HORIZONTAL;
+    window[2] = SSD1306_COLUMN_ADDR;
+    window[3] = lo;
+    window[4] = hi;
+    window[5] = SSD1306_PAGE_ADDR;
+    window[6] = block;
+    window[7] = block;
+
+    if(i2c_bus_write_buffer(dev->bus, dev->address, SSD1306_CTRL_CMD, window, sizeof(window)) != SUCCESS)
+    {
+        return ERROR;
+    }
+
+    return i2c_bus_write_start(dev->bus, dev->address, SSD1306_CTRL_DATA, &dev->fb[block * dev->block_size + lo],
+                               hi - lo + 1);
+}
+
+/**
+ * @brief  SSD1306速率校验: 写入一串空操作命令, 每个字节都须应答
+ * @note   I2C接口的SSD1306不能读回, 只能由应答判断
+ * @param  dev: 设备
+ * @param  round: 第几次校验
+ * @param  bytes: 输出总线上的字节数
+ * @retval SUCCESS/ERROR
+ */
+static error_status ssd1306_verify(display_dev_t* dev, uint8_t round, uint16_t* bytes)
+{
+    uint8_t nop[DISPLAY_VERIFY_SIZE];
+    uint8_t i;
+
+    for(i = 0; i < DISPLAY_VERIFY_SIZE; i++)
+    {
+        nop[i] = SSD1306_NOP;
+    }
+
+    /* 地址 控制字节 命令 */
+    *bytes = DISPLAY_VERIFY_SIZE + 2;
+
+    return i2c_bus_write_buffer(dev->bus, dev->address, SSD1306_CTRL_CMD, nop, sizeof(nop));
+}
+
+/**
+ * @brief  HT16K33初始化: 开振荡器, 开显示 (不闪烁), 最大亮度
+ * @param  dev: 设备
+ * @retval SUCCESS/ERROR
+ */
+static error_status ht16k33_init(display_dev_t* dev)
+{
+    if((i2c_bus_write_buffer(dev->bus, dev->address, HT16K33_OSC_ON, NULL, 0) != SUCCESS) ||
+       (i2c_bus_write_buffer(dev->bus, dev->address, HT16K33_DISPLAY_ON, NULL, 0) != SUCCESS))
+    {
+        return ERROR;
+    }
+
+    return i2c_bus_write_buffer(dev->bus, dev->address, HT16K33_DIMMING_MAX, NULL, 0);
+}
+
+/**
+ * @brief  HT16K33刷新显示RAM的字节范围 (RAM地址即帧缓冲区偏移)
+ * @param  dev: 设备
+ * @param  block: 块号 (只有一块)
+ * @param  lo: 起始偏移
+ * @param  hi: 结束偏移
+ * @retval SUCCESS/ERROR
+ */
+static error_status ht16k33_flush(display_dev_t* dev, uint8_t block, uint8_t lo, uint8_t hi)
+{
+    return i2c_bus_write_start(dev->bus, dev->address, lo, &dev->fb[lo], hi - lo + 1);
+}
+
+/**
+ * @brief  HT16K33速率校验: 把测试数据写入显示RAM后读回比较
+ * @note   每次的数据不同, 读回上一次残留的内容也能发现
+ * @param  dev: 设备
+ * @param  round: 第几次校验
+ * @param  bytes: 输出总线上的字节数
+ * @retval SUCCESS/ERROR
+ */
+static error_status ht16k33_verify(display_dev_t* dev, uint8_t round, uint16_t* bytes)
+{
+    uint8_t pattern[DISPLAY_VERIFY_SIZE];
+    uint8_t readback[DISPLAY_VERIFY_SIZE];
+    uint8_t i;
+
+    for(i = 0; i < DISPLAY_VERIFY_SIZE; i++)
+    {
+        pattern[i] = (uint8_t)((i * 0x3B) ^ (round * 0x55) ^ 0xA5);
+        readback[i] = (uint8_t)~pattern[i];
+    }
+
+    /* 写: 地址 RAM地址 数据; 读: 地址 RAM地址 地址 数据 */
+    *bytes = 2 * DISPLAY_VERIFY_SIZE + 5;
+
+    if((i2c_bus_write_buffer(dev->bus, dev->address, 0x00, pattern, sizeof(pattern)) != SUCCESS) ||
+       (i2c_bus_read_buffer(dev->bus, dev->address, 0x00, readback, sizeof(readback)) != SUCCESS))
+    {
+        return ERROR;
+    }
+
+    for(i = 0; i < DISPLAY_VERIFY_SIZE; i++)
+    {
+        if(readback[i] != pattern[i])
+        {
+            return ERROR;
+        }
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief  把设备所在总线切换到指定速率档
+ * @note   首选占空比的实际速率偏差过大时换另一种占空比
+ * @param  dev: 设备
+ * @param  step: 档位
+ * @retval SUCCESS/ERROR (两种占空比都达不到该速率)
+ */
+static error_status display_dev_apply_speed(display_dev_t* dev, uint8_t step)
+{
+    const display_speed_step_t* speed_step = &display_speed_steps[step];
+    i2c_clock_duty_type duty = speed_step->duty;
+
+    if(i2c_bus_set_speed(dev->bus, speed_step->speed, duty) != SUCCESS)
+    {
+        duty = (duty == I2C_CLOCK_DUTY_2) ? I2C_CLOCK_DUTY_16_9 : I2C_CLOCK_DUTY_2;
+        if((speed_step->speed <= I2C_SPEED_STANDARD) ||
+           (i2c_bus_set_speed(dev->bus, speed_step->speed, duty) != SUCCESS))
+        {
+            return ERROR;
+        }
+    }
+
+    dev->duty = duty;
+    dev->scl_rate = i2c_bus_scl_rate(dev->bus);
+
+    return SUCCESS;
+}
+
+/**
+ * @brief  对设备操作前把总线切换到设备的速率 (与当前相同时不操作)
+ * @note   时钟档位切换后达不到该速率时重新选择占空比, 仍不行则改用标准模式
+ * @param  dev: 设备 (总线空闲)
+ * @retval None
+ */
+static void display_dev_select(display_dev_t* dev)
+{
+    if(i2c_bus_set_speed(dev->bus, display_speed_steps[dev->speed_step].speed, dev->duty) == SUCCESS)
+    {
+        return;
+    }
+
+    if(display_dev_apply_speed(dev, dev->speed_step) != SUCCESS)
+    {
+        dev->speed_step = 0;
+        display_dev_apply_speed(dev, 0);
+    }
+}
+
+/**
+ * @brief  从配置存储读取设备的速率档
+ * @param  dev: 设备 (地址已确定)
+ * @retval 档位, 未保存时为 DISPLAY_SPEED_STEP_DEFAULT
+ */
+static uint8_t display_dev_speed_load(const display_dev_t* dev)
+{
+    uint8_t table[DISPLAY_SPEED_ENTRIES * 2];
+    uint8_t i;
+
+    if(config_get(CONFIG_KEY_I2C_SPEED, table, sizeof(table)) == SUCCESS)
+    {
+        for(i = 0; i < DISPLAY_SPEED_ENTRIES; i++)
+        {
+            if((table[i * 2] == DISPLAY_SPEED_KEY(dev)) && (table[i * 2 + 1] < DISPLAY_SPEED_STEP_COUNT))
+            {
+                return table[i * 2 + 1];
+            }
+        }
+    }
+
+    return DISPLAY_SPEED_STEP_DEFAULT;
+}
+
+/**
+ * @brief  保存设备的速率档: 更新同一地址的项, 否则占用空项, 表满时覆盖最后一项
+ * @param  dev: 设备
+ * @retval None
+ */
+static void display_dev_speed_save(const display_dev_t* dev)
+{
+    uint8_t table[DISPLAY_SPEED_ENTRIES * 2];
+    uint8_t i;
+
+    if(config_get(CONFIG_KEY_I2C_SPEED, table, sizeof(table)) != SUCCESS)
+    {
+        for(i = 0; i < sizeof(table); i++)
+        {
+            table[i] = 0;
+        }
+    }
+
+    for(i = 0; i < DISPLAY_SPEED_ENTRIES; i++)
+    {
+        if(table[i * 2] == DISPLAY_SPEED_KEY(dev))
+        {
+            break;
+        }
+    }
+    if(i == DISPLAY_SPEED_ENTRIES)
+    {
+        for(i = 0; i < DISPLAY_SPEED_ENTRIES - 1; i++)
+        {
+            if(table[i * 2] == 0)
+            {
+                break;
+            }
+        }
+    }
+
+    table[i * 2] = DISPLAY_SPEED_KEY(dev);
+    table[i * 2 + 1] = dev->speed_step;
+    config_set(CONFIG_KEY_I2C_SPEED, table, sizeof(table));
+}
+
+/**
+ * @brief  清除所有脏区
+ * @param  dev: 设备
+ * @retval None
+ */
+static void display_dev_clean(display_dev_t* dev)
+{
+    uint8_t i;
+
+    for(i = 0; i < dev->blocks; i++)
+    {
+        dev->dirty_lo[i] = dev->block_size;
+        dev->dirty_hi[i] = 0;
+    }
+}
+
+/**
+ * @brief  a是否应在b之前刷新
+ * @note   已过期限的优先; 其次优先级高的优先; 再次期限早的优先
+ * @param  a: 设备
+ * @param  b: 设备
+ * @param  now: 当前时刻
+ * @retval 1: a在前, 0: b在前
+ */
+static uint8_t display_dev_before(const display_dev_t* a, const display_dev_t* b, uint32_t now)
+{
+    uint8_t a_late = ((int32_t)(now - a->deadline) >= 0) ? 1 : 0;
+    uint8_t b_late = ((int32_t)(now - b->deadline) >= 0) ? 1 : 0;
+
+    if(a_late != b_late)
+    {
+        return a_late;
+    }
+    if(a->priority != b->priority)
+    {
+        return (a->priority < b->priority) ? 1 : 0;
+    }
+
+    return ((int32_t)(a->deadline - b->deadline) < 0) ? 1 : 0;
+}
+
+/**
+ * @brief  探测未应答的设备, 应答后初始化并整屏刷新
+ * @note   各设备共用探测间隔, 每个间隔最多探测一个设备
+ * @param  dev: 设备 (state 为 I2C_DISPLAY_STATE_PROBING)
+ * @param  now: 当前时刻
+ * @retval 1: 有总线操作, 0: 未到探测间隔
+ */
+static uint8_t display_dev_probe(display_dev_t* dev, uint32_t now)
+{
+    if((now - display_probe_tick) < DISPLAY_PROBE_INTERVAL_MS)
+    {
+        return 0;
+    }
+    display_probe_tick = now;
+
+    display_dev_select(dev);
+    if(i2c_bus_probe(dev->bus, dev->address) == SUCCESS)
+    {
+        if(dev->driver->init(dev) == SUCCESS)
+        {
+            dev->state = I2C_DISPLAY_STATE_READY;
+            display_dev_invalidate(dev);
+            display_dev_commit(dev);
+        }
+    }
+    else if((now - dev->probe_start) >= DISPLAY_READY_TIMEOUT_MS)
+    {
+        dev->state = I2C_DISPLAY_STATE_ABSENT;
+    }
+
+    return 1;
+}
+
+/**
+ * @brief  开始刷新设备的下一个脏块; 没有脏块时 (空提交) 直接记一帧
+ * @note   先清除再写, 刷新期间写入的变化记入新的脏区
+ * @param  dev: 设备 (有待刷新的提交, 总线空闲)
+ * @param  now: 当前时刻
+ * @retval None
+ */
+static void display_dev_flush_block(display_dev_t* dev, uint32_t now)
+{
+    uint8_t block;
+    uint8_t lo;
+    uint8_t hi;
+    uint8_t i;
+
+    for(i = 0; i < dev->blocks; i++)
+    {
+        block = dev->next_block;
+        dev->next_block = (dev->next_block + 1) % dev->blocks;
+
+        lo = dev->dirty_lo[block];
+        hi = dev->dirty_hi[block];
+        if(lo > hi)
+        {
+            continue;
+        }
+
+        dev->dirty_lo[block] = dev->block_size;
+        dev->dirty_hi[block] = 0;
+
+        dev->inflight_bytes = hi - lo + 1;
+        display_dev_select(dev);
+        if(dev->driver->flush(dev, block, lo, hi) != SUCCESS)
+        {
+            display_dev_flush_done(dev, ERROR, now);
+            return;
+        }
+        dev->inflight = 1;
+        return;
+    }
+
+    display_dev_flush_done(dev, SUCCESS, now);
+}
+
+/**
+ * @brief  一块刷新结束: 统计, 全部刷完时记一帧
+ * @note   写失败时重新探测, 应答后整屏刷新
+ * @param  dev: 设备
+ * @param  result: 刷新结果
+ * @param  now: 当前时刻
+ * @retval None
+ */
+static void display_dev_flush_done(display_dev_t* dev, error_status result, uint32_t now)
+{
+    dev->inflight = 0;
+
+    if(result != SUCCESS)
+    {
+        dev->errors++;
+        METRIC_INC(METRIC_DISPLAY_FLUSH_ERROR);
+        dev->state = I2C_DISPLAY_STATE_PROBING;
+        dev->probe_start = now;
+        return;
+    }
+    METRIC_ADD(METRIC_DISPLAY_FLUSH_BYTES, dev->inflight_bytes);
+    dev->inflight_bytes = 0;
+
+    if(display_dev_dirty_bytes(dev) != 0)
+    {
+        return;
+    }
+
+    /* 本次提交 (及其间合并的提交) 刷新完成 */
+    dev->pending = 0;
+    dev->frames++;
+    dev->window_frames++;
+    if((now - dev->commit_tick) > dev->latency_max_ms)
+    {
+        dev->latency_max_ms = now - dev->commit_tick;
+    }
+    if((int32_t)(now - dev->deadline) > 0)
+    {
+        dev->deadline_miss++;
+    }
+}
+
+/**
+ * @brief  每个统计窗口结束时计算各设备的实际刷新率
+ * @param  now: 当前时刻
+ * @retval None
+ */
+static void display_dev_rate_update(uint32_t now)
+{
+    uint32_t elapsed = now - display_rate_tick;
+    uint8_t i;
+
+    if(elapsed < DISPLAY_DEV_RATE_WINDOW_MS)
+    {
+        return;
+    }
+
+    for(i = 0; i < DISPLAY_DEV_COUNT; i++)
+    {
+        display_devs[i].fps_x10 = (uint32_t)display_devs[i].window_frames * 10000 / elapsed;
+        display_devs[i].window_frames = 0;
+    }
+    display_rate_tick = now;
+}
+
+/**
+ * @brief  初始化各设备 (帧缓冲区清零, 等待探测)
+ * @param  None
+ * @retval None
+ */
+void display_dev_init(void)
+{
+    display_dev_t* dev;
+    uint16_t size;
+    uint16_t j;
+    uint8_t i;
+
+    for(i = 0; i < DISPLAY_DEV_COUNT; i++)
+    {
+        dev = &display_devs[i];
+        size = display_dev_fb_size(dev);
+        for(j = 0; j < size; j++)
+        {
+            dev->fb[j] = 0;
+        }
+        display_dev_clean(dev);
+
+        dev->bus = i2c_bus_get(dev->bus_id);
+        dev->speed_step = DISPLAY_SPEED_STEP_DEFAULT;
+        dev->duty = display_speed_steps[DISPLAY_SPEED_STEP_DEFAULT].duty;
+        dev->scl_rate = 0;
+        dev->stretch_us = 0;
+        dev->state = I2C_DISPLAY_STATE_PROBING;
+        dev->pending = 0;
+        dev->next_block = 0;
+        dev->inflight = 0;
+        dev->frames = 0;
+        dev->window_frames = 0;
+        dev->fps_x10 = 0;
+        dev->latency_max_ms = 0;
+        dev->deadline_miss = 0;
+        dev->errors = 0;
+    }
+
+    display_started = 0;
+}
+
+/**
+ * @brief  按编号取设备
+ * @param  id: display_dev_id_t
+ * @retval 设备, 编号无效时返回NULL
+ */
+display_dev_t* display_dev_get(uint8_t id)
+{
+    return (id < DISPLAY_DEV_COUNT) ? &display_devs[id] : NULL;
+}
+
+/**
+ * @brief  帧缓冲区大小
+ * @param  dev: 设备
+ * @retval 字节数
+ */
+uint16_t display_dev_fb_size(const display_dev_t* dev)
+{
+    return (uint16_t)dev->block_size * dev->blocks;
+}
+
+/**
+ * @brief  写帧缓冲区的一个字节, 内容改变时记为脏
+ * @param  dev: 设备
+ * @param  pos: 帧缓冲区偏移 (调用者检查范围)
+ * @param  value: 新值
+ * @retval None
+ */
+void display_dev_put(display_dev_t* dev, uint16_t pos, uint8_t value)
+{
+    uint8_t block;
+    uint8_t offset;
+
+    if(dev->fb[pos] == value)
+    {
+        return;
+    }
+    dev->fb[pos] = value;
+
+    block = pos / dev->block_size;
+    offset = pos % dev->block_size;
+    if(offset < dev->dirty_lo[block])
+    {
+        dev->dirty_lo[block] = offset;
+    }
+    if(offset > dev->dirty_hi[block])
+    {
+        dev->dirty_hi[block] = offset;
+    }
+}
+
+/**
+ * @brief  整屏记为脏 (显示屏重新上电后)
+ * @param  dev: 设备
+ * @retval None
+ */
+void display_dev_invalidate(display_dev_t* dev)
+{
+    uint8_t i;
+
+    for(i = 0; i < dev->blocks; i++)
+    {
+        dev->dirty_lo[i] = 0;
+        dev->dirty_hi[i] = dev->block_size - 1;
+    }
+}
+
+/**
+ * @brief  提交一帧: 之前写入的变化交给仲裁刷新, 期限从本次提交起算
+ * @note   上一帧还在刷新时合并, 期限不变
+ * @param  dev: 设备
+ * @retval None
+ */
+void display_dev_commit(display_dev_t* dev)
+{
+    uint32_t now = get_tick();
+
+    if(dev->pending)
+    {
+        return;
+    }
+
+    dev->pending = 1;
+    dev->commit_tick = now;
+    dev->deadline = now + dev->period_ms;
+}
+
+/**
+ * @brief  待刷新字节数
+ * @param  dev: 设备
+ * @retval 字节数
+ */
+uint16_t display_dev_dirty_bytes(const display_dev_t* dev)
+{
+    uint16_t bytes = 0;
+    uint8_t i;
+
+    for(i = 0; i < dev->blocks; i++)
+    {
+        if(dev->dirty_lo[i] <= dev->dirty_hi[i])
+        {
+            bytes += dev->dirty_hi[i] - dev->dirty_lo[i] + 1;
+        }
+    }
+
+    return bytes;
+}
+
+/**
+ * @brief  I2C速率探测: 从最低档起逐档提高速率, 每档写入测试数据并校验 (回读或应答),
+ *         在第一个失败的档位退回上一档, 结果按设备地址保存到配置存储
+ * @note   每次校验用DWT计时, 减去按实际SCL速率算出的理论时间即为从机时钟延展
+ *         (含主机逐字节轮询的间隙), 记录通过的最高档的最大值.
+ *         失败的传输可能使显示屏收到残缺的命令, 结束后重新初始化并整屏刷新
+ * @param  dev: 设备 (已应答)
+ * @param  max_step: 最高尝试的档位, DISPLAY_SPEED_STEP_ALL 为全部
+ * @retval SUCCESS: 至少最低档通过, ERROR: 设备未就绪或最低档也失败 (恢复默认档)
+ */
+error_status display_dev_speed_probe(display_dev_t* dev, uint8_t max_step)
+{
+    uint32_t cycles_per_us = system_core_clock / 1000000;
+    uint32_t start;
+    uint32_t elapsed_us;
+    uint32_t wire_us;
+    uint16_t stretch_us;
+    uint16_t bytes;
+    uint8_t best = DISPLAY_SPEED_STEP_ALL;
+    uint8_t step;
+    uint8_t round;
+    error_status result = SUCCESS;
+
+    if(dev->state != I2C_DISPLAY_STATE_READY)
+    {
+        return ERROR;
+    }
+    if(max_step >= DISPLAY_SPEED_STEP_COUNT)
+    {
+        max_step = DISPLAY_SPEED_STEP_COUNT - 1;
+    }
+
+    for(step = 0; step <= max_step; step++)
+    {
+        if(display_dev_apply_speed(dev, step) != SUCCESS)
+        {
+            break;
+        }
+
+        stretch_us = 0;
+        for(round = 0; round < DISPLAY_SPEED_PROBE_ROUNDS; round++)
+        {
+            start = DWT->CYCCNT;
+            if(dev->driver->verify(dev, round, &bytes) != SUCCESS)
+            {
+                break;
+            }
+            elapsed_us = (DWT->CYCCNT - start) / cycles_per_us;
+
+            /* 每字节9位 (含应答) */
+            wire_us = (uint32_t)bytes * 9 * 1000000 / dev->scl_rate;
+            if((elapsed_us > wire_us) && ((elapsed_us - wire_us) > stretch_us))
+            {
+                stretch_us = elapsed_us - wire_us;
+            }
+        }
+        if(round < DISPLAY_SPEED_PROBE_ROUNDS)
+        {
+            break;
+        }
+
+        best = step;
+        dev->stretch_us = stretch_us;
+    }
+
+    if(best == DISPLAY_SPEED_STEP_ALL)
+    {
+        best = DISPLAY_SPEED_STEP_DEFAULT;
+        result = ERROR;
+    }
+
+    dev->speed_step = best;
+    if(display_dev_apply_speed(dev, best) != SUCCESS)
+    {
+        dev->speed_step = 0;
+        display_dev_apply_speed(dev, 0);
+    }
+    if(result == SUCCESS)
+    {
+        display_dev_speed_save(dev);
+    }
+
+    if(dev->driver->init(dev) != SUCCESS)
+    {
+        dev->state = I2C_DISPLAY_STATE_PROBING;
+        dev->probe_start = get_tick();
+        return ERROR;
+    }
+    display_dev_invalidate(dev);
+    display_dev_commit(dev);
+
+    return result;
+}
+
+/**
+ * @brief  速率档对应的设定速率
+ * @param  step: 档位
+ * @retval 速率 (Hz), 档位无效时为0
+ */
+uint32_t display_dev_speed_hz(uint8_t step)
+{
+    return (step < DISPLAY_SPEED_STEP_COUNT) ? display_speed_steps[step].speed : 0;
+}
+
+/**
+ * @brief  探测设备并按优先级和期限刷新, 在主循环中调用
+ * @note   每次最多一个总线操作 (探测/初始化/刷新一块), 大屏的整屏刷新与小屏交错进行
+ * @param  None
+ * @retval 1: 有总线操作, 0: 无事可做
+ */
+uint8_t display_dev_poll(void)
+{
+    uint32_t now = get_tick();
+    display_dev_t* best;
+    display_dev_t* dev;
+    uint8_t busy = 0;
+    uint8_t bus_id;
+    uint8_t i;
+
+    /* 启动阶段之后开始探测, OLED地址以配置项为准, 速率档按地址取配置项 */
+    if(!display_started)
+    {
+        display_devs[DISPLAY_DEV_OLED].address = i2c_display_get_address();
+        for(i = 0; i < DISPLAY_DEV_COUNT; i++)
+        {
+            display_devs[i].probe_start = now;
+            display_devs[i].speed_step = display_dev_speed_load(&display_devs[i]);
+            display_devs[i].duty = display_speed_steps[display_devs[i].speed_step].duty;
+        }
+        display_rate_tick = now;
+        display_probe_tick = now - DISPLAY_PROBE_INTERVAL_MS;
+        display_started = 1;
+    }
+
+    display_dev_rate_update(now);
+
+    /* 结束已完成的DMA刷新 */
+    for(i = 0; i < DISPLAY_DEV_COUNT; i++)
+    {
+        dev = &display_devs[i];
+        if(!dev->inflight)
+        {
+            continue;
+        }
+        if(i2c_bus_poll(dev->bus))
+        {
+            busy = 1;
+            continue;
+        }
+        display_dev_flush_done(dev, i2c_bus_async_result(dev->bus), now);
+    }
+
+    for(i = 0; i < DISPLAY_DEV_COUNT; i++)
+    {
+        dev = &display_devs[i];
+        if((dev->state == I2C_DISPLAY_STATE_PROBING) && !i2c_bus_poll(dev->bus) && display_dev_probe(dev, now))
+        {
+            return 1;
+        }
+    }
+
+    /* 每条空闲总线选一个设备 */
+    for(bus_id = 0; bus_id < I2C_BUS_COUNT; bus_id++)
+    {
+        if(i2c_bus_poll(i2c_bus_get(bus_id)))
+        {
+            continue;
+        }
+
+        best = NULL;
+        for(i = 0; i < DISPLAY_DEV_COUNT; i++)
+        {
+            dev = &display_devs[i];
+            if((dev->bus_id != bus_id) || (dev->state != I2C_DISPLAY_STATE_READY) || !dev->pending)
+            {
+                continue;
+            }
+            if((best == NULL) || display_dev_before(dev, best, now))
+            {
+                best = dev;
+            }
+        }
+
+        if(best != NULL)
+        {
+            display_dev_flush_block(best, now);
+            busy = 1;
+        }
+    }
+
+    return busy;
+}
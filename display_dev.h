@@ -0,0 +1,194 @@
+/**
+ * @file display_dev.h
+ * @brief 显示设备模块头文件 (同一I2C总线上的多个显示屏, 各自的帧缓冲区和驱动, 刷新仲裁)
+ * @author Jason
+ * @date 2026-10-18
+ */
+
+#ifndef __DISPLAY_DEV_H
+#define __DISPLAY_DEV_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "at32f403a_407.h"
+#include "i2c_display.h"
+
+/* Exported types ------------------------------------------------------------*/
+/**
+ * @brief  显示设备编号 (B3 标志字节 bit2~3)
+ */
+typedef enum
+{
+    DISPLAY_DEV_OLED = 0,           /*!< SSD1306 128x64 OLED, 地址取配置项 (默认 DISPLAY_I2C_ADDRESS) */
+    DISPLAY_DEV_MATRIX,             /*!< HT16K33 16x8 LED矩阵 (LED_MATRIX_I2C_ADDRESS) */
+    DISPLAY_DEV_COUNT
+} display_dev_id_t;
+
+typedef struct display_dev display_dev_t;
+
+/**
+ * @brief  显示屏驱动
+ * @note   帧缓冲区按块组织, 每块 block_size 字节; 刷新时写一块中 [lo, hi] 的字节.
+ *         flush 以 i2c_bus_write_start 开始DMA写传输后返回, 由仲裁检查结束.
+ *         verify 供速率探测使用, 阻塞传输, 可以改写显示内容 (探测后整屏刷新)
+ */
+typedef struct
+{
+    error_status (*init)(display_dev_t* dev);                                       /*!< 应答后初始化显示屏 */
+    error_status (*flush)(display_dev_t* dev, uint8_t block, uint8_t lo, uint8_t hi); /*!< 写一块的 [lo, hi] */
+    error_status (*verify)(display_dev_t* dev, uint8_t round, uint16_t* bytes);     /*!< 写入测试数据并校验, 给出总线字节数 */
+} display_driver_t;
+
+/* 每个设备最多块数 (SSD1306 8页) */
+#define DISPLAY_DEV_MAX_BLOCKS      8
+
+/**
+ * @brief  显示设备
+ */
+struct display_dev
+{
+    const char* name;               /*!< 名称 */
+    const display_driver_t* driver; /*!< 驱动 */
+    uint8_t* fb;                    /*!< 帧缓冲区 (block_size * blocks 字节, DMA可访问) */
+    uint8_t bus_id;                 /*!< 所在I2C总线 (i2c_bus_id_t) */
+    uint8_t address;                /*!< 7位I2C地址 */
+    uint8_t block_size;             /*!< 每块字节数 */
+    uint8_t blocks;                 /*!< 块数, 不大于 DISPLAY_DEV_MAX_BLOCKS */
+    uint8_t priority;               /*!< 优先级, 0最高 */
+    uint16_t period_ms;             /*!< 提交到刷新完成的期限 (ms) */
+
+    uint8_t speed_step;             /*!< I2C速率档 (DISPLAY_SPEED_STEP_*), 刷新前把总线切换到该速率 */
+    i2c_clock_duty_type duty;       /*!< 该速率采用的占空比 */
+    uint32_t scl_rate;              /*!< 实际SCL速率 (Hz) */
+    uint16_t stretch_us;            /*!< 速率探测测得的每次校验传输超出理论时间 (us) */
+    i2c_bus_t* bus;                 /*!< 所在I2C总线 */
+    i2c_display_state_t state;      /*!< 应答状态, 应答后由驱动初始化 */
+    uint32_t probe_start;           /*!< 开始探测的时刻 */
+    uint8_t dirty_lo[DISPLAY_DEV_MAX_BLOCKS];   /*!< 各块脏字节范围 (lo > hi 为无) */
+    uint8_t dirty_hi[DISPLAY_DEV_MAX_BLOCKS];
+    uint8_t pending;                /*!< 已提交, 等待刷新 */
+    uint8_t next_block;             /*!< 下一个检查的块 */
+    uint8_t inflight;               /*!< 本设备的DMA刷新正在进行 */
+    uint8_t inflight_bytes;         /*!< 正在刷新的字节数 */
+    uint32_t commit_tick;           /*!< 最早未完成提交的时刻 */
+    uint32_t deadline;              /*!< 刷新期限 */
+
+    uint32_t frames;                /*!< 刷新完成的帧数 */
+    uint16_t window_frames;         /*!< 本统计窗口内完成的帧数 */
+    uint16_t fps_x10;               /*!< 上一统计窗口的实际刷新率 (0.1Hz) */
+    uint16_t latency_max_ms;        /*!< 提交到刷新完成的最长时间 (ms) */
+    uint16_t deadline_miss;         /*!< 超过期限完成的帧数 */
+    uint16_t errors;                /*!< 刷新失败次数 */
+};
+
+/* Exported constants --------------------------------------------------------*/
+/* OLED帧缓冲区: 8页 x 128列, 每字节为一列的8个像素 (低位在上), 偏移 = 页 * 128 + 列 */
+#define DISPLAY_OLED_WIDTH          128
+#define DISPLAY_OLED_PAGES          8
+#define DISPLAY_OLED_PERIOD_MS      50
+
+/* LED矩阵帧缓冲区: 8行, 每行2字节 (列0~7, 列8~15), 与HT16K33显示RAM相同 */
+#define DISPLAY_MATRIX_SIZE         16
+#define DISPLAY_MATRIX_PERIOD_MS    10
+
+/* I2C速率档: 100k 400k 600k 800k 1M (Hz), 速率探测从低到高逐档尝试 */
+#define DISPLAY_SPEED_STEP_COUNT    5
+#define DISPLAY_SPEED_STEP_DEFAULT  1       /*!< 400kHz, 未保存探测结果的设备 */
+#define DISPLAY_SPEED_STEP_ALL      0xFF    /*!< 探测全部档位 */
+
+/* 每档校验次数 */
+#define DISPLAY_SPEED_PROBE_ROUNDS  4
+
+/* 刷新率统计窗口 (ms) */
+#define DISPLAY_DEV_RATE_WINDOW_MS  1000
+
+/* Exported macro ------------------------------------------------------------*/
+/* Exported functions prototypes ---------------------------------------------*/
+
+/**
+ * @brief  初始化各设备 (帧缓冲区清零, 等待探测)
+ * @param  None
+ * @retval None
+ */
+void display_dev_init(void);
+
+/**
+ * @brief  按编号取设备
+ * @param  id: display_dev_id_t
+ * @retval 设备, 编号无效时返回NULL
+ */
+display_dev_t* display_dev_get(uint8_t id);
+
+/**
+ * @brief  帧缓冲区大小
+ * @param  dev: 设备
+ * @retval 字节数
+ */
+uint16_t display_dev_fb_size(const display_dev_t* dev);
+
+/**
+ * @brief  写帧缓冲区的一个字节, 内容改变时记为脏
+ * @param  dev: 设备
+ * @param  pos: 帧缓冲区偏移 (调用者检查范围)
+ * @param  value: 新值
+ * @retval None
+ */
+void display_dev_put(display_dev_t* dev, uint16_t pos, uint8_t value);
+
+/**
+ * @brief  整屏记为脏 (显示屏重新上电后)
+ * @param  dev: 设备
+ * @retval None
+ */
+void display_dev_invalidate(display_dev_t* dev);
+
+/**
+ * @brief  提交一帧: 之前写入的变化交给仲裁刷新, 期限从本次提交起算
+ * @note   上一帧还在刷新时合并, 期限不变
+ * @param  dev: 设备
+ * @retval None
+ */
+void display_dev_commit(display_dev_t* dev);
+
+/**
+ * @brief  待刷新字节数
+ * @param  dev: 设备
+ * @retval 字节数
+ */
+uint16_t display_dev_dirty_bytes(const display_dev_t* dev);
+
+/**
+ * @brief  I2C速率探测: 从最低档起逐档提高速率, 每档写入测试数据并校验 (回读或应答),
+ *         在第一个失败的档位退回上一档, 结果按设备地址保存到配置存储
+ * @note   阻塞执行 (约20ms, 无应答时立即失败), 结束后重新初始化显示屏并整屏刷新;
+ *         实际速率偏差过大的档位 (分频取整) 也视为失败
+ * @param  dev: 设备 (已应答)
+ * @param  max_step: 最高尝试的档位, DISPLAY_SPEED_STEP_ALL 为全部
+ * @retval SUCCESS: 至少最低档通过, ERROR: 设备未就绪或最低档也失败 (恢复默认档)
+ */
+error_status display_dev_speed_probe(display_dev_t* dev, uint8_t max_step);
+
+/**
+ * @brief  速率档对应的设定速率
+ * @param  step: 档位
+ * @retval 速率 (Hz), 档位无效时为0
+ */
+uint32_t display_dev_speed_hz(uint8_t step);
+
+/**
+ * @brief  探测设备并按优先级和期限刷新, 在主循环中调用
+ * @note   每条总线同时只有一个刷新 (一块), 不同总线的刷新并行进行;
+ *         同一总线上大屏的整屏刷新与小屏交错进行
+ * @param  None
+ * @retval 1: 有总线操作或刷新进行中, 0: 无事可做
+ */
+uint8_t display_dev_poll(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __DISPLAY_DEV_H */
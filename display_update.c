@@ -0,0 +1,195 @@
+/**
+ * @file display_update.c
+ * @brief 显示帧缓冲区远程更新模块实现
+ * @author Jason
+ * @date 2026-10-18
+ *
+ * 主机把整屏画面以RLE压缩帧或相对上一帧的XOR差分发送 (B3 命令), 本机从接收帧直接
+ * 解码到所选显示设备的帧缓冲区, 只有内容确实改变的字节才记为脏. 更新结束后提交给
+ * 显示设备仲裁 (display_dev.c), I2C只传输变化的部分.
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "display_update.h"
+#include "main.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private define ------------------------------------------------------------*/
+/* Private macro -------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+static uint8_t display_upd_error = 0;           // 本次更新有段解码失败
+
+/* Private function prototypes -----------------------------------------------*/
+static error_status display_decode_raw(display_dev_t* dev, const uint8_t* src, uint16_t len, uint16_t pos);
+static error_status display_decode_rle(display_dev_t* dev, const uint8_t* src, uint16_t len, uint16_t pos,
+                                       uint8_t xor_mode);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief  原始字节段
+ * @param  dev: 目标设备
+ * @param  src: 段数据
+ * @param  len: 段长度
+ * @param  pos: 起始偏移
+ * @retval SUCCESS/ERROR (超出帧缓冲区)
+ */
+static error_status display_decode_raw(display_dev_t* dev, const uint8_t* src, uint16_t len, uint16_t pos)
+{
+    uint16_t i;
+
+    if((uint32_t)pos + len > display_dev_fb_size(dev))
+    {
+        return ERROR;
+    }
+
+    for(i = 0; i < len; i++)
+    {
+        display_dev_put(dev, pos + i, src[i]);
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief  游程编码段
+ * @note   XOR模式下0的游程不改变内容, 直接跳过
+ * @param  dev: 目标设备
+ * @param  src: 段数据
+ * @param  len: 段长度
+ * @param  pos: 起始偏移
+ * @param  xor_mode: 1为与帧缓冲区异或
+ * @retval SUCCESS/ERROR (数据截断或超出帧缓冲区, 出错前的部分已写入)
+ */
+static error_status display_decode_rle(display_dev_t* dev, const uint8_t* src, uint16_t len, uint16_t pos,
+                                       uint8_t xor_mode)
+{
+    uint16_t fb_size = display_dev_fb_size(dev);
+    uint16_t i = 0;
+    uint16_t count;
+    uint8_t ctrl;
+    uint8_t value;
+
+    while(i < len)
+    {
+        ctrl = src[i++];
+
+        if(ctrl & DISPLAY_RLE_RUN)
+        {
+            count = (ctrl & DISPLAY_RLE_COUNT_MASK) + DISPLAY_RLE_RUN_MIN;
+            if((i >= len) || ((uint32_t)pos + count > fb_size))
+            {
+                return ERROR;
+            }
+            value = src[i++];
+
+            if(xor_mode && (value == 0))
+            {
+                pos += count;
+                continue;
+            }
+            while(count--)
+            {
+                display_dev_put(dev, pos, xor_mode ? (dev->fb[pos] ^ value) : value);
+                pos++;
+            }
+        }
+        else
+        {
+            count = ctrl + 1;
+            if(((uint32_t)i + count > len) || ((uint32_t)pos + count > fb_size))
+            {
+                return ERROR;
+            }
+            while(count--)
+            {
+                value = src[i++];
+                display_dev_put(dev, pos, xor_mode ? (dev->fb[pos] ^ value) : value);
+                pos++;
+            }
+        }
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief  处理 B3 命令帧: 解码到所选设备的帧缓冲区, 最后一段回复并提交刷新
+ * @note   B3 标志 偏移(u16) 编码数据; 最后一段回复 B3 状态 CRC32(u32) 待刷新字节数(u16)
+ * @param  frame: 命令帧
+ * @param  len: 帧长度
+ * @retval None
+ */
+void display_update_command(const uint8_t* frame, uint16_t len)
+{
+    const uint8_t* data = &frame[DISPLAY_UPD_HEADER_SIZE];
+    display_dev_t* dev;
+    uint16_t data_len;
+    uint16_t pos;
+    uint8_t flags;
+    error_status status = ERROR;
+
+    if(len < DISPLAY_UPD_HEADER_SIZE)
+    {
+        return;
+    }
+
+    flags = frame[1];
+    pos = rs485_get_u16(&frame[2]);
+    data_len = len - DISPLAY_UPD_HEADER_SIZE;
+
+    dev = display_dev_get((flags & DISPLAY_UPD_DEV_MASK) >> DISPLAY_UPD_DEV_SHIFT);
+    if(dev == NULL)
+    {
+        display_upd_error = 1;
+        METRIC_INC(METRIC_DISPLAY_DECODE_ERROR);
+        if(flags & DISPLAY_UPD_END)
+        {
+            cmd_reply_status(frame[0], CMD_STATUS_ERROR);
+            display_upd_error = 0;
+        }
+        return;
+    }
+
+    switch(flags & DISPLAY_UPD_ENC_MASK)
+    {
+        case DISPLAY_ENC_RAW:
+            status = display_decode_raw(dev, data, data_len, pos);
+            break;
+
+        case DISPLAY_ENC_RLE:
+            status = display_decode_rle(dev, data, data_len, pos, 0);
+            break;
+
+        case DISPLAY_ENC_XOR_RLE:
+            status = display_decode_rle(dev, data, data_len, pos, 1);
+            break;
+
+        default:
+            break;
+    }
+
+    if(status != SUCCESS)
+    {
+        display_upd_error = 1;
+        METRIC_INC(METRIC_DISPLAY_DECODE_ERROR);
+    }
+
+    if(!(flags & DISPLAY_UPD_END))
+    {
+        return;
+    }
+
+    if(flags & DISPLAY_UPD_FULL)
+    {
+        display_dev_invalidate(dev);
+    }
+    display_dev_commit(dev);
+
+    cmd_reply_begin(frame[0], display_upd_error ? CMD_STATUS_ERROR : CMD_STATUS_OK);
+    cmd_reply_u32(flash_if_crc32(dev->fb, display_dev_fb_size(dev)));
+    cmd_reply_u16(display_dev_dirty_bytes(dev));
+    cmd_reply_end();
+
+    display_upd_error = 0;
+}
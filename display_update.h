@@ -0,0 +1,71 @@
+/**
+ * @file display_update.h
+ * @brief 显示帧缓冲区远程更新模块头文件 (RLE压缩帧/XOR差分帧, 只刷新变化区域)
+ * @author Jason
+ * @date 2026-10-18
+ */
+
+#ifndef __DISPLAY_UPDATE_H
+#define __DISPLAY_UPDATE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "at32f403a_407.h"
+#include "display_dev.h"
+
+/* Exported types ------------------------------------------------------------*/
+/**
+ * @brief  B3 命令的段编码 (标志字节低2位)
+ */
+typedef enum
+{
+    DISPLAY_ENC_RAW = 0,            /*!< 原始字节 */
+    DISPLAY_ENC_RLE,                /*!< 游程编码, 解码后写入帧缓冲区 */
+    DISPLAY_ENC_XOR_RLE             /*!< 游程编码的XOR差分, 解码后与帧缓冲区异或; 0的游程直接跳过 */
+} display_enc_t;
+
+/* Exported constants --------------------------------------------------------*/
+/*
+ * B3 帧格式: B3 标志 偏移(u16) 编码数据...
+ * 标志 bit2~3 选择显示设备 (display_dev_id_t, 0为OLED), 偏移和帧缓冲区布局由设备决定.
+ * 一次更新由若干段组成, 每段独立解码到 [偏移, 偏移+解码长度); 段之间未覆盖的区域不变.
+ * 最后一段带 DISPLAY_UPD_END, 处理后提交刷新并回复:
+ *   B3 状态 帧缓冲区CRC32(u32) 待刷新字节数(u16)
+ * 其他段不回复; 本次更新中任一段解码失败时状态为 CMD_STATUS_ERROR.
+ * 主机比较CRC32与自己的帧缓冲区副本, 不一致 (丢帧、本机复位) 时下次发送RLE完整帧
+ */
+#define DISPLAY_UPD_ENC_MASK        0x03    /*!< display_enc_t */
+#define DISPLAY_UPD_DEV_MASK        0x0C    /*!< display_dev_id_t */
+#define DISPLAY_UPD_DEV_SHIFT       2
+#define DISPLAY_UPD_FULL            0x40    /*!< 整屏重新刷新 (显示屏重新上电后) */
+#define DISPLAY_UPD_END             0x80    /*!< 本次更新的最后一段 */
+#define DISPLAY_UPD_HEADER_SIZE     4
+
+/*
+ * 游程编码, 控制字节:
+ *   0x00~0x7F: 其后 控制字节+1 个字节原样输出 (1~128)
+ *   0x80~0xFF: 其后1字节重复 (控制字节&0x7F)+2 次 (2~129)
+ */
+#define DISPLAY_RLE_RUN             0x80
+#define DISPLAY_RLE_COUNT_MASK      0x7F
+#define DISPLAY_RLE_RUN_MIN         2
+
+/* Exported macro ------------------------------------------------------------*/
+/* Exported functions prototypes ---------------------------------------------*/
+
+/**
+ * @brief  处理 B3 命令帧: 解码到所选设备的帧缓冲区, 最后一段回复并提交刷新
+ * @param  frame: 命令帧
+ * @param  len: 帧长度
+ * @retval None
+ */
+void display_update_command(const uint8_t* frame, uint16_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __DISPLAY_UPDATE_H */
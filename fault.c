@@ -0,0 +1,278 @@
+/**
+ * @file fault.c
+ * @brief 故障捕获模块实现 (异常现场保存、复位后通过RS485读取)
+ * @author Jason
+ * @date 2026-10-18
+ *
+ * 异常入口按EXC_RETURN选择MSP/PSP得到硬件压栈的栈帧, 连同故障状态寄存器和
+ * 最后的跟踪事件写入 .noinit 记录后软件复位. 记录在热复位后保留, 直到被读取清除
+ * 或被下一次故障覆盖. 保存过程中再次出错会进入锁定状态, 由看门狗复位.
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "fault.h"
+#include "main.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/**
+ * @brief  复位后保留的记录
+ */
+typedef struct
+{
+    uint32_t magic;                 /*!< FAULT_RECORD_MAGIC */
+    uint32_t check;                 /*!< data 各字之和取反 */
+    fault_record_t data;
+} fault_store_t;
+
+/* Private define ------------------------------------------------------------*/
+#define FAULT_RECORD_MAGIC      0x544C4146  // "FALT"
+
+/* 异常栈帧 (8字) 必须完整落在SRAM内, 与链接脚本一致 */
+#define FAULT_SRAM_START        0x20000000
+#define FAULT_SRAM_END          (FAULT_SRAM_START + 96 * 1024)
+
+#define FAULT_FRAME_WORDS       8
+#define FAULT_DUMP_HEADER_SIZE  4
+
+/* 异常入口: 按EXC_RETURN第2位选择栈指针, 与EXC_RETURN一起传给 fault_capture */
+#define FAULT_ENTRY_ASM                 \
+    "tst lr, #4             \n"         \
+    "ite eq                 \n"         \
+    "mrseq r0, msp          \n"         \
+    "mrsne r0, psp          \n"         \
+    "mov r1, lr             \n"         \
+    "b fault_capture        \n"
+
+#if defined(__ICCARM__)
+#define FAULT_ENTRY             __stackless
+#else
+#define FAULT_ENTRY             __attribute__((naked))
+#endif
+
+/* Private macro -------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+NOINIT static fault_store_t fault_store;
+
+static uint8_t fault_valid = 0;
+
+/* Private function prototypes -----------------------------------------------*/
+static uint32_t fault_checksum(void);
+static uint8_t fault_record_valid(void);
+static void fault_finish(void);
+void fault_capture(const uint32_t* frame, uint32_t exc_return);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief  计算记录校验
+ * @param  None
+ * @retval 校验值
+ */
+static uint32_t fault_checksum(void)
+{
+    const uint32_t* p = (const uint32_t*)&fault_store.data;
+    uint32_t sum = 0;
+    uint32_t i;
+
+    for(i = 0; i < sizeof(fault_record_t) / 4; i++)
+    {
+        sum += p[i];
+    }
+
+    return ~sum;
+}
+
+/**
+ * @brief  检查 .noinit 中的记录是否有效
+ * @param  None
+ * @retval 1: 有效, 0: 无效
+ */
+static uint8_t fault_record_valid(void)
+{
+    return ((fault_store.magic == FAULT_RECORD_MAGIC) && (fault_store.check == fault_checksum())) ? 1 : 0;
+}
+
+/**
+ * @brief  补全记录的公共部分, 写入校验后复位 (不返回)
+ * @note   调用前已填好原因、栈帧和故障寄存器
+ * @param  None
+ * @retval None
+ */
+static void fault_finish(void)
+{
+    uint16_t count = fault_record_valid() ? fault_store.data.fault_count : 0;
+
+    fault_store.magic = 0;
+
+    fault_store.data.uptime_ms = watchdog_ticks;
+    fault_store.data.core_clock = system_core_clock;
+    fault_store.data.trace_count = trace_copy_last(fault_store.data.trace, FAULT_TRACE_EVENTS);
+    fault_store.data.fault_count = count + 1;
+
+    fault_store.check = fault_checksum();
+    fault_store.magic = FAULT_RECORD_MAGIC;
+
+    __DSB();
+    NVIC_SystemReset();
+}
+
+/**
+ * @brief  保存异常现场并复位 (由异常入口跳转, 不返回)
+ * @param  frame: 硬件压栈的栈帧
+ * @param  exc_return: 进入异常时的LR
+ * @retval None
+ */
+void fault_capture(const uint32_t* frame, uint32_t exc_return)
+{
+    uint32_t addr = (uint32_t)frame;
+    uint32_t* regs = &fault_store.data.r0;
+    uint8_t i;
+
+    /* 栈溢出时栈帧可能不在SRAM中, 不读取 */
+    if(((addr & 3) != 0) || (addr < FAULT_SRAM_START) ||
+       (addr > FAULT_SRAM_END - FAULT_FRAME_WORDS * 4))
+    {
+        frame = NULL;
+    }
+
+    for(i = 0; i < FAULT_FRAME_WORDS; i++)
+    {
+        regs[i] = (frame != NULL) ? frame[i] : 0;
+    }
+
+    fault_store.data.cause = __get_IPSR() & 0x1FF;
+    fault_store.data.exc_return = exc_return;
+    fault_store.data.sp = addr;
+    fault_store.data.cfsr = SCB->CFSR;
+    fault_store.data.hfsr = SCB->HFSR;
+    fault_store.data.mmfar = SCB->MMFAR;
+    fault_store.data.bfar = SCB->BFAR;
+
+    fault_finish();
+}
+
+/**
+ * @brief  HardFault异常入口
+ * @param  None
+ * @retval None
+ */
+FAULT_ENTRY void HardFault_Handler(void)
+{
+    __asm volatile(FAULT_ENTRY_ASM);
+}
+
+/**
+ * @brief  MemManage异常入口
+ * @param  None
+ * @retval None
+ */
+FAULT_ENTRY void MemManage_Handler(void)
+{
+    __asm volatile(FAULT_ENTRY_ASM);
+}
+
+/**
+ * @brief  BusFault异常入口
+ * @param  None
+ * @retval None
+ */
+FAULT_ENTRY void BusFault_Handler(void)
+{
+    __asm volatile(FAULT_ENTRY_ASM);
+}
+
+/**
+ * @brief  UsageFault异常入口
+ * @param  None
+ * @retval None
+ */
+FAULT_ENTRY void UsageFault_Handler(void)
+{
+    __asm volatile(FAULT_ENTRY_ASM);
+}
+
+/**
+ * @brief  使能MemManage/BusFault/UsageFault和除零陷阱, 检查上次的故障记录
+ * @note   在main开头调用, 越早越能捕获初始化中的故障
+ * @param  None
+ * @retval None
+ */
+void fault_init(void)
+{
+    /* 上电后 .noinit 为随机值; 复位标志由 watchdog_init 读取后清除 */
+    if(crm_flag_get(CRM_POR_RESET_FLAG) != RESET)
+    {
+        fault_store.magic = 0;
+    }
+
+    fault_valid = fault_record_valid();
+
+    SCB->SHCSR |= SCB_SHCSR_MEMFAULTENA_Msk | SCB_SHCSR_BUSFAULTENA_Msk | SCB_SHCSR_USGFAULTENA_Msk;
+    SCB->CCR |= SCB_CCR_DIV_0_TRP_Msk;
+}
+
+/**
+ * @brief  记录软件错误并复位 (不返回)
+ * @param  cause: 原因
+ * @param  pc: 出错位置
+ * @retval None
+ */
+void fault_software(fault_cause_t cause, uint32_t pc)
+{
+    uint32_t* regs = &fault_store.data.r0;
+    uint8_t i;
+
+    __disable_irq();
+
+    for(i = 0; i < FAULT_FRAME_WORDS; i++)
+    {
+        regs[i] = 0;
+    }
+
+    fault_store.data.cause = (uint32_t)cause;
+    fault_store.data.pc = pc;
+    fault_store.data.exc_return = 0;
+    fault_store.data.sp = __get_MSP();
+    fault_store.data.cfsr = SCB->CFSR;
+    fault_store.data.hfsr = SCB->HFSR;
+    fault_store.data.mmfar = SCB->MMFAR;
+    fault_store.data.bfar = SCB->BFAR;
+
+    fault_finish();
+}
+
+/**
+ * @brief  清除故障记录
+ * @param  None
+ * @retval None
+ */
+void fault_clear(void)
+{
+    fault_store.magic = 0;
+    fault_valid = 0;
+}
+
+/**
+ * @brief  通过RS485发送故障记录 (单帧)
+ * @note   帧格式: 命令字, 版本, 有效标志, 保留, fault_record_t (小端);
+ *         无记录时只发送前4字节
+ * @param  None
+ * @retval None
+ */
+void fault_send_dump(void)
+{
+    uint8_t header[FAULT_DUMP_HEADER_SIZE];
+
+    header[0] = RS485_CMD_FAULT_DUMP;
+    header[1] = FAULT_DUMP_VERSION;
+    header[2] = fault_valid;
+    header[3] = 0;
+
+    rs485_frame_begin();
+    rs485_frame_write(header, sizeof(header));
+    if(fault_valid)
+    {
+        rs485_frame_write((const uint8_t*)&fault_store.data, sizeof(fault_record_t));
+    }
+    rs485_frame_end();
+}
@@ -0,0 +1,115 @@
+/**
+ * @file fault.h
+ * @brief 故障捕获模块头文件 (异常现场保存、复位后通过RS485读取)
+ * @author Jason
+ * @date 2026-10-18
+ */
+
+#ifndef __FAULT_H
+#define __FAULT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "at32f403a_407.h"
+#include "trace.h"
+
+/* Exported types ------------------------------------------------------------*/
+/* 故障记录中保存的跟踪事件数 */
+#define FAULT_TRACE_EVENTS          16
+
+/**
+ * @brief  故障原因 (异常号或软件错误)
+ */
+typedef enum
+{
+    FAULT_CAUSE_NONE            = 0,
+    FAULT_CAUSE_HARDFAULT       = 3,
+    FAULT_CAUSE_MEMMANAGE       = 4,
+    FAULT_CAUSE_BUSFAULT        = 5,
+    FAULT_CAUSE_USAGEFAULT      = 6,
+    FAULT_CAUSE_ERROR_HANDLER   = 0x100 /*!< Error_Handler, pc 为调用位置 */
+} fault_cause_t;
+
+/**
+ * @brief  故障现场 (复位后保留在 .noinit 中)
+ */
+typedef struct
+{
+    uint32_t cause;                 /*!< fault_cause_t */
+    uint32_t uptime_ms;             /*!< 故障时的运行时间 (ms) */
+    uint32_t r0;                    /*!< 异常栈帧: r0-r3, r12, lr, pc, xpsr */
+    uint32_t r1;
+    uint32_t r2;
+    uint32_t r3;
+    uint32_t r12;
+    uint32_t lr;
+    uint32_t pc;
+    uint32_t xpsr;
+    uint32_t exc_return;            /*!< 进入异常时的LR */
+    uint32_t sp;                    /*!< 异常栈帧地址 (无效时栈帧各项为0) */
+    uint32_t cfsr;                  /*!< 可配置故障状态 */
+    uint32_t hfsr;                  /*!< HardFault状态 */
+    uint32_t mmfar;                 /*!< 存储管理故障地址 */
+    uint32_t bfar;                  /*!< 总线故障地址 */
+    uint32_t core_clock;            /*!< 跟踪时间戳频率 (Hz) */
+    uint16_t trace_count;           /*!< 有效跟踪事件数 */
+    uint16_t fault_count;           /*!< 上电以来故障次数 */
+    trace_event_t trace[FAULT_TRACE_EVENTS]; /*!< 故障前最后的跟踪事件, 按时间先后 */
+} fault_record_t;
+
+/* Exported constants --------------------------------------------------------*/
+/* 故障转储帧格式版本 */
+#define FAULT_DUMP_VERSION          1
+
+/* AB 命令参数: 发送后清除记录 */
+#define FAULT_DUMP_CLEAR            0x01
+
+/* Exported macro ------------------------------------------------------------*/
+/* 当前函数的返回地址, 用作软件错误的出错位置 */
+#if defined(__GNUC__)
+#define FAULT_RETURN_ADDRESS()      ((uint32_t)__builtin_return_address(0))
+#else
+#define FAULT_RETURN_ADDRESS()      (0)
+#endif
+/* Exported functions prototypes ---------------------------------------------*/
+
+/**
+ * @brief  使能MemManage/BusFault/UsageFault和除零陷阱, 检查上次的故障记录
+ * @note   在main开头调用, 越早越能捕获初始化中的故障
+ * @param  None
+ * @retval None
+ */
+void fault_init(void);
+
+/**
+ * @brief  记录软件错误并复位 (不返回)
+ * @param  cause: 原因
+ * @param  pc: 出错位置
+ * @retval None
+ */
+void fault_software(fault_cause_t cause, uint32_t pc);
+
+/**
+ * @brief  清除故障记录
+ * @param  None
+ * @retval None
+ */
+void fault_clear(void);
+
+/**
+ * @brief  通过RS485发送故障记录 (单帧)
+ * @note   帧格式: 命令字, 版本, 有效标志, 保留, fault_record_t (小端);
+ *         无记录时只发送前4字节
+ * @param  None
+ * @retval None
+ */
+void fault_send_dump(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FAULT_H */
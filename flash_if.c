@@ -0,0 +1,138 @@
+/**
+ * @file flash_if.c
+ * @brief 内部Flash分区和擦写模块实现 (应用与bootloader共用)
+ * @author Jason
+ * @date 2026-10-18
+ *
+ * 只依赖固件库和 memmap.h, bootloader 直接链接本文件.
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "flash_if.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private define ------------------------------------------------------------*/
+#define FLASH_IF_ERASED_WORD    0xFFFFFFFF
+
+/* Private macro -------------------------------------------------------------*/
+/* 按小端从可能不对齐的地址取一个字 */
+#define FLASH_IF_GET_U32(p)     ((uint32_t)(p)[0] | ((uint32_t)(p)[1] << 8) | \
+                                 ((uint32_t)(p)[2] << 16) | ((uint32_t)(p)[3] << 24))
+
+/* Private variables ---------------------------------------------------------*/
+/* Private function prototypes -----------------------------------------------*/
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief  擦除一个扇区并检查 (在SRAM中执行)
+ * @note   擦除期间Flash不能取指, 等待循环放在SRAM中, RAM中的接收中断照常响应.
+ *         调用前须 flash_unlock. 写保护等原因未擦除时整个扇区不全为0xFF, 擦除后逐字检查
+ * @param  addr: 扇区地址
+ * @retval SUCCESS/ERROR
+ */
+RAMFUNC error_status flash_if_erase(uint32_t addr)
+{
+    uint32_t i;
+
+    FLASH->ctrl_bit.secers = TRUE;
+    FLASH->addr = addr;
+    FLASH->ctrl_bit.erstr = TRUE;
+
+    while(FLASH->sts_bit.obf)
+    {
+    }
+
+    FLASH->ctrl_bit.secers = FALSE;
+
+    for(i = 0; i < FLASH_IF_SECTOR_SIZE; i += 4)
+    {
+        if(FLASH_IF_WORD(addr + i) != FLASH_IF_ERASED_WORD)
+        {
+            return ERROR;
+        }
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief  按字写入并校验
+ * @note   调用前须 flash_unlock; 目标区域须已擦除, 源数据可不对齐
+ * @param  addr: 目标地址 (4字节对齐)
+ * @param  data: 数据
+ * @param  len: 长度 (4的倍数)
+ * @retval SUCCESS/ERROR
+ */
+error_status flash_if_program(uint32_t addr, const uint8_t* data, uint32_t len)
+{
+    uint32_t word;
+    uint32_t i;
+
+    for(i = 0; i < len; i += 4)
+    {
+        word = FLASH_IF_GET_U32(&data[i]);
+
+        /* 擦除后的值不用写 */
+        if(word != FLASH_IF_ERASED_WORD)
+        {
+            if(flash_word_program(addr + i, word) != FLASH_OPERATE_DONE)
+            {
+                return ERROR;
+            }
+        }
+
+        if(FLASH_IF_WORD(addr + i) != word)
+        {
+            return ERROR;
+        }
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief  检查区域是否为擦除状态
+ * @param  addr: 起始地址 (4字节对齐)
+ * @param  len: 长度 (4的倍数)
+ * @retval 1: 全为0xFF, 0: 否
+ */
+uint8_t flash_if_blank(uint32_t addr, uint32_t len)
+{
+    uint32_t i;
+
+    for(i = 0; i < len; i += 4)
+    {
+        if(FLASH_IF_WORD(addr + i) != FLASH_IF_ERASED_WORD)
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * @brief  计算CRC-32 (与zlib crc32相同, 硬件CRC单元)
+ * @note   按小端取字, 输入按字节位反转、输出位反转, 初值和结果异或0xFFFFFFFF
+ * @param  data: 数据, 可不对齐
+ * @param  len: 长度 (4的倍数)
+ * @retval CRC
+ */
+uint32_t flash_if_crc32(const uint8_t* data, uint32_t len)
+{
+    uint32_t i;
+
+    crm_periph_clock_enable(CRM_CRC_PERIPH_CLOCK, TRUE);
+
+    crc_init_data_set(0xFFFFFFFF);
+    crc_reverse_input_data_set(CRC_REVERSE_INPUT_BY_BYTE);
+    crc_reverse_output_data_set(CRC_REVERSE_OUTPUT_DATA);
+    crc_data_reset();
+
+    for(i = 0; i < len; i += 4)
+    {
+        CRC->dt = FLASH_IF_GET_U32(&data[i]);
+    }
+
+    return ~crc_data_get();
+}
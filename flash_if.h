@@ -0,0 +1,90 @@
+/**
+ * @file flash_if.h
+ * @brief 内部Flash分区和擦写模块头文件 (应用与bootloader共用)
+ * @author Jason
+ * @date 2026-10-18
+ */
+
+#ifndef __FLASH_IF_H
+#define __FLASH_IF_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "at32f403a_407.h"
+#include "memmap.h"
+
+/* Exported types ------------------------------------------------------------*/
+/* Exported constants --------------------------------------------------------*/
+#define FLASH_IF_SECTOR_SIZE        2048
+
+/*
+ * 分区 (256KB), 链接脚本 AT32F403AxC_FLASH.ld / bootloader/AT32F403AxC_BOOT.ld 与此一致:
+ *   0x08000000  16KB   bootloader
+ *   0x08004000  112KB  应用程序
+ *   0x08020000  112KB  更新暂存区 (新固件先写入此处, 重启时由bootloader复制到应用区)
+ *   0x0803C000  2KB    更新状态 (会话、各块完成标记、提交标记)
+ *   0x0803C800  10KB   保留
+ *   0x0803F000  4KB    配置存储 (两个扇区)
+ */
+#define FLASH_IF_BOOT_BASE          0x08000000
+#define FLASH_IF_BOOT_SIZE          (16 * 1024)
+#define FLASH_IF_APP_BASE           0x08004000
+#define FLASH_IF_APP_SIZE           (112 * 1024)
+#define FLASH_IF_STAGING_BASE       0x08020000
+#define FLASH_IF_STAGING_SIZE       (112 * 1024)
+#define FLASH_IF_STATE_BASE         0x0803C000
+#define FLASH_IF_CONFIG_BASE        0x0803F000
+
+/* 应用程序栈指针的合法范围 (SRAM 96KB) */
+#define FLASH_IF_SRAM_BASE          0x20000000
+#define FLASH_IF_SRAM_SIZE          (96 * 1024)
+
+/* Exported macro ------------------------------------------------------------*/
+#define FLASH_IF_WORD(addr)         (*(__IO uint32_t*)(addr))
+#define FLASH_IF_HALFWORD(addr)     (*(__IO uint16_t*)(addr))
+
+/* Exported functions prototypes ---------------------------------------------*/
+
+/**
+ * @brief  擦除一个扇区并检查 (在SRAM中执行)
+ * @note   擦除期间Flash不能取指, 等待循环放在SRAM中, RAM中的接收中断照常响应.
+ *         调用前须 flash_unlock
+ * @param  addr: 扇区地址
+ * @retval SUCCESS: 整个扇区为0xFF, ERROR: 未擦除 (写保护或Flash损坏)
+ */
+RAMFUNC error_status flash_if_erase(uint32_t addr);
+
+/**
+ * @brief  按字写入并校验
+ * @note   调用前须 flash_unlock; 目标区域须已擦除, 源数据可不对齐
+ * @param  addr: 目标地址 (4字节对齐)
+ * @param  data: 数据
+ * @param  len: 长度 (4的倍数)
+ * @retval SUCCESS/ERROR
+ */
+error_status flash_if_program(uint32_t addr, const uint8_t* data, uint32_t len);
+
+/**
+ * @brief  检查区域是否为擦除状态
+ * @param  addr: 起始地址 (4字节对齐)
+ * @param  len: 长度 (4的倍数)
+ * @retval 1: 全为0xFF, 0: 否
+ */
+uint8_t flash_if_blank(uint32_t addr, uint32_t len);
+
+/**
+ * @brief  计算CRC-32 (与zlib crc32相同, 硬件CRC单元)
+ * @param  data: 数据, 可不对齐
+ * @param  len: 长度 (4的倍数)
+ * @retval CRC
+ */
+uint32_t flash_if_crc32(const uint8_t* data, uint32_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FLASH_IF_H */
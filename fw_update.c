@@ -0,0 +1,520 @@
+/**
+ * @file fw_update.c
+ * @brief RS485固件更新模块实现 (写入暂存区, 重启后由bootloader安装)
+ * @author Jason
+ * @date 2026-10-18
+ *
+ * 新映像按 FW_CHUNK_SIZE 分块写入暂存区, 应用程序照常运行. 进度全部记在状态扇区:
+ * 会话头、暂存区各扇区的已擦除标记、各块的已写入标记 (半字写0), 复位或断线后
+ * 主机用相同参数重新 BEGIN 即可从缺失的块继续. 暂存区在主循环中每次擦除一个扇区.
+ * 提交时校验整个映像的CRC并写提交标记, 重启后bootloader把暂存区复制到应用区,
+ * 校验通过后才擦除状态扇区; 复制中途掉电, 下次启动重新复制.
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "fw_update.h"
+#include "main.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private define ------------------------------------------------------------*/
+#define FW_DATA_HEADER_SIZE     9       // AC op 标志 块号(u16) CRC32
+#define FW_BEGIN_SIZE           14      // AC op 大小 CRC32 版本
+#define FW_PROGRESS_SIZE        11      // AC op 状态 下一个缺失块(u16) 已收块数(u16) 位图(u32)
+#define FW_BEGIN_REPLY_SIZE     (FW_PROGRESS_SIZE + 3)  // 进度 + 块大小(u16) 窗口(u8)
+#define FW_SECTOR_MAX           (FLASH_IF_STAGING_SIZE / FLASH_IF_SECTOR_SIZE)
+
+#if FW_DATA_HEADER_SIZE + FW_CHUNK_SIZE > RS485_FRAME_MAX_SIZE
+#error "FW_CHUNK_SIZE too large for RS485_FRAME_MAX_SIZE"
+#endif
+
+#if FW_STATE_ERASED_OFFSET + FW_SECTOR_MAX * 2 > FW_STATE_CHUNK_OFFSET
+#error "staging sector marks overlap chunk marks"
+#endif
+
+#if FW_STATE_CHUNK_OFFSET + FW_CHUNK_MAX * 2 > FLASH_IF_SECTOR_SIZE
+#error "chunk marks exceed the state sector"
+#endif
+
+#if FW_WINDOW < 1
+#error "RS485_FRAME_POOL_SIZE too small for pipelined firmware update"
+#endif
+
+/* Private macro -------------------------------------------------------------*/
+#define FW_CHUNK_DONE(n)        (FLASH_IF_HALFWORD(FW_STATE_CHUNK_ADDR(n)) == FW_STATE_MARK_DONE)
+#define FW_SECTOR_ERASED(n)     (FLASH_IF_HALFWORD(FW_STATE_ERASED_ADDR(n)) == FW_STATE_MARK_DONE)
+
+/* Private variables ---------------------------------------------------------*/
+static uint8_t fw_active = 0;
+static uint16_t fw_chunk_count = 0;
+static uint16_t fw_done_count = 0;
+static uint16_t fw_next_missing = 0;
+static uint8_t fw_sector_count = 0;         // 映像占用的暂存区扇区数
+static uint8_t fw_erased_count = 0;         // 已擦除的扇区数 (从头开始顺序擦除)
+static uint8_t fw_error = FW_STATUS_OK;     // 未确认帧的错误, 在下一次进度回复中报告
+static uint8_t fw_reboot_pending = 0;
+
+/* Private function prototypes -----------------------------------------------*/
+static uint8_t fw_session_valid(const fw_session_t* session);
+static void fw_scan(void);
+static error_status fw_mark(uint32_t addr);
+static uint32_t fw_chunk_len(uint16_t index);
+static uint16_t fw_progress_build(uint8_t* reply, uint8_t op, uint8_t status);
+static void fw_send_progress(uint8_t op, uint8_t status);
+static void fw_begin(const uint8_t* frame, uint16_t len);
+static void fw_data(const uint8_t* frame, uint16_t len);
+static void fw_commit(void);
+static void fw_abort(void);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief  检查会话参数
+ * @param  session: 会话
+ * @retval 1: 有效, 0: 无效
+ */
+static uint8_t fw_session_valid(const fw_session_t* session)
+{
+    return ((session->magic == FW_SESSION_MAGIC) && (session->check == FW_SESSION_CHECK(session)) &&
+            (session->size != 0) && ((session->size & 3) == 0) &&
+            (session->size <= FLASH_IF_STAGING_SIZE)) ? 1 : 0;
+}
+
+/**
+ * @brief  从状态扇区统计进度
+ * @param  None
+ * @retval None
+ */
+static void fw_scan(void)
+{
+    uint16_t i;
+
+    fw_active = fw_session_valid(FW_STATE_SESSION);
+    if(!fw_active)
+    {
+        return;
+    }
+
+    fw_chunk_count = (uint16_t)((FW_STATE_SESSION->size + FW_CHUNK_SIZE - 1) / FW_CHUNK_SIZE);
+    fw_sector_count = (uint8_t)((FW_STATE_SESSION->size + FLASH_IF_SECTOR_SIZE - 1) / FLASH_IF_SECTOR_SIZE);
+
+    fw_erased_count = 0;
+    while((fw_erased_count < fw_sector_count) && FW_SECTOR_ERASED(fw_erased_count))
+    {
+        fw_erased_count++;
+    }
+
+    fw_done_count = 0;
+    fw_next_missing = fw_chunk_count;
+    for(i = 0; i < fw_chunk_count; i++)
+    {
+        if(FW_CHUNK_DONE(i))
+        {
+            fw_done_count++;
+        }
+        else if(fw_next_missing == fw_chunk_count)
+        {
+            fw_next_missing = i;
+        }
+    }
+}
+
+/**
+ * @brief  在状态扇区写一个完成标记
+ * @param  addr: 标记地址
+ * @retval SUCCESS/ERROR
+ */
+static error_status fw_mark(uint32_t addr)
+{
+    flash_status_type status;
+
+    flash_unlock();
+    status = flash_halfword_program(addr, FW_STATE_MARK_DONE);
+    flash_lock();
+
+    return (status == FLASH_OPERATE_DONE) ? SUCCESS : ERROR;
+}
+
+/**
+ * @brief  数据块长度 (最后一块可能不足 FW_CHUNK_SIZE)
+ * @param  index: 块号
+ * @retval 长度
+ */
+static uint32_t fw_chunk_len(uint16_t index)
+{
+    uint32_t offset = (uint32_t)index * FW_CHUNK_SIZE;
+    uint32_t left = FW_STATE_SESSION->size - offset;
+
+    return (left < FW_CHUNK_SIZE) ? left : FW_CHUNK_SIZE;
+}
+
+/**
+ * @brief  生成进度回复
+ * @note   AC op 状态 下一个缺失块 已收块数 位图; 位图第i位为 下一个缺失块+i 是否已收到,
+ *         主机据此只重发缺失的块. 有未报告的错误时状态为该错误
+ * @param  reply: 输出缓冲区 (至少 FW_PROGRESS_SIZE 字节)
+ * @param  op: 操作码
+ * @param  status: 状态 (OK时按擦除进度改为BUSY)
+ * @retval 长度
+ */
+static uint16_t fw_progress_build(uint8_t* reply, uint8_t op, uint8_t status)
+{
+    uint32_t bitmap = 0;
+    uint16_t i;
+
+    if(status == FW_STATUS_OK)
+    {
+        if(fw_error != FW_STATUS_OK)
+        {
+            status = fw_error;
+        }
+        else if(!fw_active)
+        {
+            status = FW_STATUS_ERROR_STATE;
+        }
+        else if(fw_erased_count < fw_sector_count)
+        {
+            status = FW_STATUS_BUSY;
+        }
+    }
+    fw_error = FW_STATUS_OK;
+
+    for(i = 0; (i < 32) && (fw_next_missing + i < fw_chunk_count); i++)
+    {
+        if(FW_CHUNK_DONE(fw_next_missing + i))
+        {
+            bitmap |= (1UL << i);
+        }
+    }
+
+    reply[0] = RS485_CMD_FW_UPDATE;
+    reply[1] = op;
+    reply[2] = status;
+    rs485_put_u16(&reply[3], fw_next_missing);
+    rs485_put_u16(&reply[5], fw_done_count);
+    rs485_put_u32(&reply[7], bitmap);
+
+    return FW_PROGRESS_SIZE;
+}
+
+/**
+ * @brief  回复接收进度
+ * @param  op: 操作码
+ * @param  status: 状态
+ * @retval None
+ */
+static void fw_send_progress(uint8_t op, uint8_t status)
+{
+    uint8_t reply[FW_PROGRESS_SIZE];
+
+    rs485_frame_send(reply, fw_progress_build(reply, op, status));
+}
+
+/**
+ * @brief  开始或恢复会话
+ * @note   参数与状态扇区中的会话相同时保留进度, 否则擦除状态扇区开始新会话.
+ *         回复为进度后附块大小(u16)和窗口(u8)
+ * @param  frame: 命令帧
+ * @param  len: 帧长度
+ * @retval None
+ */
+static void fw_begin(const uint8_t* frame, uint16_t len)
+{
+    uint8_t reply[FW_BEGIN_REPLY_SIZE];
+    fw_session_t session;
+    uint8_t status = FW_STATUS_OK;
+
+    session.magic = FW_SESSION_MAGIC;
+    session.size = (len >= FW_BEGIN_SIZE) ? rs485_get_u32(&frame[2]) : 0;
+    session.crc32 = (len >= FW_BEGIN_SIZE) ? rs485_get_u32(&frame[6]) : 0;
+    session.version = (len >= FW_BEGIN_SIZE) ? rs485_get_u32(&frame[10]) : 0;
+    session.check = FW_SESSION_CHECK(&session);
+
+    if(!fw_session_valid(&session))
+    {
+        status = FW_STATUS_ERROR_PARAM;
+    }
+    else if(!fw_active || (FW_STATE_SESSION->size != session.size) ||
+            (FW_STATE_SESSION->crc32 != session.crc32) ||
+            (FW_STATE_SESSION->version != session.version))
+    {
+        /* 新会话: 暂存区由 fw_update_poll 逐扇区擦除 */
+        flash_unlock();
+        if((flash_if_erase(FLASH_IF_STATE_BASE) != SUCCESS) ||
+           (flash_if_program(FLASH_IF_STATE_BASE, (const uint8_t*)&session, sizeof(session)) != SUCCESS))
+        {
+            status = FW_STATUS_ERROR_FLASH;
+        }
+        flash_lock();
+
+        fw_scan();
+    }
+
+    /* BEGIN 也用于断线后重新同步, 之前未确认帧的错误不再报告, 缺失的块由位图体现 */
+    fw_error = FW_STATUS_OK;
+
+    fw_progress_build(reply, FW_OP_BEGIN, status);
+    rs485_put_u16(&reply[FW_PROGRESS_SIZE], FW_CHUNK_SIZE);
+    reply[FW_PROGRESS_SIZE + 2] = FW_WINDOW;
+
+    rs485_frame_send(reply, sizeof(reply));
+}
+
+/**
+ * @brief  写入一个数据块
+ * @note   AC 01 标志 块号 CRC32 数据, CRC32为数据的CRC异或块号, 块号出错也能检出.
+ *         只有带 FW_DATA_ACK 的帧回复进度, 其余帧的错误
+ *         记在 fw_error 中随下一次进度报告. 重复的块直接确认; 块区域非空时 (写入后
+ *         未来得及写完成标记就复位) 内容相同则补写标记, 不同则报告写入失败
+ * @param  frame: 命令帧
+ * @param  len: 帧长度
+ * @retval None
+ */
+static void fw_data(const uint8_t* frame, uint16_t len)
+{
+    const uint8_t* data = &frame[FW_DATA_HEADER_SIZE];
+    uint32_t data_len;
+    uint32_t addr;
+    uint32_t i;
+    uint16_t index;
+    uint8_t status = FW_STATUS_OK;
+
+    if(len < FW_DATA_HEADER_SIZE)
+    {
+        fw_send_progress(FW_OP_DATA, FW_STATUS_ERROR_PARAM);
+        return;
+    }
+
+    index = rs485_get_u16(&frame[3]);
+    data_len = len - FW_DATA_HEADER_SIZE;
+    addr = FLASH_IF_STAGING_BASE + (uint32_t)index * FW_CHUNK_SIZE;
+
+    if(!fw_active)
+    {
+        status = FW_STATUS_ERROR_STATE;
+    }
+    else if((index >= fw_chunk_count) || (data_len != fw_chunk_len(index)))
+    {
+        status = FW_STATUS_ERROR_PARAM;
+    }
+    else if((flash_if_crc32(data, data_len) ^ index) != rs485_get_u32(&frame[5]))
+    {
+        status = FW_STATUS_ERROR_CRC;
+    }
+    else if(index / FW_CHUNKS_PER_SECTOR >= fw_erased_count)
+    {
+        /* 所在扇区还未擦除, 丢弃, 主机按位图重发 */
+        status = FW_STATUS_BUSY;
+    }
+    else if(!FW_CHUNK_DONE(index))
+    {
+        if(flash_if_blank(addr, data_len))
+        {
+            flash_unlock();
+            if(flash_if_program(addr, data, data_len) != SUCCESS)
+            {
+                status = FW_STATUS_ERROR_FLASH;
+            }
+            flash_lock();
+        }
+        else
+        {
+            for(i = 0; i < data_len; i++)
+            {
+                if(*(const uint8_t*)(addr + i) != data[i])
+                {
+                    status = FW_STATUS_ERROR_FLASH;
+                    break;
+                }
+            }
+        }
+
+        if((status == FW_STATUS_OK) && (fw_mark(FW_STATE_CHUNK_ADDR(index)) != SUCCESS))
+        {
+            status = FW_STATUS_ERROR_FLASH;
+        }
+
+        if(status == FW_STATUS_OK)
+        {
+            fw_done_count++;
+            while((fw_next_missing < fw_chunk_count) && FW_CHUNK_DONE(fw_next_missing))
+            {
+                fw_next_missing++;
+            }
+        }
+    }
+
+    if((status != FW_STATUS_OK) && (status != FW_STATUS_BUSY))
+    {
+        METRIC_INC(METRIC_FW_CHUNK_REJECT);
+        fw_error = status;
+    }
+
+    if(frame[2] & FW_DATA_ACK)
+    {
+        fw_send_progress(FW_OP_DATA, FW_STATUS_OK);
+    }
+}
+
+/**
+ * @brief  校验整个映像并写提交标记
+ * @param  None
+ * @retval None
+ */
+static void fw_commit(void)
+{
+    uint8_t reply[3];
+    flash_status_type result;
+
+    reply[0] = RS485_CMD_FW_UPDATE;
+    reply[1] = FW_OP_COMMIT;
+    reply[2] = FW_STATUS_OK;
+
+    if(!fw_active || (fw_done_count != fw_chunk_count))
+    {
+        reply[2] = FW_STATUS_ERROR_STATE;
+    }
+    else if(flash_if_crc32((const uint8_t*)FLASH_IF_STAGING_BASE, FW_STATE_SESSION->size) != FW_STATE_SESSION->crc32)
+    {
+        reply[2] = FW_STATUS_ERROR_VERIFY;
+    }
+    else if(FW_STATE_COMMIT != FW_COMMIT_MAGIC)
+    {
+        flash_unlock();
+        result = flash_word_program(FLASH_IF_STATE_BASE + FW_STATE_COMMIT_OFFSET, FW_COMMIT_MAGIC);
+        flash_lock();
+
+        if(result != FLASH_OPERATE_DONE)
+        {
+            reply[2] = FW_STATUS_ERROR_FLASH;
+        }
+    }
+
+    rs485_frame_send(reply, sizeof(reply));
+}
+
+/**
+ * @brief  放弃会话 (擦除状态扇区, 暂存区内容留到下次会话擦除)
+ * @param  None
+ * @retval None
+ */
+static void fw_abort(void)
+{
+    uint8_t reply[3];
+    error_status status;
+
+    flash_unlock();
+    status = flash_if_erase(FLASH_IF_STATE_BASE);
+    flash_lock();
+
+    fw_active = 0;
+    fw_chunk_count = 0;
+    fw_done_count = 0;
+    fw_next_missing = 0;
+    fw_sector_count = 0;
+    fw_erased_count = 0;
+    fw_error = FW_STATUS_OK;
+
+    reply[0] = RS485_CMD_FW_UPDATE;
+    reply[1] = FW_OP_ABORT;
+    reply[2] = (status == SUCCESS) ? FW_STATUS_OK : FW_STATUS_ERROR_FLASH;
+    rs485_frame_send(reply, sizeof(reply));
+}
+
+/**
+ * @brief  从状态扇区恢复未完成的会话
+ * @param  None
+ * @retval None
+ */
+void fw_update_init(void)
+{
+    fw_scan();
+}
+
+/**
+ * @brief  处理 AC 命令帧
+ * @param  frame: 命令帧
+ * @param  len: 帧长度
+ * @retval None
+ */
+void fw_update_command(const uint8_t* frame, uint16_t len)
+{
+    uint8_t reply[3];
+
+    if(len < 2)
+    {
+        return;
+    }
+
+    switch(frame[1])
+    {
+        case FW_OP_BEGIN:
+            fw_begin(frame, len);
+            break;
+
+        case FW_OP_DATA:
+            fw_data(frame, len);
+            break;
+
+        case FW_OP_STATUS:
+            fw_send_progress(FW_OP_STATUS, FW_STATUS_OK);
+            break;
+
+        case FW_OP_COMMIT:
+            fw_commit();
+            break;
+
+        case FW_OP_ABORT:
+            fw_abort();
+            break;
+
+        case FW_OP_REBOOT:
+            reply[0] = RS485_CMD_FW_UPDATE;
+            reply[1] = FW_OP_REBOOT;
+            reply[2] = FW_STATUS_OK;
+            rs485_frame_send(reply, sizeof(reply));
+            fw_reboot_pending = 1;
+            break;
+
+        default:
+            fw_send_progress(frame[1], FW_STATUS_ERROR_PARAM);
+            break;
+    }
+}
+
+/**
+ * @brief  后台擦除暂存区和延迟复位, 在主循环中调用
+ * @note   每次最多擦除一个扇区, 只在RS485总线空闲时进行; 复位等回复发送完成后进行
+ * @param  None
+ * @retval None
+ */
+void fw_update_poll(void)
+{
+    error_status status;
+
+    if(fw_reboot_pending)
+    {
+        if(rs485_line_idle())
+        {
+            NVIC_SystemReset();
+        }
+        return;
+    }
+
+    if(!fw_active || (fw_erased_count >= fw_sector_count) || !rs485_line_idle())
+    {
+        return;
+    }
+
+    flash_unlock();
+    status = flash_if_erase(FLASH_IF_STAGING_BASE + (uint32_t)fw_erased_count * FLASH_IF_SECTOR_SIZE);
+    flash_lock();
+
+    if((status == SUCCESS) && (fw_mark(FW_STATE_ERASED_ADDR(fw_erased_count)) == SUCCESS))
+    {
+        fw_erased_count++;
+    }
+    else
+    {
+        fw_error = FW_STATUS_ERROR_FLASH;
+    }
+}
@@ -0,0 +1,125 @@
+/**
+ * @file fw_update.h
+ * @brief RS485固件更新模块头文件 (写入暂存区, 重启后由bootloader安装)
+ * @author Jason
+ * @date 2026-10-18
+ */
+
+#ifndef __FW_UPDATE_H
+#define __FW_UPDATE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "at32f403a_407.h"
+#include "flash_if.h"
+#include "rs485_frame.h"
+
+/* Exported types ------------------------------------------------------------*/
+/**
+ * @brief  AC 命令的操作码 (帧第2字节)
+ */
+typedef enum
+{
+    FW_OP_BEGIN = 0,                /*!< 开始/恢复会话, 参数: 大小 CRC32 版本 (u32) */
+    FW_OP_DATA,                     /*!< 数据块, 参数: 标志 块号(u16) CRC32 数据 */
+    FW_OP_STATUS,                   /*!< 查询接收进度 */
+    FW_OP_COMMIT,                   /*!< 校验整个映像并标记待安装 */
+    FW_OP_ABORT,                    /*!< 放弃会话 */
+    FW_OP_REBOOT                    /*!< 回复后复位, 由bootloader安装 */
+} fw_op_t;
+
+/**
+ * @brief  回复状态
+ */
+typedef enum
+{
+    FW_STATUS_OK = 0,
+    FW_STATUS_BUSY,                 /*!< 正在擦除暂存区, 稍后重试 */
+    FW_STATUS_ERROR_PARAM,          /*!< 参数或长度错误 */
+    FW_STATUS_ERROR_STATE,          /*!< 无会话, 或提交时还有块未收到 */
+    FW_STATUS_ERROR_CRC,            /*!< 数据块CRC错误 */
+    FW_STATUS_ERROR_FLASH,          /*!< 写入失败 (块区域非空且内容不同, 须放弃后重新开始) */
+    FW_STATUS_ERROR_VERIFY          /*!< 整个映像CRC不符 */
+} fw_status_t;
+
+/**
+ * @brief  更新会话 (状态扇区开头)
+ */
+typedef struct
+{
+    uint32_t magic;                 /*!< FW_SESSION_MAGIC */
+    uint32_t size;                  /*!< 映像大小 (4的倍数) */
+    uint32_t crc32;                 /*!< 整个映像的CRC-32 */
+    uint32_t version;               /*!< 主机给出的版本号 */
+    uint32_t check;                 /*!< FW_SESSION_CHECK */
+} fw_session_t;
+
+/* Exported constants --------------------------------------------------------*/
+/* 数据块大小: 一帧 (9字节头 + 数据) 不超过 RS485_FRAME_MAX_SIZE */
+#define FW_CHUNK_SIZE               128
+#define FW_CHUNK_MAX                (FLASH_IF_STAGING_SIZE / FW_CHUNK_SIZE)
+#define FW_CHUNKS_PER_SECTOR        (FLASH_IF_SECTOR_SIZE / FW_CHUNK_SIZE)
+
+/*
+ * 确认窗口: 主机连续发送的块数, 最后一块带 FW_DATA_ACK, 本机处理完后回复一次.
+ * 半双工总线上不能边收边回复, 窗口内的帧在帧池中排队, 须小于帧池块数
+ */
+#define FW_WINDOW                   (RS485_FRAME_POOL_SIZE - 2)
+
+/* 数据帧标志 */
+#define FW_DATA_ACK                 0x01    /*!< 处理后回复进度 */
+
+/*
+ * 状态扇区布局 (FLASH_IF_STATE_BASE), 标记为半字, 写0表示完成, 擦除后可逐个写入:
+ *   0x000  fw_session_t
+ *   0x020  提交标记 (u32, FW_COMMIT_MAGIC)
+ *   0x040  暂存区各扇区已擦除标记
+ *   0x100  各数据块已写入标记
+ */
+#define FW_SESSION_MAGIC            0x31535746  // "FWS1"
+#define FW_COMMIT_MAGIC             0x544D4F43  // "COMT"
+#define FW_STATE_COMMIT_OFFSET      0x020
+#define FW_STATE_ERASED_OFFSET      0x040
+#define FW_STATE_CHUNK_OFFSET       0x100
+#define FW_STATE_MARK_DONE          0x0000
+
+/* Exported macro ------------------------------------------------------------*/
+#define FW_SESSION_CHECK(s)         (~((s)->magic ^ (s)->size ^ (s)->crc32 ^ (s)->version))
+
+#define FW_STATE_SESSION            ((const fw_session_t*)FLASH_IF_STATE_BASE)
+#define FW_STATE_COMMIT             FLASH_IF_WORD(FLASH_IF_STATE_BASE + FW_STATE_COMMIT_OFFSET)
+#define FW_STATE_ERASED_ADDR(n)     (FLASH_IF_STATE_BASE + FW_STATE_ERASED_OFFSET + (uint32_t)(n) * 2)
+#define FW_STATE_CHUNK_ADDR(n)      (FLASH_IF_STATE_BASE + FW_STATE_CHUNK_OFFSET + (uint32_t)(n) * 2)
+
+/* Exported functions prototypes ---------------------------------------------*/
+
+/**
+ * @brief  从状态扇区恢复未完成的会话
+ * @param  None
+ * @retval None
+ */
+void fw_update_init(void);
+
+/**
+ * @brief  处理 AC 命令帧
+ * @param  frame: 命令帧
+ * @param  len: 帧长度
+ * @retval None
+ */
+void fw_update_command(const uint8_t* frame, uint16_t len);
+
+/**
+ * @brief  后台擦除暂存区和延迟复位, 在主循环中调用
+ * @param  None
+ * @retval None
+ */
+void fw_update_poll(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FW_UPDATE_H */
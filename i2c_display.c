@@ -12,30 +12,78 @@
 /* Private typedef -----------------------------------------------------------*/
 /* Private define ------------------------------------------------------------*/
 #define I2C_TIMEOUT         1000    // I2C超时时间 (ms)
+#define I2C_PROBE_TIMEOUT   2       // 就绪探测超时时间 (ms)
 
 /* Private macro -------------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
+static i2c_display_state_t i2c_display_state = I2C_DISPLAY_STATE_PROBING;
+static uint32_t i2c_display_init_tick = 0;
+static uint32_t i2c_display_probe_tick = 0;
+static uint8_t i2c_display_address = DISPLAY_I2C_ADDRESS;    // 显示板地址, 可由配置存储覆盖
+
+/* 总线表: 外设 时钟 速率 DMA通道 弹性映射通道 请求源 完成标志 {软件I2C引脚} */
+static i2c_bus_t i2c_buses[I2C_BUS_COUNT] =
+{
+    { DISPLAY_I2C,  DISPLAY_I2C_CLK,  DISPLAY_I2C_SPEED,  DISPLAY_I2C_DMA_CHANNEL,
+      DISPLAY_I2C_DMA_FLEX_CHANNEL,  DISPLAY_I2C_DMA_REQUEST,  DISPLAY_I2C_DMA_FDT_FLAG,
+      { DISPLAY_SCL_GPIO_PORT,  DISPLAY_SCL_GPIO_PIN,  DISPLAY_SDA_GPIO_PORT,  DISPLAY_SDA_GPIO_PIN } },
+    { DISPLAY2_I2C, DISPLAY2_I2C_CLK, DISPLAY2_I2C_SPEED, DISPLAY2_I2C_DMA_CHANNEL,
+      DISPLAY2_I2C_DMA_FLEX_CHANNEL, DISPLAY2_I2C_DMA_REQUEST, DISPLAY2_I2C_DMA_FDT_FLAG,
+      { DISPLAY2_SCL_GPIO_PORT, DISPLAY2_SCL_GPIO_PIN, DISPLAY2_SDA_GPIO_PORT, DISPLAY2_SDA_GPIO_PIN } },
+};
+
+/* i2c_display_* 函数使用的总线 */
+static i2c_bus_t* const i2c_display_bus = &i2c_buses[I2C_BUS_DISPLAY];
+
+/* 传输描述符池 */
+MEM_POOL_STORAGE(i2c_xfer_pool_storage, sizeof(i2c_xfer_t), I2C_XFER_POOL_SIZE);
+static mem_pool_t i2c_xfer_pool;
+
+/* 对比测试数据 */
+DMA_BUFFER static uint8_t i2c_bench_data[I2C_BENCH_MAX_LEN];
+
 /* Private function prototypes -----------------------------------------------*/
-static error_status i2c_wait_flag(uint32_t flag, flag_status status, uint32_t timeout);
-static error_status i2c_wait_event(uint32_t event, uint32_t timeout);
+static error_status i2c_wait_flag(i2c_bus_t* bus, uint32_t flag, flag_status status, uint32_t timeout);
+static error_status i2c_wait_event(i2c_bus_t* bus, uint32_t event, uint32_t timeout);
+static void i2c_bus_recover(i2c_bus_t* bus);
+static void i2c_bus_config(i2c_bus_t* bus);
+static void i2c_bus_init(i2c_bus_t* bus);
+static error_status i2c_bus_wait_idle(i2c_bus_t* bus);
+static void i2c_bus_async_finish(i2c_bus_t* bus, error_status result);
+static error_status i2c_bus_start(i2c_bus_t* bus);
+static error_status i2c_bus_probe_locked(i2c_bus_t* bus, uint8_t device_addr);
+static error_status i2c_bus_transfer_locked(i2c_bus_t* bus, const i2c_xfer_t* xfer);
+static error_status i2c_bus_transfer_hw(i2c_bus_t* bus, const i2c_xfer_t* xfer);
+static error_status i2c_bus_write_address(i2c_bus_t* bus, uint8_t device_addr, uint8_t reg_addr);
+static error_status i2c_bus_write_start_locked(i2c_bus_t* bus, uint8_t device_addr, uint8_t reg_addr,
+                                               const uint8_t* data, uint16_t len);
+static uint8_t i2c_bus_poll_locked(i2c_bus_t* bus);
+static void i2c_bus_wedged(i2c_bus_t* bus);
+static void i2c_bus_pins_mux(i2c_bus_t* bus);
+static error_status i2c_display_clock_notify(clock_event_t event, clock_profile_t profile);
+static error_status i2c_display_xfer_run(i2c_bus_t* bus, uint8_t device_addr, uint8_t reg_addr,
+                                         i2c_xfer_dir_t dir, uint8_t* data, uint16_t len);
 
 /* Private functions ---------------------------------------------------------*/
 
 /**
  * @brief  等待I2C标志位
+ * @param  bus: 总线
  * @param  flag: 标志位
  * @param  status: 期望状态
  * @param  timeout: 超时时间
  * @retval SUCCESS/ERROR
  */
-static error_status i2c_wait_flag(uint32_t flag, flag_status status, uint32_t timeout)
+static error_status i2c_wait_flag(i2c_bus_t* bus, uint32_t flag, flag_status status, uint32_t timeout)
 {
     uint32_t tick_start = get_tick();
     
-    while(i2c_flag_get(DISPLAY_I2C, flag) != status)
+    while(i2c_flag_get(bus->i2c, flag) != status)
     {
         if((get_tick() - tick_start) > timeout)
         {
+            METRIC_INC(METRIC_I2C_TIMEOUT);
+            i2c_bus_recover(bus);
             return ERROR;
         }
     }
@@ -45,321 +93,1143 @@ static error_status i2c_wait_flag(uint32_t flag, flag_status status, uint32_t ti
 
 /**
  * @brief  等待I2C事件
+ * @param  bus: 总线
  * @param  event: 事件
  * @param  timeout: 超时时间
  * @retval SUCCESS/ERROR
  */
-static error_status i2c_wait_event(uint32_t event, uint32_t timeout)
+static error_status i2c_wait_event(i2c_bus_t* bus, uint32_t event, uint32_t timeout)
 {
     uint32_t tick_start = get_tick();
     
-    while(!i2c_event_check(DISPLAY_I2C, event))
+    while(!i2c_event_check(bus->i2c, event))
     {
+        /* 从机无应答, 无需等到超时 */
+        if(i2c_flag_get(bus->i2c, I2C_ACKFAIL_FLAG) != RESET)
+        {
+            i2c_flag_clear(bus->i2c, I2C_ACKFAIL_FLAG);
+            METRIC_INC(METRIC_I2C_NACK);
+            TRACE(TRACE_EVT_I2C_NACK, event);
+            i2c_bus_recover(bus);
+            return ERROR;
+        }
+        
         if((get_tick() - tick_start) > timeout)
         {
+            METRIC_INC(METRIC_I2C_TIMEOUT);
+            TRACE(TRACE_EVT_I2C_TIMEOUT, event);
+            i2c_bus_recover(bus);
             return ERROR;
         }
     }
     
+    TRACE(TRACE_EVT_I2C_STATE, event);
+    
     return SUCCESS;
 }
 
 /**
- * @brief  I2C显示板初始化
- * @param  None
+ * @brief  传输出错后释放总线
+ * @note   发送停止信号并恢复应答, 使下一次传输从空闲总线开始
+ * @param  bus: 总线
  * @retval None
  */
-void i2c_display_init(void)
+static void i2c_bus_recover(i2c_bus_t* bus)
+{
+    i2c_stop_generate(bus->i2c);
+    i2c_ack_enable(bus->i2c, TRUE);
+    
+    METRIC_INC(METRIC_I2C_RECOVERY);
+}
+
+/**
+ * @brief  I2C参数配置 (时钟分频由当前APB1时钟计算)
+ * @param  bus: 总线
+ * @retval None
+ */
+static void i2c_bus_config(i2c_bus_t* bus)
 {
     i2c_init_type i2c_init_struct;
+    crm_clocks_freq_type clocks;
     
-    /* 使能I2C时钟 */
-    crm_periph_clock_enable(DISPLAY_I2C_CLK, TRUE);
+    i2c_enable(bus->i2c, FALSE);
     
     /* I2C配置 */
     i2c_default_para_init(&i2c_init_struct);
     i2c_init_struct.mode = I2C_MODE_MASTER;
-    i2c_init_struct.master_clock_speed = DISPLAY_I2C_SPEED;
-    i2c_init_struct.clock_duty = I2C_CLOCK_DUTY_2;
+    i2c_init_struct.master_clock_speed = bus->speed;
+    i2c_init_struct.clock_duty = bus->duty;
     i2c_init_struct.address_mode = I2C_ADDRESS_MODE_7BIT;
     i2c_init_struct.own_address1 = 0x00;
-    i2c_init(DISPLAY_I2C, &i2c_init_struct);
+    i2c_init(bus->i2c, &i2c_init_struct);
+    
+    /* 快速模式+: 最长上升时间120ns (库函数按快速模式的300ns配置) */
+    if(bus->speed > I2C_SPEED_FAST)
+    {
+        crm_clocks_freq_get(&clocks);
+        bus->i2c->tmrise_bit.risetime = (clocks.apb1_freq / 1000000) * 120 / 1000 + 1;
+    }
     
     /* 使能I2C */
-    i2c_enable(DISPLAY_I2C, TRUE);
+    i2c_enable(bus->i2c, TRUE);
+}
+
+/**
+ * @brief  总线初始化: 外设和发送DMA通道
+ * @param  bus: 总线
+ * @retval None
+ */
+static void i2c_bus_init(i2c_bus_t* bus)
+{
+    dma_init_type dma_init_struct;
     
-    /* 初始化控制引脚 */
-    gpio_bits_reset(DISPLAY_CTRL1_GPIO_PORT, DISPLAY_CTRL1_GPIO_PIN);
-    gpio_bits_reset(DISPLAY_CTRL2_GPIO_PORT, DISPLAY_CTRL2_GPIO_PIN);
+    crm_periph_clock_enable(bus->clk, TRUE);
+    bus->duty = I2C_CLOCK_DUTY_2;
+    i2c_bus_config(bus);
     
-    /* 延时等待设备稳定 */
-    delay_ms(100);
+    /* 发送DMA: 存储器到I2C数据寄存器, 字节宽度, 单次 */
+    dma_flexible_config(DISPLAY_I2C_DMA, bus->dma_flex_channel, bus->dma_request);
+    dma_reset(bus->dma_channel);
+    dma_default_para_init(&dma_init_struct);
+    dma_init_struct.buffer_size = 0;
+    dma_init_struct.direction = DMA_DIR_MEMORY_TO_PERIPHERAL;
+    dma_init_struct.memory_base_addr = 0;
+    dma_init_struct.memory_data_width = DMA_MEMORY_DATA_WIDTH_BYTE;
+    dma_init_struct.memory_inc_enable = TRUE;
+    dma_init_struct.peripheral_base_addr = (uint32_t)&bus->i2c->dt;
+    dma_init_struct.peripheral_data_width = DMA_PERIPHERAL_DATA_WIDTH_BYTE;
+    dma_init_struct.peripheral_inc_enable = FALSE;
+    dma_init_struct.priority = DMA_PRIORITY_MEDIUM;
+    dma_init_struct.loop_mode_enable = FALSE;
+    dma_init(bus->dma_channel, &dma_init_struct);
+    
+    bus->async_busy = 0;
+    bus->async_result = SUCCESS;
+    bus->soft_active = 0;
+    bus->wedge_count = 0;
+    bus->initialized = 1;
 }
 
 /**
- * @brief  I2C写单个字节
- * @param  device_addr: 设备地址
- * @param  reg_addr: 寄存器地址
- * @param  data: 数据
- * @retval SUCCESS/ERROR
+ * @brief  等待本总线的DMA写传输结束
+ * @param  bus: 总线
+ * @retval SUCCESS: 总线空闲, ERROR: 总线未初始化
  */
-error_status i2c_display_write_byte(uint8_t device_addr, uint8_t reg_addr, uint8_t data)
+static error_status i2c_bus_wait_idle(i2c_bus_t* bus)
 {
-    /* 生成起始信号 */
-    i2c_start_generate(DISPLAY_I2C);
-    
-    /* 等待起始信号发送完成 */
-    if(i2c_wait_event(I2C_EVENT_MASTER_START_GENERATED, I2C_TIMEOUT) != SUCCESS)
+    if(!bus->initialized)
     {
         return ERROR;
     }
     
-    /* 发送设备地址 */
-    i2c_7bit_address_send(DISPLAY_I2C, device_addr << 1, I2C_DIRECTION_TRANSMIT);
-    
-    /* 等待地址发送完成 */
-    if(i2c_wait_event(I2C_EVENT_MASTER_TRANSMIT_ADDRESS_MATCHED, I2C_TIMEOUT) != SUCCESS)
+    while(i2c_bus_poll(bus))
     {
-        return ERROR;
     }
     
-    /* 发送寄存器地址 */
-    i2c_data_send(DISPLAY_I2C, reg_addr);
+    return SUCCESS;
+}
+
+/**
+ * @brief  结束DMA写传输: 关闭DMA, 出错时释放总线
+ * @param  bus: 总线
+ * @param  result: 传输结果
+ * @retval None
+ */
+static void i2c_bus_async_finish(i2c_bus_t* bus, error_status result)
+{
+    bus->dma_channel->ctrl_bit.chen = FALSE;
+    i2c_dma_enable(bus->i2c, FALSE);
+    dma_flag_clear(bus->dma_fdt_flag);
     
-    /* 等待数据发送完成 */
-    if(i2c_wait_event(I2C_EVENT_MASTER_DATA_TRANSMIT_COMPLETE, I2C_TIMEOUT) != SUCCESS)
+    if(result == SUCCESS)
     {
-        return ERROR;
+        i2c_stop_generate(bus->i2c);
+    }
+    else
+    {
+        i2c_bus_recover(bus);
     }
     
-    /* 发送数据 */
-    i2c_data_send(DISPLAY_I2C, data);
+    bus->async_result = result;
+    bus->async_busy = 0;
     
-    /* 等待数据发送完成 */
-    if(i2c_wait_event(I2C_EVENT_MASTER_DATA_TRANSMIT_COMPLETE, I2C_TIMEOUT) != SUCCESS)
+    TRACE(TRACE_EVT_I2C_XFER_END, result);
+}
+
+/**
+ * @brief  生成起始信号并等待完成 (传输的第一个起始)
+ * @param  bus: 总线
+ * @retval SUCCESS/ERROR
+ */
+static error_status i2c_bus_start(i2c_bus_t* bus)
+{
+    i2c_start_generate(bus->i2c);
+    if(i2c_wait_event(bus, I2C_EVENT_MASTER_START_GENERATED, I2C_TIMEOUT) != SUCCESS)
     {
+        i2c_bus_wedged(bus);
         return ERROR;
     }
     
-    /* 生成停止信号 */
-    i2c_stop_generate(DISPLAY_I2C);
+    bus->wedge_count = 0;
     
     return SUCCESS;
 }
 
 /**
- * @brief  I2C读单个字节
- * @param  device_addr: 设备地址
- * @param  reg_addr: 寄存器地址
- * @param  data: 数据指针
+ * @brief  无法生成起始信号: 外设卡在忙状态或SDA被从机拉低
+ * @note   连续 I2C_WEDGE_LIMIT 次后改用软件I2C, 软件I2C初始化时输出时钟清除总线
+ * @param  bus: 总线
+ * @retval None
+ */
+static void i2c_bus_wedged(i2c_bus_t* bus)
+{
+    if(++bus->wedge_count < I2C_WEDGE_LIMIT)
+    {
+        return;
+    }
+    
+    METRIC_INC(METRIC_I2C_SOFT_FALLBACK);
+    i2c_bus_set_soft(bus, TRUE);
+}
+
+/**
+ * @brief  总线引脚改回I2C复用功能 (开漏, 上拉)
+ * @param  bus: 总线
+ * @retval None
+ */
+static void i2c_bus_pins_mux(i2c_bus_t* bus)
+{
+    gpio_init_type gpio_init_struct;
+    
+    gpio_default_para_init(&gpio_init_struct);
+    gpio_init_struct.gpio_drive_strength = GPIO_DRIVE_STRENGTH_STRONGER;
+    gpio_init_struct.gpio_mode = GPIO_MODE_MUX;
+    gpio_init_struct.gpio_out_type = GPIO_OUTPUT_OPEN_DRAIN;
+    gpio_init_struct.gpio_pull = GPIO_PULL_UP;
+    gpio_init_struct.gpio_pins = bus->soft.scl_pin;
+    gpio_init(bus->soft.scl_port, &gpio_init_struct);
+    gpio_init_struct.gpio_pins = bus->soft.sda_pin;
+    gpio_init(bus->soft.sda_port, &gpio_init_struct);
+}
+
+/**
+ * @brief  系统时钟切换通知
+ * @note   阻塞传输在主循环中完成, 切换时不会进行; DMA写传输进行中时否决切换
+ * @param  event: 通知事件
+ * @param  profile: 目标档位
  * @retval SUCCESS/ERROR
  */
-error_status i2c_display_read_byte(uint8_t device_addr, uint8_t reg_addr, uint8_t* data)
+static error_status i2c_display_clock_notify(clock_event_t event, clock_profile_t profile)
 {
-    /* 生成起始信号 */
-    i2c_start_generate(DISPLAY_I2C);
+    uint8_t i;
     
-    /* 等待起始信号发送完成 */
-    if(i2c_wait_event(I2C_EVENT_MASTER_START_GENERATED, I2C_TIMEOUT) != SUCCESS)
+    if(event == CLOCK_EVENT_CHANGE_BEGIN)
     {
-        return ERROR;
+        return SUCCESS;
     }
     
-    /* 发送设备地址 (写模式) */
-    i2c_7bit_address_send(DISPLAY_I2C, device_addr << 1, I2C_DIRECTION_TRANSMIT);
+    for(i = 0; i < I2C_BUS_COUNT; i++)
+    {
+        if(!i2c_buses[i].initialized)
+        {
+            continue;
+        }
+        
+        if(event == CLOCK_EVENT_PRE_CHANGE)
+        {
+            if(i2c_bus_poll(&i2c_buses[i]))
+            {
+                return ERROR;
+            }
+        }
+        else if(i2c_buses[i].soft_active)
+        {
+            soft_i2c_set_speed(&i2c_buses[i].soft, i2c_buses[i].speed);
+        }
+        else
+        {
+            i2c_bus_config(&i2c_buses[i]);
+        }
+    }
     
-    /* 等待地址发送完成 */
-    if(i2c_wait_event(I2C_EVENT_MASTER_TRANSMIT_ADDRESS_MATCHED, I2C_TIMEOUT) != SUCCESS)
+    return SUCCESS;
+}
+
+/**
+ * @brief  I2C显示板初始化 (两条总线, 默认总线上的显示板开始探测)
+ * @param  None
+ * @retval None
+ */
+void i2c_display_init(void)
+{
+    uint8_t addr;
+    uint8_t i;
+    
+    /* 显示板型号不同地址不同, 以配置存储中的地址为准 (7位地址) */
+    if((config_get(CONFIG_KEY_DISPLAY_ADDRESS, &addr, sizeof(addr)) == SUCCESS) && (addr < 0x80))
     {
-        return ERROR;
+        i2c_display_address = addr;
     }
     
-    /* 发送寄存器地址 */
-    i2c_data_send(DISPLAY_I2C, reg_addr);
+    mem_pool_init(&i2c_xfer_pool, i2c_xfer_pool_storage, sizeof(i2c_xfer_t), I2C_XFER_POOL_SIZE);
     
-    /* 等待数据发送完成 */
-    if(i2c_wait_event(I2C_EVENT_MASTER_DATA_TRANSMIT_COMPLETE, I2C_TIMEOUT) != SUCCESS)
+    /* 使能I2C和DMA时钟 */
+    crm_periph_clock_enable(DISPLAY_I2C_DMA_CLK, TRUE);
+    for(i = 0; i < I2C_BUS_COUNT; i++)
     {
-        return ERROR;
+        os_mutex_init(&i2c_buses[i].lock);
+        i2c_bus_init(&i2c_buses[i]);
     }
+    clock_profile_register(i2c_display_clock_notify);
     
-    /* 生成重复起始信号 */
-    i2c_start_generate(DISPLAY_I2C);
+    /* 初始化控制引脚 */
+    gpio_bits_reset(DISPLAY_CTRL1_GPIO_PORT, DISPLAY_CTRL1_GPIO_PIN);
+    gpio_bits_reset(DISPLAY_CTRL2_GPIO_PORT, DISPLAY_CTRL2_GPIO_PIN);
     
-    /* 等待起始信号发送完成 */
-    if(i2c_wait_event(I2C_EVENT_MASTER_START_GENERATED, I2C_TIMEOUT) != SUCCESS)
+    /* 不再固定延时, 由 i2c_display_ready_poll 轮询设备应答 */
+    i2c_display_state = I2C_DISPLAY_STATE_PROBING;
+    i2c_display_init_tick = get_tick();
+    i2c_display_probe_tick = i2c_display_init_tick - DISPLAY_PROBE_INTERVAL_MS;
+}
+
+/**
+ * @brief  按编号取总线
+ * @param  id: i2c_bus_id_t
+ * @retval 总线句柄, 编号无效时返回NULL
+ */
+i2c_bus_t* i2c_bus_get(uint8_t id)
+{
+    return (id < I2C_BUS_COUNT) ? &i2c_buses[id] : NULL;
+}
+
+/**
+ * @brief  设置总线速率和快速模式占空比
+ * @note   先等待本总线的DMA写传输结束; 与当前设置相同时直接返回.
+ *         分频值取整后实际速率可能偏离设定值 (如APB1 120MHz下1MHz、16:9占空比为1.2MHz),
+ *         偏差超过 I2C_SPEED_ERROR_PCT 时恢复原设置
+ * @param  bus: 总线
+ * @param  speed: 速率 (Hz, 不大于 I2C_SPEED_MAX)
+ * @param  duty: I2C_CLOCK_DUTY_2 / I2C_CLOCK_DUTY_16_9, 标准模式下忽略
+ * @retval SUCCESS/ERROR
+ */
+error_status i2c_bus_set_speed(i2c_bus_t* bus, uint32_t speed, i2c_clock_duty_type duty)
+{
+    uint32_t old_speed = bus->speed;
+    i2c_clock_duty_type old_duty = bus->duty;
+    uint32_t rate;
+    error_status status = SUCCESS;
+    
+    if((speed == 0) || (speed > I2C_SPEED_MAX))
     {
         return ERROR;
     }
     
-    /* 发送设备地址 (读模式) */
-    i2c_7bit_address_send(DISPLAY_I2C, device_addr << 1, I2C_DIRECTION_RECEIVE);
-    
-    /* 等待地址发送完成 */
-    if(i2c_wait_event(I2C_EVENT_MASTER_RECEIVE_ADDRESS_MATCHED, I2C_TIMEOUT) != SUCCESS)
+    os_mutex_lock(&bus->lock);
+    if(i2c_bus_wait_idle(bus) != SUCCESS)
     {
+        os_mutex_unlock(&bus->lock);
         return ERROR;
     }
+    if((speed == old_speed) && ((duty == old_duty) || (speed <= I2C_SPEED_STANDARD)))
+    {
+        os_mutex_unlock(&bus->lock);
+        return SUCCESS;
+    }
+    
+    bus->speed = speed;
+    bus->duty = duty;
+    if(bus->soft_active)
+    {
+        soft_i2c_set_speed(&bus->soft, speed);
+    }
+    else
+    {
+        i2c_bus_config(bus);
+    }
     
-    /* 禁用应答 */
-    i2c_ack_enable(DISPLAY_I2C, FALSE);
+    rate = i2c_bus_scl_rate(bus);
+    if((rate * 100 > speed * (100 + I2C_SPEED_ERROR_PCT)) || (rate * 100 < speed * (100 - I2C_SPEED_ERROR_PCT)))
+    {
+        bus->speed = old_speed;
+        bus->duty = old_duty;
+        if(bus->soft_active)
+        {
+            soft_i2c_set_speed(&bus->soft, old_speed);
+        }
+        else
+        {
+            i2c_bus_config(bus);
+        }
+        status = ERROR;
+    }
+    os_mutex_unlock(&bus->lock);
     
-    /* 生成停止信号 */
-    i2c_stop_generate(DISPLAY_I2C);
+    return status;
+}
+
+/**
+ * @brief  由时钟控制寄存器和APB1时钟计算的实际SCL速率 (不含上升时间)
+ * @note   标准模式 pclk/(2*N), 快速模式占空比2:1 pclk/(3*N), 16:9 pclk/(25*N);
+ *         软件I2C为 sysclk/(2*半周期周期数)
+ * @param  bus: 总线
+ * @retval 速率 (Hz), 未配置时为0
+ */
+uint32_t i2c_bus_scl_rate(const i2c_bus_t* bus)
+{
+    crm_clocks_freq_type clocks;
+    uint32_t div = bus->i2c->clkctrl_bit.speed;
     
-    /* 等待接收数据 */
-    if(i2c_wait_flag(I2C_RDBF_FLAG, SET, I2C_TIMEOUT) != SUCCESS)
+    if(bus->soft_active)
     {
-        return ERROR;
+        return soft_i2c_rate(&bus->soft);
+    }
+    if(div == 0)
+    {
+        return 0;
     }
     
-    /* 读取数据 */
-    *data = i2c_data_receive(DISPLAY_I2C);
+    crm_clocks_freq_get(&clocks);
+    if(!bus->i2c->clkctrl_bit.speedmode)
+    {
+        return clocks.apb1_freq / (2 * div);
+    }
     
-    /* 使能应答 */
-    i2c_ack_enable(DISPLAY_I2C, TRUE);
+    return clocks.apb1_freq / ((bus->i2c->clkctrl_bit.dutymode ? 25 : 3) * div);
+}
+
+/**
+ * @brief  在硬件I2C和软件I2C之间切换
+ * @note   先等待本总线的DMA写传输结束. 切换到软件时关闭外设, 引脚改为GPIO开漏输出并清除总线;
+ *         切回硬件时复位外设 (清除卡住的忙状态), 引脚改回复用功能并重新配置
+ * @param  bus: 总线
+ * @param  enable: TRUE 软件I2C, FALSE 硬件I2C
+ * @retval None
+ */
+void i2c_bus_set_soft(i2c_bus_t* bus, confirm_state enable)
+{
+    os_mutex_lock(&bus->lock);
+    if((i2c_bus_wait_idle(bus) != SUCCESS) || ((enable == TRUE) == (bus->soft_active != 0)))
+    {
+        os_mutex_unlock(&bus->lock);
+        return;
+    }
     
-    return SUCCESS;
+    if(enable == TRUE)
+    {
+        i2c_enable(bus->i2c, FALSE);
+        soft_i2c_init(&bus->soft, bus->speed);
+        bus->soft_active = 1;
+    }
+    else
+    {
+        bus->i2c->ctrl1_bit.reset = TRUE;
+        bus->i2c->ctrl1_bit.reset = FALSE;
+        i2c_bus_pins_mux(bus);
+        i2c_bus_config(bus);
+        bus->soft_active = 0;
+    }
+    bus->wedge_count = 0;
+    os_mutex_unlock(&bus->lock);
 }
 
 /**
- * @brief  I2C写多个字节
+ * @brief  对比测试: 同一数据分别用硬件DMA写和软件I2C写入, 测量实际速率和每字节CPU周期
+ * @note   实际速率按 (数据+地址+寄存器) x 9位 / 起始到结束的时间计算, 含起始/停止和逐字节开销.
+ *         硬件路径的CPU周期为启动DMA写 (地址阶段) 和结束 (生成停止) 两次调用, 中间主循环可做别的事;
+ *         软件路径全程占用CPU. 阻塞执行, 结束后恢复原来的模式
+ * @param  bus: 总线
  * @param  device_addr: 设备地址
  * @param  reg_addr: 寄存器地址
- * @param  data: 数据缓冲区
- * @param  len: 数据长度
- * @retval SUCCESS/ERROR
+ * @param  len: 数据长度 (1~I2C_BENCH_MAX_LEN)
+ * @param  result: 输出结果
+ * @retval SUCCESS/ERROR (参数错误或任一次写入失败)
  */
-error_status i2c_display_write_buffer(uint8_t device_addr, uint8_t reg_addr, uint8_t* data, uint16_t len)
+error_status i2c_bus_benchmark(i2c_bus_t* bus, uint8_t device_addr, uint8_t reg_addr, uint16_t len, i2c_bench_t* result)
 {
-    /* 生成起始信号 */
-    i2c_start_generate(DISPLAY_I2C);
+    uint8_t was_soft = bus->soft_active;
+    uint32_t bits = (uint32_t)(len + 2) * 9;
+    uint32_t start;
+    uint32_t cycles;
+    uint32_t cpu;
+    uint16_t i;
+    error_status status = SUCCESS;
     
-    /* 等待起始信号发送完成 */
-    if(i2c_wait_event(I2C_EVENT_MASTER_START_GENERATED, I2C_TIMEOUT) != SUCCESS)
+    result->hw_rate = 0;
+    result->hw_cycles_per_byte = 0;
+    result->soft_rate = 0;
+    result->soft_cycles_per_byte = 0;
+    
+    if((len == 0) || (len > I2C_BENCH_MAX_LEN))
     {
         return ERROR;
     }
     
-    /* 发送设备地址 */
-    i2c_7bit_address_send(DISPLAY_I2C, device_addr << 1, I2C_DIRECTION_TRANSMIT);
-    
-    /* 等待地址发送完成 */
-    if(i2c_wait_event(I2C_EVENT_MASTER_TRANSMIT_ADDRESS_MATCHED, I2C_TIMEOUT) != SUCCESS)
+    os_mutex_lock(&bus->lock);
+    if(i2c_bus_wait_idle(bus) != SUCCESS)
     {
+        os_mutex_unlock(&bus->lock);
         return ERROR;
     }
     
-    /* 发送寄存器地址 */
-    i2c_data_send(DISPLAY_I2C, reg_addr);
+    for(i = 0; i < len; i++)
+    {
+        i2c_bench_data[i] = (uint8_t)(i * 0x3B);
+    }
     
-    /* 等待数据发送完成 */
-    if(i2c_wait_event(I2C_EVENT_MASTER_DATA_TRANSMIT_COMPLETE, I2C_TIMEOUT) != SUCCESS)
+    /* 硬件DMA写 */
+    i2c_bus_set_soft(bus, FALSE);
+    start = DWT->CYCCNT;
+    if(i2c_bus_write_start(bus, device_addr, reg_addr, i2c_bench_data, len) != SUCCESS)
+    {
+        status = ERROR;
+    }
+    cpu = DWT->CYCCNT - start;
+    while(status == SUCCESS)
+    {
+        cycles = DWT->CYCCNT;
+        if(!i2c_bus_poll(bus))
+        {
+            cpu += DWT->CYCCNT - cycles;
+            break;
+        }
+    }
+    cycles = DWT->CYCCNT - start;
+    if((status == SUCCESS) && (i2c_bus_async_result(bus) == SUCCESS))
+    {
+        result->hw_rate = (uint32_t)((uint64_t)bits * system_core_clock / cycles);
+        result->hw_cycles_per_byte = cpu / len;
+    }
+    else
+    {
+        status = ERROR;
+    }
+    
+    /* 软件I2C */
+    i2c_bus_set_soft(bus, TRUE);
+    start = DWT->CYCCNT;
+    if(soft_i2c_transfer(&bus->soft, device_addr, reg_addr, 0, i2c_bench_data, len) == SUCCESS)
+    {
+        cycles = DWT->CYCCNT - start;
+        result->soft_rate = (uint32_t)((uint64_t)bits * system_core_clock / cycles);
+        result->soft_cycles_per_byte = cycles / len;
+    }
+    else
+    {
+        status = ERROR;
+    }
+    
+    i2c_bus_set_soft(bus, was_soft ? TRUE : FALSE);
+    os_mutex_unlock(&bus->lock);
+    
+    return status;
+}
+
+/**
+ * @brief  探测设备是否应答 (已持有总线锁)
+ * @param  bus: 总线
+ * @param  device_addr: 设备地址
+ * @retval SUCCESS: 有应答, ERROR: 无应答或超时
+ */
+static error_status i2c_bus_probe_locked(i2c_bus_t* bus, uint8_t device_addr)
+{
+    error_status result = ERROR;
+    uint32_t tick_start;
+    
+    if(i2c_bus_wait_idle(bus) != SUCCESS)
     {
         return ERROR;
     }
+    if(bus->soft_active)
+    {
+        return soft_i2c_probe(&bus->soft, device_addr);
+    }
+    tick_start = get_tick();
+    
+    /* 生成起始信号 */
+    i2c_start_generate(bus->i2c);
     
-    /* 发送数据 */
-    for(uint16_t i = 0; i < len; i++)
+    while(!i2c_event_check(bus->i2c, I2C_EVENT_MASTER_START_GENERATED))
     {
-        i2c_data_send(DISPLAY_I2C, data[i]);
-        
-        /* 等待数据发送完成 */
-        if(i2c_wait_event(I2C_EVENT_MASTER_DATA_TRANSMIT_COMPLETE, I2C_TIMEOUT) != SUCCESS)
+        if((get_tick() - tick_start) > I2C_PROBE_TIMEOUT)
         {
+            i2c_stop_generate(bus->i2c);
+            i2c_bus_wedged(bus);
             return ERROR;
         }
     }
+    bus->wedge_count = 0;
+    
+    /* 发送设备地址, 等待应答或无应答 */
+    i2c_7bit_address_send(bus->i2c, device_addr << 1, I2C_DIRECTION_TRANSMIT);
+    
+    while((get_tick() - tick_start) <= I2C_PROBE_TIMEOUT)
+    {
+        if(i2c_event_check(bus->i2c, I2C_EVENT_MASTER_TRANSMIT_ADDRESS_MATCHED))
+        {
+            result = SUCCESS;
+            break;
+        }
+        
+        if(i2c_flag_get(bus->i2c, I2C_ACKFAIL_FLAG) != RESET)
+        {
+            i2c_flag_clear(bus->i2c, I2C_ACKFAIL_FLAG);
+            break;
+        }
+    }
     
     /* 生成停止信号 */
-    i2c_stop_generate(DISPLAY_I2C);
+    i2c_stop_generate(bus->i2c);
     
-    return SUCCESS;
+    return result;
 }
 
 /**
- * @brief  I2C读多个字节
+ * @brief  探测设备是否应答 (只发送地址)
+ * @note   无应答是正常结果, 不计入I2C错误统计
+ * @param  bus: 总线
  * @param  device_addr: 设备地址
- * @param  reg_addr: 寄存器地址
- * @param  data: 数据缓冲区
- * @param  len: 数据长度
+ * @retval SUCCESS: 有应答, ERROR: 无应答或超时
+ */
+error_status i2c_bus_probe(i2c_bus_t* bus, uint8_t device_addr)
+{
+    error_status result;
+    
+    os_mutex_lock(&bus->lock);
+    result = i2c_bus_probe_locked(bus, device_addr);
+    os_mutex_unlock(&bus->lock);
+    
+    return result;
+}
+
+/**
+ * @brief  探测默认总线上的设备是否应答 (只发送地址)
+ * @param  device_addr: 设备地址
+ * @retval SUCCESS: 有应答, ERROR: 无应答或超时
+ */
+error_status i2c_display_probe(uint8_t device_addr)
+{
+    return i2c_bus_probe(i2c_display_bus, device_addr);
+}
+
+/**
+ * @brief  轮询显示板是否就绪 (非阻塞, 在主循环中调用)
+ * @param  None
+ * @retval 当前就绪状态
+ */
+i2c_display_state_t i2c_display_ready_poll(void)
+{
+    uint32_t now = get_tick();
+    
+    if(i2c_display_state != I2C_DISPLAY_STATE_PROBING)
+    {
+        return i2c_display_state;
+    }
+    
+    if((now - i2c_display_probe_tick) < DISPLAY_PROBE_INTERVAL_MS)
+    {
+        return i2c_display_state;
+    }
+    i2c_display_probe_tick = now;
+    
+    if(i2c_display_probe(i2c_display_address) == SUCCESS)
+    {
+        i2c_display_state = I2C_DISPLAY_STATE_READY;
+    }
+    else if((now - i2c_display_init_tick) >= DISPLAY_READY_TIMEOUT_MS)
+    {
+        i2c_display_state = I2C_DISPLAY_STATE_ABSENT;
+    }
+    
+    return i2c_display_state;
+}
+
+/**
+ * @brief  显示板是否已应答
+ * @param  None
+ * @retval 1: 就绪, 0: 未就绪
+ */
+uint8_t i2c_display_is_ready(void)
+{
+    return (i2c_display_state == I2C_DISPLAY_STATE_READY) ? 1 : 0;
+}
+
+/**
+ * @brief  显示板地址 (配置项覆盖后的值)
+ * @param  None
+ * @retval 7位I2C地址
+ */
+uint8_t i2c_display_get_address(void)
+{
+    return i2c_display_address;
+}
+
+/**
+ * @brief  从描述符池分配传输描述符 (可在中断中调用)
+ * @param  None
+ * @retval 描述符, 池空时返回NULL
+ */
+i2c_xfer_t* i2c_display_xfer_alloc(void)
+{
+    return (i2c_xfer_t*)mem_pool_alloc(&i2c_xfer_pool);
+}
+
+/**
+ * @brief  归还传输描述符
+ * @param  xfer: i2c_display_xfer_alloc 返回的描述符
+ * @retval None
+ */
+void i2c_display_xfer_free(i2c_xfer_t* xfer)
+{
+    mem_pool_free(&i2c_xfer_pool, xfer);
+    METRIC_GAUGE_SET(METRIC_GAUGE_I2C_POOL_PEAK, mem_pool_high_water(&i2c_xfer_pool));
+}
+
+/**
+ * @brief  执行一次传输 (已持有总线锁)
+ * @note   开始后无论成功失败都记录 XFER_END, 跟踪中的传输区间总是闭合
+ * @param  bus: 总线
+ * @param  xfer: 传输描述符
  * @retval SUCCESS/ERROR
  */
-error_status i2c_display_read_buffer(uint8_t device_addr, uint8_t reg_addr, uint8_t* data, uint16_t len)
+static error_status i2c_bus_transfer_locked(i2c_bus_t* bus, const i2c_xfer_t* xfer)
 {
-    /* 生成起始信号 */
-    i2c_start_generate(DISPLAY_I2C);
+    error_status status;
     
-    /* 等待起始信号发送完成 */
-    if(i2c_wait_event(I2C_EVENT_MASTER_START_GENERATED, I2C_TIMEOUT) != SUCCESS)
+    if(((xfer->dir == I2C_XFER_READ) && (xfer->len == 0)) || (i2c_bus_wait_idle(bus) != SUCCESS))
+    {
+        return ERROR;
+    }
+    
+    TRACE(TRACE_EVT_I2C_XFER_START, (xfer->device_addr << 8) | xfer->reg_addr);
+    
+    if(bus->soft_active)
+    {
+        status = soft_i2c_transfer(&bus->soft, xfer->device_addr, xfer->reg_addr, (xfer->dir == I2C_XFER_READ) ? 1 : 0,
+                                   xfer->data, xfer->len);
+    }
+    else
+    {
+        status = i2c_bus_transfer_hw(bus, xfer);
+    }
+    
+    TRACE(TRACE_EVT_I2C_XFER_END, status);
+    
+    return status;
+}
+
+/**
+ * @brief  硬件I2C执行一次传输
+ * @param  bus: 总线
+ * @param  xfer: 传输描述符
+ * @retval SUCCESS/ERROR
+ */
+static error_status i2c_bus_transfer_hw(i2c_bus_t* bus, const i2c_xfer_t* xfer)
+{
+    uint16_t i;
+    
+    /* 生成起始信号并等待完成 */
+    if(i2c_bus_start(bus) != SUCCESS)
     {
         return ERROR;
     }
     
     /* 发送设备地址 (写模式) */
-    i2c_7bit_address_send(DISPLAY_I2C, device_addr << 1, I2C_DIRECTION_TRANSMIT);
+    i2c_7bit_address_send(bus->i2c, xfer->device_addr << 1, I2C_DIRECTION_TRANSMIT);
     
     /* 等待地址发送完成 */
-    if(i2c_wait_event(I2C_EVENT_MASTER_TRANSMIT_ADDRESS_MATCHED, I2C_TIMEOUT) != SUCCESS)
+    if(i2c_wait_event(bus, I2C_EVENT_MASTER_TRANSMIT_ADDRESS_MATCHED, I2C_TIMEOUT) != SUCCESS)
     {
         return ERROR;
     }
     
     /* 发送寄存器地址 */
-    i2c_data_send(DISPLAY_I2C, reg_addr);
+    i2c_data_send(bus->i2c, xfer->reg_addr);
     
     /* 等待数据发送完成 */
-    if(i2c_wait_event(I2C_EVENT_MASTER_DATA_TRANSMIT_COMPLETE, I2C_TIMEOUT) != SUCCESS)
+    if(i2c_wait_event(bus, I2C_EVENT_MASTER_DATA_TRANSMIT_COMPLETE, I2C_TIMEOUT) != SUCCESS)
     {
         return ERROR;
     }
     
+    if(xfer->dir == I2C_XFER_WRITE)
+    {
+        /* 发送数据 */
+        for(i = 0; i < xfer->len; i++)
+        {
+            i2c_data_send(bus->i2c, xfer->data[i]);
+            
+            /* 等待数据发送完成 */
+            if(i2c_wait_event(bus, I2C_EVENT_MASTER_DATA_TRANSMIT_COMPLETE, I2C_TIMEOUT) != SUCCESS)
+            {
+                return ERROR;
+            }
+        }
+        
+        /* 生成停止信号 */
+        i2c_stop_generate(bus->i2c);
+        
+        return SUCCESS;
+    }
+    
     /* 生成重复起始信号 */
-    i2c_start_generate(DISPLAY_I2C);
+    i2c_start_generate(bus->i2c);
     
     /* 等待起始信号发送完成 */
-    if(i2c_wait_event(I2C_EVENT_MASTER_START_GENERATED, I2C_TIMEOUT) != SUCCESS)
+    if(i2c_wait_event(bus, I2C_EVENT_MASTER_START_GENERATED, I2C_TIMEOUT) != SUCCESS)
     {
         return ERROR;
     }
     
     /* 发送设备地址 (读模式) */
-    i2c_7bit_address_send(DISPLAY_I2C, device_addr << 1, I2C_DIRECTION_RECEIVE);
+    i2c_7bit_address_send(bus->i2c, xfer->device_addr << 1, I2C_DIRECTION_RECEIVE);
     
     /* 等待地址发送完成 */
-    if(i2c_wait_event(I2C_EVENT_MASTER_RECEIVE_ADDRESS_MATCHED, I2C_TIMEOUT) != SUCCESS)
+    if(i2c_wait_event(bus, I2C_EVENT_MASTER_RECEIVE_ADDRESS_MATCHED, I2C_TIMEOUT) != SUCCESS)
     {
         return ERROR;
     }
     
     /* 接收数据 */
-    for(uint16_t i = 0; i < len; i++)
+    for(i = 0; i < xfer->len; i++)
     {
-        if(i == len - 1)
+        if(i == xfer->len - 1)
         {
             /* 最后一个字节，禁用应答 */
-            i2c_ack_enable(DISPLAY_I2C, FALSE);
+            i2c_ack_enable(bus->i2c, FALSE);
             
             /* 生成停止信号 */
-            i2c_stop_generate(DISPLAY_I2C);
+            i2c_stop_generate(bus->i2c);
         }
         
         /* 等待接收数据 */
-        if(i2c_wait_flag(I2C_RDBF_FLAG, SET, I2C_TIMEOUT) != SUCCESS)
+        if(i2c_wait_flag(bus, I2C_RDBF_FLAG, SET, I2C_TIMEOUT) != SUCCESS)
         {
             return ERROR;
         }
         
         /* 读取数据 */
-        data[i] = i2c_data_receive(DISPLAY_I2C);
+        xfer->data[i] = i2c_data_receive(bus->i2c);
     }
     
     /* 使能应答 */
-    i2c_ack_enable(DISPLAY_I2C, TRUE);
+    i2c_ack_enable(bus->i2c, TRUE);
+    
+    return SUCCESS;
+}
+
+/**
+ * @brief  执行一次传输 (阻塞, 先等待本总线的DMA写传输结束)
+ * @note   写: 起始, 地址+W, 寄存器, 数据..., 停止;
+ *         读: 起始, 地址+W, 寄存器, 重复起始, 地址+R, 数据... (最后一字节前NACK+停止)
+ * @param  bus: 总线
+ * @param  xfer: 传输描述符
+ * @retval SUCCESS/ERROR
+ */
+error_status i2c_bus_transfer(i2c_bus_t* bus, const i2c_xfer_t* xfer)
+{
+    error_status status;
+    
+    os_mutex_lock(&bus->lock);
+    status = i2c_bus_transfer_locked(bus, xfer);
+    os_mutex_unlock(&bus->lock);
+    
+    return status;
+}
+
+/**
+ * @brief  执行一次传输 (阻塞, 默认总线)
+ * @param  xfer: 传输描述符
+ * @retval SUCCESS/ERROR
+ */
+error_status i2c_display_transfer(const i2c_xfer_t* xfer)
+{
+    return i2c_bus_transfer(i2c_display_bus, xfer);
+}
+
+/**
+ * @brief  DMA写传输的地址阶段: 起始, 地址+W, 寄存器地址 (发送缓冲区空即返回)
+ * @param  bus: 总线
+ * @param  device_addr: 设备地址
+ * @param  reg_addr: 寄存器地址
+ * @retval SUCCESS/ERROR
+ */
+static error_status i2c_bus_write_address(i2c_bus_t* bus, uint8_t device_addr, uint8_t reg_addr)
+{
+    if(i2c_bus_start(bus) != SUCCESS)
+    {
+        return ERROR;
+    }
+    
+    i2c_7bit_address_send(bus->i2c, device_addr << 1, I2C_DIRECTION_TRANSMIT);
+    if(i2c_wait_event(bus, I2C_EVENT_MASTER_TRANSMIT_ADDRESS_MATCHED, I2C_TIMEOUT) != SUCCESS)
+    {
+        return ERROR;
+    }
+    
+    /* 寄存器地址由CPU写入, 发送缓冲区空后数据交给DMA */
+    i2c_data_send(bus->i2c, reg_addr);
+    
+    return i2c_wait_flag(bus, I2C_TDBE_FLAG, SET, I2C_TIMEOUT);
+}
+
+/**
+ * @brief  开始DMA写传输 (已持有总线锁)
+ * @param  bus: 总线
+ * @param  device_addr: 设备地址
+ * @param  reg_addr: 寄存器地址
+ * @param  data: 数据缓冲区 (DMA可访问)
+ * @param  len: 数据长度
+ * @retval SUCCESS: 已开始, ERROR: 总线忙或地址阶段失败
+ */
+static error_status i2c_bus_write_start_locked(i2c_bus_t* bus, uint8_t device_addr, uint8_t reg_addr,
+                                               const uint8_t* data, uint16_t len)
+{
+    if(!bus->initialized || i2c_bus_poll(bus))
+    {
+        return ERROR;
+    }
+    
+    TRACE(TRACE_EVT_I2C_XFER_START, (device_addr << 8) | reg_addr);
+    
+    /* 软件I2C: 阻塞完成, 结果照常由 i2c_bus_async_result 读取 */
+    if(bus->soft_active)
+    {
+        bus->async_result = soft_i2c_transfer(&bus->soft, device_addr, reg_addr, 0, (uint8_t*)data, len);
+        TRACE(TRACE_EVT_I2C_XFER_END, bus->async_result);
+        return bus->async_result;
+    }
+    
+    /* 地址阶段失败时传输到此结束; 成功时由 i2c_bus_async_finish 记录结束 */
+    if(i2c_bus_write_address(bus, device_addr, reg_addr) != SUCCESS)
+    {
+        TRACE(TRACE_EVT_I2C_XFER_END, ERROR);
+        return ERROR;
+    }
+    
+    bus->async_busy = 1;
+    bus->async_tick = get_tick();
+    
+    if(len == 0)
+    {
+        return SUCCESS;
+    }
+    
+    dma_flag_clear(bus->dma_fdt_flag);
+    bus->dma_channel->ctrl_bit.chen = FALSE;
+    bus->dma_channel->maddr = (uint32_t)data;
+    bus->dma_channel->dtcnt = len;
+    bus->dma_channel->ctrl_bit.chen = TRUE;
+    i2c_dma_enable(bus->i2c, TRUE);
     
     return SUCCESS;
 }
 
+/**
+ * @brief  开始DMA写传输 (非阻塞)
+ * @note   起始、地址和寄存器地址 (约3字节时间) 在调用中发送, 数据由DMA发送;
+ *         data 在传输结束前不得修改. 结束由 i2c_bus_poll 检查
+ * @param  bus: 总线
+ * @param  device_addr: 设备地址
+ * @param  reg_addr: 寄存器地址
+ * @param  data: 数据缓冲区 (DMA可访问)
+ * @param  len: 数据长度
+ * @retval SUCCESS: 已开始, ERROR: 总线忙或地址阶段失败
+ */
+error_status i2c_bus_write_start(i2c_bus_t* bus, uint8_t device_addr, uint8_t reg_addr, const uint8_t* data, uint16_t len)
+{
+    error_status status;
+    
+    os_mutex_lock(&bus->lock);
+    status = i2c_bus_write_start_locked(bus, device_addr, reg_addr, data, len);
+    os_mutex_unlock(&bus->lock);
+    
+    return status;
+}
+
+/**
+ * @brief  检查DMA写传输 (已持有总线锁)
+ * @param  bus: 总线
+ * @retval 1: 传输中, 0: 空闲 (结果由 i2c_bus_async_result 读取)
+ */
+static uint8_t i2c_bus_poll_locked(i2c_bus_t* bus)
+{
+    if(!bus->async_busy)
+    {
+        return 0;
+    }
+    
+    if(i2c_flag_get(bus->i2c, I2C_ACKFAIL_FLAG) != RESET)
+    {
+        i2c_flag_clear(bus->i2c, I2C_ACKFAIL_FLAG);
+        METRIC_INC(METRIC_I2C_NACK);
+        TRACE(TRACE_EVT_I2C_NACK, I2C_ACKFAIL_FLAG);
+        i2c_bus_async_finish(bus, ERROR);
+        return 0;
+    }
+    
+    if(((bus->dma_channel->dtcnt == 0) || !bus->dma_channel->ctrl_bit.chen) &&
+       (i2c_flag_get(bus->i2c, I2C_TDC_FLAG) != RESET))
+    {
+        i2c_bus_async_finish(bus, SUCCESS);
+        return 0;
+    }
+    
+    if((get_tick() - bus->async_tick) > I2C_ASYNC_TIMEOUT_MS)
+    {
+        METRIC_INC(METRIC_I2C_TIMEOUT);
+        TRACE(TRACE_EVT_I2C_TIMEOUT, I2C_TDC_FLAG);
+        i2c_bus_async_finish(bus, ERROR);
+        return 0;
+    }
+    
+    return 1;
+}
+
+/**
+ * @brief  检查DMA写传输, 发送完毕时生成停止信号
+ * @note   DMA写完最后一字节后还要等移位完成 (TDC) 才能停止
+ * @param  bus: 总线
+ * @retval 1: 传输中, 0: 空闲 (结果由 i2c_bus_async_result 读取)
+ */
+uint8_t i2c_bus_poll(i2c_bus_t* bus)
+{
+    uint8_t busy;
+    
+    /* 空闲时不加锁, 主循环每次都调用 */
+    if(!bus->async_busy)
+    {
+        return 0;
+    }
+    
+    os_mutex_lock(&bus->lock);
+    busy = i2c_bus_poll_locked(bus);
+    os_mutex_unlock(&bus->lock);
+    
+    return busy;
+}
+
+/**
+ * @brief  上一次DMA写传输的结果
+ * @param  bus: 总线
+ * @retval SUCCESS/ERROR
+ */
+error_status i2c_bus_async_result(const i2c_bus_t* bus)
+{
+    return bus->async_result;
+}
+
+/**
+ * @brief  分配描述符并执行一次传输
+ * @param  bus: 总线
+ * @param  device_addr: 设备地址
+ * @param  reg_addr: 寄存器地址
+ * @param  dir: 传输方向
+ * @param  data: 数据缓冲区
+ * @param  len: 数据长度
+ * @retval SUCCESS/ERROR (描述符池空时返回ERROR)
+ */
+static error_status i2c_display_xfer_run(i2c_bus_t* bus, uint8_t device_addr, uint8_t reg_addr,
+                                         i2c_xfer_dir_t dir, uint8_t* data, uint16_t len)
+{
+    i2c_xfer_t* xfer;
+    error_status status;
+    
+    xfer = i2c_display_xfer_alloc();
+    if(xfer == NULL)
+    {
+        return ERROR;
+    }
+    
+    xfer->device_addr = device_addr;
+    xfer->reg_addr = reg_addr;
+    xfer->dir = dir;
+    xfer->data = data;
+    xfer->len = len;
+    
+    status = i2c_bus_transfer(bus, xfer);
+    i2c_display_xfer_free(xfer);
+    
+    return status;
+}
+
+/**
+ * @brief  I2C写单个字节
+ * @param  device_addr: 设备地址
+ * @param  reg_addr: 寄存器地址
+ * @param  data: 数据
+ * @retval SUCCESS/ERROR
+ */
+error_status i2c_display_write_byte(uint8_t device_addr, uint8_t reg_addr, uint8_t data)
+{
+    return i2c_display_xfer_run(i2c_display_bus, device_addr, reg_addr, I2C_XFER_WRITE, &data, 1);
+}
+
+/**
+ * @brief  I2C读单个字节
+ * @param  device_addr: 设备地址
+ * @param  reg_addr: 寄存器地址
+ * @param  data: 数据指针
+ * @retval SUCCESS/ERROR
+ */
+error_status i2c_display_read_byte(uint8_t device_addr, uint8_t reg_addr, uint8_t* data)
+{
+    return i2c_display_xfer_run(i2c_display_bus, device_addr, reg_addr, I2C_XFER_READ, data, 1);
+}
+
+/**
+ * @brief  I2C写多个字节
+ * @param  device_addr: 设备地址
+ * @param  reg_addr: 寄存器地址
+ * @param  data: 数据缓冲区
+ * @param  len: 数据长度
+ * @retval SUCCESS/ERROR
+ */
+error_status i2c_display_write_buffer(uint8_t device_addr, uint8_t reg_addr, uint8_t* data, uint16_t len)
+{
+    return i2c_display_xfer_run(i2c_display_bus, device_addr, reg_addr, I2C_XFER_WRITE, data, len);
+}
+
+/**
+ * @brief  I2C读多个字节
+ * @param  device_addr: 设备地址
+ * @param  reg_addr: 寄存器地址
+ * @param  data: 数据缓冲区
+ * @param  len: 数据长度
+ * @retval SUCCESS/ERROR
+ */
+error_status i2c_display_read_buffer(uint8_t device_addr, uint8_t reg_addr, uint8_t* data, uint16_t len)
+{
+    return i2c_display_xfer_run(i2c_display_bus, device_addr, reg_addr, I2C_XFER_READ, data, len);
+}
+
+/**
+ * @brief  I2C写多个字节 (阻塞)
+ * @param  bus: 总线
+ * @param  device_addr: 设备地址
+ * @param  reg_addr: 寄存器地址
+ * @param  data: 数据缓冲区
+ * @param  len: 数据长度
+ * @retval SUCCESS/ERROR
+ */
+error_status i2c_bus_write_buffer(i2c_bus_t* bus, uint8_t device_addr, uint8_t reg_addr, uint8_t* data, uint16_t len)
+{
+    return i2c_display_xfer_run(bus, device_addr, reg_addr, I2C_XFER_WRITE, data, len);
+}
+
+/**
+ * @brief  I2C读多个字节 (阻塞)
+ * @param  bus: 总线
+ * @param  device_addr: 设备地址
+ * @param  reg_addr: 寄存器地址
+ * @param  data: 数据缓冲区
+ * @param  len: 数据长度
+ * @retval SUCCESS/ERROR
+ */
+error_status i2c_bus_read_buffer(i2c_bus_t* bus, uint8_t device_addr, uint8_t reg_addr, uint8_t* data, uint16_t len)
+{
+    return i2c_display_xfer_run(bus, device_addr, reg_addr, I2C_XFER_READ, data, len);
+}
+
 /**
  * @brief  发送数据到显示板
  * @param  reg_addr: 寄存器地址
@@ -368,7 +1238,7 @@ error_status i2c_display_read_buffer(uint8_t device_addr, uint8_t reg_addr, uint
  */
 error_status i2c_display_send_data(uint8_t reg_addr, uint8_t data)
 {
-    return i2c_display_write_byte(DISPLAY_I2C_ADDRESS, reg_addr, data);
+    return i2c_display_write_byte(i2c_display_address, reg_addr, data);
 }
 
 /**
@@ -379,7 +1249,7 @@ error_status i2c_display_send_data(uint8_t reg_addr, uint8_t data)
  */
 error_status i2c_display_read_data(uint8_t reg_addr, uint8_t* data)
 {
-    return i2c_display_read_byte(DISPLAY_I2C_ADDRESS, reg_addr, data);
+    return i2c_display_read_byte(i2c_display_address, reg_addr, data);
 }
 
 /**
@@ -391,7 +1261,7 @@ error_status i2c_display_read_data(uint8_t reg_addr, uint8_t* data)
  */
 error_status i2c_display_send_buffer(uint8_t reg_addr, uint8_t* data, uint16_t len)
 {
-    return i2c_display_write_buffer(DISPLAY_I2C_ADDRESS, reg_addr, data, len);
+    return i2c_display_write_buffer(i2c_display_address, reg_addr, data, len);
 }
 
 /**
@@ -403,7 +1273,7 @@ error_status i2c_display_send_buffer(uint8_t reg_addr, uint8_t* data, uint16_t l
  */
 error_status i2c_display_read_buffer_data(uint8_t reg_addr, uint8_t* data, uint16_t len)
 {
-    return i2c_display_read_buffer(DISPLAY_I2C_ADDRESS, reg_addr, data, len);
+    return i2c_display_read_buffer(i2c_display_address, reg_addr, data, len);
 }
 
 /**
@@ -473,16 +1343,16 @@ void i2c_display_scan(void)
     for(address = 1; address < 128; address++)
     {
         /* 生成起始信号 */
-        i2c_start_generate(DISPLAY_I2C);
+        i2c_start_generate(i2c_display_bus->i2c);
         
         /* 等待起始信号发送完成 */
-        if(i2c_wait_event(I2C_EVENT_MASTER_START_GENERATED, 100) == SUCCESS)
+        if(i2c_wait_event(i2c_display_bus, I2C_EVENT_MASTER_START_GENERATED, 100) == SUCCESS)
         {
             /* 发送设备地址 */
-            i2c_7bit_address_send(DISPLAY_I2C, address << 1, I2C_DIRECTION_TRANSMIT);
+            i2c_7bit_address_send(i2c_display_bus->i2c, address << 1, I2C_DIRECTION_TRANSMIT);
             
             /* 等待地址发送完成 */
-            result = i2c_wait_event(I2C_EVENT_MASTER_TRANSMIT_ADDRESS_MATCHED, 100);
+            result = i2c_wait_event(i2c_display_bus, I2C_EVENT_MASTER_TRANSMIT_ADDRESS_MATCHED, 100);
             
             if(result == SUCCESS)
             {
@@ -493,7 +1363,7 @@ void i2c_display_scan(void)
         }
         
         /* 生成停止信号 */
-        i2c_stop_generate(DISPLAY_I2C);
+        i2c_stop_generate(i2c_display_bus->i2c);
         
         /* 延时 */
         delay_ms(1);
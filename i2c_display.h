@@ -14,9 +14,116 @@ extern "C" {
 
 /* Includes ------------------------------------------------------------------*/
 #include "at32f403a_407.h"
+#include "soft_i2c.h"
+#include "os_port.h"
 
 /* Exported types ------------------------------------------------------------*/
+/**
+ * @brief  显示板就绪状态
+ */
+typedef enum
+{
+    I2C_DISPLAY_STATE_PROBING = 0,  /*!< 等待设备应答 */
+    I2C_DISPLAY_STATE_READY,        /*!< 设备已应答 */
+    I2C_DISPLAY_STATE_ABSENT        /*!< 超时无应答 */
+} i2c_display_state_t;
+
+/**
+ * @brief  I2C传输方向
+ */
+typedef enum
+{
+    I2C_XFER_WRITE = 0,             /*!< 写寄存器 */
+    I2C_XFER_READ                   /*!< 写寄存器地址后重复起始读 */
+} i2c_xfer_dir_t;
+
+/**
+ * @brief  I2C总线编号
+ */
+typedef enum
+{
+    I2C_BUS_DISPLAY = 0,            /*!< I2C1 (PB6/PB7), i2c_display_* 函数使用的默认总线 */
+    I2C_BUS_DISPLAY2,               /*!< I2C2 (PB10/PB11) */
+    I2C_BUS_COUNT
+} i2c_bus_id_t;
+
+/**
+ * @brief  I2C总线句柄: 外设和发送DMA通道, 以及正在进行的DMA写传输
+ * @note   各总线的DMA写传输互相独立, 可以同时进行.
+ *         切换到软件I2C后同一组函数改由 soft 在相同引脚上执行, DMA写传输变为阻塞完成.
+ *         i2c_bus_* 函数内部加总线锁; DMA写传输期间不持有锁, 其他任务的传输先等待它结束
+ */
+typedef struct
+{
+    i2c_type* i2c;                  /*!< I2C外设 */
+    crm_periph_clock_type clk;      /*!< 外设时钟 */
+    uint32_t speed;                 /*!< 总线速率 (Hz), 初值为默认速率, i2c_bus_set_speed 修改 */
+    dma_channel_type* dma_channel;  /*!< 发送DMA通道 */
+    uint8_t dma_flex_channel;       /*!< 弹性映射通道 */
+    dma_flexible_request_type dma_request; /*!< DMA请求源 */
+    uint32_t dma_fdt_flag;          /*!< DMA传输完成标志 */
+    soft_i2c_t soft;                /*!< 软件I2C (引脚与外设相同), 外设卡死时的后备 */
+
+    i2c_clock_duty_type duty;       /*!< 快速模式SCL占空比 */
+    uint8_t initialized;            /*!< 已初始化 */
+    uint8_t soft_active;            /*!< 使用软件I2C */
+    uint8_t wedge_count;            /*!< 连续无法生成起始信号的次数 */
+    __IO uint8_t async_busy;        /*!< DMA写传输进行中 */
+    error_status async_result;      /*!< 上一次DMA写传输结果 */
+    uint32_t async_tick;            /*!< DMA写传输开始时刻 */
+    os_mutex_t lock;                /*!< 总线锁: FreeRTOS下各任务的传输串行化, 裸机为空操作 */
+} i2c_bus_t;
+
+/**
+ * @brief  硬件与软件I2C对比测试结果
+ */
+typedef struct
+{
+    uint32_t hw_rate;               /*!< 硬件DMA写实测速率 (Hz, 每字节9位), 0为未测 */
+    uint32_t hw_cycles_per_byte;    /*!< 硬件DMA写每字节占用的CPU周期 (启动和结束) */
+    uint32_t soft_rate;             /*!< 软件I2C实测速率 (Hz) */
+    uint32_t soft_cycles_per_byte;  /*!< 软件I2C每字节占用的CPU周期 (全程阻塞) */
+} i2c_bench_t;
+
+/**
+ * @brief  I2C传输描述符 (从描述符池分配)
+ */
+typedef struct
+{
+    uint8_t device_addr;            /*!< 7位设备地址 */
+    uint8_t reg_addr;               /*!< 寄存器地址 */
+    i2c_xfer_dir_t dir;             /*!< 传输方向 */
+    uint16_t len;                   /*!< 数据长度 */
+    uint8_t* data;                  /*!< 数据缓冲区 */
+} i2c_xfer_t;
+
 /* Exported constants --------------------------------------------------------*/
+/* 上电后等待显示板应答的最长时间 (ms), 取代原固定100ms延时 */
+#define DISPLAY_READY_TIMEOUT_MS    100
+
+/* 就绪探测间隔 (ms) */
+#define DISPLAY_PROBE_INTERVAL_MS   2
+
+/* 传输描述符池块数 */
+#define I2C_XFER_POOL_SIZE          4
+
+/* DMA写传输超时 (ms), 400kHz下1KB约23ms, 100kHz下128字节约12ms */
+#define I2C_ASYNC_TIMEOUT_MS        50
+
+/* 速率范围 (Hz): 标准模式上限, 快速模式上限, 超过快速模式时按快速模式+ (1MHz) 的上升时间配置 */
+#define I2C_SPEED_STANDARD          100000
+#define I2C_SPEED_FAST              400000
+#define I2C_SPEED_MAX               1000000
+
+/* 实际SCL速率与设定值的最大偏差 (%), 分频取整后超出时不采用该速率 */
+#define I2C_SPEED_ERROR_PCT         5
+
+/* 连续多少次无法生成起始信号 (外设卡死或SDA被拉低) 后改用软件I2C */
+#define I2C_WEDGE_LIMIT             3
+
+/* 对比测试最多字节数 */
+#define I2C_BENCH_MAX_LEN           64
+
 /* 常用显示板I2C地址 */
 #define OLED_I2C_ADDRESS        0x3C    // OLED显示屏地址
 #define LCD_I2C_ADDRESS         0x27    // LCD显示屏地址
@@ -32,12 +139,173 @@ extern "C" {
 /* Exported functions prototypes ---------------------------------------------*/
 
 /**
- * @brief  I2C显示板初始化
+ * @brief  I2C显示板初始化 (两条总线, 默认总线上的显示板开始探测)
  * @param  None
  * @retval None
  */
 void i2c_display_init(void);
 
+/**
+ * @brief  按编号取总线
+ * @param  id: i2c_bus_id_t
+ * @retval 总线句柄, 编号无效时返回NULL
+ */
+i2c_bus_t* i2c_bus_get(uint8_t id);
+
+/**
+ * @brief  设置总线速率和快速模式占空比
+ * @note   先等待本总线的DMA写传输结束; 与当前设置相同时直接返回.
+ *         按当前APB1时钟算出的实际SCL速率偏差超过 I2C_SPEED_ERROR_PCT 时恢复原设置
+ * @param  bus: 总线
+ * @param  speed: 速率 (Hz, 不大于 I2C_SPEED_MAX)
+ * @param  duty: I2C_CLOCK_DUTY_2 (低:高=2:1) / I2C_CLOCK_DUTY_16_9, 标准模式下忽略
+ * @retval SUCCESS/ERROR
+ */
+error_status i2c_bus_set_speed(i2c_bus_t* bus, uint32_t speed, i2c_clock_duty_type duty);
+
+/**
+ * @brief  由时钟控制寄存器和APB1时钟计算的实际SCL速率 (不含上升时间)
+ * @param  bus: 总线
+ * @retval 速率 (Hz), 未配置时为0
+ */
+uint32_t i2c_bus_scl_rate(const i2c_bus_t* bus);
+
+/**
+ * @brief  在硬件I2C和软件I2C之间切换
+ * @note   先等待本总线的DMA写传输结束. 切换到软件时关闭外设, 引脚改为GPIO开漏输出并清除总线;
+ *         切回硬件时引脚改回复用功能并重新配置外设
+ * @param  bus: 总线
+ * @param  enable: TRUE 软件I2C, FALSE 硬件I2C
+ * @retval None
+ */
+void i2c_bus_set_soft(i2c_bus_t* bus, confirm_state enable);
+
+/**
+ * @brief  对比测试: 同一数据分别用硬件DMA写和软件I2C写入, 测量实际速率和每字节CPU周期
+ * @note   阻塞执行, 结束后恢复原来的模式; 写入的内容会改变显示, 调用者之后重新刷新
+ * @param  bus: 总线
+ * @param  device_addr: 设备地址
+ * @param  reg_addr: 寄存器地址
+ * @param  len: 数据长度 (1~I2C_BENCH_MAX_LEN)
+ * @param  result: 输出结果
+ * @retval SUCCESS/ERROR (参数错误或任一次写入失败)
+ */
+error_status i2c_bus_benchmark(i2c_bus_t* bus, uint8_t device_addr, uint8_t reg_addr, uint16_t len, i2c_bench_t* result);
+
+/**
+ * @brief  探测设备是否应答 (只发送地址)
+ * @param  bus: 总线
+ * @param  device_addr: 设备地址
+ * @retval SUCCESS: 有应答, ERROR: 无应答或超时
+ */
+error_status i2c_bus_probe(i2c_bus_t* bus, uint8_t device_addr);
+
+/**
+ * @brief  执行一次传输 (阻塞, 先等待本总线的DMA写传输结束)
+ * @param  bus: 总线
+ * @param  xfer: 传输描述符
+ * @retval SUCCESS/ERROR
+ */
+error_status i2c_bus_transfer(i2c_bus_t* bus, const i2c_xfer_t* xfer);
+
+/**
+ * @brief  I2C写多个字节 (阻塞)
+ * @param  bus: 总线
+ * @param  device_addr: 设备地址
+ * @param  reg_addr: 寄存器地址
+ * @param  data: 数据缓冲区
+ * @param  len: 数据长度
+ * @retval SUCCESS/ERROR
+ */
+error_status i2c_bus_write_buffer(i2c_bus_t* bus, uint8_t device_addr, uint8_t reg_addr, uint8_t* data, uint16_t len);
+
+/**
+ * @brief  I2C读多个字节 (阻塞)
+ * @param  bus: 总线
+ * @param  device_addr: 设备地址
+ * @param  reg_addr: 寄存器地址
+ * @param  data: 数据缓冲区
+ * @param  len: 数据长度
+ * @retval SUCCESS/ERROR
+ */
+error_status i2c_bus_read_buffer(i2c_bus_t* bus, uint8_t device_addr, uint8_t reg_addr, uint8_t* data, uint16_t len);
+
+/**
+ * @brief  开始DMA写传输 (非阻塞)
+ * @note   起始、地址和寄存器地址 (约3字节时间) 在调用中发送, 数据由DMA发送;
+ *         data 在传输结束前不得修改. 结束由 i2c_bus_poll 检查
+ * @param  bus: 总线
+ * @param  device_addr: 设备地址
+ * @param  reg_addr: 寄存器地址
+ * @param  data: 数据缓冲区 (DMA可访问)
+ * @param  len: 数据长度
+ * @retval SUCCESS: 已开始, ERROR: 总线忙或地址阶段失败
+ */
+error_status i2c_bus_write_start(i2c_bus_t* bus, uint8_t device_addr, uint8_t reg_addr, const uint8_t* data, uint16_t len);
+
+/**
+ * @brief  检查DMA写传输, 发送完毕时生成停止信号
+ * @param  bus: 总线
+ * @retval 1: 传输中, 0: 空闲 (结果由 i2c_bus_async_result 读取)
+ */
+uint8_t i2c_bus_poll(i2c_bus_t* bus);
+
+/**
+ * @brief  上一次DMA写传输的结果
+ * @param  bus: 总线
+ * @retval SUCCESS/ERROR
+ */
+error_status i2c_bus_async_result(const i2c_bus_t* bus);
+
+/**
+ * @brief  探测默认总线上的设备是否应答 (只发送地址)
+ * @param  device_addr: 设备地址
+ * @retval SUCCESS: 有应答, ERROR: 无应答或超时
+ */
+error_status i2c_display_probe(uint8_t device_addr);
+
+/**
+ * @brief  轮询显示板是否就绪 (非阻塞, 在主循环中调用)
+ * @param  None
+ * @retval 当前就绪状态
+ */
+i2c_display_state_t i2c_display_ready_poll(void);
+
+/**
+ * @brief  显示板是否已应答
+ * @param  None
+ * @retval 1: 就绪, 0: 未就绪
+ */
+uint8_t i2c_display_is_ready(void);
+
+/**
+ * @brief  显示板地址 (配置项覆盖后的值)
+ * @param  None
+ * @retval 7位I2C地址
+ */
+uint8_t i2c_display_get_address(void);
+
+/**
+ * @brief  从描述符池分配传输描述符 (可在中断中调用)
+ * @param  None
+ * @retval 描述符, 池空时返回NULL
+ */
+i2c_xfer_t* i2c_display_xfer_alloc(void);
+
+/**
+ * @brief  归还传输描述符
+ * @param  xfer: i2c_display_xfer_alloc 返回的描述符
+ * @retval None
+ */
+void i2c_display_xfer_free(i2c_xfer_t* xfer);
+
+/**
+ * @brief  执行一次传输 (阻塞)
+ * @param  xfer: 传输描述符
+ * @retval SUCCESS/ERROR
+ */
+error_status i2c_display_transfer(const i2c_xfer_t* xfer);
+
 /**
  * @brief  I2C写单个字节
  * @param  device_addr: 设备地址
@@ -108,7 +376,7 @@ error_status i2c_display_send_buffer(uint8_t reg_addr, uint8_t* data, uint16_t l
  * @param  len: 数据长度
  * @retval SUCCESS/ERROR
  */
-error_status i2c_display_read_buffer(uint8_t reg_addr, uint8_t* data, uint16_t len);
+error_status i2c_display_read_buffer_data(uint8_t reg_addr, uint8_t* data, uint16_t len);
 
 /**
  * @brief  设置显示板控制引脚1
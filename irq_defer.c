@@ -0,0 +1,316 @@
+/**
+ * @file irq_defer.c
+ * @brief 延迟工作队列实现
+ * @author Jason
+ * @date 2026-10-18
+ *
+ * 中断优先级方案见 main.h 的 IRQ_PRIO_*: 中断只做必须立即完成的事 (读数据寄存器、写下一步周期、
+ * 捕获时刻), 其余 (除法、重新配置外设等) 用 irq_defer_post 交给延迟工作中断 (裸机为PendSV,
+ * FreeRTOS下为EXINT3, 见 IRQ_DEFER_IRQ). 它是最低优先级, 任何外设中断都能抢占它, RS485接收不会被底半部推迟.
+ *
+ * 队列是有界多生产者单消费者环: 生产者用 LDREX/STREX 抢占写位置, 填好后写入该项的序号表示就绪;
+ * 消费者 (延迟工作中断) 按顺序取序号就绪的项. 生产者在填写中途被抢占时, 后提交的项等它就绪后才执行.
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "irq_defer.h"
+#include "main.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/**
+ * @brief  队列项
+ */
+typedef struct
+{
+    __IO uint32_t seq;              /*!< 序号: 等于写位置时空闲, 等于写位置+1时就绪 */
+    irq_defer_fn_t fn;              /*!< 工作函数 */
+    uint32_t arg;                   /*!< 参数 */
+    uint32_t post_cycles;           /*!< 提交时刻 */
+    uint8_t level;                  /*!< 提交者的优先级 */
+} irq_defer_item_t;
+
+/* Private define ------------------------------------------------------------*/
+#define IRQ_DEFER_QUEUE_MASK        (IRQ_DEFER_QUEUE_SIZE - 1)
+
+/* 探测定时器: 计数器从此值起计, 溢出 (更新事件) 后从0继续, 中断入口的计数值即为延迟 */
+#define IRQ_PROBE_DELAY_MIN         1000
+#define IRQ_PROBE_DELAY_JITTER      0x3FF
+
+/* Private macro -------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+static irq_defer_item_t irq_defer_queue[IRQ_DEFER_QUEUE_SIZE];
+static __IO uint32_t irq_defer_head = 0;    // 生产者写位置
+static uint32_t irq_defer_tail = 0;         // 消费者读位置, 只由延迟工作中断修改
+
+static irq_level_stats_t irq_level_stats[IRQ_LEVEL_NUM];
+
+/* 探测的级别: 在用的优先级 */
+static const uint8_t irq_probe_levels[] =
+{
+    IRQ_PRIO_RS485_RX, IRQ_PRIO_CTRL_SEQ, IRQ_PRIO_RS485_TX, IRQ_PRIO_AUTOBAUD, IRQ_PRIO_SYSTICK, IRQ_PRIO_DEFER
+};
+
+static uint8_t irq_probe_index = 0;
+static uint8_t irq_probe_armed = 0;
+static uint32_t irq_probe_tick = 0;
+static uint32_t irq_probe_tmr_clk = 0;
+static __IO uint8_t irq_probe_done = 0;
+static __IO uint16_t irq_probe_ticks = 0;
+
+/* Private function prototypes -----------------------------------------------*/
+static uint8_t irq_defer_current_level(void);
+static uint32_t irq_probe_tmr_clock(void);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief  当前执行的优先级
+ * @param  None
+ * @retval 抢占优先级, 线程模式为 IRQ_LEVEL_THREAD
+ */
+static uint8_t irq_defer_current_level(void)
+{
+    uint32_t exception = __get_IPSR();
+
+    if(exception == 0)
+    {
+        return IRQ_LEVEL_THREAD;
+    }
+
+    /* 分组4: 优先级全部为抢占优先级 */
+    return (uint8_t)(NVIC_GetPriority((IRQn_Type)((int32_t)exception - 16)) & 0x0F);
+}
+
+/**
+ * @brief  探测定时器时钟 (APB1分频不为1时为APB1的2倍)
+ * @param  None
+ * @retval 时钟频率 (Hz)
+ */
+static uint32_t irq_probe_tmr_clock(void)
+{
+    crm_clocks_freq_type clocks;
+
+    crm_clocks_freq_get(&clocks);
+
+    return (clocks.apb1_freq != clocks.ahb_freq) ? clocks.apb1_freq * 2 : clocks.apb1_freq;
+}
+
+/**
+ * @brief  初始化: 延迟工作中断设为最低优先级, 配置进入延迟探测定时器
+ * @note   在 nvic_config 之后调用
+ * @param  None
+ * @retval None
+ */
+void irq_defer_init(void)
+{
+    tmr_type* tmr = IRQ_LATENCY_TMR;
+    uint8_t i;
+
+    for(i = 0; i < IRQ_DEFER_QUEUE_SIZE; i++)
+    {
+        irq_defer_queue[i].seq = i;
+    }
+    irq_defer_head = 0;
+    irq_defer_tail = 0;
+    irq_defer_stats_clear();
+
+    NVIC_SetPriority(IRQ_DEFER_IRQ, NVIC_EncodePriority(NVIC_GetPriorityGrouping(), IRQ_PRIO_DEFER, 0));
+#if OS_RTOS_ENABLE
+    NVIC_ClearPendingIRQ(IRQ_DEFER_IRQ);
+    NVIC_EnableIRQ(IRQ_DEFER_IRQ);
+#endif
+
+    /* 探测定时器: 不分频, 16位计数, 只产生溢出中断 */
+    crm_periph_clock_enable(IRQ_LATENCY_TMR_CLK, TRUE);
+    tmr_base_init(tmr, 0xFFFF, 0);
+    tmr_cnt_dir_set(tmr, TMR_COUNT_UP);
+    tmr_flag_clear(tmr, TMR_OVF_FLAG);
+    tmr_interrupt_enable(tmr, TMR_OVF_INT, TRUE);
+    NVIC_ClearPendingIRQ(IRQ_LATENCY_TMR_IRQ);
+    NVIC_EnableIRQ(IRQ_LATENCY_TMR_IRQ);
+
+    irq_probe_index = 0;
+    irq_probe_armed = 0;
+    irq_probe_tick = get_tick();
+}
+
+/**
+ * @brief  提交延迟工作 (无锁, 可在任意优先级的中断和主循环中调用)
+ * @note   工作按提交顺序在延迟工作中断中执行, 它低于所有外设中断, 可被它们抢占
+ * @param  fn: 工作函数
+ * @param  arg: 参数
+ * @retval SUCCESS/ERROR (队列满, 计数 DEFER_OVERFLOW)
+ */
+RAMFUNC error_status irq_defer_post(irq_defer_fn_t fn, uint32_t arg)
+{
+    irq_defer_item_t* item;
+    uint32_t pos;
+
+    /* 抢占写位置: 该项的序号等于写位置说明已被消费, 可以使用 */
+    do
+    {
+        pos = __LDREXW((uint32_t*)&irq_defer_head);
+        item = &irq_defer_queue[pos & IRQ_DEFER_QUEUE_MASK];
+        if(item->seq != pos)
+        {
+            __CLREX();
+            METRIC_INC(METRIC_DEFER_OVERFLOW);
+            return ERROR;
+        }
+    } while(__STREXW(pos + 1, (uint32_t*)&irq_defer_head) != 0);
+
+    item->fn = fn;
+    item->arg = arg;
+    item->post_cycles = DWT->CYCCNT;
+    item->level = irq_defer_current_level();
+    METRIC_GAUGE_MAX(METRIC_GAUGE_DEFER_QUEUE_PEAK, pos + 1 - irq_defer_tail);
+
+    /* 内容写完后才标记就绪 */
+    __DMB();
+    item->seq = pos + 1;
+
+#if OS_RTOS_ENABLE
+    NVIC_SetPendingIRQ(IRQ_DEFER_IRQ);
+#else
+    SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+#endif
+
+    return SUCCESS;
+}
+
+/**
+ * @brief  进入延迟探测, 在主循环中调用
+ * @note   每 IRQ_LATENCY_PERIOD_MS 把探测定时器中断设为下一个在用的优先级, 在随机时刻产生更新事件,
+ *         中断入口读出计数值即为该优先级当时的进入延迟 (含被更高或同级中断阻塞的时间)
+ * @param  None
+ * @retval None
+ */
+void irq_defer_poll(void)
+{
+    irq_level_stats_t* stats;
+    uint32_t cycles;
+    uint8_t level;
+
+    if(irq_probe_armed)
+    {
+        if(!irq_probe_done)
+        {
+            return;
+        }
+
+        /* 计数值换算为CPU周期 */
+        stats = &irq_level_stats[irq_probe_levels[irq_probe_index]];
+        cycles = (uint32_t)((uint64_t)irq_probe_ticks * system_core_clock / irq_probe_tmr_clk);
+        stats->probe_count++;
+        if(cycles > stats->probe_max_cycles)
+        {
+            stats->probe_max_cycles = cycles;
+        }
+
+        irq_probe_armed = 0;
+        irq_probe_index = (irq_probe_index + 1) % sizeof(irq_probe_levels);
+        irq_probe_tick = get_tick();
+    }
+
+    if((get_tick() - irq_probe_tick) < IRQ_LATENCY_PERIOD_MS)
+    {
+        return;
+    }
+
+    /* 设置优先级时探测中断未挂起也未在执行 */
+    level = irq_probe_levels[irq_probe_index];
+    NVIC_SetPriority(IRQ_LATENCY_TMR_IRQ, NVIC_EncodePriority(NVIC_GetPriorityGrouping(), level, 0));
+    irq_probe_tmr_clk = irq_probe_tmr_clock();
+
+    /* 更新事件时刻取决于DWT计数低位, 与其他中断的相位随机 */
+    irq_probe_done = 0;
+    irq_probe_armed = 1;
+    tmr_counter_value_set(IRQ_LATENCY_TMR, 0xFFFF - IRQ_PROBE_DELAY_MIN - (DWT->CYCCNT & IRQ_PROBE_DELAY_JITTER));
+    tmr_counter_enable(IRQ_LATENCY_TMR, TRUE);
+}
+
+/**
+ * @brief  读取一个级别的统计
+ * @param  level: 0~15 抢占优先级, IRQ_LEVEL_THREAD 主循环
+ * @retval 统计, 级别无效时返回NULL
+ */
+const irq_level_stats_t* irq_defer_stats(uint8_t level)
+{
+    return (level < IRQ_LEVEL_NUM) ? &irq_level_stats[level] : NULL;
+}
+
+/**
+ * @brief  清除统计
+ * @param  None
+ * @retval None
+ */
+void irq_defer_stats_clear(void)
+{
+    uint8_t i;
+
+    for(i = 0; i < IRQ_LEVEL_NUM; i++)
+    {
+        irq_level_stats[i].probe_count = 0;
+        irq_level_stats[i].probe_max_cycles = 0;
+        irq_level_stats[i].defer_count = 0;
+        irq_level_stats[i].defer_max_cycles = 0;
+    }
+}
+
+/**
+ * @brief  延迟工作中断: 按顺序执行就绪的延迟工作
+ * @note   项先释放再执行, 工作函数中可以再提交
+ * @param  None
+ * @retval None
+ */
+RAMFUNC void IRQ_DEFER_IRQHandler(void)
+{
+    irq_defer_item_t* item;
+    irq_level_stats_t* stats;
+    irq_defer_fn_t fn;
+    uint32_t arg;
+    uint32_t wait;
+
+    while(1)
+    {
+        item = &irq_defer_queue[irq_defer_tail & IRQ_DEFER_QUEUE_MASK];
+        if(item->seq != irq_defer_tail + 1)
+        {
+            break;
+        }
+
+        fn = item->fn;
+        arg = item->arg;
+        wait = DWT->CYCCNT - item->post_cycles;
+        stats = &irq_level_stats[item->level];
+
+        /* 读完后才释放给下一圈的生产者 */
+        __DMB();
+        item->seq = irq_defer_tail + IRQ_DEFER_QUEUE_SIZE;
+        irq_defer_tail++;
+
+        stats->defer_count++;
+        if(wait > stats->defer_max_cycles)
+        {
+            stats->defer_max_cycles = wait;
+        }
+
+        fn(arg);
+    }
+}
+
+/**
+ * @brief  进入延迟探测定时器中断: 读出更新事件以来的计数值
+ * @param  None
+ * @retval None
+ */
+RAMFUNC void IRQ_LATENCY_TMR_IRQHandler(void)
+{
+    uint16_t ticks = (uint16_t)IRQ_LATENCY_TMR->cval;
+
+    tmr_counter_enable(IRQ_LATENCY_TMR, FALSE);
+    tmr_flag_clear(IRQ_LATENCY_TMR, TMR_OVF_FLAG);
+
+    irq_probe_ticks = ticks;
+    irq_probe_done = 1;
+}
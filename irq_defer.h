@@ -0,0 +1,93 @@
+/**
+ * @file irq_defer.h
+ * @brief 延迟工作队列头文件 (中断顶半部提交, 最低优先级的延迟工作中断执行; 各优先级延迟测量)
+ * @author Jason
+ * @date 2026-10-18
+ */
+
+#ifndef __IRQ_DEFER_H
+#define __IRQ_DEFER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "at32f403a_407.h"
+
+/* Exported types ------------------------------------------------------------*/
+/**
+ * @brief  延迟工作函数, 在延迟工作中断 (IRQ_DEFER_IRQ) 中执行
+ */
+typedef void (*irq_defer_fn_t)(uint32_t arg);
+
+/**
+ * @brief  一个优先级的延迟统计 (周期数为CPU周期)
+ */
+typedef struct
+{
+    uint32_t probe_count;           /*!< 进入延迟探测次数 */
+    uint32_t probe_max_cycles;      /*!< 定时器更新事件到该优先级中断入口的最长时间 */
+    uint32_t defer_count;           /*!< 从该优先级提交的延迟工作数 */
+    uint32_t defer_max_cycles;      /*!< 延迟工作从提交到开始执行的最长时间 */
+} irq_level_stats_t;
+
+/* Exported constants --------------------------------------------------------*/
+/* 队列项数 (2的幂) */
+#define IRQ_DEFER_QUEUE_SIZE        16
+
+/* 统计的级别: 抢占优先级 0~15, 以及线程模式 (主循环) */
+#define IRQ_LEVEL_THREAD            16
+#define IRQ_LEVEL_NUM               17
+
+/* 进入延迟探测间隔 (ms), 每次探测一个级别, 各级别轮流 */
+#define IRQ_LATENCY_PERIOD_MS       10
+
+/* Exported macro ------------------------------------------------------------*/
+/* Exported functions prototypes ---------------------------------------------*/
+
+/**
+ * @brief  初始化: 延迟工作中断设为最低优先级, 配置进入延迟探测定时器
+ * @note   在 nvic_config 之后调用
+ * @param  None
+ * @retval None
+ */
+void irq_defer_init(void);
+
+/**
+ * @brief  提交延迟工作 (无锁, 可在任意优先级的中断和主循环中调用)
+ * @note   工作按提交顺序在延迟工作中断中执行, 它低于所有外设中断, 可被它们抢占
+ * @param  fn: 工作函数
+ * @param  arg: 参数
+ * @retval SUCCESS/ERROR (队列满, 计数 DEFER_OVERFLOW)
+ */
+error_status irq_defer_post(irq_defer_fn_t fn, uint32_t arg);
+
+/**
+ * @brief  进入延迟探测, 在主循环中调用
+ * @note   每 IRQ_LATENCY_PERIOD_MS 把探测定时器中断设为下一个在用的优先级, 在随机时刻产生更新事件,
+ *         中断入口读出计数值即为该优先级当时的进入延迟 (含被更高或同级中断阻塞的时间)
+ * @param  None
+ * @retval None
+ */
+void irq_defer_poll(void);
+
+/**
+ * @brief  读取一个级别的统计
+ * @param  level: 0~15 抢占优先级, IRQ_LEVEL_THREAD 主循环
+ * @retval 统计, 级别无效时返回NULL
+ */
+const irq_level_stats_t* irq_defer_stats(uint8_t level);
+
+/**
+ * @brief  清除统计
+ * @param  None
+ * @retval None
+ */
+void irq_defer_stats_clear(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __IRQ_DEFER_H */
@@ -9,16 +9,54 @@
 #include "main.h"
 
 /* Private typedef -----------------------------------------------------------*/
+/**
+ * @brief  演示任务步骤
+ */
+typedef enum
+{
+    DEMO_STEP_RS485 = 0,        /*!< 发送测试字符串 */
+    DEMO_STEP_BUZZER_ON,        /*!< 蜂鸣器开始鸣叫 */
+    DEMO_STEP_BUZZER_OFF,       /*!< 蜂鸣器停止 */
+    DEMO_STEP_DISPLAY,          /*!< 写显示板寄存器 */
+    DEMO_STEP_CTRL_PINS,        /*!< 翻转显示板控制引脚 */
+    DEMO_STEP_STOPPED           /*!< 主机已接管蜂鸣器/显示板/控制引脚 */
+} demo_step_t;
+
 /* Private define ------------------------------------------------------------*/
+/* 主循环一次最多处理的RS485帧数 */
+#define RS485_CMD_BATCH_MAX     RS485_FRAME_POOL_SIZE
+
+/* FreeRTOS下主任务无事可做时阻塞等待接收事件的最长时间 (ms), 原始分帧的帧结束和定时轮询靠超时发现 */
+#define MAIN_IDLE_WAIT_MS       1
+
 /* Private macro -------------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
 static __IO uint32_t uwTick;
 
+/* 快速启动时钟状态 */
+static system_clock_state_t system_clock_state = SYSTEM_CLOCK_HEXT_WAIT;
+static uint32_t system_clock_start_tick = 0;
+
+/* 演示任务 */
+static demo_step_t demo_step = DEMO_STEP_RS485;
+static uint32_t demo_next_tick = 0;
+static const char demo_hello[] = "Hello RS485\r\n";
+
+/* 主循环的唤醒事件 (RS485收到完整帧) */
+static os_event_t main_wake;
+
 /* Private function prototypes -----------------------------------------------*/
+static uint8_t rs485_command_poll(void);
+static uint8_t demo_poll(void);
+static void demo_stop(void);
+static void main_loop(void);
+
 /* Private functions ---------------------------------------------------------*/
 
 /**
- * @brief  系统时钟配置
+ * @brief  系统时钟配置 (快速启动)
+ * @note   只启动HEXT起振而不等待, 系统先以HICK (8MHz) 运行;
+ *         PLL的锁定和切换由 system_clock_poll 在后台完成
  * @param  None
  * @retval None
  */
@@ -27,12 +65,6 @@ void system_clock_config(void)
     /* 复位CRM配置 */
     crm_reset();
     
-    /* 使能外部高速晶振 */
-    crm_clock_source_enable(CRM_CLOCK_SOURCE_HEXT, TRUE);
-    
-    /* 等待外部晶振稳定 */
-    while(crm_hext_stable_wait() == ERROR);
-    
     /* 配置AHB预分频器 */
     crm_ahb_div_set(CRM_AHB_DIV_1);
     
@@ -42,28 +74,61 @@ void system_clock_config(void)
     /* 配置APB1预分频器 */
     crm_apb1_div_set(CRM_APB1_DIV_2);
     
-    /* 配置PLL */
-    crm_pll_config(CRM_PLL_SOURCE_HEXT, CRM_PLL_MULT_30);
-    
-    /* 使能PLL */
-    crm_clock_source_enable(CRM_CLOCK_SOURCE_PLL, TRUE);
-    
-    /* 等待PLL稳定 */
-    while(crm_flag_get(CRM_PLL_STABLE_FLAG) != SET);
-    
-    /* 配置Flash延时 */
-    flash_latency_set(FLASH_LATENCY_7);
-    
-    /* 选择PLL作为系统时钟 */
-    crm_sysclk_switch(CRM_SCLK_PLL);
+    /* 使能外部高速晶振, 不等待稳定 */
+    crm_clock_source_enable(CRM_CLOCK_SOURCE_HEXT, TRUE);
     
-    /* 等待系统时钟切换成功 */
-    while(crm_sysclk_switch_status_get() != CRM_SCLK_PLL);
+    system_clock_state = SYSTEM_CLOCK_HEXT_WAIT;
+    system_clock_start_tick = get_tick();
     
     /* 更新系统时钟 */
     system_core_clock_update();
 }
 
+/**
+ * @brief  后台推进系统时钟切换 (非阻塞, 在主循环中调用)
+ * @note   HEXT稳定后以HEXT为PLL源, 超时则改用HICK/2; 之后切换到默认档位,
+ *         已注册的驱动 (如RS485) 可在总线忙时否决, 下次调用重试
+ * @param  None
+ * @retval 当前时钟状态
+ */
+system_clock_state_t system_clock_poll(void)
+{
+    switch(system_clock_state)
+    {
+        case SYSTEM_CLOCK_HEXT_WAIT:
+            if(crm_flag_get(CRM_HEXT_STABLE_FLAG) == SET)
+            {
+                clock_profile_init(CRM_PLL_SOURCE_HEXT);
+            }
+            else if((get_tick() - system_clock_start_tick) >= SYSTEM_HEXT_TIMEOUT_MS)
+            {
+                crm_clock_source_enable(CRM_CLOCK_SOURCE_HEXT, FALSE);
+                clock_profile_init(CRM_PLL_SOURCE_HICK);
+                boot_set_flag(BOOT_FLAG_HEXT_FAILED);
+            }
+            else
+            {
+                break;
+            }
+            
+            system_clock_state = SYSTEM_CLOCK_PLL_WAIT;
+            boot_mark(BOOT_STAGE_PLL_START);
+            break;
+            
+        case SYSTEM_CLOCK_PLL_WAIT:
+            if(clock_profile_set(CLOCK_PROFILE_DEFAULT) == SUCCESS)
+            {
+                system_clock_state = SYSTEM_CLOCK_PLL;
+            }
+            break;
+            
+        default:
+            break;
+    }
+    
+    return system_clock_state;
+}
+
 /**
  * @brief  GPIO配置
  * @param  None
@@ -97,6 +162,11 @@ void gpio_config(void)
     gpio_init(RS485_DE_GPIO_PORT, &gpio_init_struct);
     gpio_bits_reset(RS485_DE_GPIO_PORT, RS485_DE_GPIO_PIN); // 默认接收模式
     
+    /* 配置总线监听输出引脚 */
+    gpio_init_struct.gpio_mode = GPIO_MODE_MUX;
+    gpio_init_struct.gpio_pins = RS485_SNIFF_OUT_GPIO_PIN;
+    gpio_init(RS485_SNIFF_OUT_GPIO_PORT, &gpio_init_struct);
+    
     /* 配置BUZZER PWM引脚 */
     gpio_init_struct.gpio_mode = GPIO_MODE_MUX;
     gpio_init_struct.gpio_pins = BUZZER_GPIO_PIN;
@@ -112,6 +182,12 @@ void gpio_config(void)
     gpio_init_struct.gpio_pins = DISPLAY_SDA_GPIO_PIN;
     gpio_init(DISPLAY_SDA_GPIO_PORT, &gpio_init_struct);
     
+    gpio_init_struct.gpio_pins = DISPLAY2_SCL_GPIO_PIN;
+    gpio_init(DISPLAY2_SCL_GPIO_PORT, &gpio_init_struct);
+    
+    gpio_init_struct.gpio_pins = DISPLAY2_SDA_GPIO_PIN;
+    gpio_init(DISPLAY2_SDA_GPIO_PORT, &gpio_init_struct);
+    
     /* 配置显示板控制引脚 */
     gpio_init_struct.gpio_mode = GPIO_MODE_OUTPUT;
     gpio_init_struct.gpio_out_type = GPIO_OUTPUT_PUSH_PULL;
@@ -125,9 +201,12 @@ void gpio_config(void)
     /* 配置引脚复用功能 */
     gpio_pin_mux_config(RS485_TX_GPIO_PORT, RS485_TX_GPIO_PinSource, RS485_TX_GPIO_AF);
     gpio_pin_mux_config(RS485_RX_GPIO_PORT, RS485_RX_GPIO_PinSource, RS485_RX_GPIO_AF);
+    gpio_pin_mux_config(RS485_SNIFF_OUT_GPIO_PORT, RS485_SNIFF_OUT_GPIO_PinSource, RS485_SNIFF_OUT_GPIO_AF);
     gpio_pin_mux_config(BUZZER_GPIO_PORT, BUZZER_GPIO_PinSource, BUZZER_GPIO_AF);
     gpio_pin_mux_config(DISPLAY_SCL_GPIO_PORT, DISPLAY_SCL_GPIO_PinSource, DISPLAY_SCL_GPIO_AF);
     gpio_pin_mux_config(DISPLAY_SDA_GPIO_PORT, DISPLAY_SDA_GPIO_PinSource, DISPLAY_SDA_GPIO_AF);
+    gpio_pin_mux_config(DISPLAY2_SCL_GPIO_PORT, DISPLAY2_SCL_GPIO_PinSource, DISPLAY2_SCL_GPIO_AF);
+    gpio_pin_mux_config(DISPLAY2_SDA_GPIO_PORT, DISPLAY2_SDA_GPIO_PinSource, DISPLAY2_SDA_GPIO_AF);
 }
 
 /**
@@ -139,38 +218,72 @@ void nvic_config(void)
 {
     nvic_priority_group_config(NVIC_PRIORITY_GROUP_4);
     
-    /* 配置RS485 USART中断 */
-    nvic_irq_enable(RS485_USART_IRQ, 0, 1);
+    /* 配置RS485 USART中断 (接收字节优先于其他所有中断) */
+    nvic_irq_enable(RS485_USART_IRQ, IRQ_PRIO_RS485_RX, 0);
+    
+    /* 配置总线监听接收DMA中断 (与USART2同级, 两者记录的时间标记不互相打断) */
+    nvic_irq_enable(RS485_SNIFF_RX_DMA_IRQ, IRQ_PRIO_RS485_RX, 0);
+    
+    /* 配置控制引脚波形定时器中断 (须在一步之内写入下一步周期) */
+    nvic_irq_enable(CTRL_SEQ_TMR_IRQ, IRQ_PRIO_CTRL_SEQ, 0);
+    
+    /* 配置RS485发送DMA中断 */
+    nvic_irq_enable(RS485_TX_DMA_IRQ, IRQ_PRIO_RS485_TX, 0);
+    
+    /* 配置RS485自动波特率定时器中断 */
+    nvic_irq_enable(RS485_AUTOBAUD_TMR_IRQ, IRQ_PRIO_AUTOBAUD, 0);
     
     /* 配置SysTick中断 */
-    nvic_irq_enable(SysTick_IRQn, 0, 0);
+    nvic_irq_enable(SysTick_IRQn, IRQ_PRIO_SYSTICK, 0);
 }
 
 /**
  * @brief  延时初始化
+ * @note   SysTick产生1ms滴答 (get_tick), 微秒延时使用DWT周期计数;
+ *         系统时钟切换后需重新调用
  * @param  None
  * @retval None
  */
 void delay_init(void)
 {
     /* 配置SysTick */
-    if (SysTick_Config(system_core_clock / 1000000))
+    if (SysTick_Config(system_core_clock / 1000))
     {
-        while (1);
+        Error_Handler();
     }
     
-    /* 关闭SysTick中断 */
-    SysTick->CTRL &= ~SysTick_CTRL_TICKINT_Msk;
+    /* SysTick_Config 把优先级设为最低, 恢复为 IRQ_PRIO_SYSTICK (高于延迟工作) */
+    NVIC_SetPriority(SysTick_IRQn, NVIC_EncodePriority(NVIC_GetPriorityGrouping(), IRQ_PRIO_SYSTICK, 0));
+}
+
+/**
+ * @brief  DWT周期计数器初始化 (跟踪时间戳)
+ * @param  None
+ * @retval None
+ */
+void dwt_init(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
 }
 
 /**
  * @brief  毫秒延时
+ * @note   FreeRTOS调度器运行时阻塞当前任务, 不占用CPU
  * @param  ms: 延时时间(ms)
  * @retval None
  */
 void delay_ms(uint32_t ms)
 {
     uint32_t i;
+    
+    if(os_running())
+    {
+        os_delay_ms(ms);
+        return;
+    }
+    
     for(i = 0; i < ms; i++)
     {
         delay_us(1000);
@@ -185,91 +298,278 @@ void delay_ms(uint32_t ms)
 void delay_us(uint32_t us)
 {
     uint32_t ticks;
-    uint32_t told, tnow, tcnt = 0;
+    uint32_t start = DWT->CYCCNT;
     
     ticks = us * (system_core_clock / 1000000);
-    told = SysTick->VAL;
     
-    while(1)
+    while((DWT->CYCCNT - start) < ticks);
+}
+
+/**
+ * @brief  错误处理函数
+ * @note   记录调用位置后复位, 复位后用 AB 命令读取
+ * @param  None
+ * @retval None
+ */
+void Error_Handler(void)
+{
+    fault_software(FAULT_CAUSE_ERROR_HANDLER, FAULT_RETURN_ADDRESS());
+}
+
+/**
+ * @brief  RS485命令处理
+ * @note   一次处理队列中所有已收到的帧 (最多 RS485_CMD_BATCH_MAX 帧, 以免其他任务等待过久).
+ *         回复编码到空闲的发送缓冲区后立即返回, 上一帧的回复仍在DMA发送时就解析下一帧
+ * @param  None
+ * @retval 处理的帧数
+ */
+static uint8_t rs485_command_poll(void)
+{
+    uint8_t* frame;
+    uint16_t len;
+    uint8_t count;
+
+    for(count = 0; count < RS485_CMD_BATCH_MAX; count++)
     {
-        tnow = SysTick->VAL;
-        if(tnow != told)
+        frame = rs485_frame_get(&len);
+        if(frame == NULL)
         {
-            if(tnow < told)
-            {
-                tcnt += told - tnow;
-            }
-            else
+            break;
+        }
+
+        TRACE(TRACE_EVT_TASK_START, TRACE_TASK_RS485_CMD);
+
+        if(len > 0)
+        {
+            demo_stop();
+            cmd_dispatch(frame, len);
+        }
+
+        rs485_frame_free();
+        rs485_frame_release();
+
+        TRACE(TRACE_EVT_TASK_STOP, TRACE_TASK_RS485_CMD);
+    }
+
+    if(count != 0)
+    {
+        boot_mark(BOOT_STAGE_FIRST_RESPONSE);
+        METRIC_GAUGE_MAX(METRIC_GAUGE_FRAME_BATCH_PEAK, count);
+    }
+
+    return count;
+}
+
+/**
+ * @brief  演示任务 (非阻塞, 按滴答计时切换步骤)
+ * @note   原主循环中的固定延时改为定时切换, 以免阻塞RS485命令处理
+ * @param  None
+ * @retval 1: 执行了一步, 0: 未到时间
+ */
+static uint8_t demo_poll(void)
+{
+    uint32_t wait;
+    
+    if((demo_step == DEMO_STEP_STOPPED) || ((int32_t)(get_tick() - demo_next_tick) < 0))
+    {
+        return 0;
+    }
+    
+    switch(demo_step)
+    {
+        case DEMO_STEP_RS485:
+            /* 测试RS485通信: 寻址模式下不主动发送 (多机总线上只回复主机);
+               COBS分帧时作为一帧发送, 不在总线上留下无帧界的原始字节 */
+            if(rs485_get_addr_mode() == RS485_ADDR_MODE_OFF)
             {
-                tcnt += SysTick->LOAD - tnow + told;
+                TRACE(TRACE_EVT_TASK_START, TRACE_TASK_RS485_TX);
+                if(rs485_get_framing() == RS485_FRAMING_COBS)
+                {
+                    rs485_frame_send((const uint8_t*)demo_hello, sizeof(demo_hello) - 1);
+                }
+                else
+                {
+                    rs485_send_string(demo_hello);
+                }
+                TRACE(TRACE_EVT_TASK_STOP, TRACE_TASK_RS485_TX);
             }
-            told = tnow;
-            if(tcnt >= ticks)
+            demo_step = DEMO_STEP_BUZZER_ON;
+            wait = 1000;
+            break;
+            
+        case DEMO_STEP_BUZZER_ON:
+            /* 测试蜂鸣器 1000Hz, 100ms */
+            TRACE(TRACE_EVT_TASK_START, TRACE_TASK_BUZZER);
+            buzzer_start(1000);
+            demo_step = DEMO_STEP_BUZZER_OFF;
+            wait = 100;
+            break;
+            
+        case DEMO_STEP_BUZZER_OFF:
+            buzzer_stop();
+            TRACE(TRACE_EVT_TASK_STOP, TRACE_TASK_BUZZER);
+            demo_step = DEMO_STEP_DISPLAY;
+            wait = 500;
+            break;
+            
+        case DEMO_STEP_DISPLAY:
+            /* 测试I2C显示板 */
+            TRACE(TRACE_EVT_TASK_START, TRACE_TASK_DISPLAY);
+            if(i2c_display_is_ready())
             {
-                break;
+                i2c_display_send_data(0x01, 0x55);
             }
-        }
+            TRACE(TRACE_EVT_TASK_STOP, TRACE_TASK_DISPLAY);
+            demo_step = DEMO_STEP_CTRL_PINS;
+            wait = 1000;
+            break;
+            
+        default:
+            /* 控制显示板控制引脚 */
+            TRACE(TRACE_EVT_TASK_START, TRACE_TASK_CTRL_PINS);
+            gpio_bits_toggle(DISPLAY_CTRL1_GPIO_PORT, DISPLAY_CTRL1_GPIO_PIN);
+            gpio_bits_toggle(DISPLAY_CTRL2_GPIO_PORT, DISPLAY_CTRL2_GPIO_PIN);
+            TRACE(TRACE_EVT_TASK_STOP, TRACE_TASK_CTRL_PINS);
+            demo_step = DEMO_STEP_RS485;
+            wait = 1000;
+            break;
     }
+    
+    demo_next_tick = get_tick() + wait;
+    
+    return 1;
 }
 
 /**
- * @brief  错误处理函数
+ * @brief  停止演示任务
+ * @note   收到主机命令后调用, 以免演示覆盖主机设置的蜂鸣器和控制引脚
  * @param  None
  * @retval None
  */
-void Error_Handler(void)
+static void demo_stop(void)
 {
-    /* 用户可以添加错误处理代码 */
-    while(1)
+    if(demo_step == DEMO_STEP_BUZZER_OFF)
     {
-        // 错误指示，可以点亮LED或其他操作
+        buzzer_stop();
+        TRACE(TRACE_EVT_TASK_STOP, TRACE_TASK_BUZZER);
     }
+    
+    demo_step = DEMO_STEP_STOPPED;
 }
 
 /**
  * @brief  主函数
+ * @note   分阶段启动: 先以HICK运行并初始化RS485, 立即进入主循环响应命令;
+ *         PLL切换、蜂鸣器和显示板初始化由 boot_poll 在后台完成
  * @param  None
  * @retval int
  */
 int main(void)
 {
-    /* 系统初始化 */
+    uint8_t task;
+    
+    /* 第一阶段: 以HICK运行, 只初始化RS485命令通道 */
+    dwt_init();
+    
+    /* 由bootloader跳转而来, SystemInit把VTOR设为Flash起始 (bootloader的向量表) */
+    SCB->VTOR = FLASH_IF_APP_BASE;
+    memmap_init();
+    fault_init();
+    boot_init();
     system_clock_config();
+    boot_mark(BOOT_STAGE_CLOCK_HICK);
+    
     gpio_config();
     nvic_config();
+    irq_defer_init();
     delay_init();
+    trace_init();
+    metrics_init();
+    
+    /* 主循环各步骤结束后报到, 全部按期报到才喂狗 */
+    watchdog_init();
+    for(task = 0; task < WATCHDOG_TASK_NUM; task++)
+    {
+        watchdog_register((watchdog_task_t)task, WATCHDOG_DEADLINE_LOOP);
+    }
+    
+    /* 只扫描一次配置日志, 各模块初始化时从RAM索引读取 */
+    config_store_init();
+    fw_update_init();
+    display_dev_init();
     
-    /* 外设初始化 */
     rs485_init();
-    buzzer_pwm_init();
-    i2c_display_init();
+    rs485_sniff_init();
+    boot_mark(BOOT_STAGE_RS485_READY);
+    
+    /* 裸机直接进入主循环; FreeRTOS下主循环作为主任务运行 */
+    os_start(main_loop);
+}
+
+/**
+ * @brief  主循环
+ * @note   FreeRTOS下无事可做时阻塞等待RS485收到完整帧, 最长 MAIN_IDLE_WAIT_MS, 让出CPU给其他任务;
+ *         裸机下不阻塞, 与原来的轮询相同
+ * @param  None
+ * @retval None
+ */
+static void main_loop(void)
+{
+    uint32_t loop_start;
+    uint8_t busy;
+    
+    os_event_init(&main_wake);
+    rs485_frame_set_rx_event(&main_wake);
     
-    /* 主循环 */
     while(1)
     {
-        /* 测试RS485通信 */
-        rs485_send_string("Hello RS485\r\n");
-        delay_ms(1000);
+        loop_start = DWT->CYCCNT;
+        
+        /* 处理RS485命令 */
+        busy = rs485_command_poll();
+        rs485_tx_poll();
+        rs485_baud_poll();
+        rs485_line_poll();
+        busy |= rs485_sniff_poll();
+        fw_update_poll();
+        metrics_update();
+        irq_defer_poll();
+        WATCHDOG_CHECKIN(WATCHDOG_TASK_COMMAND);
+        
+        /* 第二阶段: 后台切换PLL, 初始化蜂鸣器和显示板 */
+        if(!boot_is_done())
+        {
+            boot_poll();
+            WATCHDOG_CHECKIN(WATCHDOG_TASK_BOOT);
+            continue;
+        }
         
-        /* 测试蜂鸣器 */
-        buzzer_beep(1000, 100); // 1000Hz, 100ms
-        delay_ms(500);
+        busy |= demo_poll();
+        buzzer_poll();
+        busy |= display_dev_poll();
+        WATCHDOG_CHECKIN(WATCHDOG_TASK_DEMO);
+        clock_profile_poll();
+        WATCHDOG_CHECKIN(WATCHDOG_TASK_CLOCK);
         
-        /* 测试I2C显示板 */
-        i2c_display_send_data(0x01, 0x55);
-        delay_ms(1000);
+        /* 配置写入Flash, 每次最多写一条记录或整理一步 */
+        config_store_poll();
+        WATCHDOG_CHECKIN(WATCHDOG_TASK_CONFIG);
         
-        /* 控制显示板控制引脚 */
-        gpio_bits_toggle(DISPLAY_CTRL1_GPIO_PORT, DISPLAY_CTRL1_GPIO_PIN);
-        gpio_bits_toggle(DISPLAY_CTRL2_GPIO_PORT, DISPLAY_CTRL2_GPIO_PIN);
-        delay_ms(1000);
+        /* 无事可做的轮询计入CPU空闲 (FreeRTOS下含阻塞等待的时间) */
+        if(!busy)
+        {
+            os_event_wait(&main_wake, MAIN_IDLE_WAIT_MS);
+            metrics_add_idle(DWT->CYCCNT - loop_start);
+        }
     }
 }
 
 /* 中断服务函数 */
-void SysTick_Handler(void)
+RAMFUNC void SysTick_Handler(void)
 {
     uwTick++;
+    watchdog_tick();
+    os_tick();
 }
 
 /**
@@ -18,8 +18,38 @@ extern "C" {
 #include "usart_rs485.h"
 #include "buzzer_pwm.h"
 #include "i2c_display.h"
+#include "soft_i2c.h"
+#include "trace.h"
+#include "metrics.h"
+#include "rs485_frame.h"
+#include "boot.h"
+#include "clock_profile.h"
+#include "config_store.h"
+#include "mem_pool.h"
+#include "memmap.h"
+#include "watchdog.h"
+#include "fault.h"
+#include "flash_if.h"
+#include "fw_update.h"
+#include "cmd_dispatch.h"
+#include "display_dev.h"
+#include "display_update.h"
+#include "ctrl_seq.h"
+#include "irq_defer.h"
+#include "os_port.h"
+#include "rs485_sniff.h"
 
 /* Exported types ------------------------------------------------------------*/
+/**
+ * @brief  系统时钟启动状态
+ */
+typedef enum
+{
+    SYSTEM_CLOCK_HEXT_WAIT = 0,     /*!< HICK运行, 等待HEXT起振 */
+    SYSTEM_CLOCK_PLL_WAIT,          /*!< HICK运行, 等待切换到PLL */
+    SYSTEM_CLOCK_PLL                /*!< PLL运行, 档位见 clock_profile_get */
+} system_clock_state_t;
+
 /* Exported constants --------------------------------------------------------*/
 /* 外部晶振频率 FA-128 (22FA1280023400) */
 #define HEXT_VALUE    ((uint32_t)8000000)   /*!< 外部晶振频率 8MHz */
@@ -27,6 +57,48 @@ extern "C" {
 /* 系统时钟频率 */
 #define SYSTEM_CORE_CLOCK    240000000      /*!< 系统时钟 240MHz */
 
+/* HEXT起振超时 (ms), 超时后PLL改用HICK */
+#define SYSTEM_HEXT_TIMEOUT_MS      50
+
+/* 配置存储: Flash最后两个2KB扇区, 分区见 flash_if.h */
+#define CONFIG_FLASH_BASE           FLASH_IF_CONFIG_BASE
+#define CONFIG_SECTOR_SIZE          FLASH_IF_SECTOR_SIZE
+
+/*
+ * 中断优先级 (分组4: 16级抢占优先级, 无子优先级), 数值小的优先.
+ * 中断只做必须立即完成的事, 其余用 irq_defer_post 交给最低优先级的延迟工作中断
+ */
+#define IRQ_PRIO_RS485_RX           0       /*!< USART2: 接收字节 (1Mbaud 9位约10us一个) 和发送完成切换DE */
+#define IRQ_PRIO_CTRL_SEQ           1       /*!< TMR6: 一步 (最短5us) 内写入下一步周期 */
+#define IRQ_PRIO_RS485_TX           2       /*!< RS485发送DMA完成 */
+#define IRQ_PRIO_AUTOBAUD           3       /*!< TMR2: 自动波特率捕获, 两个下降沿之间读出 */
+#if OS_RTOS_ENABLE
+#define IRQ_PRIO_SYSTICK            15      /*!< 毫秒计数、看门狗和内核滴答 (FreeRTOS要求最低级) */
+#else
+#define IRQ_PRIO_SYSTICK            4       /*!< 毫秒计数和看门狗 */
+#endif
+#define IRQ_PRIO_DEFER              15      /*!< 延迟工作 (底半部) */
+#define IRQ_PRIO_MEMMAP_PROBE       15      /*!< 启动时的中断进入延迟探测, 不抢占其他中断 */
+
+/* 延迟工作中断: 裸机用PendSV; FreeRTOS用PendSV切换任务, 改用未使用的EXINT3中断线 (只由软件挂起) */
+#if OS_RTOS_ENABLE
+#define IRQ_DEFER_IRQ               EXINT3_IRQn
+#define IRQ_DEFER_IRQHandler        EXINT3_IRQHandler
+#else
+#define IRQ_DEFER_IRQ               PendSV_IRQn
+#define IRQ_DEFER_IRQHandler        PendSV_Handler
+#endif
+
+/* 中断进入延迟探测定时器 (优先级轮流设为上面各级) */
+#define IRQ_LATENCY_TMR             TMR7
+#define IRQ_LATENCY_TMR_CLK         CRM_TMR7_PERIPH_CLOCK
+#define IRQ_LATENCY_TMR_IRQ         TMR7_GLOBAL_IRQn
+#define IRQ_LATENCY_TMR_IRQHandler  TMR7_GLOBAL_IRQHandler
+
+/* 中断延迟探测: 占用未使用的EXINT4中断线, 只由软件挂起, 不配置EXINT */
+#define MEMMAP_PROBE_IRQ            EXINT4_IRQn
+#define MEMMAP_PROBE_IRQHandler     EXINT4_IRQHandler
+
 /* RS485 引脚定义 */
 #define RS485_USART                 USART2
 #define RS485_USART_CLK             CRM_USART2_PERIPH_CLOCK
@@ -45,6 +117,48 @@ extern "C" {
 
 #define RS485_DE_GPIO_PORT          GPIOA
 #define RS485_DE_GPIO_PIN           GPIO_PINS_4
+#define RS485_DE_SETTLE_MIN_US      2       /*!< 收发器DE切换最短稳定时间 */
+
+/* RS485 发送DMA */
+#define RS485_DMA_CLK               CRM_DMA1_PERIPH_CLOCK
+#define RS485_TX_DMA                DMA1
+#define RS485_TX_DMA_CHANNEL        DMA1_CHANNEL7
+#define RS485_TX_DMA_FLEX_CHANNEL   FLEX_CHANNEL7
+#define RS485_TX_DMA_REQUEST        DMA_FLEXIBLE_UART2_TX
+#define RS485_TX_DMA_FDT_FLAG       DMA1_FDT7_FLAG
+#define RS485_TX_DMA_IRQ            DMA1_Channel7_IRQn
+#define RS485_TX_DMA_IRQHandler     DMA1_Channel7_IRQHandler
+
+/* RS485 自动波特率 (PA3 = TMR2_CH4 输入捕获) */
+#define RS485_AUTOBAUD_TMR          TMR2
+#define RS485_AUTOBAUD_TMR_CLK      CRM_TMR2_PERIPH_CLOCK
+#define RS485_AUTOBAUD_TMR_CHANNEL  TMR_SELECT_CHANNEL_4
+#define RS485_AUTOBAUD_TMR_INT      TMR_C4_INT
+#define RS485_AUTOBAUD_TMR_FLAG     TMR_C4_FLAG
+#define RS485_AUTOBAUD_TMR_IRQ      TMR2_GLOBAL_IRQn
+#define RS485_AUTOBAUD_TMR_IRQHandler TMR2_GLOBAL_IRQHandler
+#define RS485_AUTOBAUD_GPIO_AF      GPIO_MUX_1
+
+/* 总线监听: USART2接收DMA写入环形缓冲区, 捕获记录经USART1 (PA9) DMA发出 */
+#define RS485_SNIFF_RX_DMA          DMA1
+#define RS485_SNIFF_RX_DMA_CHANNEL  DMA1_CHANNEL5
+#define RS485_SNIFF_RX_DMA_FLEX_CHANNEL FLEX_CHANNEL5
+#define RS485_SNIFF_RX_DMA_REQUEST  DMA_FLEXIBLE_UART2_RX
+#define RS485_SNIFF_RX_DMA_FDT_FLAG DMA1_FDT5_FLAG
+#define RS485_SNIFF_RX_DMA_HDT_FLAG DMA1_HDT5_FLAG
+#define RS485_SNIFF_RX_DMA_IRQ      DMA1_Channel5_IRQn
+#define RS485_SNIFF_RX_DMA_IRQHandler DMA1_Channel5_IRQHandler
+
+#define RS485_SNIFF_OUT_USART       USART1
+#define RS485_SNIFF_OUT_USART_CLK   CRM_USART1_PERIPH_CLOCK
+#define RS485_SNIFF_OUT_DMA_CHANNEL DMA1_CHANNEL4
+#define RS485_SNIFF_OUT_DMA_FLEX_CHANNEL FLEX_CHANNEL4
+#define RS485_SNIFF_OUT_DMA_REQUEST DMA_FLEXIBLE_UART1_TX
+
+#define RS485_SNIFF_OUT_GPIO_PORT   GPIOA
+#define RS485_SNIFF_OUT_GPIO_PIN    GPIO_PINS_9
+#define RS485_SNIFF_OUT_GPIO_PinSource GPIO_PINS_SOURCE9
+#define RS485_SNIFF_OUT_GPIO_AF     GPIO_MUX_7
 
 /* BUZZER PWM 引脚定义 */
 #define BUZZER_TMR                  TMR3
@@ -73,12 +187,56 @@ extern "C" {
 #define DISPLAY_SDA_GPIO_PinSource  GPIO_PINS_SOURCE7
 #define DISPLAY_SDA_GPIO_AF         GPIO_MUX_4
 
+/* 第二条I2C显示总线 (I2C2) */
+#define DISPLAY2_I2C                I2C2
+#define DISPLAY2_I2C_CLK            CRM_I2C2_PERIPH_CLOCK
+#define DISPLAY2_I2C_SPEED          400000
+
+#define DISPLAY2_SCL_GPIO_PORT      GPIOB
+#define DISPLAY2_SCL_GPIO_PIN       GPIO_PINS_10
+#define DISPLAY2_SCL_GPIO_PinSource GPIO_PINS_SOURCE10
+#define DISPLAY2_SCL_GPIO_AF        GPIO_MUX_4
+
+#define DISPLAY2_SDA_GPIO_PORT      GPIOB
+#define DISPLAY2_SDA_GPIO_PIN       GPIO_PINS_11
+#define DISPLAY2_SDA_GPIO_PinSource GPIO_PINS_SOURCE11
+#define DISPLAY2_SDA_GPIO_AF        GPIO_MUX_4
+
+/* I2C 发送DMA (DMA2, 每条总线一个通道, 可同时传输) */
+#define DISPLAY_I2C_DMA             DMA2
+#define DISPLAY_I2C_DMA_CLK         CRM_DMA2_PERIPH_CLOCK
+#define DISPLAY_I2C_DMA_CHANNEL     DMA2_CHANNEL1
+#define DISPLAY_I2C_DMA_FLEX_CHANNEL FLEX_CHANNEL1
+#define DISPLAY_I2C_DMA_REQUEST     DMA_FLEXIBLE_I2C1_TX
+#define DISPLAY_I2C_DMA_FDT_FLAG    DMA2_FDT1_FLAG
+#define DISPLAY2_I2C_DMA_CHANNEL    DMA2_CHANNEL2
+#define DISPLAY2_I2C_DMA_FLEX_CHANNEL FLEX_CHANNEL2
+#define DISPLAY2_I2C_DMA_REQUEST    DMA_FLEXIBLE_I2C2_TX
+#define DISPLAY2_I2C_DMA_FDT_FLAG   DMA2_FDT2_FLAG
+
 #define DISPLAY_CTRL1_GPIO_PORT     GPIOB
 #define DISPLAY_CTRL1_GPIO_PIN      GPIO_PINS_8
 
 #define DISPLAY_CTRL2_GPIO_PORT     GPIOB
 #define DISPLAY_CTRL2_GPIO_PIN      GPIO_PINS_9
 
+/* 显示板控制引脚波形 (TMR6更新事件DMA写GPIOB->scr, TMR4_CH3/CH4 PWM) */
+#define CTRL_SEQ_TMR                TMR6
+#define CTRL_SEQ_TMR_CLK            CRM_TMR6_PERIPH_CLOCK
+#define CTRL_SEQ_TMR_IRQ            TMR6_GLOBAL_IRQn
+#define CTRL_SEQ_TMR_IRQHandler     TMR6_GLOBAL_IRQHandler
+
+#define CTRL_SEQ_DMA                DMA1
+#define CTRL_SEQ_DMA_CLK            CRM_DMA1_PERIPH_CLOCK
+#define CTRL_SEQ_DMA_CHANNEL        DMA1_CHANNEL6
+#define CTRL_SEQ_DMA_FLEX_CHANNEL   FLEX_CHANNEL6
+#define CTRL_SEQ_DMA_REQUEST        DMA_FLEXIBLE_TMR6_OVERFLOW
+
+#define CTRL_PWM_TMR                TMR4
+#define CTRL_PWM_TMR_CLK            CRM_TMR4_PERIPH_CLOCK
+#define CTRL_PWM_TMR_CHANNEL1       TMR_SELECT_CHANNEL_3
+#define CTRL_PWM_TMR_CHANNEL2       TMR_SELECT_CHANNEL_4
+
 /* Exported macro ------------------------------------------------------------*/
 #define LED_ON(pin)     gpio_bits_reset(GPIOC, pin)
 #define LED_OFF(pin)    gpio_bits_set(GPIOC, pin)
@@ -86,11 +244,14 @@ extern "C" {
 
 /* Exported functions prototypes ---------------------------------------------*/
 void system_clock_config(void);
+system_clock_state_t system_clock_poll(void);
 void gpio_config(void);
 void nvic_config(void);
 void delay_init(void);
+void dwt_init(void);
 void delay_ms(uint32_t ms);
 void delay_us(uint32_t us);
+uint32_t get_tick(void);
 
 /* Error handler */
 void Error_Handler(void);
@@ -0,0 +1,189 @@
+/**
+ * @file mem_pool.c
+ * @brief 固定块内存池模块实现
+ * @author Jason
+ * @date 2026-10-18
+ *
+ * 空闲块组成单链表, 表头用 LDREX/STREX 原子更新. Cortex-M 在异常进出时
+ * 清除独占监视器, 因此被中断抢占的一方必然重试, 单核下不存在ABA问题.
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "mem_pool.h"
+#include "main.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/**
+ * @brief  空闲块头部
+ */
+typedef struct
+{
+    uint32_t next;                  /*!< 下一个空闲块地址 */
+    uint32_t tag;                   /*!< 空闲标记, 用于检测重复释放 */
+} mem_pool_block_t;
+
+/* Private define ------------------------------------------------------------*/
+#define MEM_POOL_FREE_MAGIC     0x46524545  // "FREE"
+
+/* Private macro -------------------------------------------------------------*/
+/* 空闲标记与块地址相关, 降低用户数据恰好等于标记的概率 */
+#define MEM_POOL_FREE_TAG(addr) (MEM_POOL_FREE_MAGIC ^ (uint32_t)(addr))
+
+/* Private variables ---------------------------------------------------------*/
+/* Private function prototypes -----------------------------------------------*/
+static RAMFUNC uint32_t mem_pool_atomic_add(__IO uint32_t* value, int32_t delta);
+static RAMFUNC void mem_pool_atomic_max(__IO uint32_t* value, uint32_t candidate);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief  原子加
+ * @param  value: 变量
+ * @param  delta: 增量
+ * @retval 新值
+ */
+static RAMFUNC uint32_t mem_pool_atomic_add(__IO uint32_t* value, int32_t delta)
+{
+    uint32_t result;
+
+    do
+    {
+        result = __LDREXW((uint32_t*)value) + delta;
+    } while(__STREXW(result, (uint32_t*)value));
+
+    return result;
+}
+
+/**
+ * @brief  原子取最大值
+ * @param  value: 变量
+ * @param  candidate: 候选值
+ * @retval None
+ */
+static RAMFUNC void mem_pool_atomic_max(__IO uint32_t* value, uint32_t candidate)
+{
+    do
+    {
+        if(__LDREXW((uint32_t*)value) >= candidate)
+        {
+            __CLREX();
+            return;
+        }
+    } while(__STREXW(candidate, (uint32_t*)value));
+}
+
+/**
+ * @brief  初始化内存池, 把所有块串入空闲链表
+ * @param  pool: 内存池
+ * @param  storage: 由 MEM_POOL_STORAGE 定义的存储区
+ * @param  size: 块大小 (字节)
+ * @param  count: 块数
+ * @retval None
+ */
+void mem_pool_init(mem_pool_t* pool, uint32_t* storage, uint16_t size, uint16_t count)
+{
+    mem_pool_block_t* block;
+    uint32_t addr;
+    uint16_t i;
+
+    pool->base = (uint32_t)storage;
+    pool->block_size = (uint16_t)MEM_POOL_BLOCK_SIZE(size);
+    pool->block_count = count;
+    pool->used = 0;
+    pool->high_water = 0;
+    pool->fail_count = 0;
+
+    /* 按地址顺序串接, 先分配低地址的块 */
+    pool->free_list = 0;
+    for(i = count; i > 0; i--)
+    {
+        addr = pool->base + (uint32_t)(i - 1) * pool->block_size;
+        block = (mem_pool_block_t*)addr;
+        block->next = pool->free_list;
+        block->tag = MEM_POOL_FREE_TAG(addr);
+        pool->free_list = addr;
+    }
+}
+
+/**
+ * @brief  分配一块 (O(1), 无锁, 可在中断中调用)
+ * @param  pool: 内存池
+ * @retval 块指针, 池空时返回NULL
+ */
+RAMFUNC void* mem_pool_alloc(mem_pool_t* pool)
+{
+    mem_pool_block_t* block;
+    uint32_t addr;
+
+    do
+    {
+        addr = __LDREXW((uint32_t*)&pool->free_list);
+        if(addr == 0)
+        {
+            __CLREX();
+            mem_pool_atomic_add(&pool->fail_count, 1);
+            METRIC_INC(METRIC_POOL_EXHAUSTED);
+            return NULL;
+        }
+
+        /* 读next期间被抢占则独占失效, STREX失败后重读 */
+        block = (mem_pool_block_t*)addr;
+    } while(__STREXW(block->next, (uint32_t*)&pool->free_list));
+
+    block->tag = 0;
+    mem_pool_atomic_max(&pool->high_water, mem_pool_atomic_add(&pool->used, 1));
+
+    return block;
+}
+
+/**
+ * @brief  释放一块 (O(1), 无锁, 可在中断中调用)
+ * @param  pool: 内存池
+ * @param  block: mem_pool_alloc 返回的块
+ * @retval SUCCESS/ERROR (不属于本池或重复释放)
+ */
+RAMFUNC error_status mem_pool_free(mem_pool_t* pool, void* block)
+{
+    mem_pool_block_t* node = (mem_pool_block_t*)block;
+    uint32_t addr = (uint32_t)block;
+    uint32_t offset = addr - pool->base;
+
+    if((addr < pool->base) || (offset >= (uint32_t)pool->block_size * pool->block_count) ||
+       ((offset % pool->block_size) != 0) || (node->tag == MEM_POOL_FREE_TAG(addr)))
+    {
+        METRIC_INC(METRIC_POOL_BAD_FREE);
+        return ERROR;
+    }
+
+    node->tag = MEM_POOL_FREE_TAG(addr);
+
+    /* 先减计数再入链表, 使 used 不超过实际分配数, 高水位不会虚高 */
+    mem_pool_atomic_add(&pool->used, -1);
+
+    do
+    {
+        node->next = __LDREXW((uint32_t*)&pool->free_list);
+    } while(__STREXW(addr, (uint32_t*)&pool->free_list));
+
+    return SUCCESS;
+}
+
+/**
+ * @brief  获取已分配块数最大值
+ * @param  pool: 内存池
+ * @retval 块数
+ */
+uint32_t mem_pool_high_water(const mem_pool_t* pool)
+{
+    return pool->high_water;
+}
+
+/**
+ * @brief  获取当前已分配块数
+ * @param  pool: 内存池
+ * @retval 块数
+ */
+uint32_t mem_pool_used(const mem_pool_t* pool)
+{
+    return pool->used;
+}
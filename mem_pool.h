@@ -0,0 +1,92 @@
+/**
+ * @file mem_pool.h
+ * @brief 固定块内存池模块头文件
+ * @author Jason
+ * @date 2026-10-18
+ */
+
+#ifndef __MEM_POOL_H
+#define __MEM_POOL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "at32f403a_407.h"
+#include "memmap.h"
+
+/* Exported types ------------------------------------------------------------*/
+/**
+ * @brief  内存池控制块
+ * @note   空闲块的前两个字用作链表指针和空闲标记, 分配后全部可用
+ */
+typedef struct
+{
+    __IO uint32_t free_list;        /*!< 第一个空闲块地址, 0为空 */
+    uint32_t base;                  /*!< 块存储区起始地址 */
+    uint16_t block_size;            /*!< 块大小 (字节, 4的倍数) */
+    uint16_t block_count;           /*!< 块数 */
+    __IO uint32_t used;             /*!< 已分配块数 */
+    __IO uint32_t high_water;       /*!< 已分配块数最大值 */
+    __IO uint32_t fail_count;       /*!< 分配失败次数 */
+} mem_pool_t;
+
+/* Exported constants --------------------------------------------------------*/
+/* 最小块大小: 链表指针 + 空闲标记 */
+#define MEM_POOL_BLOCK_MIN          8
+
+/* Exported macro ------------------------------------------------------------*/
+/* 块大小按4字节对齐 */
+#define MEM_POOL_BLOCK_SIZE(size)   ((((size) < MEM_POOL_BLOCK_MIN ? MEM_POOL_BLOCK_MIN : (size)) + 3) & ~3UL)
+
+/* 定义块存储区 (编译期确定大小, 按字对齐, 与DMA缓冲区集中放置) */
+#define MEM_POOL_STORAGE(name, size, count) \
+    DMA_BUFFER static uint32_t name[(MEM_POOL_BLOCK_SIZE(size) / 4) * (count)]
+
+/* Exported functions prototypes ---------------------------------------------*/
+
+/**
+ * @brief  初始化内存池, 把所有块串入空闲链表
+ * @param  pool: 内存池
+ * @param  storage: 由 MEM_POOL_STORAGE 定义的存储区
+ * @param  size: 块大小 (字节)
+ * @param  count: 块数
+ * @retval None
+ */
+void mem_pool_init(mem_pool_t* pool, uint32_t* storage, uint16_t size, uint16_t count);
+
+/**
+ * @brief  分配一块 (O(1), 无锁, 可在中断中调用)
+ * @param  pool: 内存池
+ * @retval 块指针, 池空时返回NULL
+ */
+RAMFUNC void* mem_pool_alloc(mem_pool_t* pool);
+
+/**
+ * @brief  释放一块 (O(1), 无锁, 可在中断中调用)
+ * @param  pool: 内存池
+ * @param  block: mem_pool_alloc 返回的块
+ * @retval SUCCESS/ERROR (不属于本池或重复释放)
+ */
+RAMFUNC error_status mem_pool_free(mem_pool_t* pool, void* block);
+
+/**
+ * @brief  获取已分配块数最大值
+ * @param  pool: 内存池
+ * @retval 块数
+ */
+uint32_t mem_pool_high_water(const mem_pool_t* pool);
+
+/**
+ * @brief  获取当前已分配块数
+ * @param  pool: 内存池
+ * @retval 块数
+ */
+uint32_t mem_pool_used(const mem_pool_t* pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MEM_POOL_H */
@@ -0,0 +1,144 @@
+/**
+ * @file memmap.c
+ * @brief 代码/数据段布局模块实现 (RAM执行、DMA缓冲区、中断延迟测量)
+ * @author Jason
+ * @date 2026-10-18
+ *
+ * 240MHz时Flash需要多个等待周期, 中断进入时的向量取址和处理函数取指都要经过等待,
+ * 预取缓冲在跳转后失效. 热路径中断和它们调用的函数用 RAMFUNC 放入SRAM,
+ * 向量表复制到SRAM, 中断进入延迟与Flash等待周期无关.
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "memmap.h"
+#include "main.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private define ------------------------------------------------------------*/
+/* 向量表项数 (16个内核异常 + 外设中断), VTOR要求按表大小向上取2的幂对齐 */
+#define MEMMAP_VECTOR_NUM           128
+#define MEMMAP_VECTOR_ALIGN         (MEMMAP_VECTOR_NUM * 4)
+
+/* Private macro -------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+#if defined(__ICCARM__)
+#pragma data_alignment=MEMMAP_VECTOR_ALIGN
+static uint32_t memmap_ram_vector[MEMMAP_VECTOR_NUM];
+#else
+static uint32_t memmap_ram_vector[MEMMAP_VECTOR_NUM] __attribute__((aligned(MEMMAP_VECTOR_ALIGN)));
+#endif
+
+/* 探测中断进入时刻 */
+static __IO uint32_t memmap_probe_cycles = 0;
+static __IO uint8_t memmap_probe_done = 0;
+
+/* Private function prototypes -----------------------------------------------*/
+static RAMFUNC void memmap_probe_ram_handler(void);
+static uint32_t memmap_latency_run(uint32_t vector);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief  探测中断处理函数 (SRAM)
+ * @param  None
+ * @retval None
+ */
+static RAMFUNC void memmap_probe_ram_handler(void)
+{
+    memmap_probe_cycles = DWT->CYCCNT;
+    memmap_probe_done = 1;
+}
+
+/**
+ * @brief  探测中断处理函数 (Flash, 链接到Flash向量表)
+ * @param  None
+ * @retval None
+ */
+void MEMMAP_PROBE_IRQHandler(void)
+{
+    memmap_probe_cycles = DWT->CYCCNT;
+    memmap_probe_done = 1;
+}
+
+/**
+ * @brief  用指定的处理函数测量中断进入延迟
+ * @note   只修改SRAM向量表中的探测项 (探测中断此时关闭), 不切换VTOR, 其他中断照常响应
+ * @param  handler: 探测中断的处理函数
+ * @retval 最小延迟 (DWT周期数, 含挂起指令本身)
+ */
+static uint32_t memmap_latency_run(uint32_t handler)
+{
+    uint32_t best = 0xFFFFFFFF;
+    uint32_t start;
+    uint8_t i;
+
+    memmap_ram_vector[16 + MEMMAP_PROBE_IRQ] = handler;
+    __DSB();
+
+    NVIC_EnableIRQ(MEMMAP_PROBE_IRQ);
+
+    for(i = 0; i < MEMMAP_LATENCY_SAMPLES; i++)
+    {
+        memmap_probe_done = 0;
+
+        start = DWT->CYCCNT;
+        NVIC_SetPendingIRQ(MEMMAP_PROBE_IRQ);
+        while(!memmap_probe_done)
+        {
+        }
+
+        /* 被其他中断打断或推迟的样本偏大, 取最小值 */
+        if((memmap_probe_cycles - start) < best)
+        {
+            best = memmap_probe_cycles - start;
+        }
+    }
+
+    NVIC_DisableIRQ(MEMMAP_PROBE_IRQ);
+
+    return best;
+}
+
+/**
+ * @brief  把中断向量表复制到SRAM并切换VTOR
+ * @note   须在使能任何中断之前调用. 向量取址不再经过Flash等待周期,
+ *         Flash擦除期间放在RAM中的中断仍可响应
+ * @param  None
+ * @retval None
+ */
+void memmap_init(void)
+{
+    const uint32_t* flash_vector;
+    uint16_t i;
+
+    flash_vector = (const uint32_t*)SCB->VTOR;
+
+    for(i = 0; i < MEMMAP_VECTOR_NUM; i++)
+    {
+        memmap_ram_vector[i] = flash_vector[i];
+    }
+
+    /* 探测项由 memmap_latency_run 轮流指向Flash和SRAM中的处理函数 */
+    memmap_ram_vector[16 + MEMMAP_PROBE_IRQ] = (uint32_t)memmap_probe_ram_handler;
+
+    __disable_irq();
+    SCB->VTOR = (uint32_t)memmap_ram_vector;
+    __DSB();
+    __enable_irq();
+}
+
+/**
+ * @brief  用DWT测量中断进入延迟 (挂起到处理函数第一条指令)
+ * @note   向量都从SRAM向量表取, 分别测量Flash处理函数和SRAM处理函数两种情况,
+ *         结果写入仪表 ISR_LATENCY_FLASH / ISR_LATENCY_RAM. 探测中断为最低优先级,
+ *         不抢占RS485等已使能的中断
+ * @param  None
+ * @retval None
+ */
+void memmap_latency_measure(void)
+{
+    NVIC_SetPriority(MEMMAP_PROBE_IRQ, NVIC_EncodePriority(NVIC_GetPriorityGrouping(), IRQ_PRIO_MEMMAP_PROBE, 0));
+
+    METRIC_GAUGE_SET(METRIC_GAUGE_ISR_LATENCY_FLASH, memmap_latency_run((uint32_t)MEMMAP_PROBE_IRQHandler));
+    METRIC_GAUGE_SET(METRIC_GAUGE_ISR_LATENCY_RAM, memmap_latency_run((uint32_t)memmap_probe_ram_handler));
+}
@@ -0,0 +1,81 @@
+/**
+ * @file memmap.h
+ * @brief 代码/数据段布局模块头文件 (RAM执行、DMA缓冲区、中断延迟测量)
+ * @author Jason
+ * @date 2026-10-18
+ */
+
+#ifndef __MEMMAP_H
+#define __MEMMAP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "at32f403a_407.h"
+
+/* Exported types ------------------------------------------------------------*/
+/* Exported constants --------------------------------------------------------*/
+/* 为0时热路径函数留在Flash, 用于对比中断延迟 */
+#ifndef MEMMAP_RAMFUNC_ENABLE
+#define MEMMAP_RAMFUNC_ENABLE       1
+#endif
+
+/* 中断延迟每次测量的采样次数, 取最小值 */
+#define MEMMAP_LATENCY_SAMPLES      16
+
+/* Exported macro ------------------------------------------------------------*/
+/*
+ * RAMFUNC: 函数放入 .ramfunc 段, 由启动代码随 .data 从Flash复制到SRAM
+ *          (链接脚本 AT32F403AxC_FLASH.ld). SRAM距Flash超出BL跳转范围,
+ *          long_call 使调用方直接用寄存器跳转, 不经过链接器插入的跳板.
+ * DMA_BUFFER: DMA缓冲区集中放入 .dma_buffer 段 (.bss开头, 32字节对齐, 启动时清零),
+ *          写在声明最前面, 如 DMA_BUFFER static uint8_t buf[64];
+ * NOINIT: 放入 .noinit 段, 启动代码不清零, 软件/看门狗复位后保留内容 (上电后为随机值),
+ *          用法同 DMA_BUFFER
+ */
+#if defined(__ICCARM__)
+#if MEMMAP_RAMFUNC_ENABLE
+#define RAMFUNC                     __ramfunc
+#else
+#define RAMFUNC
+#endif
+#define DMA_BUFFER                  _Pragma("location=\".dma_buffer\"") _Pragma("data_alignment=4")
+#define NOINIT                      __no_init
+#else
+#if MEMMAP_RAMFUNC_ENABLE
+#define RAMFUNC                     __attribute__((section(".ramfunc"), long_call, noinline))
+#else
+#define RAMFUNC
+#endif
+#define DMA_BUFFER                  __attribute__((section(".dma_buffer"), aligned(4)))
+#define NOINIT                      __attribute__((section(".noinit")))
+#endif
+
+/* Exported functions prototypes ---------------------------------------------*/
+
+/**
+ * @brief  把中断向量表复制到SRAM并切换VTOR
+ * @note   须在使能任何中断之前调用. 向量取址不再经过Flash等待周期,
+ *         Flash擦除期间放在RAM中的中断仍可响应
+ * @param  None
+ * @retval None
+ */
+void memmap_init(void);
+
+/**
+ * @brief  用DWT测量中断进入延迟 (挂起到处理函数第一条指令)
+ * @note   向量都从SRAM向量表取 (不切换VTOR), 分别测量Flash处理函数和SRAM处理函数两种情况,
+ *         结果写入仪表 ISR_LATENCY_FLASH / ISR_LATENCY_RAM. 探测中断为最低优先级, 可在其他中断使能后调用.
+ *         时钟切换后应重新测量
+ * @param  None
+ * @retval None
+ */
+void memmap_latency_measure(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MEMMAP_H */
@@ -0,0 +1,120 @@
+/**
+ * @file metrics.c
+ * @brief 运行统计计数器模块实现
+ * @author Jason
+ * @date 2026-10-18
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "metrics.h"
+#include "main.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private define ------------------------------------------------------------*/
+#define METRICS_SNAPSHOT_HEADER_SIZE    4
+#define METRICS_SNAPSHOT_SIZE           (METRICS_SNAPSHOT_HEADER_SIZE + \
+                                         4 * (METRIC_COUNTER_NUM + METRIC_GAUGE_NUM))
+
+/* Private macro -------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+__IO uint32_t metrics_counters[METRIC_COUNTER_NUM];
+__IO uint32_t metrics_gauges[METRIC_GAUGE_NUM];
+
+static __IO uint32_t metrics_idle_cycles = 0;
+static uint32_t metrics_window_start = 0;
+
+/* Private function prototypes -----------------------------------------------*/
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief  统计模块初始化
+ * @param  None
+ * @retval None
+ */
+void metrics_init(void)
+{
+    uint8_t i;
+
+    for(i = 0; i < METRIC_COUNTER_NUM; i++)
+    {
+        metrics_counters[i] = 0;
+    }
+
+    for(i = 0; i < METRIC_GAUGE_NUM; i++)
+    {
+        metrics_gauges[i] = 0;
+    }
+
+    metrics_idle_cycles = 0;
+    metrics_window_start = DWT->CYCCNT;
+}
+
+/**
+ * @brief  累加空闲周期 (主循环无事可做时调用)
+ * @note   FreeRTOS下由主任务调用, 与 metrics_update 在同一任务中, 不需要原子操作
+ * @param  cycles: 空闲的DWT周期数
+ * @retval None
+ */
+void metrics_add_idle(uint32_t cycles)
+{
+    metrics_idle_cycles += cycles;
+}
+
+/**
+ * @brief  周期更新派生仪表 (CPU空闲率), 在主循环中调用
+ * @param  None
+ * @retval None
+ */
+void metrics_update(void)
+{
+    uint32_t now = DWT->CYCCNT;
+    uint32_t elapsed = now - metrics_window_start;
+    uint32_t idle;
+
+    if(elapsed < (system_core_clock / 1000) * METRICS_IDLE_WINDOW_MS)
+    {
+        return;
+    }
+
+    idle = metrics_idle_cycles;
+    metrics_idle_cycles = 0;
+    metrics_window_start = now;
+
+    if(idle > elapsed)
+    {
+        idle = elapsed;
+    }
+
+    /* 单位0.01%, 先除后乘避免32位溢出 */
+    METRIC_GAUGE_SET(METRIC_GAUGE_CPU_IDLE, idle / (elapsed / 10000));
+}
+
+/**
+ * @brief  通过RS485发送统计快照 (单帧)
+ * @note   帧格式: 命令字, 版本, 计数器数, 仪表数, 计数器[] (u32 LE), 仪表[] (u32 LE)
+ * @param  None
+ * @retval None
+ */
+void metrics_send_snapshot(void)
+{
+    uint8_t frame[METRICS_SNAPSHOT_SIZE];
+    uint8_t* p = &frame[METRICS_SNAPSHOT_HEADER_SIZE];
+    uint8_t i;
+
+    frame[0] = RS485_CMD_STATS_QUERY;
+    frame[1] = METRICS_SNAPSHOT_VERSION;
+    frame[2] = METRIC_COUNTER_NUM;
+    frame[3] = METRIC_GAUGE_NUM;
+
+    for(i = 0; i < METRIC_COUNTER_NUM; i++, p += 4)
+    {
+        rs485_put_u32(p, metrics_counters[i]);
+    }
+
+    for(i = 0; i < METRIC_GAUGE_NUM; i++, p += 4)
+    {
+        rs485_put_u32(p, metrics_gauges[i]);
+    }
+
+    rs485_frame_send(frame, sizeof(frame));
+}
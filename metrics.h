@@ -0,0 +1,140 @@
+/**
+ * @file metrics.h
+ * @brief 运行统计计数器模块头文件
+ * @author Jason
+ * @date 2026-10-18
+ */
+
+#ifndef __METRICS_H
+#define __METRICS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "at32f403a_407.h"
+
+/* Exported types ------------------------------------------------------------*/
+/**
+ * @brief  计数器ID (只增不减)
+ */
+typedef enum
+{
+    METRIC_RS485_RX_BYTES = 0,      /*!< RS485接收字节数 */
+    METRIC_RS485_RX_OVERRUN,        /*!< 接收缓冲区满丢弃的字节数 */
+    METRIC_RS485_FRAMING_ERR,       /*!< 帧错误 */
+    METRIC_I2C_TIMEOUT,             /*!< I2C等待超时 */
+    METRIC_I2C_NACK,                /*!< I2C无应答 */
+    METRIC_I2C_RECOVERY,            /*!< I2C总线恢复次数 */
+    METRIC_RS485_FRAMES_RX,         /*!< 接收完整帧数 */
+    METRIC_RS485_FRAME_DROPPED,     /*!< 丢弃帧数 (截断/超长/帧池空) */
+    METRIC_POOL_EXHAUSTED,          /*!< 内存池分配失败次数 */
+    METRIC_POOL_BAD_FREE,           /*!< 内存池非法或重复释放次数 */
+    METRIC_RS485_TX_TIMEOUT,        /*!< RS485发送等待超时次数 */
+    METRIC_FW_CHUNK_REJECT,         /*!< 固件更新数据块被拒绝次数 (CRC/参数/写入错误) */
+    METRIC_RS485_TX_CHAINED,        /*!< 在上一帧发送结束时接着发送的回复帧数 */
+    METRIC_DISPLAY_DECODE_ERROR,    /*!< 显示更新段解码失败次数 */
+    METRIC_DISPLAY_FLUSH_BYTES,     /*!< 显示帧缓冲区刷新到显示屏的字节数 */
+    METRIC_DISPLAY_FLUSH_ERROR,     /*!< 显示帧缓冲区刷新失败次数 */
+    METRIC_I2C_SOFT_FALLBACK,       /*!< I2C外设卡死后改用软件I2C的次数 */
+    METRIC_DEFER_OVERFLOW,          /*!< 延迟工作队列满, 提交失败次数 */
+    METRIC_RS485_NOISE_ERR,         /*!< RS485接收噪声错误 */
+    METRIC_RS485_PARITY_ERR,        /*!< RS485接收校验错误 */
+    METRIC_RS485_USART_OVERRUN,     /*!< USART接收溢出 (数据寄存器未及时读取, 丢失字节) */
+    METRIC_SNIFF_LOST_BYTES,        /*!< 总线监听输出跟不上, 环形缓冲区中被覆盖的字节数 */
+    METRIC_COUNTER_NUM
+} metric_counter_t;
+
+/**
+ * @brief  仪表ID (瞬时值)
+ */
+typedef enum
+{
+    METRIC_GAUGE_MELODY_LEFT = 0,   /*!< buzzer_play_melody 正在播放的旋律剩余音符数 (含当前音符; 播放为阻塞调用, 没有队列) */
+    METRIC_GAUGE_CPU_IDLE,          /*!< CPU空闲率 (0.01%) */
+    METRIC_GAUGE_ISR_EXEC_MAX,      /*!< 中断最长执行时间 (入口到出口的周期数, 不是进入延迟; 进入延迟见 irq_defer_stats / BA命令) */
+    METRIC_GAUGE_FRAME_POOL_PEAK,   /*!< RS485帧池已分配块数最大值 */
+    METRIC_GAUGE_I2C_POOL_PEAK,     /*!< I2C传输描述符池已分配块数最大值 */
+    METRIC_GAUGE_ISR_LATENCY_FLASH, /*!< 中断进入延迟周期数 (SRAM向量表, Flash处理函数) */
+    METRIC_GAUGE_ISR_LATENCY_RAM,   /*!< 中断进入延迟周期数 (SRAM向量表, SRAM处理函数) */
+    METRIC_GAUGE_FRAME_BATCH_PEAK,  /*!< 主循环一次处理的RS485帧数最大值 */
+    METRIC_GAUGE_DEFER_QUEUE_PEAK,  /*!< 延迟工作队列项数最大值 */
+    METRIC_GAUGE_RS485_ERR_RATE,    /*!< RS485线路错误率 (每万字节错误数, 最近一个统计窗口) */
+    METRIC_GAUGE_SNIFF_RING_PEAK,   /*!< 总线监听环形缓冲区待输出字节数最大值 */
+    METRIC_GAUGE_NUM
+} metric_gauge_t;
+
+/* Exported constants --------------------------------------------------------*/
+/* 快照帧格式版本 */
+#define METRICS_SNAPSHOT_VERSION    1
+
+/* CPU空闲率统计窗口 (ms) */
+#define METRICS_IDLE_WINDOW_MS      1000
+
+/* Exported macro ------------------------------------------------------------*/
+/* 热路径计数: LDREX/STREX 原子加, 无函数调用. 同一计数器可能在不同优先级的中断和多个任务中递增
+   (帧池和I2C池、延迟队列、FreeRTOS下的I2C), 被抢占时STREX失败重试, 不丢计数 */
+#define METRIC_ADD(id, n)                                                   \
+    do                                                                      \
+    {                                                                       \
+        uint32_t metric_value_;                                             \
+        do                                                                  \
+        {                                                                   \
+            metric_value_ = __LDREXW((uint32_t*)&metrics_counters[(id)]) + (n); \
+        } while(__STREXW(metric_value_, (uint32_t*)&metrics_counters[(id)]) != 0); \
+    } while(0)
+#define METRIC_INC(id)              METRIC_ADD((id), 1)
+#define METRIC_GAUGE_SET(id, v)     (metrics_gauges[(id)] = (v))
+#define METRIC_GAUGE_MAX(id, v)     do { if((v) > metrics_gauges[(id)]) { metrics_gauges[(id)] = (v); } } while(0)
+
+/* 中断执行时间统计 (处理函数自身用时, 不含进入延迟), 在中断入口取 DWT->CYCCNT, 出口调用 */
+#define METRIC_ISR_EXIT(t_enter)                                            \
+    do                                                                      \
+    {                                                                       \
+        uint32_t isr_cycles_ = DWT->CYCCNT - (t_enter);                     \
+        if(isr_cycles_ > metrics_gauges[METRIC_GAUGE_ISR_EXEC_MAX])         \
+        {                                                                   \
+            metrics_gauges[METRIC_GAUGE_ISR_EXEC_MAX] = isr_cycles_;        \
+        }                                                                   \
+    } while(0)
+
+/* Exported variables --------------------------------------------------------*/
+extern __IO uint32_t metrics_counters[METRIC_COUNTER_NUM];
+extern __IO uint32_t metrics_gauges[METRIC_GAUGE_NUM];
+
+/* Exported functions prototypes ---------------------------------------------*/
+
+/**
+ * @brief  统计模块初始化
+ * @param  None
+ * @retval None
+ */
+void metrics_init(void);
+
+/**
+ * @brief  累加空闲周期 (主循环无事可做时调用)
+ * @param  cycles: 空闲的DWT周期数
+ * @retval None
+ */
+void metrics_add_idle(uint32_t cycles);
+
+/**
+ * @brief  周期更新派生仪表 (CPU空闲率), 在主循环中调用
+ * @param  None
+ * @retval None
+ */
+void metrics_update(void);
+
+/**
+ * @brief  通过RS485发送统计快照 (单帧)
+ * @param  None
+ * @retval None
+ */
+void metrics_send_snapshot(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __METRICS_H */
@@ -0,0 +1,383 @@
+/**
+ * @file os_port.c
+ * @brief 操作系统适配层实现
+ * @author Jason
+ * @date 2026-10-18
+ *
+ * 裸机 (OS_RTOS_ENABLE 为0): 主循环直接运行, 互斥锁为空操作, 事件只计数不阻塞, 行为与没有本模块时相同.
+ *
+ * FreeRTOS: 主循环作为主任务运行, 应用任务可以阻塞式调用驱动 (RS485发送、蜂鸣器、I2C总线加了互斥锁).
+ * 内核只屏蔽 IRQ_PRIO_SYSTICK 及更低的中断 (configMAX_SYSCALL_INTERRUPT_PRIORITY), RS485接收等
+ * 更高优先级的中断不受调度器影响, 也不能调用内核: 它们用 os_event_post 经延迟工作队列通知任务.
+ * PendSV由内核用于任务切换, 延迟工作改用软件挂起的EXINT3中断 (见 main.h 的 IRQ_DEFER_IRQ).
+ * 所有内核对象静态分配, 不使用堆
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "os_port.h"
+#include "main.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private define ------------------------------------------------------------*/
+/* Private macro -------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+#if OS_RTOS_ENABLE
+static os_task_fn_t os_main_fn = NULL;
+static StaticTask_t os_main_tcb;
+static StackType_t os_main_stack[OS_MAIN_STACK_WORDS];
+
+static StaticTask_t os_idle_tcb;
+static StackType_t os_idle_stack[configMINIMAL_STACK_SIZE];
+
+/* 切换延迟测量: 起点由测量方写入, 测量任务运行后立即算出经过的周期数 */
+static StaticTask_t os_bench_tcb;
+static StackType_t os_bench_stack[OS_BENCH_STACK_WORDS];
+static TaskHandle_t os_bench_handle = NULL;
+static __IO uint32_t os_bench_start = 0;
+static __IO uint32_t os_bench_elapsed = 0;
+#endif
+
+/* Private function prototypes -----------------------------------------------*/
+#if OS_RTOS_ENABLE
+static void os_main_task(void* arg);
+static void os_bench_task(void* arg);
+static void os_bench_isr(uint32_t arg);
+static void os_event_deferred(uint32_t arg);
+#endif
+
+/* Private functions ---------------------------------------------------------*/
+#if OS_RTOS_ENABLE
+
+/**
+ * @brief  主任务
+ * @param  arg: 未使用
+ * @retval None
+ */
+static void os_main_task(void* arg)
+{
+    os_main_fn();
+}
+
+/**
+ * @brief  测量任务: 被通知后记录从起点经过的周期数
+ * @param  arg: 未使用
+ * @retval None
+ */
+static void os_bench_task(void* arg)
+{
+    while(1)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        os_bench_elapsed = DWT->CYCCNT - os_bench_start;
+    }
+}
+
+/**
+ * @brief  延迟工作: 在中断中通知测量任务
+ * @param  arg: 未使用
+ * @retval None
+ */
+static void os_bench_isr(uint32_t arg)
+{
+    BaseType_t woken = pdFALSE;
+
+    vTaskNotifyGiveFromISR(os_bench_handle, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+/**
+ * @brief  延迟工作: 转交 os_event_post 提交的通知
+ * @param  arg: 事件地址
+ * @retval None
+ */
+static void os_event_deferred(uint32_t arg)
+{
+    os_event_signal((os_event_t*)arg);
+}
+
+/**
+ * @brief  空闲任务的静态存储 (configSUPPORT_STATIC_ALLOCATION 要求)
+ * @param  tcb: 输出任务控制块
+ * @param  stack: 输出栈
+ * @param  stack_size: 输出栈大小 (字)
+ * @retval None
+ */
+void vApplicationGetIdleTaskMemory(StaticTask_t** tcb, StackType_t** stack, uint32_t* stack_size)
+{
+    *tcb = &os_idle_tcb;
+    *stack = os_idle_stack;
+    *stack_size = configMINIMAL_STACK_SIZE;
+}
+
+#endif
+
+/**
+ * @brief  启动: 裸机直接执行 fn; FreeRTOS下创建主任务执行 fn 并启动调度器
+ * @param  fn: 主任务入口 (不返回)
+ * @retval None
+ */
+void os_start(os_task_fn_t fn)
+{
+#if OS_RTOS_ENABLE
+    os_main_fn = fn;
+    xTaskCreateStatic(os_main_task, "main", OS_MAIN_STACK_WORDS, NULL, OS_MAIN_PRIORITY,
+                      os_main_stack, &os_main_tcb);
+    vTaskStartScheduler();
+
+    /* 调度器启动后不返回 */
+    Error_Handler();
+#else
+    fn();
+#endif
+}
+
+/**
+ * @brief  调度器是否已运行
+ * @param  None
+ * @retval 1: 运行中, 0: 裸机或尚未启动
+ */
+uint8_t os_running(void)
+{
+#if OS_RTOS_ENABLE
+    return (xTaskGetSchedulerState() == taskSCHEDULER_RUNNING) ? 1 : 0;
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief  系统滴答, 在 SysTick_Handler 中调用 (调度器启动前不处理)
+ * @param  None
+ * @retval None
+ */
+void os_tick(void)
+{
+#if OS_RTOS_ENABLE
+    if(xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED)
+    {
+        xPortSysTickHandler();
+    }
+#endif
+}
+
+/**
+ * @brief  毫秒延时: 调度器运行时阻塞当前任务, 否则忙等
+ * @note   阻塞的滴答数加1, 保证至少延时 ms (当前滴答已过去一部分)
+ * @param  ms: 延时时间 (ms)
+ * @retval None
+ */
+void os_delay_ms(uint32_t ms)
+{
+#if OS_RTOS_ENABLE
+    if(os_running())
+    {
+        vTaskDelay(pdMS_TO_TICKS(ms) + 1);
+        return;
+    }
+#endif
+    delay_ms(ms);
+}
+
+/**
+ * @brief  初始化互斥锁 (在驱动初始化中调用)
+ * @param  mutex: 互斥锁
+ * @retval None
+ */
+void os_mutex_init(os_mutex_t* mutex)
+{
+#if OS_RTOS_ENABLE
+    mutex->handle = xSemaphoreCreateRecursiveMutexStatic(&mutex->storage);
+#endif
+}
+
+/**
+ * @brief  加锁 (阻塞), 只在任务中调用; 调度器未运行或锁未初始化时不做任何事
+ * @param  mutex: 互斥锁
+ * @retval None
+ */
+void os_mutex_lock(os_mutex_t* mutex)
+{
+#if OS_RTOS_ENABLE
+    if(os_running() && (mutex->handle != NULL))
+    {
+        xSemaphoreTakeRecursive(mutex->handle, portMAX_DELAY);
+    }
+#endif
+}
+
+/**
+ * @brief  解锁
+ * @param  mutex: 互斥锁
+ * @retval None
+ */
+void os_mutex_unlock(os_mutex_t* mutex)
+{
+#if OS_RTOS_ENABLE
+    if(os_running() && (mutex->handle != NULL))
+    {
+        xSemaphoreGiveRecursive(mutex->handle);
+    }
+#endif
+}
+
+/**
+ * @brief  初始化事件, 在等待事件的任务中调用
+ * @param  event: 事件
+ * @retval None
+ */
+void os_event_init(os_event_t* event)
+{
+#if OS_RTOS_ENABLE
+    event->task = os_running() ? xTaskGetCurrentTaskHandle() : NULL;
+#endif
+    event->count = 0;
+}
+
+/**
+ * @brief  通知事件, 在任务或不高于内核屏蔽级别的中断 (IRQ_PRIO_SYSTICK 及更低) 中调用
+ * @param  event: 事件
+ * @retval None
+ */
+void os_event_signal(os_event_t* event)
+{
+#if OS_RTOS_ENABLE
+    BaseType_t woken = pdFALSE;
+
+    if(event->task == NULL)
+    {
+        return;
+    }
+
+    if(__get_IPSR() != 0)
+    {
+        vTaskNotifyGiveFromISR(event->task, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+    else
+    {
+        xTaskNotifyGive(event->task);
+    }
+#else
+    os_event_post(event);
+#endif
+}
+
+/**
+ * @brief  通知事件, 可在任意优先级的中断中调用
+ * @note   FreeRTOS下经延迟工作队列转交 os_event_signal, 高优先级中断不调用内核;
+ *         队列满时丢失这次通知, 等待方靠超时恢复
+ * @param  event: 事件
+ * @retval None
+ */
+RAMFUNC void os_event_post(os_event_t* event)
+{
+#if OS_RTOS_ENABLE
+    irq_defer_post(os_event_deferred, (uint32_t)event);
+#else
+    uint32_t count;
+
+    do
+    {
+        count = __LDREXW((uint32_t*)&event->count);
+    } while(__STREXW(count + 1, (uint32_t*)&event->count) != 0);
+#endif
+}
+
+/**
+ * @brief  等待事件
+ * @note   FreeRTOS下阻塞到有通知或超时; 裸机不阻塞, 立即返回
+ * @param  event: 事件
+ * @param  timeout_ms: 最长等待时间 (ms)
+ * @retval 取走的通知数, 0为超时
+ */
+uint32_t os_event_wait(os_event_t* event, uint32_t timeout_ms)
+{
+    uint32_t count;
+
+#if OS_RTOS_ENABLE
+    if(os_running())
+    {
+        return ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(timeout_ms));
+    }
+#endif
+
+    do
+    {
+        count = __LDREXW((uint32_t*)&event->count);
+    } while(__STREXW(0, (uint32_t*)&event->count) != 0);
+
+    return count;
+}
+
+/**
+ * @brief  测量任务切换和中断到任务的延迟 (阻塞约 OS_BENCH_ROUNDS 次切换)
+ * @note   任务切换: 调用方 (主任务) 记下时刻后通知更高优先级的测量任务, 测量任务开始运行时算出间隔,
+ *         含 xTaskNotifyGive 和PendSV切换. 中断到任务: 提交延迟工作, 在延迟工作中断里通知测量任务,
+ *         含延迟工作中断的进入和内核的FromISR调用; 高优先级中断的进入延迟由 irq_defer 的探测测量
+ * @param  result: 输出结果
+ * @retval SUCCESS, 裸机或调度器未运行时返回ERROR
+ */
+error_status os_benchmark(os_bench_t* result)
+{
+#if OS_RTOS_ENABLE
+    uint32_t elapsed;
+    uint16_t i;
+#endif
+
+    result->switch_min = 0;
+    result->switch_max = 0;
+    result->isr_min = 0;
+    result->isr_max = 0;
+
+#if OS_RTOS_ENABLE
+    if(!os_running() || (uxTaskPriorityGet(NULL) >= OS_BENCH_PRIORITY))
+    {
+        return ERROR;
+    }
+
+    if(os_bench_handle == NULL)
+    {
+        os_bench_handle = xTaskCreateStatic(os_bench_task, "bench", OS_BENCH_STACK_WORDS, NULL, OS_BENCH_PRIORITY,
+                                            os_bench_stack, &os_bench_tcb);
+    }
+
+    result->switch_min = 0xFFFFFFFF;
+    result->isr_min = 0xFFFFFFFF;
+    for(i = 0; i < OS_BENCH_ROUNDS; i++)
+    {
+        /* 测量任务优先级更高, 通知后立即切换过去, 它再次阻塞后回到这里 */
+        os_bench_start = DWT->CYCCNT;
+        xTaskNotifyGive(os_bench_handle);
+        elapsed = os_bench_elapsed;
+        if(elapsed < result->switch_min)
+        {
+            result->switch_min = elapsed;
+        }
+        if(elapsed > result->switch_max)
+        {
+            result->switch_max = elapsed;
+        }
+
+        /* 延迟工作中断立即抢占本任务, 退出后切换到测量任务 */
+        os_bench_elapsed = 0;
+        os_bench_start = DWT->CYCCNT;
+        if(irq_defer_post(os_bench_isr, 0) != SUCCESS)
+        {
+            continue;
+        }
+        elapsed = os_bench_elapsed;
+        if(elapsed < result->isr_min)
+        {
+            result->isr_min = elapsed;
+        }
+        if(elapsed > result->isr_max)
+        {
+            result->isr_max = elapsed;
+        }
+    }
+
+    return SUCCESS;
+#else
+    return ERROR;
+#endif
+}
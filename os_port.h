@@ -0,0 +1,179 @@
+/**
+ * @file os_port.h
+ * @brief 操作系统适配层头文件 (裸机主循环 / 可选FreeRTOS: 互斥锁、事件通知、任务启动、切换延迟测量)
+ * @author Jason
+ * @date 2026-10-18
+ */
+
+#ifndef __OS_PORT_H
+#define __OS_PORT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "at32f403a_407.h"
+
+/*
+ * 为1时在FreeRTOS上运行: 主循环成为一个任务, 驱动加互斥锁, 空闲时阻塞等待事件.
+ * 需要把FreeRTOS内核 (tasks.c list.c queue.c 和 portable/GCC/ARM_CM4F/port.c) 加入工程,
+ * 内核配置见 FreeRTOSConfig.h. 为0时为裸机主循环, 本模块的函数为空或直接执行
+ */
+#ifndef OS_RTOS_ENABLE
+#define OS_RTOS_ENABLE              0
+#endif
+
+#if OS_RTOS_ENABLE
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#endif
+
+/* Exported constants --------------------------------------------------------*/
+/* 主任务栈 (32位字) 和优先级, 应用任务的优先级可高于或低于主任务 */
+#define OS_MAIN_STACK_WORDS         1024
+#define OS_MAIN_PRIORITY            2
+
+/* 切换延迟测量任务: 高于主任务, 被通知后立即运行 */
+#define OS_BENCH_STACK_WORDS        128
+#define OS_BENCH_PRIORITY           (OS_MAIN_PRIORITY + 1)
+#define OS_BENCH_ROUNDS             64
+
+/* Exported types ------------------------------------------------------------*/
+/**
+ * @brief  任务入口 (不返回)
+ */
+typedef void (*os_task_fn_t)(void);
+
+/**
+ * @brief  互斥锁 (可递归: 持有者可再次加锁, 驱动的公开函数互相调用时不会死锁)
+ */
+typedef struct
+{
+#if OS_RTOS_ENABLE
+    SemaphoreHandle_t handle;       /*!< 句柄, 初始化前为NULL */
+    StaticSemaphore_t storage;      /*!< 静态存储 */
+#else
+    uint8_t reserved;
+#endif
+} os_mutex_t;
+
+/**
+ * @brief  事件: 中断或其他任务通知一个等待的任务, 代替标志位轮询
+ * @note   FreeRTOS下用等待任务的任务通知实现, 每个任务只等待一个事件
+ */
+typedef struct
+{
+#if OS_RTOS_ENABLE
+    TaskHandle_t task;              /*!< 等待的任务 */
+#endif
+    __IO uint32_t count;            /*!< 裸机: 未取走的通知数 */
+} os_event_t;
+
+/**
+ * @brief  切换延迟测量结果 (CPU周期, OS_BENCH_ROUNDS 次的最小/最大值)
+ */
+typedef struct
+{
+    uint32_t switch_min;            /*!< 任务通知高优先级任务到其开始运行 */
+    uint32_t switch_max;
+    uint32_t isr_min;               /*!< 中断提交 (irq_defer_post) 到被通知的任务开始运行 */
+    uint32_t isr_max;
+} os_bench_t;
+
+/* Exported macro ------------------------------------------------------------*/
+/* Exported functions prototypes ---------------------------------------------*/
+
+/**
+ * @brief  启动: 裸机直接执行 fn; FreeRTOS下创建主任务执行 fn 并启动调度器
+ * @param  fn: 主任务入口 (不返回)
+ * @retval None
+ */
+void os_start(os_task_fn_t fn);
+
+/**
+ * @brief  调度器是否已运行
+ * @param  None
+ * @retval 1: 运行中, 0: 裸机或尚未启动
+ */
+uint8_t os_running(void);
+
+/**
+ * @brief  系统滴答, 在 SysTick_Handler 中调用 (调度器启动前不处理)
+ * @param  None
+ * @retval None
+ */
+void os_tick(void);
+
+/**
+ * @brief  毫秒延时: 调度器运行时阻塞当前任务, 否则忙等
+ * @param  ms: 延时时间 (ms)
+ * @retval None
+ */
+void os_delay_ms(uint32_t ms);
+
+/**
+ * @brief  初始化互斥锁 (在驱动初始化中调用)
+ * @param  mutex: 互斥锁
+ * @retval None
+ */
+void os_mutex_init(os_mutex_t* mutex);
+
+/**
+ * @brief  加锁 (阻塞), 只在任务中调用; 调度器未运行或锁未初始化时不做任何事
+ * @param  mutex: 互斥锁
+ * @retval None
+ */
+void os_mutex_lock(os_mutex_t* mutex);
+
+/**
+ * @brief  解锁
+ * @param  mutex: 互斥锁
+ * @retval None
+ */
+void os_mutex_unlock(os_mutex_t* mutex);
+
+/**
+ * @brief  初始化事件, 在等待事件的任务中调用
+ * @param  event: 事件
+ * @retval None
+ */
+void os_event_init(os_event_t* event);
+
+/**
+ * @brief  通知事件, 在任务或不高于内核屏蔽级别的中断 (IRQ_PRIO_SYSTICK 及更低) 中调用
+ * @param  event: 事件
+ * @retval None
+ */
+void os_event_signal(os_event_t* event);
+
+/**
+ * @brief  通知事件, 可在任意优先级的中断中调用
+ * @note   FreeRTOS下经延迟工作队列转交 os_event_signal, 高优先级中断不调用内核
+ * @param  event: 事件
+ * @retval None
+ */
+void os_event_post(os_event_t* event);
+
+/**
+ * @brief  等待事件
+ * @note   FreeRTOS下阻塞到有通知或超时; 裸机不阻塞, 立即返回
+ * @param  event: 事件
+ * @param  timeout_ms: 最长等待时间 (ms)
+ * @retval 取走的通知数, 0为超时
+ */
+uint32_t os_event_wait(os_event_t* event, uint32_t timeout_ms);
+
+/**
+ * @brief  测量任务切换和中断到任务的延迟 (阻塞约 OS_BENCH_ROUNDS 次切换)
+ * @param  result: 输出结果
+ * @retval SUCCESS, 裸机或调度器未运行时返回ERROR
+ */
+error_status os_benchmark(os_bench_t* result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __OS_PORT_H */
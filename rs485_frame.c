@@ -0,0 +1,429 @@
+/**
+ * @file rs485_frame.c
+ * @brief RS485 COBS分帧模块实现
+ * @author Jason
+ * @date 2026-10-18
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "rs485_frame.h"
+#include "main.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/**
+ * @brief  接收帧缓冲区 (从帧池分配)
+ */
+typedef struct
+{
+    uint16_t len;
+    uint8_t broadcast;
+    uint8_t data[RS485_FRAME_MAX_SIZE];
+} rs485_frame_buf_t;
+
+/* Private define ------------------------------------------------------------*/
+#define RS485_FRAME_QUEUE_MASK  (RS485_FRAME_QUEUE_SIZE - 1)
+#define RS485_COBS_MAX_CODE     0xFF
+
+#if (RS485_FRAME_QUEUE_SIZE & RS485_FRAME_QUEUE_MASK) != 0
+#error "RS485_FRAME_QUEUE_SIZE must be a power of 2"
+#endif
+
+#if RS485_FRAME_QUEUE_SIZE <= RS485_FRAME_POOL_SIZE
+#error "RS485_FRAME_QUEUE_SIZE must exceed RS485_FRAME_POOL_SIZE"
+#endif
+
+#if RS485_FRAME_ENCODED_MAX(RS485_FRAME_MAX_SIZE) > RS485_TX_BUFFER_SIZE
+#error "RS485_TX_BUFFER_SIZE too small for RS485_FRAME_MAX_SIZE"
+#endif
+
+/* Private macro -------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+/* 帧池 */
+MEM_POOL_STORAGE(rs485_frame_pool_storage, sizeof(rs485_frame_buf_t), RS485_FRAME_POOL_SIZE);
+static mem_pool_t rs485_frame_pool;
+
+/* 接收: 中断解码到 rx_cur, 完整帧指针入队; 主循环从队尾取帧, 处理完归还帧池 */
+static rs485_frame_buf_t* rs485_frame_rx_cur = NULL;
+static rs485_frame_buf_t* rs485_frame_queue[RS485_FRAME_QUEUE_SIZE];
+static __IO uint8_t rs485_frame_rx_head = 0;
+static __IO uint8_t rs485_frame_rx_tail = 0;
+
+/* 解码器状态 */
+static uint8_t rs485_cobs_left = 0;         // 当前块剩余数据字节
+static uint8_t rs485_cobs_zero = 0;         // 块结束后需补0
+static uint8_t rs485_cobs_discard = 0;      // 丢弃到下一个帧界
+
+/* 收到完整帧时通知的事件 */
+static os_event_t* rs485_frame_rx_event = NULL;
+
+/* 编码器状态 (输出直接在DMA缓冲区中) */
+static uint8_t* rs485_cobs_out = NULL;
+static uint16_t rs485_cobs_pos = 0;
+static uint16_t rs485_cobs_code_pos = 0;
+static uint8_t rs485_cobs_code = 0;
+static uint16_t rs485_cobs_payload = 0;
+
+/* Private function prototypes -----------------------------------------------*/
+static void rs485_frame_put(uint8_t byte);
+static RAMFUNC void rs485_frame_store(uint8_t byte);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief  初始化帧池和接收队列, 须在使能接收中断前调用
+ * @param  None
+ * @retval None
+ */
+void rs485_frame_init(void)
+{
+    mem_pool_init(&rs485_frame_pool, rs485_frame_pool_storage,
+                  sizeof(rs485_frame_buf_t), RS485_FRAME_POOL_SIZE);
+
+    rs485_frame_rx_cur = NULL;
+    rs485_frame_rx_head = 0;
+    rs485_frame_rx_tail = 0;
+    rs485_cobs_left = 0;
+    rs485_cobs_zero = 0;
+    rs485_cobs_discard = 0;
+}
+
+/**
+ * @brief  复位接收解码器并丢弃所有已缓存的帧
+ * @note   调用期间须关闭接收中断
+ * @param  None
+ * @retval None
+ */
+void rs485_frame_rx_reset(void)
+{
+    while(rs485_frame_rx_tail != rs485_frame_rx_head)
+    {
+        rs485_frame_free();
+    }
+
+    if(rs485_frame_rx_cur != NULL)
+    {
+        rs485_frame_rx_cur->len = 0;
+    }
+    rs485_cobs_left = 0;
+    rs485_cobs_zero = 0;
+    rs485_cobs_discard = 0;
+}
+
+/**
+ * @brief  设置收到完整帧时通知的事件 (代替轮询帧队列)
+ * @param  event: 事件, NULL为不通知
+ * @retval None
+ */
+void rs485_frame_set_rx_event(os_event_t* event)
+{
+    rs485_frame_rx_event = event;
+}
+
+/**
+ * @brief  向当前接收帧存入一个解码后的字节
+ * @note   帧的第一个字节到达时才从帧池分配; 池空或超长时丢弃到下一个帧界
+ * @param  byte: 解码后的字节
+ * @retval None
+ */
+static RAMFUNC void rs485_frame_store(uint8_t byte)
+{
+    if(rs485_frame_rx_cur == NULL)
+    {
+        rs485_frame_rx_cur = mem_pool_alloc(&rs485_frame_pool);
+        if(rs485_frame_rx_cur == NULL)
+        {
+            rs485_cobs_discard = 1;
+            return;
+        }
+        rs485_frame_rx_cur->len = 0;
+    }
+
+    if(rs485_frame_rx_cur->len >= RS485_FRAME_MAX_SIZE)
+    {
+        rs485_cobs_discard = 1;
+        return;
+    }
+
+    rs485_frame_rx_cur->data[rs485_frame_rx_cur->len++] = byte;
+}
+
+/**
+ * @brief  COBS增量解码一个字节 (在接收中断中调用)
+ * @param  byte: 接收到的字节
+ * @param  broadcast: 当前帧为广播帧
+ * @retval None
+ */
+RAMFUNC void rs485_frame_rx_byte(uint8_t byte, uint8_t broadcast)
+{
+    if(byte == RS485_FRAME_DELIMITER)
+    {
+        /* 块未结束就遇到帧界说明帧被截断 */
+        if(rs485_cobs_discard || (rs485_cobs_left != 0))
+        {
+            METRIC_INC(METRIC_RS485_FRAME_DROPPED);
+        }
+        else if((rs485_frame_rx_cur != NULL) && (rs485_frame_rx_cur->len > 0))
+        {
+            /* 队列比帧池大, 取得帧缓冲区就一定能入队 */
+            rs485_frame_rx_cur->broadcast = broadcast;
+            rs485_frame_queue[rs485_frame_rx_head] = rs485_frame_rx_cur;
+            rs485_frame_rx_head = (rs485_frame_rx_head + 1) & RS485_FRAME_QUEUE_MASK;
+            rs485_frame_rx_cur = NULL;
+            METRIC_INC(METRIC_RS485_FRAMES_RX);
+
+            if(rs485_frame_rx_event != NULL)
+            {
+                os_event_post(rs485_frame_rx_event);
+            }
+        }
+
+        if(rs485_frame_rx_cur != NULL)
+        {
+            rs485_frame_rx_cur->len = 0;
+        }
+        rs485_cobs_left = 0;
+        rs485_cobs_zero = 0;
+        rs485_cobs_discard = 0;
+        return;
+    }
+
+    if(rs485_cobs_discard)
+    {
+        return;
+    }
+
+    if(rs485_cobs_left == 0)
+    {
+        /* 码字节: 先补上一块隐含的0 */
+        if(rs485_cobs_zero)
+        {
+            rs485_frame_store(0);
+        }
+        rs485_cobs_left = byte - 1;
+        rs485_cobs_zero = (byte != RS485_COBS_MAX_CODE) ? 1 : 0;
+        return;
+    }
+
+    rs485_frame_store(byte);
+    rs485_cobs_left--;
+}
+
+/**
+ * @brief  线路错误后丢弃正在接收的帧 (在接收中断中调用)
+ * @note   出错字节可能是帧界或码字节, 此后的解码不可信. 丢弃到帧界时在帧界处计数 FRAME_DROPPED
+ * @param  wait_delimiter: 1: 丢弃到下一个帧界; 0: 下一个字节即为新帧开始 (寻址模式下硬件静默到下一帧)
+ * @retval None
+ */
+RAMFUNC void rs485_frame_rx_abort(uint8_t wait_delimiter)
+{
+    /* 丢弃到帧界的在帧界处计数, 不等帧界的在这里计数 */
+    if(!wait_delimiter &&
+       (rs485_cobs_discard || (rs485_cobs_left != 0) || rs485_cobs_zero ||
+        ((rs485_frame_rx_cur != NULL) && (rs485_frame_rx_cur->len > 0))))
+    {
+        METRIC_INC(METRIC_RS485_FRAME_DROPPED);
+    }
+
+    if(rs485_frame_rx_cur != NULL)
+    {
+        rs485_frame_rx_cur->len = 0;
+    }
+    rs485_cobs_left = 0;
+    rs485_cobs_zero = 0;
+    rs485_cobs_discard = wait_delimiter;
+}
+
+/**
+ * @brief  获取最早的完整帧 (零拷贝, 指向帧缓冲区)
+ * @note   广播帧在处理期间抑制发送 (rs485_frame_claim)
+ * @param  len: 输出帧长度
+ * @retval 帧数据指针, 无帧时返回NULL; 处理完后调用 rs485_frame_free
+ */
+uint8_t* rs485_frame_get(uint16_t* len)
+{
+    rs485_frame_buf_t* frame;
+
+    if(rs485_frame_rx_tail == rs485_frame_rx_head)
+    {
+        *len = 0;
+        return NULL;
+    }
+
+    frame = rs485_frame_queue[rs485_frame_rx_tail];
+    *len = frame->len;
+    rs485_frame_claim(frame->broadcast);
+
+    return frame->data;
+}
+
+/**
+ * @brief  把 rs485_frame_get 返回的帧归还帧池
+ * @param  None
+ * @retval None
+ */
+void rs485_frame_free(void)
+{
+    if(rs485_frame_rx_tail != rs485_frame_rx_head)
+    {
+        mem_pool_free(&rs485_frame_pool, rs485_frame_queue[rs485_frame_rx_tail]);
+        rs485_frame_rx_tail = (rs485_frame_rx_tail + 1) & RS485_FRAME_QUEUE_MASK;
+        METRIC_GAUGE_SET(METRIC_GAUGE_FRAME_POOL_PEAK, mem_pool_high_water(&rs485_frame_pool));
+    }
+}
+
+/**
+ * @brief  查询接收队列中的完整帧数
+ * @param  None
+ * @retval 帧数
+ */
+uint8_t rs485_frame_count(void)
+{
+    return (uint8_t)((rs485_frame_rx_head - rs485_frame_rx_tail) & RS485_FRAME_QUEUE_MASK);
+}
+
+/**
+ * @brief  编码器输出一个字节
+ * @param  byte: 原始字节
+ * @retval None
+ */
+static void rs485_frame_put(uint8_t byte)
+{
+    if(byte == 0)
+    {
+        rs485_cobs_out[rs485_cobs_code_pos] = rs485_cobs_code;
+        rs485_cobs_code_pos = rs485_cobs_pos++;
+        rs485_cobs_code = 1;
+        return;
+    }
+
+    rs485_cobs_out[rs485_cobs_pos++] = byte;
+    rs485_cobs_code++;
+
+    if(rs485_cobs_code == RS485_COBS_MAX_CODE)
+    {
+        rs485_cobs_out[rs485_cobs_code_pos] = rs485_cobs_code;
+        rs485_cobs_code_pos = rs485_cobs_pos++;
+        rs485_cobs_code = 1;
+    }
+}
+
+/**
+ * @brief  开始编码一帧, 直接写入发送DMA缓冲区
+ * @note   到 rs485_frame_end 为止持有发送锁 (rs485_tx_lock), 须成对调用
+ * @param  None
+ * @retval None
+ */
+void rs485_frame_begin(void)
+{
+    rs485_tx_lock();
+    rs485_cobs_out = rs485_tx_acquire();
+    rs485_cobs_code_pos = 0;
+    rs485_cobs_pos = 1;
+    rs485_cobs_code = 1;
+    rs485_cobs_payload = 0;
+}
+
+/**
+ * @brief  向当前帧追加数据
+ * @param  data: 数据
+ * @param  len: 长度
+ * @retval None
+ */
+void rs485_frame_write(const uint8_t* data, uint16_t len)
+{
+    uint16_t i;
+
+    /* 超长时只计数, 由 rs485_frame_end 拒绝发送 */
+    rs485_cobs_payload += len;
+    if(rs485_cobs_payload > RS485_FRAME_MAX_SIZE)
+    {
+        return;
+    }
+
+    for(i = 0; i < len; i++)
+    {
+        rs485_frame_put(data[i]);
+    }
+}
+
+/**
+ * @brief  结束当前帧并启动DMA发送
+ * @param  None
+ * @retval SUCCESS/ERROR (超过 RS485_FRAME_MAX_SIZE 时不发送)
+ */
+error_status rs485_frame_end(void)
+{
+    if(rs485_cobs_payload > RS485_FRAME_MAX_SIZE)
+    {
+        rs485_tx_unlock();
+        return ERROR;
+    }
+
+    rs485_cobs_out[rs485_cobs_code_pos] = rs485_cobs_code;
+    rs485_cobs_out[rs485_cobs_pos++] = RS485_FRAME_DELIMITER;
+
+    rs485_tx_start(rs485_cobs_pos);
+    rs485_tx_unlock();
+
+    return SUCCESS;
+}
+
+/**
+ * @brief  编码并发送一帧
+ * @param  data: 数据
+ * @param  len: 长度
+ * @retval SUCCESS/ERROR
+ */
+error_status rs485_frame_send(const uint8_t* data, uint16_t len)
+{
+    rs485_frame_begin();
+    rs485_frame_write(data, len);
+
+    return rs485_frame_end();
+}
+
+/**
+ * @brief  按小端读取16位数 (帧内参数, 可不对齐)
+ * @param  buf: 源缓冲区
+ * @retval 数值
+ */
+uint16_t rs485_get_u16(const uint8_t* buf)
+{
+    return (uint16_t)(buf[0] | ((uint16_t)buf[1] << 8));
+}
+
+/**
+ * @brief  按小端读取32位数 (帧内参数, 可不对齐)
+ * @param  buf: 源缓冲区
+ * @retval 数值
+ */
+uint32_t rs485_get_u32(const uint8_t* buf)
+{
+    return (uint32_t)buf[0] | ((uint32_t)buf[1] << 8) | ((uint32_t)buf[2] << 16) | ((uint32_t)buf[3] << 24);
+}
+
+/**
+ * @brief  按小端写入16位数
+ * @param  buf: 目标缓冲区
+ * @param  value: 数值
+ * @retval None
+ */
+void rs485_put_u16(uint8_t* buf, uint16_t value)
+{
+    buf[0] = (uint8_t)value;
+    buf[1] = (uint8_t)(value >> 8);
+}
+
+/**
+ * @brief  按小端写入32位数
+ * @param  buf: 目标缓冲区
+ * @param  value: 数值
+ * @retval None
+ */
+void rs485_put_u32(uint8_t* buf, uint32_t value)
+{
+    buf[0] = (uint8_t)value;
+    buf[1] = (uint8_t)(value >> 8);
+    buf[2] = (uint8_t)(value >> 16);
+    buf[3] = (uint8_t)(value >> 24);
+}
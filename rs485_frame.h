@@ -0,0 +1,164 @@
+/**
+ * @file rs485_frame.h
+ * @brief RS485 COBS分帧模块头文件
+ * @author Jason
+ * @date 2026-10-18
+ */
+
+#ifndef __RS485_FRAME_H
+#define __RS485_FRAME_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "at32f403a_407.h"
+#include "memmap.h"
+#include "os_port.h"
+
+/* Exported types ------------------------------------------------------------*/
+/* Exported constants --------------------------------------------------------*/
+/* 帧最大长度 (解码后) */
+#define RS485_FRAME_MAX_SIZE        256
+
+/* 帧池块数: 正在接收的帧和等待处理的帧共用, 固件更新的确认窗口由此决定 */
+#define RS485_FRAME_POOL_SIZE       8
+
+/* 接收帧队列长度, 必须为2的幂且大于帧池块数 */
+#define RS485_FRAME_QUEUE_SIZE      16
+
+/* 帧界 */
+#define RS485_FRAME_DELIMITER       0x00
+
+/* Exported macro ------------------------------------------------------------*/
+/* COBS编码后最大长度: 每254字节1个开销字节, 加首个码字节和帧界 */
+#define RS485_FRAME_ENCODED_MAX(n)  ((n) + (n) / 254 + 2)
+
+/* Exported functions prototypes ---------------------------------------------*/
+
+/**
+ * @brief  初始化帧池和接收队列, 须在使能接收中断前调用
+ * @param  None
+ * @retval None
+ */
+void rs485_frame_init(void);
+
+/**
+ * @brief  复位接收解码器并丢弃所有已缓存的帧
+ * @note   调用期间须关闭接收中断
+ * @param  None
+ * @retval None
+ */
+void rs485_frame_rx_reset(void);
+
+/**
+ * @brief  设置收到完整帧时通知的事件 (代替轮询帧队列)
+ * @param  event: 事件, NULL为不通知
+ * @retval None
+ */
+void rs485_frame_set_rx_event(os_event_t* event);
+
+/**
+ * @brief  COBS增量解码一个字节 (在接收中断中调用)
+ * @param  byte: 接收到的字节
+ * @param  broadcast: 当前帧为广播帧 (寻址模式下由地址字节确定)
+ * @retval None
+ */
+RAMFUNC void rs485_frame_rx_byte(uint8_t byte, uint8_t broadcast);
+
+/**
+ * @brief  线路错误后丢弃正在接收的帧 (在接收中断中调用)
+ * @param  wait_delimiter: 1: 丢弃到下一个帧界; 0: 下一个字节即为新帧开始 (寻址模式下硬件静默到下一帧)
+ * @retval None
+ */
+RAMFUNC void rs485_frame_rx_abort(uint8_t wait_delimiter);
+
+/**
+ * @brief  获取最早的完整帧 (零拷贝, 指向帧缓冲区)
+ * @note   广播帧在处理期间抑制发送 (rs485_frame_claim)
+ * @param  len: 输出帧长度
+ * @retval 帧数据指针, 无帧时返回NULL; 处理完后调用 rs485_frame_free
+ */
+uint8_t* rs485_frame_get(uint16_t* len);
+
+/**
+ * @brief  把 rs485_frame_get 返回的帧归还帧池
+ * @param  None
+ * @retval None
+ */
+void rs485_frame_free(void);
+
+/**
+ * @brief  查询接收队列中的完整帧数
+ * @param  None
+ * @retval 帧数
+ */
+uint8_t rs485_frame_count(void);
+
+/**
+ * @brief  开始编码一帧, 直接写入发送DMA缓冲区
+ * @note   到 rs485_frame_end 为止持有发送锁 (rs485_tx_lock), 须成对调用
+ * @param  None
+ * @retval None
+ */
+void rs485_frame_begin(void);
+
+/**
+ * @brief  向当前帧追加数据
+ * @param  data: 数据
+ * @param  len: 长度
+ * @retval None
+ */
+void rs485_frame_write(const uint8_t* data, uint16_t len);
+
+/**
+ * @brief  结束当前帧并启动DMA发送
+ * @param  None
+ * @retval SUCCESS/ERROR (超过 RS485_FRAME_MAX_SIZE 时不发送)
+ */
+error_status rs485_frame_end(void);
+
+/**
+ * @brief  编码并发送一帧
+ * @param  data: 数据
+ * @param  len: 长度
+ * @retval SUCCESS/ERROR
+ */
+error_status rs485_frame_send(const uint8_t* data, uint16_t len);
+
+/**
+ * @brief  按小端读取16位数 (帧内参数, 可不对齐)
+ * @param  buf: 源缓冲区
+ * @retval 数值
+ */
+uint16_t rs485_get_u16(const uint8_t* buf);
+
+/**
+ * @brief  按小端读取32位数 (帧内参数, 可不对齐)
+ * @param  buf: 源缓冲区
+ * @retval 数值
+ */
+uint32_t rs485_get_u32(const uint8_t* buf);
+
+/**
+ * @brief  按小端写入16位数
+ * @param  buf: 目标缓冲区
+ * @param  value: 数值
+ * @retval None
+ */
+void rs485_put_u16(uint8_t* buf, uint16_t value);
+
+/**
+ * @brief  按小端写入32位数
+ * @param  buf: 目标缓冲区
+ * @param  value: 数值
+ * @retval None
+ */
+void rs485_put_u32(uint8_t* buf, uint32_t value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __RS485_FRAME_H */
@@ -0,0 +1,653 @@
+/**
+ * @file rs485_sniff.c
+ * @brief RS485总线监听模块实现
+ * @author Jason
+ * @date 2026-10-18
+ *
+ * 监听期间USART2接收器不静默, 每个字节由DMA写入环形缓冲区 (循环模式), 不经过CPU; 接收中断只读状态寄存器.
+ * 不逐字节记时间: 线路上一帧内的字节首尾相接, 间隔固定为一个字符时间, 只在线路空闲 (一帧结束)、
+ * 线路错误和DMA半满/满时记一个时间标记 (接收字节计数 + DWT周期). 字节的时间由主机从标记往前按字符时间推算,
+ * 帧内压缩为零开销, 帧间隔以微秒记录.
+ *
+ * 主循环把两个标记之间的字节打包为段记录 (间隔和长度为变长整数), 多条记录组成一帧COBS编码,
+ * 经USART1 (PA9, 3Mbaud) DMA双缓冲发出. 输出跟不上时最老的字节被覆盖, 以丢失记录报告; 接收溢出以段标志报告.
+ * 主机用 tools/sniff2pcap.py 转换为pcap文件, 同时打印溢出和丢失统计; 高波特率下是否丢字节未实测, 以该统计为准.
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "rs485_sniff.h"
+#include "main.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/**
+ * @brief  时间标记: 段结束时的接收字节计数和时刻
+ */
+typedef struct
+{
+    uint32_t pos;                   /*!< 接收字节计数 (自由运行) */
+    uint32_t cycles;                /*!< DWT周期 */
+    uint32_t tick;                  /*!< 毫秒滴答, 间隔超过DWT回绕周期时使用 */
+    uint8_t flags;                  /*!< RS485_SNIFF_FLAG_* */
+} rs485_sniff_mark_t;
+
+/* Private define ------------------------------------------------------------*/
+#define RS485_SNIFF_RING_MASK       (RS485_SNIFF_RING_SIZE - 1)
+#define RS485_SNIFF_MARK_MASK       (RS485_SNIFF_MARK_NUM - 1)
+
+/* COBS编码后的最大长度 (每254字节1个码字节, 加帧界) */
+#define RS485_SNIFF_OUT_SIZE        (RS485_SNIFF_OUT_PAYLOAD + RS485_SNIFF_OUT_PAYLOAD / 254 + 2)
+
+/* 记录头最大长度: 段 (类型 标志 间隔5 长度2), 丢失 (类型 数量5) */
+#define RS485_SNIFF_SEG_HEADER_MAX  9
+#define RS485_SNIFF_LOST_MAX        6
+
+/* 判断覆盖时留出的余量: 复制期间DMA最多再写入的字节 */
+#define RS485_SNIFF_RING_MARGIN     16
+
+/* 间隔超过此值 (ms) 时按毫秒滴答计算, 240MHz下DWT约17.9s回绕 */
+#define RS485_SNIFF_GAP_MS_MAX      10000
+
+/* USART分频值下限 (16倍过采样) */
+#define RS485_SNIFF_USART_DIV_MIN   16
+
+/* USART状态寄存器低4位: 校验/帧/噪声/溢出错误, 与 RS485_SNIFF_FLAG_* 相同 */
+#define RS485_SNIFF_STS_ERR_MASK    0x0F
+
+/* Private macro -------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+DMA_BUFFER static uint8_t rs485_sniff_ring[RS485_SNIFF_RING_SIZE];
+DMA_BUFFER static uint8_t rs485_sniff_out[2][RS485_SNIFF_OUT_SIZE];
+static uint16_t rs485_sniff_out_len[2];
+static uint8_t rs485_sniff_out_fill = 0;       // 正在编码的输出缓冲区
+static uint8_t rs485_sniff_payload[RS485_SNIFF_OUT_PAYLOAD];
+
+/* 时间标记队列: 接收中断和DMA中断 (同一优先级) 写入, 主循环读取 */
+static rs485_sniff_mark_t rs485_sniff_marks[RS485_SNIFF_MARK_NUM];
+static __IO uint16_t rs485_sniff_mark_head = 0;
+static __IO uint16_t rs485_sniff_mark_tail = 0;
+static uint8_t rs485_sniff_lost_flags = 0;     // 队列满时未记录的标记的标志, 并入下一个标记
+
+/* 已记录标记、等待标志清除而关闭的接收中断: RS485_SNIFF_FLAG_IDLE 和 RS485_SNIFF_STS_ERR_MASK */
+static __IO uint8_t rs485_sniff_disarmed = 0;
+
+static __IO uint32_t rs485_sniff_wraps = 0;    // 环形缓冲区写满回绕次数
+static uint32_t rs485_sniff_rd = 0;            // 已输出的字节计数
+
+/* 上一个标记的时刻 (周期数的余数留到下一段) */
+static uint32_t rs485_sniff_prev_cycles = 0;
+static uint32_t rs485_sniff_prev_tick = 0;
+
+static rs485_sniff_state_t rs485_sniff_state = RS485_SNIFF_IDLE;
+static uint8_t rs485_sniff_header_pending = 0;
+static uint32_t rs485_sniff_start_tick = 0;
+static uint32_t rs485_sniff_duration_ms = 0;
+static rs485_sniff_stats_t rs485_sniff_stats;
+
+/* Private function prototypes -----------------------------------------------*/
+static RAMFUNC uint32_t rs485_sniff_rx_pos(void);
+static RAMFUNC void rs485_sniff_mark(uint8_t flags);
+static RAMFUNC void rs485_sniff_usart_isr(void);
+static void rs485_sniff_rearm(void);
+static void rs485_sniff_begin(void);
+static void rs485_sniff_end(void);
+static uint32_t rs485_sniff_gap_us(const rs485_sniff_mark_t* mark);
+static uint16_t rs485_sniff_put_varint(uint8_t* buf, uint32_t value);
+static uint16_t rs485_sniff_cobs(const uint8_t* data, uint16_t len, uint8_t* out);
+static uint16_t rs485_sniff_build(uint8_t* out);
+static error_status rs485_sniff_clock_notify(clock_event_t event, clock_profile_t profile);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief  当前接收字节计数 (在接收DMA中断同级或关闭该中断时调用)
+ * @param  None
+ * @retval 自由运行的字节计数
+ */
+static RAMFUNC uint32_t rs485_sniff_rx_pos(void)
+{
+    uint32_t wraps = rs485_sniff_wraps;
+    uint32_t left = RS485_SNIFF_RX_DMA_CHANNEL->dtcnt;
+
+    /* 已回绕 (剩余数重新装入) 而满中断还未执行 */
+    if((dma_flag_get(RS485_SNIFF_RX_DMA_FDT_FLAG) != RESET) && (left > RS485_SNIFF_RING_SIZE / 2))
+    {
+        wraps++;
+    }
+
+    return wraps * RS485_SNIFF_RING_SIZE + (RS485_SNIFF_RING_SIZE - left);
+}
+
+/**
+ * @brief  记录时间标记 (在接收中断或接收DMA中断中调用)
+ * @note   队列满时不记录, 标志并入下一个标记并加 MERGED, 字节不受影响
+ * @param  flags: RS485_SNIFF_FLAG_*
+ * @retval None
+ */
+static RAMFUNC void rs485_sniff_mark(uint8_t flags)
+{
+    rs485_sniff_mark_t* mark;
+    uint16_t head = rs485_sniff_mark_head;
+
+    if((uint16_t)(head - rs485_sniff_mark_tail) >= RS485_SNIFF_MARK_NUM)
+    {
+        rs485_sniff_lost_flags |= flags | RS485_SNIFF_FLAG_MERGED;
+        rs485_sniff_stats.marks_lost++;
+        return;
+    }
+
+    mark = &rs485_sniff_marks[head & RS485_SNIFF_MARK_MASK];
+    mark->pos = rs485_sniff_rx_pos();
+    mark->cycles = DWT->CYCCNT;
+    mark->tick = get_tick();
+    mark->flags = flags | rs485_sniff_lost_flags;
+    rs485_sniff_lost_flags = 0;
+
+    rs485_sniff_mark_head = head + 1;
+}
+
+/**
+ * @brief  监听时的USART2中断: 空闲线和线路错误各记一个时间标记
+ * @note   DMA占用接收数据寄存器, 这里只读状态寄存器, 不读数据寄存器 (会从DMA取走一个字节).
+ *         标志要等DMA读下一个字节才清除, 先关闭对应中断, 标志清除后由 rs485_sniff_rearm 重新打开
+ * @param  None
+ * @retval None
+ */
+static RAMFUNC void rs485_sniff_usart_isr(void)
+{
+    uint32_t sts = RS485_USART->sts;
+    uint8_t flags = (uint8_t)(sts & RS485_SNIFF_STS_ERR_MASK);
+
+    if(sts & USART_IDLEF_FLAG)
+    {
+        flags |= RS485_SNIFF_FLAG_IDLE;
+    }
+
+    /* 已关闭中断的标志还未清除, 上一个标记已记录 */
+    flags &= (uint8_t)~rs485_sniff_disarmed;
+    if(flags == 0)
+    {
+        return;
+    }
+
+    if(flags & RS485_SNIFF_FLAG_IDLE)
+    {
+        usart_interrupt_enable(RS485_USART, USART_IDLE_INT, FALSE);
+    }
+    if(flags & RS485_SNIFF_STS_ERR_MASK)
+    {
+        usart_interrupt_enable(RS485_USART, USART_ERR_INT, FALSE);
+        usart_interrupt_enable(RS485_USART, USART_PERR_INT, FALSE);
+        rs485_sniff_disarmed |= RS485_SNIFF_STS_ERR_MASK;
+    }
+    rs485_sniff_disarmed |= flags & RS485_SNIFF_FLAG_IDLE;
+
+    rs485_sniff_mark(flags);
+}
+
+/**
+ * @brief  标志已清除 (DMA读了下一个字节) 后重新打开空闲线和线路错误中断, 在主循环中调用
+ * @note   与接收中断修改同一控制寄存器, 期间关闭该中断
+ * @param  None
+ * @retval None
+ */
+static void rs485_sniff_rearm(void)
+{
+    uint8_t disarmed;
+    uint32_t sts;
+
+    if(rs485_sniff_disarmed == 0)
+    {
+        return;
+    }
+
+    NVIC_DisableIRQ(RS485_USART_IRQ);
+    disarmed = rs485_sniff_disarmed;
+    sts = RS485_USART->sts;
+    if((disarmed & RS485_SNIFF_FLAG_IDLE) && ((sts & USART_IDLEF_FLAG) == 0))
+    {
+        usart_interrupt_enable(RS485_USART, USART_IDLE_INT, TRUE);
+        disarmed &= (uint8_t)~RS485_SNIFF_FLAG_IDLE;
+    }
+    if((disarmed & RS485_SNIFF_STS_ERR_MASK) && ((sts & RS485_SNIFF_STS_ERR_MASK) == 0))
+    {
+        usart_interrupt_enable(RS485_USART, USART_ERR_INT, TRUE);
+        usart_interrupt_enable(RS485_USART, USART_PERR_INT, TRUE);
+        disarmed &= (uint8_t)~RS485_SNIFF_STS_ERR_MASK;
+    }
+    rs485_sniff_disarmed = disarmed;
+    NVIC_EnableIRQ(RS485_USART_IRQ);
+}
+
+/**
+ * @brief  开始捕获: 配置输出USART和两个DMA通道, 把USART2切换到监听
+ * @param  None
+ * @retval None
+ */
+static void rs485_sniff_begin(void)
+{
+    usart_init_type usart_init_struct;
+    dma_init_type dma_init_struct;
+
+    /* 输出USART1: 只发送 */
+    crm_periph_clock_enable(RS485_SNIFF_OUT_USART_CLK, TRUE);
+    usart_default_para_init(&usart_init_struct);
+    usart_init_struct.baudrate = RS485_SNIFF_OUT_BAUDRATE;
+    usart_init_struct.data_bit = USART_DATA_8BITS;
+    usart_init_struct.stop_bit = USART_STOP_1_BIT;
+    usart_init_struct.parity = USART_PARITY_NONE;
+    usart_init_struct.hardware_flow_control = USART_HARDWARE_FLOW_NONE;
+    usart_init_struct.mode = USART_MODE_TX;
+    usart_init(RS485_SNIFF_OUT_USART, &usart_init_struct);
+
+    crm_periph_clock_enable(RS485_DMA_CLK, TRUE);
+    dma_flexible_config(RS485_SNIFF_RX_DMA, RS485_SNIFF_OUT_DMA_FLEX_CHANNEL, RS485_SNIFF_OUT_DMA_REQUEST);
+    dma_reset(RS485_SNIFF_OUT_DMA_CHANNEL);
+    dma_default_para_init(&dma_init_struct);
+    dma_init_struct.buffer_size = 0;
+    dma_init_struct.direction = DMA_DIR_MEMORY_TO_PERIPHERAL;
+    dma_init_struct.memory_base_addr = (uint32_t)rs485_sniff_out[0];
+    dma_init_struct.memory_data_width = DMA_MEMORY_DATA_WIDTH_BYTE;
+    dma_init_struct.memory_inc_enable = TRUE;
+    dma_init_struct.peripheral_base_addr = (uint32_t)&RS485_SNIFF_OUT_USART->dt;
+    dma_init_struct.peripheral_data_width = DMA_PERIPHERAL_DATA_WIDTH_BYTE;
+    dma_init_struct.peripheral_inc_enable = FALSE;
+    dma_init_struct.priority = DMA_PRIORITY_MEDIUM;
+    dma_init_struct.loop_mode_enable = FALSE;
+    dma_init(RS485_SNIFF_OUT_DMA_CHANNEL, &dma_init_struct);
+    usart_dma_transmitter_enable(RS485_SNIFF_OUT_USART, TRUE);
+    usart_enable(RS485_SNIFF_OUT_USART, TRUE);
+
+    /* 接收: 循环模式写环形缓冲区, 半满和满中断记时间标记并计回绕 */
+    dma_flexible_config(RS485_SNIFF_RX_DMA, RS485_SNIFF_RX_DMA_FLEX_CHANNEL, RS485_SNIFF_RX_DMA_REQUEST);
+    dma_reset(RS485_SNIFF_RX_DMA_CHANNEL);
+    dma_init_struct.buffer_size = RS485_SNIFF_RING_SIZE;
+    dma_init_struct.direction = DMA_DIR_PERIPHERAL_TO_MEMORY;
+    dma_init_struct.memory_base_addr = (uint32_t)rs485_sniff_ring;
+    dma_init_struct.peripheral_base_addr = (uint32_t)&RS485_USART->dt;
+    dma_init_struct.priority = DMA_PRIORITY_VERY_HIGH;
+    dma_init_struct.loop_mode_enable = TRUE;
+    dma_init(RS485_SNIFF_RX_DMA_CHANNEL, &dma_init_struct);
+    dma_flag_clear(RS485_SNIFF_RX_DMA_FDT_FLAG);
+    dma_flag_clear(RS485_SNIFF_RX_DMA_HDT_FLAG);
+    dma_interrupt_enable(RS485_SNIFF_RX_DMA_CHANNEL, DMA_FDT_INT, TRUE);
+    dma_interrupt_enable(RS485_SNIFF_RX_DMA_CHANNEL, DMA_HDT_INT, TRUE);
+
+    rs485_sniff_mark_head = 0;
+    rs485_sniff_mark_tail = 0;
+    rs485_sniff_lost_flags = 0;
+    rs485_sniff_wraps = 0;
+    rs485_sniff_rd = 0;
+    rs485_sniff_out_len[0] = 0;
+    rs485_sniff_out_len[1] = 0;
+    rs485_sniff_out_fill = 0;
+    rs485_sniff_stats.bytes = 0;
+    rs485_sniff_stats.lost_bytes = 0;
+    rs485_sniff_stats.marks_lost = 0;
+    rs485_sniff_stats.ring_peak = 0;
+    rs485_sniff_header_pending = 1;
+    rs485_sniff_disarmed = 0;
+
+    rs485_sniff_prev_cycles = DWT->CYCCNT;
+    rs485_sniff_prev_tick = get_tick();
+    rs485_sniff_start_tick = rs485_sniff_prev_tick;
+
+    dma_channel_enable(RS485_SNIFF_RX_DMA_CHANNEL, TRUE);
+    rs485_set_sniff(rs485_sniff_usart_isr);
+    rs485_sniff_state = RS485_SNIFF_CAPTURE;
+}
+
+/**
+ * @brief  结束捕获: 恢复正常接收, 最后一个标记带 END 标志, 之后输出剩余记录
+ * @param  None
+ * @retval None
+ */
+static void rs485_sniff_end(void)
+{
+    rs485_set_sniff(NULL);
+
+    /* 正常接收时线路错误中断常开 (空闲线中断已按寻址模式恢复) */
+    if(rs485_sniff_disarmed & RS485_SNIFF_STS_ERR_MASK)
+    {
+        usart_interrupt_enable(RS485_USART, USART_ERR_INT, TRUE);
+        usart_interrupt_enable(RS485_USART, USART_PERR_INT, TRUE);
+    }
+    rs485_sniff_disarmed = 0;
+
+    /* 接收中断已恢复正常处理, 关闭DMA中断后由这里写最后一个标记 */
+    NVIC_DisableIRQ(RS485_SNIFF_RX_DMA_IRQ);
+    dma_channel_enable(RS485_SNIFF_RX_DMA_CHANNEL, FALSE);
+    rs485_sniff_mark(RS485_SNIFF_FLAG_END);
+    rs485_sniff_stats.bytes = rs485_sniff_rx_pos();
+    NVIC_EnableIRQ(RS485_SNIFF_RX_DMA_IRQ);
+
+    rs485_sniff_state = RS485_SNIFF_DRAIN;
+}
+
+/**
+ * @brief  一个标记与上一个标记的间隔
+ * @note   周期数不足1us的余数留到下一段, 长时间捕获时间不累积误差
+ * @param  mark: 时间标记
+ * @retval 间隔 (us)
+ */
+static uint32_t rs485_sniff_gap_us(const rs485_sniff_mark_t* mark)
+{
+    uint32_t cycles_per_us = system_core_clock / 1000000;
+    uint32_t ms = mark->tick - rs485_sniff_prev_tick;
+    uint32_t us;
+
+    if(ms > RS485_SNIFF_GAP_MS_MAX)
+    {
+        us = ms * 1000;
+        rs485_sniff_prev_cycles = mark->cycles;
+    }
+    else
+    {
+        us = (mark->cycles - rs485_sniff_prev_cycles) / cycles_per_us;
+        rs485_sniff_prev_cycles += us * cycles_per_us;
+    }
+    rs485_sniff_prev_tick = mark->tick;
+
+    return us;
+}
+
+/**
+ * @brief  写入变长整数 (每字节低7位, 最高位为1表示后面还有)
+ * @param  buf: 目标缓冲区
+ * @param  value: 数值
+ * @retval 写入的字节数 (1~5)
+ */
+static uint16_t rs485_sniff_put_varint(uint8_t* buf, uint32_t value)
+{
+    uint16_t len = 0;
+
+    while(value >= 0x80)
+    {
+        buf[len++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    buf[len++] = (uint8_t)value;
+
+    return len;
+}
+
+/**
+ * @brief  COBS编码一帧并加帧界
+ * @param  data: 负载
+ * @param  len: 负载长度
+ * @param  out: 输出缓冲区 (至少 RS485_SNIFF_OUT_SIZE)
+ * @retval 输出长度
+ */
+static uint16_t rs485_sniff_cobs(const uint8_t* data, uint16_t len, uint8_t* out)
+{
+    uint16_t code_pos = 0;
+    uint16_t pos = 1;
+    uint8_t code = 1;
+    uint16_t i;
+
+    for(i = 0; i < len; i++)
+    {
+        if(data[i] != 0)
+        {
+            out[pos++] = data[i];
+            code++;
+        }
+        if((data[i] == 0) || (code == 0xFF))
+        {
+            out[code_pos] = code;
+            code_pos = pos++;
+            code = 1;
+        }
+    }
+    out[code_pos] = code;
+    out[pos++] = 0x00;
+
+    return pos;
+}
+
+/**
+ * @brief  把已有标记的段打包为一帧输出
+ * @note   段超出本帧剩余空间时先输出前一部分 (PARTIAL), 其余在下一帧
+ * @param  out: 输出缓冲区
+ * @retval 输出长度, 0为没有可输出的记录
+ */
+static uint16_t rs485_sniff_build(uint8_t* out)
+{
+    uint8_t* p = rs485_sniff_payload;
+    rs485_sniff_mark_t* mark;
+    uint32_t prod;
+    uint32_t avail;
+    uint32_t count;
+    uint32_t lost;
+    uint16_t len = 0;
+    uint16_t room;
+    uint16_t i;
+
+    if(rs485_sniff_header_pending)
+    {
+        rs485_sniff_header_pending = 0;
+        p[len++] = RS485_SNIFF_REC_HEADER;
+        p[len++] = RS485_SNIFF_VERSION;
+        rs485_put_u32(&p[len], rs485_get_baudrate());
+        len += 4;
+        p[len++] = (rs485_get_addr_mode() == RS485_ADDR_MODE_ADDRESS_MARK) ? 11 : 10;
+    }
+
+    while(rs485_sniff_mark_tail != rs485_sniff_mark_head)
+    {
+        mark = &rs485_sniff_marks[rs485_sniff_mark_tail & RS485_SNIFF_MARK_MASK];
+
+        NVIC_DisableIRQ(RS485_SNIFF_RX_DMA_IRQ);
+        prod = rs485_sniff_rx_pos();
+        NVIC_EnableIRQ(RS485_SNIFF_RX_DMA_IRQ);
+        rs485_sniff_stats.bytes = prod;
+
+        if((prod - rs485_sniff_rd) > rs485_sniff_stats.ring_peak)
+        {
+            rs485_sniff_stats.ring_peak = (uint16_t)(prod - rs485_sniff_rd);
+            METRIC_GAUGE_MAX(METRIC_GAUGE_SNIFF_RING_PEAK, rs485_sniff_stats.ring_peak);
+        }
+
+        /* 输出跟不上: 最老的字节已被 (或在复制时将被) DMA覆盖, 跳过 */
+        if((prod - rs485_sniff_rd) > (RS485_SNIFF_RING_SIZE - RS485_SNIFF_RING_MARGIN))
+        {
+            if((len + RS485_SNIFF_LOST_MAX) > RS485_SNIFF_OUT_PAYLOAD)
+            {
+                break;
+            }
+            lost = prod - rs485_sniff_rd - (RS485_SNIFF_RING_SIZE - RS485_SNIFF_RING_MARGIN);
+            rs485_sniff_rd += lost;
+            rs485_sniff_stats.lost_bytes += lost;
+            METRIC_ADD(METRIC_SNIFF_LOST_BYTES, lost);
+            p[len++] = RS485_SNIFF_REC_LOST;
+            len += rs485_sniff_put_varint(&p[len], lost);
+        }
+
+        if((len + RS485_SNIFF_SEG_HEADER_MAX) >= RS485_SNIFF_OUT_PAYLOAD)
+        {
+            break;
+        }
+        room = RS485_SNIFF_OUT_PAYLOAD - RS485_SNIFF_SEG_HEADER_MAX - len;
+        avail = ((int32_t)(mark->pos - rs485_sniff_rd) > 0) ? (mark->pos - rs485_sniff_rd) : 0;
+        count = (avail < room) ? avail : room;
+
+        p[len++] = RS485_SNIFF_REC_SEGMENT;
+        if(count < avail)
+        {
+            p[len++] = RS485_SNIFF_FLAG_PARTIAL;
+            len += rs485_sniff_put_varint(&p[len], 0);
+        }
+        else
+        {
+            p[len++] = mark->flags;
+            len += rs485_sniff_put_varint(&p[len], rs485_sniff_gap_us(mark));
+        }
+        len += rs485_sniff_put_varint(&p[len], count);
+
+        for(i = 0; i < count; i++)
+        {
+            p[len++] = rs485_sniff_ring[(rs485_sniff_rd + i) & RS485_SNIFF_RING_MASK];
+        }
+        rs485_sniff_rd += count;
+
+        if(count < avail)
+        {
+            break;
+        }
+        rs485_sniff_mark_tail++;
+    }
+
+    if(len == 0)
+    {
+        return 0;
+    }
+
+    return rs485_sniff_cobs(p, len, out);
+}
+
+/**
+ * @brief  时钟切换通知: 监听期间否决 (时间换算和输出波特率依赖当前时钟)
+ * @param  event: 通知事件
+ * @param  profile: 目标档位
+ * @retval SUCCESS/ERROR
+ */
+static error_status rs485_sniff_clock_notify(clock_event_t event, clock_profile_t profile)
+{
+    if((event == CLOCK_EVENT_PRE_CHANGE) && (rs485_sniff_state != RS485_SNIFF_IDLE))
+    {
+        return ERROR;
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief  总线监听初始化 (注册时钟切换通知), 在 rs485_init 之后调用
+ * @param  None
+ * @retval None
+ */
+void rs485_sniff_init(void)
+{
+    rs485_sniff_state = RS485_SNIFF_IDLE;
+    clock_profile_register(rs485_sniff_clock_notify);
+}
+
+/**
+ * @brief  开始监听
+ * @note   在当前回复发完后开始, 之后本机不再处理RS485命令, 直到捕获时间结束
+ * @param  seconds: 捕获时间 (s), 0为一直捕获到复位
+ * @retval SUCCESS/ERROR (已在监听, 或当前时钟无法产生输出波特率)
+ */
+error_status rs485_sniff_start(uint16_t seconds)
+{
+    crm_clocks_freq_type clocks;
+
+    crm_clocks_freq_get(&clocks);
+    if((rs485_sniff_state != RS485_SNIFF_IDLE) ||
+       ((clocks.apb2_freq / RS485_SNIFF_OUT_BAUDRATE) < RS485_SNIFF_USART_DIV_MIN))
+    {
+        return ERROR;
+    }
+
+    rs485_sniff_duration_ms = (uint32_t)seconds * 1000;
+    rs485_sniff_state = RS485_SNIFF_PENDING;
+
+    return SUCCESS;
+}
+
+/**
+ * @brief  启动捕获、输出记录, 在主循环中调用
+ * @note   上一个缓冲区发完后立即发送已编码的缓冲区, 再编码下一个, 发送期间USART1不停顿
+ * @param  None
+ * @retval 1: 有记录待输出, 0: 空闲
+ */
+uint8_t rs485_sniff_poll(void)
+{
+    uint8_t fill = rs485_sniff_out_fill;
+
+    switch(rs485_sniff_state)
+    {
+        case RS485_SNIFF_IDLE:
+            return 0;
+
+        case RS485_SNIFF_PENDING:
+            if(rs485_tx_busy())
+            {
+                return 1;
+            }
+            rs485_sniff_begin();
+            break;
+
+        case RS485_SNIFF_CAPTURE:
+            if((rs485_sniff_duration_ms != 0) && ((get_tick() - rs485_sniff_start_tick) >= rs485_sniff_duration_ms))
+            {
+                rs485_sniff_end();
+            }
+            else
+            {
+                rs485_sniff_rearm();
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    if((rs485_sniff_out_len[fill] != 0) && (RS485_SNIFF_OUT_DMA_CHANNEL->dtcnt == 0))
+    {
+        RS485_SNIFF_OUT_DMA_CHANNEL->ctrl_bit.chen = FALSE;
+        RS485_SNIFF_OUT_DMA_CHANNEL->maddr = (uint32_t)rs485_sniff_out[fill];
+        RS485_SNIFF_OUT_DMA_CHANNEL->dtcnt = rs485_sniff_out_len[fill];
+        RS485_SNIFF_OUT_DMA_CHANNEL->ctrl_bit.chen = TRUE;
+
+        fill ^= 1;
+        rs485_sniff_out_fill = fill;
+        rs485_sniff_out_len[fill] = 0;
+    }
+
+    if(rs485_sniff_out_len[fill] == 0)
+    {
+        rs485_sniff_out_len[fill] = rs485_sniff_build(rs485_sniff_out[fill]);
+    }
+
+    /* 剩余记录都已发出 */
+    if((rs485_sniff_state == RS485_SNIFF_DRAIN) && (rs485_sniff_out_len[fill] == 0) &&
+       (RS485_SNIFF_OUT_DMA_CHANNEL->dtcnt == 0))
+    {
+        rs485_sniff_state = RS485_SNIFF_IDLE;
+        return 0;
+    }
+
+    return 1;
+}
+
+/**
+ * @brief  读取监听统计
+ * @param  stats: 输出
+ * @retval None
+ */
+void rs485_sniff_get_stats(rs485_sniff_stats_t* stats)
+{
+    *stats = rs485_sniff_stats;
+    stats->state = (uint8_t)rs485_sniff_state;
+}
+
+/**
+ * @brief  监听接收DMA中断: 半满和满时各记一个时间标记, 满时计回绕
+ * @note   与USART2接收中断同一优先级, 两者不互相打断
+ * @param  None
+ * @retval None
+ */
+RAMFUNC void RS485_SNIFF_RX_DMA_IRQHandler(void)
+{
+    if(dma_flag_get(RS485_SNIFF_RX_DMA_FDT_FLAG) != RESET)
+    {
+        dma_flag_clear(RS485_SNIFF_RX_DMA_FDT_FLAG);
+        rs485_sniff_wraps++;
+    }
+    if(dma_flag_get(RS485_SNIFF_RX_DMA_HDT_FLAG) != RESET)
+    {
+        dma_flag_clear(RS485_SNIFF_RX_DMA_HDT_FLAG);
+    }
+
+    rs485_sniff_mark(0);
+}
@@ -0,0 +1,106 @@
+/**
+ * @file rs485_sniff.h
+ * @brief RS485总线监听模块头文件 (接收DMA环形缓冲区, 带时间的捕获记录经USART1输出)
+ * @author Jason
+ * @date 2026-10-18
+ */
+
+#ifndef __RS485_SNIFF_H
+#define __RS485_SNIFF_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "at32f403a_407.h"
+
+/* Exported types ------------------------------------------------------------*/
+/**
+ * @brief  监听状态
+ */
+typedef enum
+{
+    RS485_SNIFF_IDLE = 0,           /*!< 未监听 */
+    RS485_SNIFF_PENDING,            /*!< 等待启动命令的回复发完 */
+    RS485_SNIFF_CAPTURE,            /*!< 捕获中 */
+    RS485_SNIFF_DRAIN               /*!< 捕获结束, 输出剩余记录 */
+} rs485_sniff_state_t;
+
+/**
+ * @brief  监听统计 (最近一次捕获)
+ */
+typedef struct
+{
+    uint8_t state;                  /*!< rs485_sniff_state_t */
+    uint32_t bytes;                 /*!< 捕获的字节数 */
+    uint32_t lost_bytes;            /*!< 输出跟不上被覆盖的字节数 */
+    uint32_t marks_lost;            /*!< 时间标记队列满未记录的次数 (相邻段合并, 段内时间为推算) */
+    uint16_t ring_peak;             /*!< 环形缓冲区待输出字节数最大值 */
+} rs485_sniff_stats_t;
+
+/* Exported constants --------------------------------------------------------*/
+/* 接收环形缓冲区 (2的幂), 921600波特率下约44ms */
+#define RS485_SNIFF_RING_SIZE       4096
+
+/* 时间标记队列项数 (2的幂): 每个空闲线、线路错误和半满/满各一项 */
+#define RS485_SNIFF_MARK_NUM        256
+
+/* 输出: USART1波特率和每个COBS帧的最大负载 (双缓冲) */
+#define RS485_SNIFF_OUT_BAUDRATE    3000000
+#define RS485_SNIFF_OUT_PAYLOAD     480
+
+/* 记录类型 (每个输出帧含一条或多条记录) */
+#define RS485_SNIFF_REC_HEADER      0x01    /*!< 版本 波特率(u32) 每字符位数 */
+#define RS485_SNIFF_REC_SEGMENT     0x02    /*!< 标志 间隔us(变长) 长度(变长) 数据 */
+#define RS485_SNIFF_REC_LOST        0x03    /*!< 丢失字节数(变长) */
+
+#define RS485_SNIFF_VERSION         1
+
+/* 段标志: 低4位与USART状态寄存器相同 (段的最后一个字节出错) */
+#define RS485_SNIFF_FLAG_PERR       0x01    /*!< 校验错误 */
+#define RS485_SNIFF_FLAG_FERR       0x02    /*!< 帧错误 */
+#define RS485_SNIFF_FLAG_NERR       0x04    /*!< 噪声错误 */
+#define RS485_SNIFF_FLAG_ROERR      0x08    /*!< 接收溢出 */
+#define RS485_SNIFF_FLAG_IDLE       0x10    /*!< 段后线路空闲 (一帧结束), 时间标记在最后一个字节后1个字符 */
+#define RS485_SNIFF_FLAG_MERGED     0x20    /*!< 之前的时间标记丢失, 本段含多个段 */
+#define RS485_SNIFF_FLAG_PARTIAL    0x40    /*!< 段的前一部分, 无时间, 与下一条记录属于同一段 */
+#define RS485_SNIFF_FLAG_END        0x80    /*!< 捕获结束 */
+
+/* Exported macro ------------------------------------------------------------*/
+/* Exported functions prototypes ---------------------------------------------*/
+
+/**
+ * @brief  总线监听初始化 (注册时钟切换通知), 在 rs485_init 之后调用
+ * @param  None
+ * @retval None
+ */
+void rs485_sniff_init(void);
+
+/**
+ * @brief  开始监听
+ * @note   在当前回复发完后开始, 之后本机不再处理RS485命令, 直到捕获时间结束
+ * @param  seconds: 捕获时间 (s), 0为一直捕获到复位
+ * @retval SUCCESS/ERROR (已在监听, 或当前时钟无法产生输出波特率)
+ */
+error_status rs485_sniff_start(uint16_t seconds);
+
+/**
+ * @brief  启动捕获、输出记录, 在主循环中调用
+ * @param  None
+ * @retval 1: 有记录待输出, 0: 空闲
+ */
+uint8_t rs485_sniff_poll(void);
+
+/**
+ * @brief  读取监听统计
+ * @param  stats: 输出
+ * @retval None
+ */
+void rs485_sniff_get_stats(rs485_sniff_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __RS485_SNIFF_H */
@@ -0,0 +1,376 @@
+/**
+ * @file soft_i2c.c
+ * @brief 软件I2C主机实现
+ * @author Jason
+ * @date 2026-10-18
+ *
+ * 每个SCL/SDA边沿排在DWT周期计数器的时间网格上 (间隔半个SCL周期), 引脚操作和循环的开销
+ * 在等待中被吸收, 不累积到周期里; 240MHz下400kHz半周期为300个CPU周期, 1MHz为120个.
+ * 被中断推迟的边沿从当前时刻重新计时, 只拉长该相位, 不压缩后面的相位 (I2C时钟由主机决定,
+ * 拉长任何相位都合法). 释放SCL后等待引脚读到高电平, 支持从机时钟延展.
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "soft_i2c.h"
+#include "main.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private define ------------------------------------------------------------*/
+/* Private macro -------------------------------------------------------------*/
+/* 开漏引脚: 置位为释放 (外部上拉为高), 复位为拉低 */
+#define SOFT_I2C_SCL_RELEASE(bus)   ((bus)->scl_port->scr = (bus)->scl_pin)
+#define SOFT_I2C_SCL_LOW(bus)       ((bus)->scl_port->clr = (bus)->scl_pin)
+#define SOFT_I2C_SDA_RELEASE(bus)   ((bus)->sda_port->scr = (bus)->sda_pin)
+#define SOFT_I2C_SDA_LOW(bus)       ((bus)->sda_port->clr = (bus)->sda_pin)
+#define SOFT_I2C_SCL_READ(bus)      (((bus)->scl_port->idt & (bus)->scl_pin) != 0)
+#define SOFT_I2C_SDA_READ(bus)      (((bus)->sda_port->idt & (bus)->sda_pin) != 0)
+
+/* Private variables ---------------------------------------------------------*/
+/* Private function prototypes -----------------------------------------------*/
+static void soft_i2c_delay(soft_i2c_t* bus);
+static error_status soft_i2c_scl_high(soft_i2c_t* bus);
+static error_status soft_i2c_start(soft_i2c_t* bus);
+static void soft_i2c_stop(soft_i2c_t* bus);
+static error_status soft_i2c_write_byte(soft_i2c_t* bus, uint8_t byte);
+static error_status soft_i2c_read_byte(soft_i2c_t* bus, uint8_t* byte, uint8_t ack);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief  等到下一个边沿时刻 (半个SCL周期)
+ * @note   已经过了该时刻 (被中断推迟) 时从当前时刻重新计时
+ * @param  bus: 总线
+ * @retval None
+ */
+static void soft_i2c_delay(soft_i2c_t* bus)
+{
+    uint32_t now = DWT->CYCCNT;
+
+    bus->next += bus->half_cycles;
+    if((int32_t)(now - bus->next) >= 0)
+    {
+        bus->next = now;
+        return;
+    }
+
+    while((int32_t)(DWT->CYCCNT - bus->next) < 0)
+    {
+    }
+}
+
+/**
+ * @brief  释放SCL并等待其变高 (从机可以拉低SCL延展时钟)
+ * @note   被延展时高电平相位从SCL实际变高的时刻起算
+ * @param  bus: 总线
+ * @retval SUCCESS/ERROR (延展超时)
+ */
+static error_status soft_i2c_scl_high(soft_i2c_t* bus)
+{
+    uint32_t start = DWT->CYCCNT;
+
+    SOFT_I2C_SCL_RELEASE(bus);
+    if(SOFT_I2C_SCL_READ(bus))
+    {
+        return SUCCESS;
+    }
+
+    while(!SOFT_I2C_SCL_READ(bus))
+    {
+        if((DWT->CYCCNT - start) > bus->stretch_cycles)
+        {
+            return ERROR;
+        }
+    }
+    bus->next = DWT->CYCCNT;
+
+    return SUCCESS;
+}
+
+/**
+ * @brief  起始或重复起始信号: SCL高时SDA下降
+ * @param  bus: 总线 (SCL为低, 或总线空闲)
+ * @retval SUCCESS/ERROR (SDA被占用或时钟延展超时)
+ */
+static error_status soft_i2c_start(soft_i2c_t* bus)
+{
+    SOFT_I2C_SDA_RELEASE(bus);
+    soft_i2c_delay(bus);
+    if((soft_i2c_scl_high(bus) != SUCCESS) || !SOFT_I2C_SDA_READ(bus))
+    {
+        return ERROR;
+    }
+    soft_i2c_delay(bus);
+
+    SOFT_I2C_SDA_LOW(bus);
+    soft_i2c_delay(bus);
+    SOFT_I2C_SCL_LOW(bus);
+
+    return SUCCESS;
+}
+
+/**
+ * @brief  停止信号: SCL高时SDA上升
+ * @param  bus: 总线 (SCL为低)
+ * @retval None
+ */
+static void soft_i2c_stop(soft_i2c_t* bus)
+{
+    SOFT_I2C_SDA_LOW(bus);
+    soft_i2c_delay(bus);
+    soft_i2c_scl_high(bus);
+    soft_i2c_delay(bus);
+    SOFT_I2C_SDA_RELEASE(bus);
+    soft_i2c_delay(bus);
+}
+
+/**
+ * @brief  发送一个字节并读应答
+ * @note   SDA在SCL低相位开始时改变, 高相位中保持
+ * @param  bus: 总线 (SCL为低)
+ * @param  byte: 数据
+ * @retval SUCCESS: 应答, ERROR: 无应答或时钟延展超时
+ */
+static error_status soft_i2c_write_byte(soft_i2c_t* bus, uint8_t byte)
+{
+    uint8_t mask;
+    uint8_t nack;
+
+    for(mask = 0x80; mask != 0; mask >>= 1)
+    {
+        if(byte & mask)
+        {
+            SOFT_I2C_SDA_RELEASE(bus);
+        }
+        else
+        {
+            SOFT_I2C_SDA_LOW(bus);
+        }
+        soft_i2c_delay(bus);
+        if(soft_i2c_scl_high(bus) != SUCCESS)
+        {
+            return ERROR;
+        }
+        soft_i2c_delay(bus);
+        SOFT_I2C_SCL_LOW(bus);
+    }
+
+    /* 第9个时钟: 释放SDA, 高相位末尾采样应答 */
+    SOFT_I2C_SDA_RELEASE(bus);
+    soft_i2c_delay(bus);
+    if(soft_i2c_scl_high(bus) != SUCCESS)
+    {
+        return ERROR;
+    }
+    soft_i2c_delay(bus);
+    nack = SOFT_I2C_SDA_READ(bus);
+    SOFT_I2C_SCL_LOW(bus);
+
+    return nack ? ERROR : SUCCESS;
+}
+
+/**
+ * @brief  接收一个字节并发送应答或无应答
+ * @param  bus: 总线 (SCL为低)
+ * @param  byte: 输出数据
+ * @param  ack: 1应答 (还要继续读), 0无应答 (最后一个字节)
+ * @retval SUCCESS/ERROR (时钟延展超时)
+ */
+static error_status soft_i2c_read_byte(soft_i2c_t* bus, uint8_t* byte, uint8_t ack)
+{
+    uint8_t value = 0;
+    uint8_t i;
+
+    SOFT_I2C_SDA_RELEASE(bus);
+    for(i = 0; i < 8; i++)
+    {
+        soft_i2c_delay(bus);
+        if(soft_i2c_scl_high(bus) != SUCCESS)
+        {
+            return ERROR;
+        }
+        soft_i2c_delay(bus);
+        value = (uint8_t)((value << 1) | SOFT_I2C_SDA_READ(bus));
+        SOFT_I2C_SCL_LOW(bus);
+    }
+    *byte = value;
+
+    if(ack)
+    {
+        SOFT_I2C_SDA_LOW(bus);
+    }
+    soft_i2c_delay(bus);
+    if(soft_i2c_scl_high(bus) != SUCCESS)
+    {
+        return ERROR;
+    }
+    soft_i2c_delay(bus);
+    SOFT_I2C_SCL_LOW(bus);
+    SOFT_I2C_SDA_RELEASE(bus);
+
+    return SUCCESS;
+}
+
+/**
+ * @brief  初始化: 引脚切换为开漏输出并释放, 计算时序, 清除总线
+ * @note   调用者负责先关闭占用这两个引脚的I2C外设
+ * @param  bus: 总线 (引脚已填写)
+ * @param  speed: SCL速率 (Hz)
+ * @retval None
+ */
+void soft_i2c_init(soft_i2c_t* bus, uint32_t speed)
+{
+    gpio_init_type gpio_init_struct;
+
+    SOFT_I2C_SCL_RELEASE(bus);
+    SOFT_I2C_SDA_RELEASE(bus);
+
+    gpio_default_para_init(&gpio_init_struct);
+    gpio_init_struct.gpio_drive_strength = GPIO_DRIVE_STRENGTH_STRONGER;
+    gpio_init_struct.gpio_mode = GPIO_MODE_OUTPUT;
+    gpio_init_struct.gpio_out_type = GPIO_OUTPUT_OPEN_DRAIN;
+    gpio_init_struct.gpio_pull = GPIO_PULL_UP;
+    gpio_init_struct.gpio_pins = bus->scl_pin;
+    gpio_init(bus->scl_port, &gpio_init_struct);
+    gpio_init_struct.gpio_pins = bus->sda_pin;
+    gpio_init(bus->sda_port, &gpio_init_struct);
+
+    soft_i2c_set_speed(bus, speed);
+    soft_i2c_clear(bus);
+}
+
+/**
+ * @brief  按当前系统时钟重算时序 (时钟档位切换后调用)
+ * @param  bus: 总线
+ * @param  speed: SCL速率 (Hz)
+ * @retval None
+ */
+void soft_i2c_set_speed(soft_i2c_t* bus, uint32_t speed)
+{
+    bus->half_cycles = system_core_clock / (2 * speed);
+    if(bus->half_cycles == 0)
+    {
+        bus->half_cycles = 1;
+    }
+    bus->stretch_cycles = (system_core_clock / 1000000) * SOFT_I2C_STRETCH_TIMEOUT_US;
+}
+
+/**
+ * @brief  设定的SCL速率 (由半周期周期数换算, 不含上升时间)
+ * @param  bus: 总线
+ * @retval 速率 (Hz)
+ */
+uint32_t soft_i2c_rate(const soft_i2c_t* bus)
+{
+    return system_core_clock / (2 * bus->half_cycles);
+}
+
+/**
+ * @brief  清除总线: SDA被从机拉低时输出时钟直到释放, 然后生成停止信号
+ * @note   从机在读传输中途复位 (或主机中途放弃) 时会一直拉低SDA等待时钟
+ * @param  bus: 总线
+ * @retval SUCCESS: 总线空闲, ERROR: SDA或SCL仍为低
+ */
+error_status soft_i2c_clear(soft_i2c_t* bus)
+{
+    uint8_t i;
+
+    bus->next = DWT->CYCCNT;
+    SOFT_I2C_SDA_RELEASE(bus);
+    if(soft_i2c_scl_high(bus) != SUCCESS)
+    {
+        return ERROR;
+    }
+
+    for(i = 0; (i < SOFT_I2C_CLEAR_CLOCKS) && !SOFT_I2C_SDA_READ(bus); i++)
+    {
+        soft_i2c_delay(bus);
+        SOFT_I2C_SCL_LOW(bus);
+        soft_i2c_delay(bus);
+        if(soft_i2c_scl_high(bus) != SUCCESS)
+        {
+            return ERROR;
+        }
+    }
+
+    SOFT_I2C_SCL_LOW(bus);
+    soft_i2c_stop(bus);
+
+    return (SOFT_I2C_SCL_READ(bus) && SOFT_I2C_SDA_READ(bus)) ? SUCCESS : ERROR;
+}
+
+/**
+ * @brief  探测设备是否应答 (只发送地址)
+ * @param  bus: 总线
+ * @param  device_addr: 7位设备地址
+ * @retval SUCCESS: 有应答, ERROR: 无应答或总线错误
+ */
+error_status soft_i2c_probe(soft_i2c_t* bus, uint8_t device_addr)
+{
+    error_status result = ERROR;
+
+    bus->next = DWT->CYCCNT;
+    if(soft_i2c_start(bus) == SUCCESS)
+    {
+        result = soft_i2c_write_byte(bus, device_addr << 1);
+        soft_i2c_stop(bus);
+    }
+
+    return result;
+}
+
+/**
+ * @brief  执行一次传输 (阻塞), 帧格式与硬件路径相同
+ * @note   写: 起始, 地址+W, 寄存器, 数据..., 停止;
+ *         读: 起始, 地址+W, 寄存器, 重复起始, 地址+R, 数据... (最后一字节NACK), 停止
+ * @param  bus: 总线
+ * @param  device_addr: 7位设备地址
+ * @param  reg_addr: 寄存器地址
+ * @param  read: 0写, 1读
+ * @param  data: 数据缓冲区
+ * @param  len: 数据长度 (读时不为0)
+ * @retval SUCCESS/ERROR
+ */
+error_status soft_i2c_transfer(soft_i2c_t* bus, uint8_t device_addr, uint8_t reg_addr, uint8_t read,
+                               uint8_t* data, uint16_t len)
+{
+    error_status result = ERROR;
+    uint16_t i;
+
+    if(read && (len == 0))
+    {
+        return ERROR;
+    }
+
+    bus->next = DWT->CYCCNT;
+    if(soft_i2c_start(bus) != SUCCESS)
+    {
+        return ERROR;
+    }
+
+    if((soft_i2c_write_byte(bus, device_addr << 1) == SUCCESS) && (soft_i2c_write_byte(bus, reg_addr) == SUCCESS))
+    {
+        result = SUCCESS;
+        if(!read)
+        {
+            for(i = 0; (i < len) && (result == SUCCESS); i++)
+            {
+                result = soft_i2c_write_byte(bus, data[i]);
+            }
+        }
+        else if((soft_i2c_start(bus) == SUCCESS) && (soft_i2c_write_byte(bus, (device_addr << 1) | 0x01) == SUCCESS))
+        {
+            for(i = 0; (i < len) && (result == SUCCESS); i++)
+            {
+                result = soft_i2c_read_byte(bus, &data[i], (i < len - 1) ? 1 : 0);
+            }
+        }
+        else
+        {
+            result = ERROR;
+        }
+    }
+
+    soft_i2c_stop(bus);
+
+    return result;
+}
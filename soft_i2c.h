@@ -0,0 +1,102 @@
+/**
+ * @file soft_i2c.h
+ * @brief 软件I2C主机头文件 (任意GPIO引脚, DWT周期计时)
+ * @author Jason
+ * @date 2026-10-18
+ */
+
+#ifndef __SOFT_I2C_H
+#define __SOFT_I2C_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "at32f403a_407.h"
+
+/* Exported types ------------------------------------------------------------*/
+/**
+ * @brief  软件I2C总线: 两个开漏引脚 (外部上拉) 和时序
+ */
+typedef struct
+{
+    gpio_type* scl_port;            /*!< SCL端口 */
+    uint16_t scl_pin;               /*!< SCL引脚 */
+    gpio_type* sda_port;            /*!< SDA端口 */
+    uint16_t sda_pin;               /*!< SDA引脚 */
+
+    uint32_t half_cycles;           /*!< 半个SCL周期的CPU周期数 */
+    uint32_t stretch_cycles;        /*!< 等待从机释放SCL (时钟延展) 的最长CPU周期数 */
+    uint32_t next;                  /*!< 下一个边沿的DWT时刻 */
+} soft_i2c_t;
+
+/* Exported constants --------------------------------------------------------*/
+/* 时钟延展超时 (us) */
+#define SOFT_I2C_STRETCH_TIMEOUT_US 1000
+
+/* 总线清除时最多输出的时钟数 (从机卡在一个字节中间时释放SDA) */
+#define SOFT_I2C_CLEAR_CLOCKS       9
+
+/* Exported macro ------------------------------------------------------------*/
+/* Exported functions prototypes ---------------------------------------------*/
+
+/**
+ * @brief  初始化: 引脚切换为开漏输出并释放, 计算时序, 清除总线
+ * @note   调用者负责先关闭占用这两个引脚的I2C外设
+ * @param  bus: 总线 (引脚已填写)
+ * @param  speed: SCL速率 (Hz)
+ * @retval None
+ */
+void soft_i2c_init(soft_i2c_t* bus, uint32_t speed);
+
+/**
+ * @brief  按当前系统时钟重算时序 (时钟档位切换后调用)
+ * @param  bus: 总线
+ * @param  speed: SCL速率 (Hz)
+ * @retval None
+ */
+void soft_i2c_set_speed(soft_i2c_t* bus, uint32_t speed);
+
+/**
+ * @brief  设定的SCL速率 (由半周期周期数换算, 不含上升时间)
+ * @param  bus: 总线
+ * @retval 速率 (Hz)
+ */
+uint32_t soft_i2c_rate(const soft_i2c_t* bus);
+
+/**
+ * @brief  清除总线: SDA被从机拉低时输出时钟直到释放, 然后生成停止信号
+ * @param  bus: 总线
+ * @retval SUCCESS: 总线空闲, ERROR: SDA或SCL仍为低
+ */
+error_status soft_i2c_clear(soft_i2c_t* bus);
+
+/**
+ * @brief  探测设备是否应答 (只发送地址)
+ * @param  bus: 总线
+ * @param  device_addr: 7位设备地址
+ * @retval SUCCESS: 有应答, ERROR: 无应答或总线错误
+ */
+error_status soft_i2c_probe(soft_i2c_t* bus, uint8_t device_addr);
+
+/**
+ * @brief  执行一次传输 (阻塞), 帧格式与硬件路径相同
+ * @note   写: 起始, 地址+W, 寄存器, 数据..., 停止;
+ *         读: 起始, 地址+W, 寄存器, 重复起始, 地址+R, 数据... (最后一字节NACK), 停止
+ * @param  bus: 总线
+ * @param  device_addr: 7位设备地址
+ * @param  reg_addr: 寄存器地址
+ * @param  read: 0写, 1读
+ * @param  data: 数据缓冲区
+ * @param  len: 数据长度 (读时不为0)
+ * @retval SUCCESS/ERROR
+ */
+error_status soft_i2c_transfer(soft_i2c_t* bus, uint8_t device_addr, uint8_t reg_addr, uint8_t read,
+                               uint8_t* data, uint16_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SOFT_I2C_H */
@@ -0,0 +1,239 @@
+/**
+ * @file cobs_bench.c
+ * @brief RS485 COBS分帧编解码的主机基准测试 (rs485_frame.c 原样编译)
+ * @author Jason
+ * @date 2026-10-18
+ *
+ * 编码: rs485_frame_send 写入替身发送缓冲区; 解码: 把编码结果逐字节送入 rs485_frame_rx_byte,
+ * 再 rs485_frame_get / rs485_frame_free. 每轮都校验解码结果与原始数据一致.
+ * 用法: make -C tests bench  或  tests/build/cobs_bench [帧长] [帧数]
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "main.h"
+
+/* Private define ------------------------------------------------------------*/
+#define COBS_BENCH_LEN_DEFAULT      RS485_FRAME_MAX_SIZE
+#define COBS_BENCH_FRAMES_DEFAULT   200000
+
+/* Private variables ---------------------------------------------------------*/
+/* 替身发送缓冲区和最近一次发送的长度 */
+static uint8_t bench_tx_buffer[RS485_TX_BUFFER_SIZE];
+static uint16_t bench_tx_len = 0;
+
+/* Private functions ---------------------------------------------------------*/
+
+/* rs485_frame.c 依赖的发送和事件接口 */
+void rs485_tx_lock(void)
+{
+}
+
+void rs485_tx_unlock(void)
+{
+}
+
+uint8_t* rs485_tx_acquire(void)
+{
+    return bench_tx_buffer;
+}
+
+void rs485_tx_start(uint16_t len)
+{
+    bench_tx_len = len;
+}
+
+void rs485_frame_claim(uint8_t broadcast)
+{
+    (void)broadcast;
+}
+
+void os_event_post(os_event_t* event)
+{
+    (void)event;
+}
+
+/**
+ * @brief  单调时钟 (ns)
+ * @param  None
+ * @retval 时间
+ */
+static uint64_t bench_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief  解码一帧编码数据并与原始数据比较
+ * @param  encoded: 编码数据 (含帧界)
+ * @param  encoded_len: 编码长度
+ * @param  data: 原始数据
+ * @param  len: 原始长度
+ * @retval SUCCESS/ERROR
+ */
+static error_status bench_decode(const uint8_t* encoded, uint16_t encoded_len,
+                                 const uint8_t* data, uint16_t len)
+{
+    error_status status = SUCCESS;
+    uint8_t* frame;
+    uint16_t frame_len;
+    uint16_t i;
+
+    for(i = 0; i < encoded_len; i++)
+    {
+        rs485_frame_rx_byte(encoded[i], 0);
+    }
+
+    frame = rs485_frame_get(&frame_len);
+    if((frame == NULL) || (frame_len != len))
+    {
+        status = ERROR;
+    }
+    else
+    {
+        for(i = 0; i < len; i++)
+        {
+            if(frame[i] != data[i])
+            {
+                status = ERROR;
+                break;
+            }
+        }
+    }
+    rs485_frame_free();
+
+    return status;
+}
+
+/**
+ * @brief  测量一种数据模式的编码和解码速度
+ * @param  name: 模式名
+ * @param  data: 数据
+ * @param  len: 长度
+ * @param  frames: 帧数
+ * @retval SUCCESS/ERROR (解码结果不一致)
+ */
+static error_status bench_run(const char* name, const uint8_t* data, uint16_t len, uint32_t frames)
+{
+    static uint8_t encoded[RS485_TX_BUFFER_SIZE];
+    uint64_t start;
+    uint64_t encode_ns;
+    uint64_t decode_ns;
+    uint32_t n;
+    uint16_t encoded_len;
+    uint16_t i;
+
+    /* 正确性 */
+    if(rs485_frame_send(data, len) != SUCCESS)
+    {
+        return ERROR;
+    }
+    encoded_len = bench_tx_len;
+    for(i = 0; i < encoded_len; i++)
+    {
+        encoded[i] = bench_tx_buffer[i];
+    }
+    if(bench_decode(encoded, encoded_len, data, len) != SUCCESS)
+    {
+        printf("%-8s decode mismatch\n", name);
+        return ERROR;
+    }
+
+    start = bench_now_ns();
+    for(n = 0; n < frames; n++)
+    {
+        rs485_frame_send(data, len);
+    }
+    encode_ns = bench_now_ns() - start;
+
+    start = bench_now_ns();
+    for(n = 0; n < frames; n++)
+    {
+        for(i = 0; i < encoded_len; i++)
+        {
+            rs485_frame_rx_byte(encoded[i], 0);
+        }
+        rs485_frame_free();
+    }
+    decode_ns = bench_now_ns() - start;
+
+    printf("%-8s %5u %8u %10.1f %10.1f %9.1f %9.1f\n", name, len, encoded_len - len,
+           (double)len * frames * 1000.0 / encode_ns, (double)len * frames * 1000.0 / decode_ns,
+           (double)encode_ns / frames, (double)decode_ns / frames);
+
+    return SUCCESS;
+}
+
+/**
+ * @brief  主函数
+ * @param  argc: 参数个数
+ * @param  argv: [帧长] [帧数]
+ * @retval 0: 通过, 1: 解码结果不一致
+ */
+int main(int argc, char* argv[])
+{
+    static uint8_t data[RS485_FRAME_MAX_SIZE];
+    uint32_t frames = COBS_BENCH_FRAMES_DEFAULT;
+    uint16_t len = COBS_BENCH_LEN_DEFAULT;
+    error_status status = SUCCESS;
+    uint16_t i;
+
+    if(argc > 1)
+    {
+        len = (uint16_t)atoi(argv[1]);
+    }
+    if(argc > 2)
+    {
+        frames = (uint32_t)atol(argv[2]);
+    }
+    if((len == 0) || (len > RS485_FRAME_MAX_SIZE) || (frames == 0))
+    {
+        printf("usage: %s [len 1..%d] [frames]\n", argv[0], RS485_FRAME_MAX_SIZE);
+        return 1;
+    }
+
+    rs485_frame_init();
+
+    printf("%u frames per pattern, MB/s of payload, ns per frame\n", frames);
+    printf("%-8s %5s %8s %10s %10s %9s %9s\n", "pattern", "len", "overhead", "enc MB/s", "dec MB/s",
+           "enc ns", "dec ns");
+
+    /* 随机数据: 平均每256字节一个0 */
+    srand(1);
+    for(i = 0; i < len; i++)
+    {
+        data[i] = (uint8_t)rand();
+    }
+    if(bench_run("random", data, len, frames) != SUCCESS)
+    {
+        status = ERROR;
+    }
+
+    /* 无0: 每254字节插入一个码字节 (最坏开销) */
+    for(i = 0; i < len; i++)
+    {
+        data[i] = (uint8_t)(i % 255 + 1);
+    }
+    if(bench_run("nonzero", data, len, frames) != SUCCESS)
+    {
+        status = ERROR;
+    }
+
+    /* 全0: 每个字节都结束一个块 */
+    for(i = 0; i < len; i++)
+    {
+        data[i] = 0;
+    }
+    if(bench_run("zeros", data, len, frames) != SUCCESS)
+    {
+        status = ERROR;
+    }
+
+    return (status == SUCCESS) ? 0 : 1;
+}
@@ -0,0 +1,387 @@
+/**
+ * @file config_store_test.c
+ * @brief 配置存储掉电测试 (config_store.c 原样编译, Flash用主机内存模拟)
+ * @author Jason
+ * @date 2026-10-18
+ *
+ * 两个配置扇区映射到与芯片相同的地址 (CONFIG_FLASH_BASE), 模拟Flash只能把1写成0 (或写0)、
+ * 擦除整个扇区置1. 每轮随机写一个键, 每次Flash操作都可能掉电:
+ *   编程: 只有一部分要清零的位被清零 (记录头/数据/CRC/扇区序号/magic写了一半)
+ *   擦除: 每一位以随机概率变为1 (擦除刚开始到接近完成)
+ * 掉电后重新 config_store_init, 检查每个键都是最后一次提交的值 (正在写的键也可以是新值),
+ * 不能出现旧值、错值或丢失. 每种掉电位置都须至少出现一次.
+ * 用法: make -C tests  或  tests/build/config_store_test [轮数] [随机种子]
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <setjmp.h>
+#include <sys/mman.h>
+#include "main.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/**
+ * @brief  掉电位置
+ */
+typedef enum
+{
+    TEST_CUT_RECORD_HEADER = 0,     /*!< 记录头的键和长度 */
+    TEST_CUT_RECORD_DATA,           /*!< 记录数据 */
+    TEST_CUT_RECORD_CRC,            /*!< 记录CRC (提交) */
+    TEST_CUT_INVALIDATE,            /*!< 擦除前作废备用扇区的magic */
+    TEST_CUT_ERASE,                 /*!< 擦除备用扇区 */
+    TEST_CUT_SEQ,                   /*!< 整理提交: 扇区序号 */
+    TEST_CUT_MAGIC,                 /*!< 整理提交: 已写序号, magic未写完 */
+    TEST_CUT_NUM
+} test_cut_t;
+
+/* Private define ------------------------------------------------------------*/
+#define TEST_ROUNDS_DEFAULT     200000
+#define TEST_FLASH_SIZE         (2 * CONFIG_SECTOR_SIZE)
+
+/* 每次编程/擦除掉电的概率 (1/n); 擦除较少, 提高其概率 */
+#define TEST_CUT_PROGRAM_RATE   64
+#define TEST_CUT_ERASE_RATE     4
+
+/* Private variables ---------------------------------------------------------*/
+static const char* const test_cut_names[TEST_CUT_NUM] =
+{
+    "record header", "record data", "record crc", "invalidate", "erase", "sector seq", "sector magic"
+};
+
+static uint32_t* test_flash = NULL;
+
+/* 本轮是否模拟掉电 (读回检查期间关闭) */
+static uint8_t test_cut_enable = 0;
+static jmp_buf test_power_off;
+
+/* 每个键最后提交的值 */
+static uint8_t test_committed[CONFIG_KEY_NUM][CONFIG_VALUE_MAX];
+static uint8_t test_committed_valid[CONFIG_KEY_NUM];
+
+/* 本轮写入的键和值 */
+static uint8_t test_key;
+static uint8_t test_value[CONFIG_VALUE_MAX];
+
+/* 统计 */
+static uint32_t test_cuts[TEST_CUT_NUM];
+static uint32_t test_erases = 0;
+static uint32_t test_new_after_cut = 0;
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief  32位随机数
+ * @param  None
+ * @retval 随机数
+ */
+static uint32_t test_rand32(void)
+{
+    return ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+}
+
+/**
+ * @brief  按地址和写入值判断编程操作的掉电位置
+ * @param  address: 地址
+ * @param  data: 写入值
+ * @param  halfword: 1: 半字编程
+ * @retval test_cut_t
+ */
+static test_cut_t test_program_cut(uint32_t address, uint32_t data, uint8_t halfword)
+{
+    uint32_t offset = (address - CONFIG_FLASH_BASE) % CONFIG_SECTOR_SIZE;
+
+    if(offset == 0)
+    {
+        return (data == 0) ? TEST_CUT_INVALIDATE : TEST_CUT_MAGIC;
+    }
+    if(offset == 4)
+    {
+        return TEST_CUT_SEQ;
+    }
+    if(halfword)
+    {
+        return (offset & 2) ? TEST_CUT_RECORD_CRC : TEST_CUT_RECORD_HEADER;
+    }
+
+    return TEST_CUT_RECORD_DATA;
+}
+
+/**
+ * @brief  记一次掉电并返回到 test_round
+ * @param  cut: 掉电位置
+ * @retval None
+ */
+static void test_power_off_now(test_cut_t cut)
+{
+    test_cuts[cut]++;
+    longjmp(test_power_off, 1);
+}
+
+/* config_store.c 依赖的Flash和总线接口 */
+void flash_unlock(void)
+{
+}
+
+void flash_lock(void)
+{
+}
+
+flash_status_type flash_word_program(uint32_t address, uint32_t data)
+{
+    __IO uint32_t* word = (__IO uint32_t*)address;
+
+    /* 与芯片相同: 只能写已擦除的字, 或写0 */
+    if((*word != 0xFFFFFFFF) && (data != 0))
+    {
+        return FLASH_PROGRAM_ERROR;
+    }
+
+    if(test_cut_enable && (rand() % TEST_CUT_PROGRAM_RATE == 0))
+    {
+        /* 要清零的位只清了一部分 */
+        *word &= data | test_rand32();
+        test_power_off_now(test_program_cut(address, data, 0));
+    }
+
+    *word &= data;
+
+    return FLASH_OPERATE_DONE;
+}
+
+flash_status_type flash_halfword_program(uint32_t address, uint16_t data)
+{
+    __IO uint16_t* halfword = (__IO uint16_t*)address;
+
+    if((*halfword != 0xFFFF) && (data != 0))
+    {
+        return FLASH_PROGRAM_ERROR;
+    }
+
+    if(test_cut_enable && (rand() % TEST_CUT_PROGRAM_RATE == 0))
+    {
+        *halfword &= (uint16_t)(data | test_rand32());
+        test_power_off_now(test_program_cut(address, data, 1));
+    }
+
+    *halfword &= data;
+
+    return FLASH_OPERATE_DONE;
+}
+
+error_status flash_if_erase(uint32_t addr)
+{
+    __IO uint32_t* word = (__IO uint32_t*)addr;
+    uint32_t mask;
+    uint32_t i;
+    int shift, k;
+
+    test_erases++;
+
+    if(test_cut_enable && (rand() % TEST_CUT_ERASE_RATE == 0))
+    {
+        /* 每一位以 1/2^shift 的概率已被擦除 (shift 0..8) */
+        shift = rand() % 9;
+        for(i = 0; i < CONFIG_SECTOR_SIZE / 4; i++)
+        {
+            mask = 0xFFFFFFFF;
+            for(k = 0; k < shift; k++)
+            {
+                mask &= test_rand32();
+            }
+            word[i] |= mask;
+        }
+        test_power_off_now(TEST_CUT_ERASE);
+    }
+
+    for(i = 0; i < CONFIG_SECTOR_SIZE / 4; i++)
+    {
+        word[i] = 0xFFFFFFFF;
+    }
+
+    return SUCCESS;
+}
+
+uint8_t rs485_line_idle(void)
+{
+    return 1;
+}
+
+/**
+ * @brief  检查所有键都能读出最后提交的值
+ * @param  key: 掉电时正在写的键, CONFIG_KEY_NUM 为无
+ * @param  value: 正在写的值
+ * @retval SUCCESS/ERROR
+ */
+static error_status test_verify(uint8_t key, const uint8_t* value)
+{
+    uint8_t data[CONFIG_VALUE_MAX];
+    uint8_t len;
+    uint8_t k, i;
+    uint8_t is_old, is_new;
+
+    for(k = 0; k < CONFIG_KEY_NUM; k++)
+    {
+        len = config_key_size((config_key_t)k);
+        if(config_get((config_key_t)k, data, len) != SUCCESS)
+        {
+            if(test_committed_valid[k])
+            {
+                printf("key %u lost\n", k);
+                return ERROR;
+            }
+            continue;
+        }
+
+        is_old = test_committed_valid[k];
+        is_new = (k == key);
+        for(i = 0; i < len; i++)
+        {
+            if(data[i] != test_committed[k][i])
+            {
+                is_old = 0;
+            }
+            if((k == key) && (data[i] != value[i]))
+            {
+                is_new = 0;
+            }
+        }
+
+        if(!is_old && !is_new)
+        {
+            printf("key %u has a value that was never committed\n", k);
+            return ERROR;
+        }
+
+        /* 掉电前新值已完整写入 */
+        if(is_new && !is_old)
+        {
+            for(i = 0; i < len; i++)
+            {
+                test_committed[k][i] = value[i];
+            }
+            test_committed_valid[k] = 1;
+            test_new_after_cut++;
+        }
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief  一轮: 随机写一个键, 可能在中途掉电
+ * @param  round: 轮次
+ * @param  seed: 随机种子 (用于报告)
+ * @retval SUCCESS/ERROR
+ */
+static error_status test_round(uint32_t round, uint32_t seed)
+{
+    uint8_t len, i;
+
+    test_key = (uint8_t)(rand() % CONFIG_KEY_NUM);
+    len = config_key_size((config_key_t)test_key);
+    for(i = 0; i < len; i++)
+    {
+        test_value[i] = (uint8_t)rand();
+    }
+
+    if(setjmp(test_power_off) != 0)
+    {
+        /* 掉电重启 */
+        test_cut_enable = 0;
+        config_store_init();
+
+        if(test_verify(test_key, test_value) != SUCCESS)
+        {
+            printf("round %u: recovery failed after power loss writing key %u (seed %u)\n",
+                   (unsigned)round, (unsigned)test_key, (unsigned)seed);
+            return ERROR;
+        }
+        return SUCCESS;
+    }
+
+    test_cut_enable = 1;
+    config_set((config_key_t)test_key, test_value, len);
+    while(config_store_busy())
+    {
+        config_store_poll();
+    }
+    test_cut_enable = 0;
+
+    for(i = 0; i < len; i++)
+    {
+        test_committed[test_key][i] = test_value[i];
+    }
+    test_committed_valid[test_key] = 1;
+
+    if(test_verify(CONFIG_KEY_NUM, test_value) != SUCCESS)
+    {
+        printf("round %u: readback failed without power loss (seed %u)\n", (unsigned)round, (unsigned)seed);
+        return ERROR;
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief  主函数
+ * @param  argc: 参数个数
+ * @param  argv: [轮数] [随机种子]
+ * @retval 0: 通过, 1: 失败
+ */
+int main(int argc, char* argv[])
+{
+    uint32_t rounds = TEST_ROUNDS_DEFAULT;
+    uint32_t seed = 1;
+    uint32_t round;
+    uint32_t n;
+    uint8_t cut;
+    int result = 0;
+
+    if(argc > 1)
+    {
+        rounds = (uint32_t)atol(argv[1]);
+    }
+    if(argc > 2)
+    {
+        seed = (uint32_t)atol(argv[2]);
+    }
+    srand(seed);
+
+    test_flash = mmap((void*)CONFIG_FLASH_BASE, TEST_FLASH_SIZE, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+    if(test_flash != (uint32_t*)CONFIG_FLASH_BASE)
+    {
+        printf("cannot map simulated flash at 0x%08X\n", (unsigned)CONFIG_FLASH_BASE);
+        return 1;
+    }
+    for(n = 0; n < TEST_FLASH_SIZE / 4; n++)
+    {
+        test_flash[n] = 0xFFFFFFFF;
+    }
+
+    config_store_init();
+
+    for(round = 0; round < rounds; round++)
+    {
+        if(test_round(round, seed) != SUCCESS)
+        {
+            return 1;
+        }
+    }
+
+    printf("%u rounds, %u sector erases, %u new values committed just before power loss\n",
+           (unsigned)rounds, (unsigned)test_erases, (unsigned)test_new_after_cut);
+    for(cut = 0; cut < TEST_CUT_NUM; cut++)
+    {
+        printf("  power loss during %-14s %6u\n", test_cut_names[cut], (unsigned)test_cuts[cut]);
+        if(test_cuts[cut] == 0)
+        {
+            printf("  (not covered, run more rounds)\n");
+            result = 1;
+        }
+    }
+
+    return result;
+}
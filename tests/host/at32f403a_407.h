@@ -0,0 +1,60 @@
+/**
+ * @file at32f403a_407.h
+ * @brief 主机测试用的AT32头文件替身 (只含被测模块用到的类型和接口)
+ * @author Jason
+ * @date 2026-10-18
+ */
+
+#ifndef __AT32F403A_407_H
+#define __AT32F403A_407_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define __IO volatile
+
+typedef enum {RESET = 0, SET = !RESET} flag_status;
+typedef enum {FALSE = 0, TRUE = !FALSE} confirm_state;
+typedef enum {ERROR = 0, SUCCESS = !ERROR} error_status;
+
+/* 外设类型只在结构体和函数原型中以指针或枚举出现 */
+typedef struct gpio_type gpio_type;
+typedef struct i2c_type i2c_type;
+typedef struct dma_channel_type dma_channel_type;
+typedef uint32_t crm_periph_clock_type;
+typedef uint32_t crm_pll_clock_source_type;
+typedef uint32_t dma_flexible_request_type;
+typedef uint32_t i2c_clock_duty_type;
+
+/* Flash操作结果 (与外设库相同) */
+typedef enum
+{
+    FLASH_OPERATE_BUSY = 0x00,
+    FLASH_PROGRAM_ERROR = 0x01,
+    FLASH_EPP_ERROR = 0x02,
+    FLASH_OPERATE_DONE = 0x03,
+    FLASH_OPERATE_TIMEOUT = 0x04
+} flash_status_type;
+
+void flash_unlock(void);
+void flash_lock(void);
+flash_status_type flash_word_program(uint32_t address, uint32_t data);
+flash_status_type flash_halfword_program(uint32_t address, uint16_t data);
+
+/* 独占访问: 主机测试单线程运行, STREX总是成功 */
+static inline uint32_t __LDREXW(volatile uint32_t* addr)
+{
+    return *addr;
+}
+
+static inline uint32_t __STREXW(uint32_t value, volatile uint32_t* addr)
+{
+    *addr = value;
+    return 0;
+}
+
+static inline void __CLREX(void)
+{
+}
+
+#endif /* __AT32F403A_407_H */
@@ -0,0 +1,6 @@
+/**
+ * @file at32f403a_407_conf.h
+ * @brief 主机测试用的外设库配置替身 (不使用外设库)
+ * @author Jason
+ * @date 2026-10-18
+ */
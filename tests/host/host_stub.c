@@ -0,0 +1,14 @@
+/**
+ * @file host_stub.c
+ * @brief 主机测试公用的替身 (被测模块引用的全局变量)
+ * @author Jason
+ * @date 2026-10-18
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+
+/* Private variables ---------------------------------------------------------*/
+/* 指标 (METRIC_INC / METRIC_GAUGE_SET 直接写数组) */
+__IO uint32_t metrics_counters[METRIC_COUNTER_NUM];
+__IO uint32_t metrics_gauges[METRIC_GAUGE_NUM];
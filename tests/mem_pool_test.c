@@ -0,0 +1,373 @@
+/**
+ * @file mem_pool_test.c
+ * @brief 固定块内存池主机压力测试 (mem_pool.c 原样编译)
+ * @author Jason
+ * @date 2026-10-18
+ *
+ * 几个不同块大小/块数的池随机交错分配和释放, 每步检查:
+ *   分配的块在池内、按块对齐、未被重复分配, 池空时才返回NULL; used/high_water/fail_count 与模型一致
+ * 结束时全部释放, 检查 used 为0、空闲链表恰好含 block_count 个不同的块.
+ * 另外检查重复释放、未对齐指针、其他池的指针和NULL都返回ERROR并计入 METRIC_POOL_BAD_FREE,
+ * 且不破坏空闲链表.
+ * 用法: make -C tests  或  tests/build/mem_pool_test [步数] [随机种子]
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include "main.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/**
+ * @brief  被测池和模型状态
+ */
+typedef struct
+{
+    const char* name;
+    mem_pool_t pool;
+    uint32_t* storage;
+    uint16_t size;                  /*!< 申请的块大小 */
+    uint16_t count;
+    uint8_t* owned;                 /*!< 模型: 每块是否已分配 */
+    uint32_t used;
+    uint32_t high_water;
+    uint32_t fails;
+} test_pool_t;
+
+/* Private define ------------------------------------------------------------*/
+#define TEST_STEPS_DEFAULT      2000000
+#define TEST_POOL_NUM           4
+
+/* Private macro -------------------------------------------------------------*/
+#define TEST_CHECK(cond, ...)   do { if(!(cond)) { printf(__VA_ARGS__); printf("\n"); return ERROR; } } while(0)
+
+/* Private variables ---------------------------------------------------------*/
+MEM_POOL_STORAGE(test_storage_min, 4, 3);
+MEM_POOL_STORAGE(test_storage_odd, 13, 17);
+MEM_POOL_STORAGE(test_storage_frame, 260, 8);
+MEM_POOL_STORAGE(test_storage_many, 32, 64);
+
+static uint8_t test_owned_min[3];
+static uint8_t test_owned_odd[17];
+static uint8_t test_owned_frame[8];
+static uint8_t test_owned_many[64];
+
+static test_pool_t test_pools[TEST_POOL_NUM] =
+{
+    {"min 4x3",     {0}, test_storage_min,   4,   3,  test_owned_min,   0, 0, 0},
+    {"odd 13x17",   {0}, test_storage_odd,   13,  17, test_owned_odd,   0, 0, 0},
+    {"frame 260x8", {0}, test_storage_frame, 260, 8,  test_owned_frame, 0, 0, 0},
+    {"many 32x64",  {0}, test_storage_many,  32,  64, test_owned_many,  0, 0, 0}
+};
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief  块序号 (不在池内或未对齐时返回 -1)
+ * @param  tp: 被测池
+ * @param  block: 块指针
+ * @retval 序号
+ */
+static int test_block_index(const test_pool_t* tp, const void* block)
+{
+    uint32_t offset = (uint32_t)block - tp->pool.base;
+
+    if(((uint32_t)block < tp->pool.base) || (offset >= (uint32_t)tp->pool.block_size * tp->count) ||
+       ((offset % tp->pool.block_size) != 0))
+    {
+        return -1;
+    }
+
+    return (int)(offset / tp->pool.block_size);
+}
+
+/**
+ * @brief  写满已分配块 (覆盖空闲链表指针和空闲标记所在的字)
+ * @param  tp: 被测池
+ * @param  index: 块序号
+ * @retval None
+ */
+static void test_block_fill(const test_pool_t* tp, int index)
+{
+    uint8_t* data = (uint8_t*)(tp->pool.base + (uint32_t)index * tp->pool.block_size);
+    uint16_t i;
+
+    for(i = 0; i < tp->size; i++)
+    {
+        data[i] = (uint8_t)(index * 7 + i);
+    }
+}
+
+/**
+ * @brief  遍历空闲链表, 检查块数、块各不相同且都未分配
+ * @param  tp: 被测池
+ * @param  expect: 期望的空闲块数
+ * @retval SUCCESS/ERROR
+ */
+static error_status test_free_list_check(const test_pool_t* tp, uint32_t expect)
+{
+    uint8_t seen[64] = {0};
+    uint32_t addr = tp->pool.free_list;
+    uint32_t n = 0;
+    int index;
+
+    while(addr != 0)
+    {
+        index = test_block_index(tp, (const void*)addr);
+        TEST_CHECK(index >= 0, "%s: free list entry 0x%08X outside the pool", tp->name, (unsigned)addr);
+        TEST_CHECK(!seen[index], "%s: block %d twice on the free list", tp->name, index);
+        TEST_CHECK(!tp->owned[index], "%s: allocated block %d on the free list", tp->name, index);
+        seen[index] = 1;
+        n++;
+        TEST_CHECK(n <= tp->count, "%s: free list longer than the pool", tp->name);
+        addr = *(const uint32_t*)addr;
+    }
+
+    TEST_CHECK(n == expect, "%s: free list has %u blocks, expected %u", tp->name, (unsigned)n, (unsigned)expect);
+
+    return SUCCESS;
+}
+
+/**
+ * @brief  分配一块并与模型比较
+ * @param  tp: 被测池
+ * @retval SUCCESS/ERROR
+ */
+static error_status test_alloc(test_pool_t* tp)
+{
+    void* block = mem_pool_alloc(&tp->pool);
+    int index;
+
+    if(block == NULL)
+    {
+        TEST_CHECK(tp->used == tp->count, "%s: alloc failed with %u of %u used",
+                   tp->name, (unsigned)tp->used, (unsigned)tp->count);
+        tp->fails++;
+        return SUCCESS;
+    }
+
+    index = test_block_index(tp, block);
+    TEST_CHECK(index >= 0, "%s: alloc returned %p outside the pool", tp->name, block);
+    TEST_CHECK(!tp->owned[index], "%s: block %d allocated twice", tp->name, index);
+
+    tp->owned[index] = 1;
+    tp->used++;
+    if(tp->used > tp->high_water)
+    {
+        tp->high_water = tp->used;
+    }
+    test_block_fill(tp, index);
+
+    return SUCCESS;
+}
+
+/**
+ * @brief  随机释放一个已分配的块
+ * @param  tp: 被测池
+ * @retval SUCCESS/ERROR
+ */
+static error_status test_free(test_pool_t* tp)
+{
+    int start = rand() % tp->count;
+    int index;
+    int i;
+
+    for(i = 0; i < tp->count; i++)
+    {
+        index = (start + i) % tp->count;
+        if(tp->owned[index])
+        {
+            TEST_CHECK(mem_pool_free(&tp->pool, (void*)(tp->pool.base + (uint32_t)index * tp->pool.block_size))
+                       == SUCCESS, "%s: free of allocated block %d failed", tp->name, index);
+            tp->owned[index] = 0;
+            tp->used--;
+            return SUCCESS;
+        }
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief  检查池的计数与模型一致
+ * @param  tp: 被测池
+ * @retval SUCCESS/ERROR
+ */
+static error_status test_counters_check(const test_pool_t* tp)
+{
+    TEST_CHECK(mem_pool_used(&tp->pool) == tp->used, "%s: used %u, expected %u",
+               tp->name, (unsigned)mem_pool_used(&tp->pool), (unsigned)tp->used);
+    TEST_CHECK(mem_pool_high_water(&tp->pool) == tp->high_water, "%s: high water %u, expected %u",
+               tp->name, (unsigned)mem_pool_high_water(&tp->pool), (unsigned)tp->high_water);
+    TEST_CHECK(tp->pool.fail_count == tp->fails, "%s: fail count %u, expected %u",
+               tp->name, (unsigned)tp->pool.fail_count, (unsigned)tp->fails);
+
+    return SUCCESS;
+}
+
+/**
+ * @brief  非法释放: 重复释放、未对齐、其他池的块、NULL
+ * @param  tp: 被测池
+ * @param  other: 另一个池
+ * @retval SUCCESS/ERROR
+ */
+static error_status test_bad_free(test_pool_t* tp, test_pool_t* other)
+{
+    uint32_t bad = metrics_counters[METRIC_POOL_BAD_FREE];
+    uint8_t* block;
+    uint8_t* foreign;
+    uint32_t used;
+
+    block = mem_pool_alloc(&tp->pool);
+    foreign = mem_pool_alloc(&other->pool);
+    TEST_CHECK((block != NULL) && (foreign != NULL), "%s: setup alloc failed", tp->name);
+    used = mem_pool_used(&tp->pool);
+
+    TEST_CHECK(mem_pool_free(&tp->pool, block + 4) == ERROR, "%s: misaligned free accepted", tp->name);
+    TEST_CHECK(mem_pool_free(&tp->pool, block + tp->pool.block_size - 1) == ERROR,
+               "%s: free of last byte accepted", tp->name);
+    TEST_CHECK(mem_pool_free(&tp->pool, foreign) == ERROR, "%s: free of %s block accepted",
+               tp->name, other->name);
+    TEST_CHECK(mem_pool_free(&tp->pool, NULL) == ERROR, "%s: free of NULL accepted", tp->name);
+    TEST_CHECK(mem_pool_free(&tp->pool, (void*)(tp->pool.base + (uint32_t)tp->count * tp->pool.block_size))
+               == ERROR, "%s: free past the end accepted", tp->name);
+    TEST_CHECK(mem_pool_used(&tp->pool) == used, "%s: bad free changed used", tp->name);
+
+    TEST_CHECK(mem_pool_free(&tp->pool, block) == SUCCESS, "%s: valid free failed", tp->name);
+    TEST_CHECK(mem_pool_free(&tp->pool, block) == ERROR, "%s: double free accepted", tp->name);
+    TEST_CHECK(mem_pool_used(&tp->pool) == used - 1, "%s: double free changed used", tp->name);
+    TEST_CHECK(mem_pool_free(&other->pool, foreign) == SUCCESS, "%s: valid free failed", other->name);
+
+    TEST_CHECK(metrics_counters[METRIC_POOL_BAD_FREE] == bad + 6, "%s: BAD_FREE counted %u of 6",
+               tp->name, (unsigned)(metrics_counters[METRIC_POOL_BAD_FREE] - bad));
+
+    return SUCCESS;
+}
+
+/**
+ * @brief  初始化全部被测池
+ * @param  None
+ * @retval SUCCESS/ERROR
+ */
+static error_status test_init(void)
+{
+    test_pool_t* tp;
+    int p, i;
+
+    for(p = 0; p < TEST_POOL_NUM; p++)
+    {
+        tp = &test_pools[p];
+        TEST_CHECK((uintptr_t)tp->storage < 0x100000000ULL, "%s: storage above 4GB, link with -no-pie", tp->name);
+        mem_pool_init(&tp->pool, tp->storage, tp->size, tp->count);
+        for(i = 0; i < tp->count; i++)
+        {
+            tp->owned[i] = 0;
+        }
+        tp->used = 0;
+        tp->high_water = 0;
+        tp->fails = 0;
+        TEST_CHECK(test_free_list_check(tp, tp->count) == SUCCESS, "%s: bad free list after init", tp->name);
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief  主函数
+ * @param  argc: 参数个数
+ * @param  argv: [步数] [随机种子]
+ * @retval 0: 通过, 1: 失败
+ */
+int main(int argc, char* argv[])
+{
+    uint32_t steps = TEST_STEPS_DEFAULT;
+    uint32_t seed = 1;
+    uint32_t step;
+    test_pool_t* tp;
+    int p;
+    int bias;
+
+    if(argc > 1)
+    {
+        steps = (uint32_t)atol(argv[1]);
+    }
+    if(argc > 2)
+    {
+        seed = (uint32_t)atol(argv[2]);
+    }
+    srand(seed);
+
+    if(test_init() != SUCCESS)
+    {
+        return 1;
+    }
+
+    for(step = 0; step < steps; step++)
+    {
+        tp = &test_pools[rand() % TEST_POOL_NUM];
+
+        /* 分配倾向缓慢变化, 池在空和满之间来回 */
+        bias = ((step >> 12) & 1) ? 70 : 30;
+        if(rand() % 100 < bias)
+        {
+            if(test_alloc(tp) != SUCCESS)
+            {
+                printf("step %u (seed %u)\n", (unsigned)step, (unsigned)seed);
+                return 1;
+            }
+        }
+        else if(test_free(tp) != SUCCESS)
+        {
+            printf("step %u (seed %u)\n", (unsigned)step, (unsigned)seed);
+            return 1;
+        }
+
+        if(((step & 0x3FF) == 0) &&
+           ((test_counters_check(tp) != SUCCESS) || (test_free_list_check(tp, tp->count - tp->used) != SUCCESS)))
+        {
+            printf("step %u (seed %u)\n", (unsigned)step, (unsigned)seed);
+            return 1;
+        }
+    }
+
+    /* 全部释放后空闲链表须恢复完整 */
+    for(p = 0; p < TEST_POOL_NUM; p++)
+    {
+        tp = &test_pools[p];
+        while(tp->used > 0)
+        {
+            if(test_free(tp) != SUCCESS)
+            {
+                return 1;
+            }
+        }
+        if((test_counters_check(tp) != SUCCESS) || (tp->used != 0) || (mem_pool_used(&tp->pool) != 0) ||
+           (test_free_list_check(tp, tp->count) != SUCCESS))
+        {
+            printf("%s: pool not whole after freeing everything\n", tp->name);
+            return 1;
+        }
+    }
+
+    for(p = 0; p < TEST_POOL_NUM; p++)
+    {
+        if(test_bad_free(&test_pools[p], &test_pools[(p + 1) % TEST_POOL_NUM]) != SUCCESS)
+        {
+            return 1;
+        }
+        if(test_free_list_check(&test_pools[p], test_pools[p].count) != SUCCESS)
+        {
+            return 1;
+        }
+    }
+
+    printf("%u steps over %d pools:", (unsigned)steps, TEST_POOL_NUM);
+    for(p = 0; p < TEST_POOL_NUM; p++)
+    {
+        printf(" %s high water %u, %u failed allocs;", test_pools[p].name,
+               (unsigned)test_pools[p].high_water, (unsigned)test_pools[p].fails);
+    }
+    printf("\nbad frees rejected: %u\n", (unsigned)metrics_counters[METRIC_POOL_BAD_FREE]);
+
+    return 0;
+}
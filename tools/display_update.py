@@ -0,0 +1,444 @@
+#!/usr/bin/env python3
+"""
+display_update.py - 显示帧缓冲区远程更新 (RS485_CMD_DISPLAY_UPDATE 0xB3) 编码器和基准测试
+
+用法:
+    python3 display_update.py                                   # 内置UI画面序列上的压缩率和延迟估算
+    python3 display_update.py screens/*.pbm --baud 921600       # 录制的画面 (128x64 PBM, P1/P4)
+    python3 display_update.py screens/*.pbm --port /dev/ttyUSB0 # 发送到设备, 测量往返延迟
+
+每个画面编码为RLE完整帧或相对上一帧的XOR差分 (取较小者), 按帧长度分段:
+    B3 标志 偏移(u16) 编码数据       标志: 低2位编码 (0原始 1RLE 2XOR-RLE), 0x40整屏刷新, 0x80最后一段
+最后一段的回复为 B3 状态 CRC32(u32) 待刷新字节数(u16); CRC32与主机的帧缓冲区副本
+不一致时 (丢帧、设备复位) 下一个画面改发RLE完整帧并整屏刷新. 编码规则见 display_update.h.
+
+延迟估算 = RS485发送 (COBS编码字节 + 帧界, 每字符10位) + 回复 + I2C刷新脏列
+(每页: 窗口命令8字节 + 数据, 每字节9位, 另加地址和控制字节). 基准为每次发送1024字节原始帧并整屏刷新.
+"""
+
+import argparse
+import random
+import sys
+import time
+import zlib
+
+from fw_update import SerialLink, RS485_DEFAULT_BAUDRATE, cobs_encode
+
+RS485_CMD_DISPLAY_UPDATE = 0xB3
+RS485_FRAME_MAX_SIZE = 256
+BITS_PER_CHAR = 10
+TX_GUARD_CHARS = 1.5
+
+FB_WIDTH = 128
+FB_PAGES = 8
+FB_HEIGHT = FB_PAGES * 8
+FB_SIZE = FB_WIDTH * FB_PAGES
+
+ENC_RAW, ENC_RLE, ENC_XOR_RLE = range(3)
+UPD_FULL = 0x40
+UPD_END = 0x80
+HEADER_SIZE = 4
+SEGMENT_MAX = RS485_FRAME_MAX_SIZE - HEADER_SIZE
+
+RLE_RUN = 0x80
+RLE_RUN_MIN = 2
+RLE_RUN_MAX = 0x7F + RLE_RUN_MIN
+RLE_LITERAL_MAX = 128
+
+I2C_SPEED = 400000
+I2C_WINDOW_CMD_SIZE = 8
+I2C_XFER_OVERHEAD = 2           # 地址 + 控制字节
+REPLY_SIZE = 8
+
+
+# ---------------------------------------------------------------------------
+# 编码
+
+def rle_tokens(data):
+    """游程编码为 (编码字节, 解码长度, 是否为0的游程) 列表"""
+    tokens = []
+    i = 0
+    literal = bytearray()
+
+    def flush_literal():
+        while literal:
+            chunk = literal[:RLE_LITERAL_MAX]
+            del literal[:RLE_LITERAL_MAX]
+            tokens.append((bytes([len(chunk) - 1]) + bytes(chunk), len(chunk), False))
+
+    while i < len(data):
+        run = 1
+        while i + run < len(data) and data[i + run] == data[i] and run < RLE_RUN_MAX:
+            run += 1
+        # 2字节的游程和字面量一样长, 游程至少3个才断开字面量 (0的游程在XOR模式下可跳过, 2个即可)
+        if run >= 3 or (run == RLE_RUN_MIN and (data[i] == 0 or not literal)):
+            flush_literal()
+            tokens.append((bytes([RLE_RUN | (run - RLE_RUN_MIN), data[i]]), run, data[i] == 0))
+            i += run
+        else:
+            literal.append(data[i])
+            i += 1
+    flush_literal()
+    return tokens
+
+
+def segments(data, encoding):
+    """按帧长度分段, 返回 [(偏移, 编码数据)]; XOR模式下段首和段尾0的游程不发送"""
+    skip_zero = encoding == ENC_XOR_RLE
+    result = []
+    offset = 0
+    start = 0
+    payload = b""
+    for encoded, out_len, zero_run in rle_tokens(data):
+        if skip_zero and zero_run and not payload:
+            offset += out_len
+            start = offset
+            continue
+        if len(payload) + len(encoded) > SEGMENT_MAX:
+            result.append((start, payload))
+            start, payload = offset, b""
+            if skip_zero and zero_run:
+                offset += out_len
+                start = offset
+                continue
+        payload += encoded
+        offset += out_len
+    if payload:
+        result.append((start, payload))
+    if skip_zero:
+        result = [(off, trim_zero_runs(p)) for off, p in result]
+    return result
+
+
+def trim_zero_runs(payload):
+    """去掉段尾0的游程 (XOR模式下不改变内容)"""
+    tokens = []
+    i = 0
+    while i < len(payload):
+        ctrl = payload[i]
+        size = 2 if ctrl & RLE_RUN else ctrl + 2
+        tokens.append(payload[i:i + size])
+        i += size
+    while tokens and tokens[-1][0] & RLE_RUN and tokens[-1][1] == 0:
+        tokens.pop()
+    return b"".join(tokens)
+
+
+def encode_update(prev, cur, keyframe=False):
+    """一个画面的B3帧列表. prev为设备帧缓冲区的副本, keyframe强制RLE完整帧并整屏刷新"""
+    key = [(ENC_RLE, off, p) for off, p in segments(cur, ENC_RLE)]
+    if keyframe:
+        chosen, flags = key, UPD_FULL
+    else:
+        delta = [(ENC_XOR_RLE, off, p) for off, p in segments(bytes(a ^ b for a, b in zip(prev, cur)), ENC_XOR_RLE)]
+        chosen = delta if payload_size(delta) <= payload_size(key) else key
+        flags = 0
+    if not chosen:
+        chosen = [(ENC_XOR_RLE, 0, b"")]
+    frames = []
+    for n, (encoding, off, payload) in enumerate(chosen):
+        f = encoding | (flags | UPD_END if n == len(chosen) - 1 else 0)
+        frames.append(bytes([RS485_CMD_DISPLAY_UPDATE, f, off & 0xFF, off >> 8]) + payload)
+    return frames
+
+
+def payload_size(segs):
+    return sum(HEADER_SIZE + len(p) for _, _, p in segs)
+
+
+# ---------------------------------------------------------------------------
+# 设备模型 (与 display_update.c 的解码和脏列记录一致)
+
+class DeviceModel:
+    def __init__(self):
+        self.fb = bytearray(FB_SIZE)
+        self.dirty = [None] * FB_PAGES
+        self.error = False
+
+    def put(self, pos, value):
+        if self.fb[pos] != value:
+            self.fb[pos] = value
+            page, col = divmod(pos, FB_WIDTH)
+            lo, hi = self.dirty[page] or (col, col)
+            self.dirty[page] = (min(lo, col), max(hi, col))
+
+    def decode(self, frame):
+        flags, pos = frame[1], frame[2] | (frame[3] << 8)
+        data = frame[HEADER_SIZE:]
+        encoding = flags & 0x03
+        try:
+            if encoding == ENC_RAW:
+                if pos + len(data) > FB_SIZE:
+                    raise ValueError
+                for n, b in enumerate(data):
+                    self.put(pos + n, b)
+            else:
+                pos = self.decode_rle(data, pos, encoding == ENC_XOR_RLE)
+        except (ValueError, IndexError):
+            self.error = True
+        if not flags & UPD_END:
+            return None
+        if flags & UPD_FULL:
+            self.dirty = [(0, FB_WIDTH - 1)] * FB_PAGES
+        status, self.error = (1 if self.error else 0), False
+        return status, zlib.crc32(bytes(self.fb)), self.dirty_bytes()
+
+    def decode_rle(self, data, pos, xor_mode):
+        i = 0
+        while i < len(data):
+            ctrl = data[i]
+            i += 1
+            if ctrl & RLE_RUN:
+                count = (ctrl & 0x7F) + RLE_RUN_MIN
+                if i >= len(data) or pos + count > FB_SIZE:
+                    raise ValueError
+                value = data[i]
+                i += 1
+                if xor_mode and value == 0:
+                    pos += count
+                    continue
+                values = [value] * count
+            else:
+                count = ctrl + 1
+                if i + count > len(data) or pos + count > FB_SIZE:
+                    raise ValueError
+                values = data[i:i + count]
+                i += count
+            for v in values:
+                self.put(pos, self.fb[pos] ^ v if xor_mode else v)
+                pos += 1
+        return pos
+
+    def dirty_bytes(self):
+        return sum(hi - lo + 1 for lo, hi in filter(None, self.dirty))
+
+    def flush(self):
+        """刷新全部脏列, 返回I2C时间 (s)"""
+        bits = 0
+        for page, rng in enumerate(self.dirty):
+            if rng:
+                lo, hi = rng
+                bits += 9 * (I2C_WINDOW_CMD_SIZE + I2C_XFER_OVERHEAD) + 9 * (hi - lo + 1 + I2C_XFER_OVERHEAD) + 4
+        self.dirty = [None] * FB_PAGES
+        return bits / I2C_SPEED
+
+    def flush_full(self):
+        self.dirty = [(0, FB_WIDTH - 1)] * FB_PAGES
+        return self.flush()
+
+
+# ---------------------------------------------------------------------------
+# 画面
+
+def load_pbm(path):
+    """128x64 PBM (P1/P4) 转为页格式帧缓冲区"""
+    with open(path, "rb") as f:
+        raw = f.read()
+    fields = []
+    pos = 0
+    while len(fields) < 3:
+        while raw[pos:pos + 1].isspace():
+            pos += 1
+        if raw[pos:pos + 1] == b"#":
+            pos = raw.index(b"\n", pos)
+            continue
+        end = pos
+        while not raw[end:end + 1].isspace():
+            end += 1
+        fields.append(raw[pos:end])
+        pos = end
+    magic, width, height = fields[0], int(fields[1]), int(fields[2])
+    if (width, height) != (FB_WIDTH, FB_HEIGHT):
+        raise ValueError("%s: %dx%d, expected %dx%d" % (path, width, height, FB_WIDTH, FB_HEIGHT))
+    if magic == b"P4":
+        bits = raw[pos + 1:]
+        pixel = lambda x, y: (bits[y * (width // 8) + x // 8] >> (7 - x % 8)) & 1
+    elif magic == b"P1":
+        digits = [c for c in raw[pos:] if c in b"01"]
+        pixel = lambda x, y: digits[y * width + x] - ord("0")
+    else:
+        raise ValueError("%s: not a PBM file" % path)
+    fb = bytearray(FB_SIZE)
+    for y in range(FB_HEIGHT):
+        for x in range(FB_WIDTH):
+            if pixel(x, y):
+                fb[(y // 8) * FB_WIDTH + x] |= 1 << (y % 8)
+    return bytes(fb)
+
+
+class Canvas:
+    """生成内置UI画面用的简单画布 (5x7点阵字形按字符随机生成, 只用于统计)"""
+
+    glyphs = {}
+
+    def __init__(self):
+        self.fb = bytearray(FB_SIZE)
+
+    def set(self, x, y, on=True):
+        if 0 <= x < FB_WIDTH and 0 <= y < FB_HEIGHT:
+            bit = 1 << (y % 8)
+            if on:
+                self.fb[(y // 8) * FB_WIDTH + x] |= bit
+            else:
+                self.fb[(y // 8) * FB_WIDTH + x] &= ~bit
+
+    def rect(self, x0, y0, w, h, on=True):
+        for y in range(y0, y0 + h):
+            for x in range(x0, x0 + w):
+                self.set(x, y, on)
+
+    def text(self, x, y, s, on=True):
+        for c in s:
+            if c != " ":
+                glyph = Canvas.glyphs.setdefault(c, random.Random(ord(c)).getrandbits(35))
+                for n in range(35):
+                    if glyph >> n & 1:
+                        self.set(x + n % 5, y + n // 5, on)
+            x += 6
+
+
+def builtin_screens():
+    """状态页 (时钟走动)、菜单 (选中行移动)、进度条、滚动列表、弹出报警"""
+    screens = []
+    items = ["BAUD 115200", "ADDR 01", "CLOCK 240M", "BEEP 2000HZ", "DISPLAY OLED", "FW 1.4.2",
+             "TRACE ON", "WATCHDOG", "RESET", "ABOUT"]
+
+    for t in range(20):
+        c = Canvas()
+        c.rect(0, 0, 128, 10)
+        c.text(2, 1, "STATUS", on=False)
+        c.text(80, 1, "%02d:%02d" % (12, t), on=False)
+        c.text(2, 14, "RS485 OK   %5d" % (1200 + t * 37))
+        c.text(2, 24, "TEMP  %d.%dC" % (24 + t // 7, t % 10))
+        c.text(2, 34, "LOAD  %2d%%" % (30 + (t * 7) % 40))
+        c.rect(2, 50, 124, 1)
+        screens.append(bytes(c.fb))
+
+    for sel in list(range(6)) + list(range(5, -1, -1)):
+        c = Canvas()
+        c.text(2, 0, "SETTINGS")
+        for n, item in enumerate(items[:6]):
+            y = 9 + n * 9
+            if n == sel:
+                c.rect(0, y - 1, 128, 9)
+            c.text(4, y, item, on=(n != sel))
+        screens.append(bytes(c.fb))
+
+    for p in range(0, 101, 5):
+        c = Canvas()
+        c.text(2, 4, "UPDATING")
+        c.text(2, 16, "%3d%%" % p)
+        c.rect(2, 30, 124, 12)
+        c.rect(4, 32, 120, 8, on=False)
+        c.rect(4, 32, 120 * p // 100, 8)
+        screens.append(bytes(c.fb))
+
+    for top in range(len(items) - 5):
+        c = Canvas()
+        for n, item in enumerate(items[top:top + 6]):
+            c.text(4, 2 + n * 10, item)
+        c.rect(124, 2 + top * 8, 3, 20)
+        screens.append(bytes(c.fb))
+
+    c = Canvas()
+    c.fb[:] = screens[5]
+    c.rect(14, 14, 100, 36, on=False)
+    c.rect(14, 14, 100, 1)
+    c.rect(14, 49, 100, 1)
+    c.text(30, 26, "ALARM 3")
+    screens.append(bytes(c.fb))
+    screens.append(screens[5])
+    return screens
+
+
+# ---------------------------------------------------------------------------
+# 基准测试
+
+def wire_chars(frame, address):
+    if address is not None:
+        frame = bytes([address]) + frame
+    return len(cobs_encode(frame)) + 1
+
+
+def bench(screens, baud, address):
+    char_s = BITS_PER_CHAR / baud
+    device = DeviceModel()
+    host_fb = bytes(FB_SIZE)
+    raw_frames = [bytes([RS485_CMD_DISPLAY_UPDATE, ENC_RAW | (UPD_END if off + SEGMENT_MAX >= FB_SIZE else 0),
+                         off & 0xFF, off >> 8]) + bytes(SEGMENT_MAX) for off in range(0, FB_SIZE, SEGMENT_MAX)]
+    raw_frames[-1] = raw_frames[-1][:HEADER_SIZE + FB_SIZE % SEGMENT_MAX]
+    raw_wire = sum(wire_chars(f, address) for f in raw_frames)
+    reply_s = (TX_GUARD_CHARS + wire_chars(bytes(REPLY_SIZE), address)) * char_s
+    raw_latency = raw_wire * char_s + reply_s + DeviceModel().flush_full()
+
+    sent = wire = 0
+    latency = []
+    kinds = {ENC_RLE: 0, ENC_XOR_RLE: 0}
+    for n, screen in enumerate(screens):
+        frames = encode_update(host_fb, screen, keyframe=(n == 0))
+        for frame in frames:
+            reply = device.decode(frame)
+        status, crc, _ = reply
+        if status != 0 or crc != zlib.crc32(screen):
+            raise RuntimeError("screen %d: device model out of sync" % n)
+        host_fb = screen
+        kinds[frames[0][1] & 0x03] = kinds.get(frames[0][1] & 0x03, 0) + 1
+        chars = sum(wire_chars(f, address) for f in frames)
+        sent += sum(len(f) - HEADER_SIZE for f in frames)
+        wire += chars
+        latency.append(chars * char_s + reply_s + device.flush())
+
+    count = len(screens)
+    latency.sort()
+    print("%d screens at %d baud, I2C %d kHz" % (count, baud, I2C_SPEED // 1000))
+    print("updates:     %d RLE, %d XOR delta" % (kinds[ENC_RLE], kinds[ENC_XOR_RLE]))
+    print("payload:     %.0f bytes/screen (raw %d), ratio %.1f:1" % (sent / count, FB_SIZE, FB_SIZE * count / sent))
+    print("on the wire: %.0f chars/screen (raw %d)" % (wire / count, raw_wire))
+    print("latency:     mean %.2f ms, p50 %.2f ms, max %.2f ms (raw %.2f ms)" %
+          (1e3 * sum(latency) / count, 1e3 * latency[count // 2], 1e3 * latency[-1], 1e3 * raw_latency))
+    return 0
+
+
+def send(screens, link):
+    """发送到设备, 测量从发出第一段到收到回复的时间"""
+    host_fb = bytes(FB_SIZE)
+    keyframe = True
+    times = []
+    resync = 0
+    for n, screen in enumerate(screens):
+        frames = encode_update(host_fb, screen, keyframe)
+        start = time.monotonic()
+        for frame in frames:
+            link.send(frame)
+        reply = link.recv(1.0)
+        times.append(time.monotonic() - start)
+        if reply is None or len(reply) < 8 or reply[0] != RS485_CMD_DISPLAY_UPDATE:
+            print("screen %d: no reply" % n, file=sys.stderr)
+            keyframe, resync = True, resync + 1
+            continue
+        crc = int.from_bytes(reply[2:6], "little")
+        keyframe = reply[1] != 0 or crc != zlib.crc32(screen)
+        resync += keyframe
+        host_fb = screen
+    times.sort()
+    print("%d screens, %d resyncs; round trip mean %.2f ms, p50 %.2f ms, max %.2f ms" %
+          (len(screens), resync, 1e3 * sum(times) / len(times), 1e3 * times[len(times) // 2], 1e3 * times[-1]))
+    return 0 if resync == 0 else 1
+
+
+def main():
+    parser = argparse.ArgumentParser(description="display framebuffer update encoder and benchmark")
+    parser.add_argument("screens", nargs="*", help="128x64 PBM files in display order (default: built-in UI)")
+    parser.add_argument("--port", help="send to a device instead of the model")
+    parser.add_argument("--baud", type=int, default=RS485_DEFAULT_BAUDRATE)
+    parser.add_argument("--address", type=lambda s: int(s, 0), help="node address prefix (idle-line mode)")
+    args = parser.parse_args()
+
+    screens = [load_pbm(p) for p in args.screens] if args.screens else builtin_screens()
+    if args.port:
+        return send(screens, SerialLink(args.port, args.baud, args.address))
+    return bench(screens, args.baud, args.address)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,197 @@
+#!/usr/bin/env python3
+"""
+fault_decode.py - 解析RS485故障转储 (RS485_CMD_FAULT_DUMP)
+
+用法:
+    python3 fault_decode.py dump.bin                         # 输出寄存器、故障位和最后的跟踪事件
+    python3 fault_decode.py dump.bin -e build/firmware.elf   # 同时用 addr2line 解析 pc/lr
+
+转储为一个COBS帧: 命令字 0xAB, 版本, 有效标志, 保留, 之后为 fault_record_t (小端),
+见 fault.h.
+"""
+
+import argparse
+import shutil
+import struct
+import subprocess
+import sys
+
+from trace_decode import EVENT, EVENT_NAMES, TASK_NAMES, EVT_TASK_START, EVT_TASK_STOP, cobs_decode
+
+RS485_CMD_FAULT_DUMP = 0xAB
+FAULT_DUMP_VERSION = 1
+FAULT_TRACE_EVENTS = 16
+
+RECORD_FIELDS = (
+    "cause", "uptime_ms", "r0", "r1", "r2", "r3", "r12", "lr", "pc", "xpsr",
+    "exc_return", "sp", "cfsr", "hfsr", "mmfar", "bfar", "core_clock",
+)
+RECORD = struct.Struct("<%dIHH" % len(RECORD_FIELDS))
+
+CAUSE_NAMES = {
+    3: "HardFault",
+    4: "MemManage",
+    5: "BusFault",
+    6: "UsageFault",
+    0x100: "Error_Handler",
+}
+
+CFSR_BITS = {
+    0: "IACCVIOL: 取指访问违例",
+    1: "DACCVIOL: 数据访问违例",
+    3: "MUNSTKERR: 异常返回出栈时MemManage",
+    4: "MSTKERR: 异常进入压栈时MemManage",
+    5: "MLSPERR: 浮点惰性压栈时MemManage",
+    7: "MMARVALID: MMFAR有效",
+    8: "IBUSERR: 取指总线错误",
+    9: "PRECISERR: 精确数据总线错误",
+    10: "IMPRECISERR: 非精确数据总线错误",
+    11: "UNSTKERR: 异常返回出栈时BusFault",
+    12: "STKERR: 异常进入压栈时BusFault (栈溢出?)",
+    13: "LSPERR: 浮点惰性压栈时BusFault",
+    15: "BFARVALID: BFAR有效",
+    16: "UNDEFINSTR: 未定义指令",
+    17: "INVSTATE: 非法EPSR状态 (跳转地址最低位为0?)",
+    18: "INVPC: 非法EXC_RETURN",
+    19: "NOCP: 协处理器不可用 (FPU未使能?)",
+    24: "UNALIGNED: 非对齐访问",
+    25: "DIVBYZERO: 除零",
+}
+
+HFSR_BITS = {
+    1: "VECTTBL: 读取向量表出错",
+    30: "FORCED: 可配置故障升级为HardFault",
+    31: "DEBUGEVT: 调试事件",
+}
+
+
+def find_dump(data):
+    """返回第一个故障转储帧的内容 (不含命令字)"""
+    for encoded in data.split(b"\x00"):
+        if not encoded:
+            continue
+        try:
+            frame = cobs_decode(encoded)
+        except ValueError:
+            continue
+        if frame and frame[0] == RS485_CMD_FAULT_DUMP:
+            return frame[1:]
+    raise ValueError("fault dump frame not found")
+
+
+def parse_dump(payload):
+    """返回记录字典, 无记录时返回 None"""
+    if len(payload) < 3:
+        raise ValueError("fault dump too short")
+
+    version, valid = payload[0], payload[1]
+    if version != FAULT_DUMP_VERSION:
+        raise ValueError("unsupported fault dump version %d" % version)
+    if not valid:
+        return None
+
+    body = payload[3:]
+    if len(body) < RECORD.size + FAULT_TRACE_EVENTS * EVENT.size:
+        raise ValueError("fault record truncated")
+
+    values = RECORD.unpack_from(body, 0)
+    record = dict(zip(RECORD_FIELDS, values))
+    record["trace_count"], record["fault_count"] = values[-2:]
+
+    events = []
+    for i in range(min(record["trace_count"], FAULT_TRACE_EVENTS)):
+        events.append(EVENT.unpack_from(body, RECORD.size + i * EVENT.size))
+    record["trace"] = events
+    return record
+
+
+def decode_bits(value, names):
+    return [text for bit, text in sorted(names.items()) if value & (1 << bit)]
+
+
+def addr2line(elf, addresses):
+    tool = shutil.which("arm-none-eabi-addr2line")
+    if tool is None:
+        print("warning: arm-none-eabi-addr2line not found", file=sys.stderr)
+        return {}
+    args = [tool, "-f", "-C", "-p", "-e", elf] + ["0x%08x" % a for a in addresses]
+    lines = subprocess.run(args, capture_output=True, text=True, check=False).stdout.splitlines()
+    return dict(zip(addresses, lines))
+
+
+def print_record(record, elf=None):
+    cause = record["cause"]
+    print("cause:      %s (%d)" % (CAUSE_NAMES.get(cause, "IRQ/other"), cause))
+    print("uptime:     %d ms" % record["uptime_ms"])
+    print("faults:     %d since power-on" % record["fault_count"])
+    print("core clock: %.1f MHz" % (record["core_clock"] / 1e6))
+    print()
+
+    if cause < 0x100 and record["xpsr"] == 0:
+        print("warning: stack frame outside SRAM, registers not captured")
+
+    for row in (("r0", "r1", "r2", "r3"), ("r12", "lr", "pc", "xpsr"),
+                ("sp", "exc_return", "mmfar", "bfar")):
+        print("  ".join("%-10s 0x%08x" % (name, record[name]) for name in row))
+    print()
+
+    if elf:
+        symbols = addr2line(elf, [record["pc"], record["lr"] & ~1])
+        for name, addr in (("pc", record["pc"]), ("lr", record["lr"] & ~1)):
+            if addr in symbols:
+                print("%-3s %s" % (name, symbols[addr]))
+        print()
+
+    if cause < 0x100:
+        exc_return = record["exc_return"]
+        print("stack: %s, mode: %s" % ("PSP" if exc_return & 0x4 else "MSP",
+                                       "thread" if exc_return & 0x8 else "handler"))
+        print("CFSR 0x%08x" % record["cfsr"])
+        for text in decode_bits(record["cfsr"], CFSR_BITS):
+            print("  " + text)
+        if record["cfsr"] & (1 << 7):
+            print("  MMFAR = 0x%08x" % record["mmfar"])
+        if record["cfsr"] & (1 << 15):
+            print("  BFAR = 0x%08x" % record["bfar"])
+        print("HFSR 0x%08x" % record["hfsr"])
+        for text in decode_bits(record["hfsr"], HFSR_BITS):
+            print("  " + text)
+        print()
+
+    events = record["trace"]
+    print("last %d trace events:" % len(events))
+    if not events:
+        return
+    last = events[-1][0]
+    cycles_per_us = record["core_clock"] / 1e6 if record["core_clock"] else 1.0
+    for ts, eid, arg in events:
+        name = EVENT_NAMES.get(eid, "0x%02x" % eid)
+        if eid in (EVT_TASK_START, EVT_TASK_STOP):
+            detail = TASK_NAMES.get(arg, "%d" % arg)
+        else:
+            detail = "0x%04x" % arg
+        # 时间戳为32位周期数, 相对最后一个事件
+        delta = ((ts - last) + (1 << 31)) % (1 << 32) - (1 << 31)
+        print("  %12.2f us  %-16s %s" % (delta / cycles_per_us, name, detail))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode RS485 fault dump")
+    parser.add_argument("dump", help="raw bytes captured from RS485 (COBS frames)")
+    parser.add_argument("-e", "--elf", help="firmware ELF for addr2line")
+    args = parser.parse_args()
+
+    with open(args.dump, "rb") as f:
+        data = f.read()
+
+    record = parse_dump(find_dump(data))
+    if record is None:
+        print("no fault recorded")
+        return 0
+
+    print_record(record, args.elf)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,602 @@
+#!/usr/bin/env python3
+"""
+fw_update.py - 通过RS485更新固件 (RS485_CMD_FW_UPDATE 0xAC)
+
+用法:
+    python3 fw_update.py app.bin --port /dev/ttyUSB0                      # 115200下更新
+    python3 fw_update.py app.bin --port /dev/ttyUSB0 --fast-baud 921600   # 先协商到更高波特率
+    python3 fw_update.py app.bin --simulate --loss 0.02 --reset-at 300    # 模拟器上跑完整流程
+
+流程: (A2/A3 协商波特率) -> BEGIN -> 等待擦除 -> 按窗口发送数据块, 每个窗口最后一块
+请求确认, 按回复的位图只重发缺失的块 -> COMMIT -> REBOOT. 断线或设备复位后
+用相同参数重新 BEGIN, 从缺失的块继续. 协议见 fw_update.h / fw_update.c.
+
+--simulate 使用内置的设备模型 (暂存区/状态扇区的擦写规则、后台擦除、bootloader安装),
+可注入丢帧/错帧和中途复位, 按波特率估算传输时间. 串口需要 pyserial.
+"""
+
+import argparse
+import random
+import struct
+import sys
+import time
+import zlib
+
+from trace_decode import cobs_decode
+
+RS485_CMD_BAUD_SWITCH = 0xA2
+RS485_CMD_BAUD_CONFIRM = 0xA3
+RS485_CMD_FW_UPDATE = 0xAC
+RS485_DEFAULT_BAUDRATE = 115200
+
+OP_BEGIN, OP_DATA, OP_STATUS, OP_COMMIT, OP_ABORT, OP_REBOOT = range(6)
+
+STATUS_OK = 0
+STATUS_BUSY = 1
+STATUS_ERROR_PARAM = 2
+STATUS_ERROR_STATE = 3
+STATUS_ERROR_CRC = 4
+STATUS_ERROR_FLASH = 5
+STATUS_ERROR_VERIFY = 6
+STATUS_NAMES = ["ok", "busy", "param", "state", "crc", "flash", "verify"]
+STATUS_FATAL = (STATUS_ERROR_STATE, STATUS_ERROR_FLASH, STATUS_ERROR_VERIFY)
+
+
+def status_name(status):
+    return STATUS_NAMES[status] if status < len(STATUS_NAMES) else "0x%02x" % status
+
+DATA_ACK = 0x01
+PROGRESS = struct.Struct("<BBBHHI")
+
+# 与 flash_if.h / fw_update.h 一致
+SECTOR_SIZE = 2048
+APP_SIZE = 112 * 1024
+STAGING_SIZE = 112 * 1024
+CHUNK_SIZE = 128
+FRAME_POOL_SIZE = 8
+WINDOW = FRAME_POOL_SIZE - 2
+STATE_COMMIT_OFFSET = 0x020
+STATE_ERASED_OFFSET = 0x040
+STATE_CHUNK_OFFSET = 0x100
+SESSION_MAGIC = 0x31535746
+COMMIT_MAGIC = 0x544D4F43
+
+
+def cobs_encode(data):
+    out = bytearray()
+    block = bytearray()
+    for b in data:
+        if b == 0:
+            out.append(len(block) + 1)
+            out += block
+            block = bytearray()
+        else:
+            block.append(b)
+            if len(block) == 254:
+                out.append(255)
+                out += block
+                block = bytearray()
+    out.append(len(block) + 1)
+    out += block
+    return bytes(out)
+
+
+def session_check(size, crc, version):
+    return ~(SESSION_MAGIC ^ size ^ crc ^ version) & 0xFFFFFFFF
+
+
+class SerialLink:
+    """RS485串口, 每帧COBS编码, 以0x00分隔"""
+
+    def __init__(self, port, baud, address=None):
+        import serial
+        self.serial = serial.Serial(port, baud, timeout=0.01)
+        self.address = address
+        self.rx = bytearray()
+        self.start = time.monotonic()
+
+    @property
+    def baud(self):
+        return self.serial.baudrate
+
+    def set_baud(self, baud):
+        self.serial.flush()
+        self.serial.baudrate = baud
+
+    def send(self, frame):
+        if self.address is not None:
+            frame = bytes([self.address]) + frame
+        self.serial.write(cobs_encode(frame) + b"\x00")
+
+    def recv(self, timeout):
+        deadline = time.monotonic() + timeout
+        while time.monotonic() < deadline:
+            self.rx += self.serial.read(256)
+            while b"\x00" in self.rx:
+                encoded, _, rest = bytes(self.rx).partition(b"\x00")
+                self.rx = bytearray(rest)
+                if not encoded:
+                    continue
+                try:
+                    frame = cobs_decode(encoded)
+                except ValueError:
+                    continue
+                if self.address is not None:
+                    frame = frame[1:]
+                return frame
+        return None
+
+    def wait(self, seconds):
+        time.sleep(seconds)
+
+    def elapsed(self):
+        return time.monotonic() - self.start
+
+
+class SimDevice:
+    """fw_update.c 和 bootloader.c 的模型: Flash只能把1写成0, 擦除以扇区为单位"""
+
+    ERASE_SECONDS = 0.030       # 一个2KB扇区的擦除时间
+    PROGRAM_SECONDS = 0.0015    # 写一个128字节块
+
+    def __init__(self, app_image):
+        self.app = bytearray(app_image.ljust(APP_SIZE, b"\xff"))
+        self.staging = bytearray(b"\xa5" * STAGING_SIZE)  # 上次更新留下的内容
+        self.state = bytearray(b"\xff" * SECTOR_SIZE)
+        self.busy_until = 0.0
+        self.reboot_pending = False
+        self.reboots = 0
+        self.scan()
+
+    # --- Flash ---
+    def state_u32(self, offset):
+        return struct.unpack_from("<I", self.state, offset)[0]
+
+    def program(self, buf, offset, data):
+        for i, b in enumerate(data):
+            if buf[offset + i] != 0xFF and buf[offset + i] != b:
+                return False
+            buf[offset + i] = b
+        return True
+
+    def mark(self, offset):
+        return self.program(self.state, offset, b"\x00\x00")
+
+    def marked(self, offset):
+        return self.state[offset] == 0 and self.state[offset + 1] == 0
+
+    # --- fw_update.c ---
+    def scan(self):
+        magic, size, crc, version, check = struct.unpack_from("<5I", self.state, 0)
+        self.active = (magic == SESSION_MAGIC and check == session_check(size, crc, version) and
+                       0 < size <= STAGING_SIZE and size % 4 == 0)
+        self.error = STATUS_OK
+        if not self.active:
+            self.size = self.crc = self.version = 0
+            self.chunks = self.sectors = self.erased = self.done = self.next = 0
+            return
+        self.size, self.crc, self.version = size, crc, version
+        self.chunks = (size + CHUNK_SIZE - 1) // CHUNK_SIZE
+        self.sectors = (size + SECTOR_SIZE - 1) // SECTOR_SIZE
+        self.erased = 0
+        while self.erased < self.sectors and self.marked(STATE_ERASED_OFFSET + 2 * self.erased):
+            self.erased += 1
+        done = [self.chunk_done(i) for i in range(self.chunks)]
+        self.done = sum(done)
+        self.next = done.index(False) if False in done else self.chunks
+
+    def chunk_done(self, index):
+        return self.marked(STATE_CHUNK_OFFSET + 2 * index)
+
+    def progress(self, op, status=STATUS_OK):
+        if status == STATUS_OK:
+            if self.error != STATUS_OK:
+                status = self.error
+            elif not self.active:
+                status = STATUS_ERROR_STATE
+            elif self.erased < self.sectors:
+                status = STATUS_BUSY
+        self.error = STATUS_OK
+        bitmap = 0
+        for i in range(32):
+            if self.next + i >= self.chunks:
+                break
+            if self.chunk_done(self.next + i):
+                bitmap |= 1 << i
+        return PROGRESS.pack(RS485_CMD_FW_UPDATE, op, status, self.next, self.done, bitmap)
+
+    def handle(self, frame, now):
+        """处理一帧, 返回回复 (或 None)"""
+        if len(frame) < 2 or frame[0] != RS485_CMD_FW_UPDATE:
+            return None
+        op = frame[1]
+        if op == OP_BEGIN:
+            return self.begin(frame)
+        if op == OP_DATA:
+            return self.data(frame, now)
+        if op == OP_STATUS:
+            return self.progress(OP_STATUS)
+        if op == OP_COMMIT:
+            return self.commit()
+        if op == OP_ABORT:
+            self.state = bytearray(b"\xff" * SECTOR_SIZE)
+            self.scan()
+            return bytes([RS485_CMD_FW_UPDATE, OP_ABORT, STATUS_OK])
+        if op == OP_REBOOT:
+            self.reboot_pending = True
+            return bytes([RS485_CMD_FW_UPDATE, OP_REBOOT, STATUS_OK])
+        return self.progress(op, STATUS_ERROR_PARAM)
+
+    def begin(self, frame):
+        status = STATUS_OK
+        size, crc, version = struct.unpack_from("<3I", frame, 2) if len(frame) >= 14 else (0, 0, 0)
+        if not (0 < size <= STAGING_SIZE and size % 4 == 0):
+            status = STATUS_ERROR_PARAM
+        elif not self.active or (self.size, self.crc, self.version) != (size, crc, version):
+            self.state = bytearray(b"\xff" * SECTOR_SIZE)
+            struct.pack_into("<5I", self.state, 0, SESSION_MAGIC, size, crc, version,
+                             session_check(size, crc, version))
+            self.scan()
+        self.error = STATUS_OK
+        return self.progress(OP_BEGIN, status) + struct.pack("<HB", CHUNK_SIZE, WINDOW)
+
+    def data(self, frame, now):
+        flags, index, crc = struct.unpack_from("<BHI", frame, 2)
+        data = frame[9:]
+        status = STATUS_OK
+        offset = index * CHUNK_SIZE
+        if not self.active:
+            status = STATUS_ERROR_STATE
+        elif index >= self.chunks or len(data) != min(CHUNK_SIZE, self.size - offset):
+            status = STATUS_ERROR_PARAM
+        elif zlib.crc32(data) ^ index != crc:
+            status = STATUS_ERROR_CRC
+        elif index // (SECTOR_SIZE // CHUNK_SIZE) >= self.erased:
+            status = STATUS_BUSY
+        elif not self.chunk_done(index):
+            if not self.program(self.staging, offset, data):
+                status = STATUS_ERROR_FLASH
+            elif not self.mark(STATE_CHUNK_OFFSET + 2 * index):
+                status = STATUS_ERROR_FLASH
+            else:
+                self.done += 1
+                while self.next < self.chunks and self.chunk_done(self.next):
+                    self.next += 1
+            self.busy_until = max(self.busy_until, now) + self.PROGRAM_SECONDS
+        if status not in (STATUS_OK, STATUS_BUSY):
+            self.error = status
+        return self.progress(OP_DATA) if flags & DATA_ACK else None
+
+    def commit(self):
+        status = STATUS_OK
+        if not self.active or self.done != self.chunks:
+            status = STATUS_ERROR_STATE
+        elif zlib.crc32(bytes(self.staging[:self.size])) != self.crc:
+            status = STATUS_ERROR_VERIFY
+        elif self.state_u32(STATE_COMMIT_OFFSET) != COMMIT_MAGIC:
+            if not self.program(self.state, STATE_COMMIT_OFFSET, struct.pack("<I", COMMIT_MAGIC)):
+                status = STATUS_ERROR_FLASH
+        return bytes([RS485_CMD_FW_UPDATE, OP_COMMIT, status])
+
+    def poll(self, now, line_idle):
+        """主循环: 总线空闲时擦除一个暂存区扇区"""
+        if self.reboot_pending:
+            self.reset(bootloader=True)
+            return
+        if now < self.busy_until or not line_idle:
+            return
+        if self.active and self.erased < self.sectors:
+            start = self.erased * SECTOR_SIZE
+            self.staging[start:start + SECTOR_SIZE] = b"\xff" * SECTOR_SIZE
+            self.mark(STATE_ERASED_OFFSET + 2 * self.erased)
+            self.erased += 1
+            self.busy_until = now + self.ERASE_SECONDS
+
+    def reset(self, bootloader=False, torn_chunk=None):
+        """复位: RAM状态丢失, 从状态扇区恢复. torn_chunk 模拟块已写入但完成标记未写"""
+        if torn_chunk is not None and self.active and torn_chunk < self.chunks and \
+                not self.chunk_done(torn_chunk) and torn_chunk // (SECTOR_SIZE // CHUNK_SIZE) < self.erased:
+            offset = torn_chunk * CHUNK_SIZE
+            self.program(self.staging, offset, self.image[offset:offset + CHUNK_SIZE])
+        self.reboot_pending = False
+        self.reboots += 1
+        if bootloader:
+            self.bootloader()
+        self.scan()
+
+    # --- bootloader.c ---
+    def bootloader(self):
+        magic, size, crc, version, check = struct.unpack_from("<5I", self.state, 0)
+        pending = (magic == SESSION_MAGIC and check == session_check(size, crc, version) and
+                   0 < size <= APP_SIZE and self.state_u32(STATE_COMMIT_OFFSET) == COMMIT_MAGIC)
+        if not pending:
+            return
+        if zlib.crc32(bytes(self.staging[:size])) == crc:
+            self.app[:size] = self.staging[:size]
+            if zlib.crc32(bytes(self.app[:size])) != crc:
+                return
+        self.state = bytearray(b"\xff" * SECTOR_SIZE)
+
+
+class SimLink:
+    """模拟半双工总线: 按波特率计时, 可丢帧、错帧和在第N个数据帧后复位设备"""
+
+    def __init__(self, device, baud, loss=0.0, reset_at=None, seed=1):
+        self.device = device
+        self.baud = baud
+        self.loss = loss
+        self.reset_at = reset_at
+        self.random = random.Random(seed)
+        self.now = 0.0
+        self.replies = []
+        self.data_frames = 0
+        self.pending_baud = None
+
+    def wire_time(self, frame):
+        return (len(cobs_encode(frame)) + 1) * 10.0 / self.baud
+
+    def set_baud(self, baud):
+        self.baud = baud
+
+    def corrupt(self, frame):
+        if self.loss and self.random.random() < self.loss:
+            if self.random.random() < 0.5:
+                return None
+            frame = bytearray(frame)
+            frame[self.random.randrange(len(frame))] ^= 0x10
+            return bytes(frame)
+        return frame
+
+    def send(self, frame):
+        self.now += self.wire_time(frame)
+        self.device.poll(self.now, line_idle=False)
+
+        if frame[0] == RS485_CMD_FW_UPDATE and frame[1] == OP_DATA:
+            self.data_frames += 1
+            if self.reset_at is not None and self.data_frames == self.reset_at:
+                # 设备在此帧写入后、写完成标记前复位, 窗口内其余帧丢失
+                index = struct.unpack_from("<H", frame, 3)[0]
+                self.device.reset(torn_chunk=index)
+                self.replies.clear()
+                return
+
+        frame = self.corrupt(frame)
+        if frame is None:
+            return
+
+        if frame[0] == RS485_CMD_BAUD_SWITCH:
+            self.pending_baud = struct.unpack_from("<I", frame, 1)[0]
+            reply = struct.pack("<BBI", RS485_CMD_BAUD_SWITCH, 0, self.pending_baud)
+        elif frame[0] == RS485_CMD_BAUD_CONFIRM:
+            reply = bytes([RS485_CMD_BAUD_CONFIRM, 0 if self.pending_baud == self.baud else 1])
+        else:
+            reply = self.device.handle(frame, self.now)
+        if reply is not None:
+            self.replies.append(reply)
+
+    def recv(self, timeout):
+        # 回复在设备处理完排队的帧之后发出
+        self.now = max(self.now, self.device.busy_until)
+        if not self.replies:
+            self.now += timeout
+            self.device.poll(self.now, line_idle=True)
+            return None
+        reply = self.replies.pop(0)
+        self.now += self.wire_time(reply)
+        reply = self.corrupt(reply)
+        self.device.poll(self.now, line_idle=True)
+        return reply
+
+    def wait(self, seconds):
+        end = self.now + seconds
+        while self.now < end:
+            self.device.poll(self.now, line_idle=True)
+            self.now = max(self.now + 0.001, min(end, self.device.busy_until))
+
+    def elapsed(self):
+        return self.now
+
+
+class Updater:
+    def __init__(self, link, image, version, verbose=False):
+        # 映像按4字节补齐 (擦除值0xFF)
+        self.image = image + b"\xff" * (-len(image) % 4)
+        self.crc = zlib.crc32(self.image)
+        self.version = version
+        self.link = link
+        self.verbose = verbose
+        self.chunks = (len(self.image) + CHUNK_SIZE - 1) // CHUNK_SIZE
+        self.window = WINDOW
+        self.done = set()
+        self.sent = 0
+        self.retransmits = 0
+        self.restarted = False
+
+    def log(self, text):
+        if self.verbose:
+            print("[%8.3fs] %s" % (self.link.elapsed(), text))
+
+    def request(self, frame, expect, timeout=0.5, retries=5):
+        for _ in range(retries):
+            self.link.send(frame)
+            reply = self.link.recv(timeout)
+            if not reply or len(reply) < 2 or reply[0] != expect[0] or reply[1] != expect[1]:
+                continue
+            # 帧本身没有校验, 状态字节损坏的回复当作丢失
+            if reply[0] == RS485_CMD_FW_UPDATE and (len(reply) < 3 or reply[2] >= len(STATUS_NAMES)):
+                continue
+            return reply
+        raise RuntimeError("no reply to %s" % frame[:2].hex())
+
+    def negotiate(self, baud):
+        """A2 请求切换, 在新波特率下 A3 确认; 失败则留在原波特率"""
+        old = self.link.baud
+        try:
+            reply = self.request(struct.pack("<BI", RS485_CMD_BAUD_SWITCH, baud),
+                                 (RS485_CMD_BAUD_SWITCH, 0), retries=2)
+        except RuntimeError:
+            return old
+        self.link.wait(0.005)
+        self.link.set_baud(baud)
+        try:
+            self.request(bytes([RS485_CMD_BAUD_CONFIRM]), (RS485_CMD_BAUD_CONFIRM, 0), retries=2)
+        except RuntimeError:
+            self.link.set_baud(old)
+            self.link.wait(0.6)
+            return old
+        actual = struct.unpack_from("<I", reply, 2)[0]
+        self.log("baud %d -> %d (actual %d)" % (old, baud, actual))
+        return baud
+
+    def apply_progress(self, reply):
+        _, _, status, next_missing, done, bitmap = PROGRESS.unpack_from(reply, 0)
+        for i in range(next_missing):
+            self.done.add(i)
+        for i in range(32):
+            if bitmap & (1 << i):
+                self.done.add(next_missing + i)
+            else:
+                self.done.discard(next_missing + i)
+        return status
+
+    def begin(self, retries=3):
+        frame = struct.pack("<BBIII", RS485_CMD_FW_UPDATE, OP_BEGIN, len(self.image), self.crc, self.version)
+        for _ in range(retries):
+            reply = self.request(frame, (RS485_CMD_FW_UPDATE, OP_BEGIN))
+            if len(reply) < PROGRESS.size + 3:
+                continue
+            status = self.apply_progress(reply)
+            chunk_size, window = struct.unpack_from("<HB", reply, PROGRESS.size)
+            # 参数错误或块大小不符可能是帧在总线上损坏, 重试几次
+            if status == STATUS_ERROR_PARAM or chunk_size != CHUNK_SIZE or not 0 < window <= WINDOW:
+                continue
+            if status in STATUS_FATAL:
+                raise RuntimeError("begin failed: %s" % status_name(status))
+            self.window = window
+            self.log("begin: %d bytes, %d chunks, %d already done, window %d" %
+                     (len(self.image), self.chunks, len(self.done), window))
+            return status
+        raise RuntimeError("begin rejected (device chunk size %d, status %s)" % (chunk_size, status_name(status)))
+
+    def wait_ready(self, status):
+        while status == STATUS_BUSY:
+            self.link.wait(0.05)
+            status = self.apply_progress(self.request(bytes([RS485_CMD_FW_UPDATE, OP_STATUS]),
+                                                      (RS485_CMD_FW_UPDATE, OP_STATUS)))
+        return status
+
+    def data_frame(self, index, ack):
+        data = self.image[index * CHUNK_SIZE:(index + 1) * CHUNK_SIZE]
+        return struct.pack("<BBBHI", RS485_CMD_FW_UPDATE, OP_DATA, DATA_ACK if ack else 0,
+                           index, zlib.crc32(data) ^ index) + data
+
+    def transfer(self):
+        self.wait_ready(self.begin())
+        while True:
+            self.send_missing()
+            # 帧没有校验, 损坏的确认可能把缺失的块报成已完成: 提交前向设备核对
+            reply = self.request(bytes([RS485_CMD_FW_UPDATE, OP_STATUS]), (RS485_CMD_FW_UPDATE, OP_STATUS))
+            _, _, _, next_missing, done, _ = PROGRESS.unpack_from(reply, 0)
+            if next_missing == self.chunks and done == self.chunks:
+                return
+            self.log("device reports %d/%d chunks, continuing" % (done, self.chunks))
+            self.done.clear()
+            self.apply_progress(reply)
+
+    def send_missing(self):
+        while len(self.done) < self.chunks:
+            missing = [i for i in range(self.chunks) if i not in self.done][:self.window]
+            for n, index in enumerate(missing):
+                self.link.send(self.data_frame(index, n == len(missing) - 1))
+                self.sent += 1
+            reply = self.link.recv(0.2)
+            if reply is None or len(reply) < PROGRESS.size or reply[0] != RS485_CMD_FW_UPDATE:
+                # 确认丢失或设备复位: 用相同参数重新 BEGIN, 设备保留进度
+                self.log("no ack, resuming")
+                self.wait_ready(self.begin())
+                continue
+            status = self.apply_progress(reply)
+            self.retransmits += sum(1 for i in missing if i not in self.done)
+            if status == STATUS_BUSY:
+                self.wait_ready(status)
+            elif status == STATUS_ERROR_FLASH and not self.restarted:
+                # 暂存区里有与映像不符的内容 (上次的会话被擦除标记欺骗), 重新开始一次
+                self.log("flash error, restarting session")
+                self.restarted = True
+                self.request(bytes([RS485_CMD_FW_UPDATE, OP_ABORT]), (RS485_CMD_FW_UPDATE, OP_ABORT))
+                self.done.clear()
+                self.wait_ready(self.begin())
+            elif status in STATUS_FATAL:
+                # CRC/参数错误 (帧在总线上损坏) 不致命, 缺失的块按位图重发
+                raise RuntimeError("transfer failed: %s" % status_name(status))
+
+    def commit(self, reboot):
+        # 提交可重复执行, 状态损坏的回复再问一次
+        for _ in range(3):
+            reply = self.request(bytes([RS485_CMD_FW_UPDATE, OP_COMMIT]), (RS485_CMD_FW_UPDATE, OP_COMMIT), timeout=1.0)
+            if reply[2] == STATUS_OK:
+                break
+        if reply[2] != STATUS_OK:
+            raise RuntimeError("commit failed: %s" % status_name(reply[2]))
+        self.log("committed, crc %08x" % self.crc)
+        if reboot:
+            self.request(bytes([RS485_CMD_FW_UPDATE, OP_REBOOT]), (RS485_CMD_FW_UPDATE, OP_REBOOT))
+            self.log("rebooting into bootloader")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="RS485 firmware update")
+    parser.add_argument("image", help="application binary (linked at 0x08004000)")
+    parser.add_argument("--port", help="serial port")
+    parser.add_argument("--baud", type=int, default=RS485_DEFAULT_BAUDRATE, help="current device baud rate")
+    parser.add_argument("--fast-baud", type=int, help="negotiate this baud rate before the transfer")
+    parser.add_argument("--address", type=lambda s: int(s, 0), help="node address prefix (idle-line mode)")
+    parser.add_argument("--version", type=lambda s: int(s, 0), default=0, help="image version tag")
+    parser.add_argument("--no-reboot", action="store_true", help="commit only, install on next reset")
+    parser.add_argument("--simulate", action="store_true", help="run against the built-in device model")
+    parser.add_argument("--loss", type=float, default=0.0, help="simulated frame loss/corruption rate")
+    parser.add_argument("--reset-at", type=int, help="simulate a device reset after N data frames")
+    parser.add_argument("--seed", type=int, default=1)
+    parser.add_argument("-v", "--verbose", action="store_true")
+    args = parser.parse_args()
+
+    with open(args.image, "rb") as f:
+        image = f.read()
+    if len(image) > APP_SIZE:
+        print("image too large: %d > %d" % (len(image), APP_SIZE), file=sys.stderr)
+        return 1
+
+    device = None
+    if args.simulate:
+        device = SimDevice(b"\x00" * 1024)
+        link = SimLink(device, args.baud, args.loss, args.reset_at, args.seed)
+    elif args.port:
+        link = SerialLink(args.port, args.baud, args.address)
+    else:
+        parser.error("--port or --simulate required")
+
+    updater = Updater(link, image, args.version, args.verbose)
+    if device is not None:
+        device.image = updater.image
+
+    if args.fast_baud and args.fast_baud != link.baud:
+        updater.negotiate(args.fast_baud)
+
+    start = link.elapsed()
+    updater.transfer()
+    transfer_time = link.elapsed() - start
+    updater.commit(not args.no_reboot)
+
+    print("%d bytes in %.2fs (%.1f KB/s at %d baud), %d data frames, %d retransmitted" %
+          (len(updater.image), transfer_time, len(updater.image) / 1024.0 / max(transfer_time, 1e-9),
+           link.baud, updater.sent, updater.retransmits))
+
+    if device is not None and not args.no_reboot:
+        ok = bytes(device.app[:len(updater.image)]) == updater.image and not device.active
+        print("simulated install: %s (%d device resets)" % ("ok" if ok else "FAILED", device.reboots))
+        return 0 if ok else 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
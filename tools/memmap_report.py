@@ -0,0 +1,185 @@
+#!/usr/bin/env python3
+"""
+memmap_report.py - 根据GNU ld生成的 .map 文件报告各段布局 (构建后步骤)
+
+用法:
+    python3 memmap_report.py app.map                    # 输出区域占用和SRAM代码/DMA缓冲区清单
+    python3 memmap_report.py app.map --max-ramfunc 4096 # SRAM代码超过预算时返回1
+
+链接时加 -Wl,-Map=app.map. 段名约定见 AT32F403AxC_FLASH.ld 和 memmap.h:
+.data 中 _sramfunc~_eramfunc 为复制到SRAM执行的代码, .bss 中
+_sdma_buffer~_edma_buffer 为DMA缓冲区.
+"""
+
+import argparse
+import re
+import sys
+from collections import defaultdict
+
+REGION_RE = re.compile(r"^(\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)")
+OUTPUT_RE = re.compile(r"^(\.\S+)(?:\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)(?:\s+load address 0x([0-9a-fA-F]+))?)?\s*$")
+INPUT_RE = re.compile(r"^ (\.\S+|COMMON)(?:\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(.+))?\s*$")
+CONT_RE = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(.+)$")
+SYMBOL_RE = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+([A-Za-z_]\w*)\s*$")
+ASSIGN_RE = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+([A-Za-z_]\w*)\s*=")
+
+
+def parse_map(text):
+    """返回 (regions, outputs, symbols); outputs为输出段列表, 每个含输入段列表"""
+    regions = []
+    outputs = []
+    symbols = {}
+    lines = text.splitlines()
+    i = 0
+
+    # 内存区域表
+    while i < len(lines) and not lines[i].startswith("Memory Configuration"):
+        i += 1
+    i += 1
+    while i < len(lines) and not lines[i].startswith("Linker script and memory map"):
+        m = REGION_RE.match(lines[i])
+        if m and m.group(1) not in ("Name", "*default*"):
+            regions.append({"name": m.group(1), "origin": int(m.group(2), 16), "length": int(m.group(3), 16)})
+        i += 1
+
+    current = None
+    pending = None
+    for line in lines[i:]:
+        if pending is not None:
+            # 段名过长时地址和大小折到下一行
+            m = CONT_RE.match(line)
+            if m:
+                add_input(current, pending, int(m.group(1), 16), int(m.group(2), 16), m.group(3))
+            pending = None
+            continue
+
+        m = OUTPUT_RE.match(line)
+        if m and m.group(2):
+            current = {
+                "name": m.group(1),
+                "addr": int(m.group(2), 16),
+                "size": int(m.group(3), 16),
+                "load": int(m.group(4), 16) if m.group(4) else int(m.group(2), 16),
+                "inputs": [],
+            }
+            outputs.append(current)
+            continue
+        if m:
+            current = {"name": m.group(1), "addr": None, "size": 0, "load": None, "inputs": []}
+            outputs.append(current)
+            pending = None
+            continue
+
+        if current is None:
+            continue
+
+        m = INPUT_RE.match(line)
+        if m:
+            if m.group(2):
+                add_input(current, m.group(1), int(m.group(2), 16), int(m.group(3), 16), m.group(4))
+            else:
+                pending = m.group(1)
+            continue
+
+        m = ASSIGN_RE.match(line) or SYMBOL_RE.match(line)
+        if m:
+            symbols[m.group(2)] = int(m.group(1), 16)
+            if current["inputs"] and SYMBOL_RE.match(line):
+                current["inputs"][-1]["symbols"].append(m.group(2))
+
+    return regions, outputs, symbols
+
+
+def add_input(output, name, addr, size, obj):
+    if output is None or size == 0:
+        return
+    output["inputs"].append({"name": name, "addr": addr, "size": size, "obj": obj.strip(), "symbols": []})
+
+
+def short_obj(obj):
+    # "libfoo.a(bar.o)" 或路径 -> 文件名
+    m = re.search(r"\(([^)]+)\)$", obj)
+    if m:
+        return m.group(1)
+    return re.split(r"[\\/]", obj)[-1]
+
+
+def region_of(regions, addr):
+    for r in regions:
+        if r["origin"] <= addr < r["origin"] + r["length"]:
+            return r["name"]
+    return None
+
+
+def print_regions(regions, outputs):
+    used = defaultdict(int)
+    for out in outputs:
+        if out["addr"] is None or out["size"] == 0:
+            continue
+        run = region_of(regions, out["addr"])
+        load = region_of(regions, out["load"])
+        if run:
+            used[run] += out["size"]
+        if load and load != run:
+            used[load] += out["size"]
+
+    print("region        origin      used /   size")
+    for r in regions:
+        pct = 100.0 * used[r["name"]] / r["length"] if r["length"] else 0.0
+        print("%-12s 0x%08x %7d / %6d (%5.1f%%)" % (r["name"], r["origin"], used[r["name"]], r["length"], pct))
+    print()
+
+
+def print_range(title, outputs, start, end):
+    """列出 [start, end) 内的输入段, 返回总大小"""
+    total = 0
+    rows = []
+    for out in outputs:
+        for inp in out["inputs"]:
+            if start <= inp["addr"] < end:
+                # static 函数/变量不出现在map中, 段名一并列出
+                name = inp["name"] + (" " + ",".join(inp["symbols"]) if inp["symbols"] else "")
+                rows.append((inp["addr"], inp["size"], name, short_obj(inp["obj"])))
+                total += inp["size"]
+
+    print("%s: %d bytes" % (title, total))
+    for addr, size, name, obj in sorted(rows):
+        print("  0x%08x %6d  %-48s %s" % (addr, size, name, obj))
+    print()
+    return total
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Report section placement from a GNU ld map file")
+    parser.add_argument("map", help="linker map file (-Wl,-Map=...)")
+    parser.add_argument("--max-ramfunc", type=int, help="fail if SRAM code exceeds this many bytes")
+    args = parser.parse_args()
+
+    with open(args.map, "r", errors="replace") as f:
+        regions, outputs, symbols = parse_map(f.read())
+
+    print_regions(regions, outputs)
+
+    print("section            address     size   load")
+    for out in outputs:
+        if out["addr"] is None or out["size"] == 0 or region_of(regions, out["addr"]) is None:
+            continue
+        print("%-16s 0x%08x %7d   0x%08x" % (out["name"], out["addr"], out["size"], out["load"]))
+    print()
+
+    ramfunc = 0
+    if "_sramfunc" in symbols and "_eramfunc" in symbols:
+        ramfunc = print_range("SRAM code (.ramfunc)", outputs, symbols["_sramfunc"], symbols["_eramfunc"])
+    else:
+        print("warning: _sramfunc/_eramfunc not found, not linked with AT32F403AxC_FLASH.ld?", file=sys.stderr)
+
+    if "_sdma_buffer" in symbols and "_edma_buffer" in symbols:
+        print_range("DMA buffers (.dma_buffer)", outputs, symbols["_sdma_buffer"], symbols["_edma_buffer"])
+
+    if args.max_ramfunc is not None and ramfunc > args.max_ramfunc:
+        print("error: SRAM code %d bytes exceeds budget %d" % (ramfunc, args.max_ramfunc), file=sys.stderr)
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
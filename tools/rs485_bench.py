@@ -0,0 +1,185 @@
+#!/usr/bin/env python3
+"""
+rs485_bench.py - RS485连续请求吞吐量测试 (饱和主站)
+
+用法:
+    python3 rs485_bench.py --port /dev/ttyUSB0                     # 每批6帧echo, 测10秒
+    python3 rs485_bench.py --port /dev/ttyUSB0 --burst 8 --size 32 --seconds 30
+    python3 rs485_bench.py --simulate --baud 921600 --proc-us 40   # 设备时序模型
+
+主站不等回复, 一次连续发出一批 echo (B2) 请求, 再收齐这一批的回复, 如此循环.
+设备在主站停止发送 (空闲1.5字符) 后才回复, 回复在上一帧发送结束时由中断接着发送,
+一批回复之间没有收发切换. 报告每秒完成的请求数, 以及按线路速率计算的上限
+(请求和回复的COBS编码字节 + 帧界 + 地址字节, 每字符10位) 和达到上限的比例.
+
+--simulate 用简化的设备时序模型比较两种处理方式:
+    single: 每次主循环处理1帧, 单发送缓冲区 (编码下一帧回复须等上一帧发完)
+    batch:  每次主循环处理队列中所有帧, 双发送缓冲区, 回复在中断中接着发送
+模型参数: 每帧解析+处理+编码时间 --proc-us, 主循环其他任务时间 --loop-us, 主机收到最后
+一帧回复到发出下一批的延时 --host-us. 设备端的批处理峰值和接着发送帧数可用 A1 命令查询.
+"""
+
+import argparse
+import os
+import struct
+import sys
+import time
+
+from fw_update import SerialLink, RS485_DEFAULT_BAUDRATE, cobs_encode
+
+RS485_CMD_ECHO = 0xB2
+BITS_PER_CHAR = 10
+FRAME_POOL_SIZE = 8
+TX_GUARD_CHARS = 1.5
+DE_SETTLE_MIN_US = 2
+
+
+def wire_chars(frame, addressed):
+    """一帧在线路上的字符数 (COBS编码 + 帧界 + 地址字节)"""
+    if addressed:
+        frame = b"\x00" + frame
+    return len(cobs_encode(frame)) + 1
+
+
+def line_limit(baud, burst, size, addressed):
+    """线路速率决定的每秒请求数上限 (每批一次收发切换和回复保护时间)"""
+    char_us = BITS_PER_CHAR * 1e6 / baud
+    request = wire_chars(bytes([RS485_CMD_ECHO]) + bytes(size), addressed)
+    reply = wire_chars(bytes([RS485_CMD_ECHO, 0]) + bytes(size), addressed)
+    turnaround = max(1e6 / baud, DE_SETTLE_MIN_US)
+    burst_us = burst * (request + reply) * char_us + TX_GUARD_CHARS * char_us + turnaround
+    return burst * 1e6 / burst_us
+
+
+def make_request(seq, size):
+    payload = struct.pack("<I", seq) + os.urandom(max(size - 4, 0))
+    return bytes([RS485_CMD_ECHO]) + payload[:size]
+
+
+def run_burst(link, seq, burst, size, timeout):
+    """发出一批请求, 收齐回复. 返回 (成功数, 丢失或错误数)"""
+    requests = [make_request(seq + i, size) for i in range(burst)]
+    data = b""
+    for frame in requests:
+        if link.address is not None:
+            frame = bytes([link.address]) + frame
+        data += cobs_encode(frame) + b"\x00"
+    link.serial.write(data)
+
+    ok = 0
+    expected = {req[1:]: req for req in requests}
+    for _ in range(burst):
+        reply = link.recv(timeout)
+        if reply is None:
+            break
+        if len(reply) >= 2 and reply[0] == RS485_CMD_ECHO and reply[1] == 0 and reply[2:] in expected:
+            del expected[reply[2:]]
+            ok += 1
+    return ok, burst - ok
+
+
+def bench(args):
+    link = SerialLink(args.port, args.baud, args.address)
+    timeout = max(0.05, 20.0 * burst_chars(args) * BITS_PER_CHAR / args.baud)
+    done = lost = seq = 0
+    start = time.monotonic()
+    while time.monotonic() - start < args.seconds:
+        ok, failed = run_burst(link, seq, args.burst, args.size, timeout)
+        done += ok
+        lost += failed
+        seq += args.burst
+        if failed:
+            link.wait(timeout)
+            link.serial.reset_input_buffer()
+            link.rx.clear()
+    elapsed = time.monotonic() - start
+
+    limit = line_limit(args.baud, args.burst, args.size, args.address is not None)
+    rate = done / elapsed
+    print("baud %d, burst %d, payload %d bytes" % (args.baud, args.burst, args.size))
+    print("requests: %d ok, %d lost in %.1f s" % (done, lost, elapsed))
+    print("rate:     %.0f req/s (line limit %.0f req/s, %.0f%%)" % (rate, limit, 100.0 * rate / limit))
+    return 0 if lost == 0 else 1
+
+
+def burst_chars(args):
+    addressed = args.address is not None
+    request = wire_chars(bytes([RS485_CMD_ECHO]) + bytes(args.size), addressed)
+    reply = wire_chars(bytes([RS485_CMD_ECHO, 0]) + bytes(args.size), addressed)
+    return args.burst * (request + reply)
+
+
+def simulate_burst(args, batch):
+    """一批请求从第一个字节发出到最后一帧回复收完的时间 (us)"""
+    char_us = BITS_PER_CHAR * 1e6 / args.baud
+    turnaround = max(1e6 / args.baud, DE_SETTLE_MIN_US)
+    addressed = args.address is not None
+    request = wire_chars(bytes([RS485_CMD_ECHO]) + bytes(args.size), addressed) * char_us
+    reply = wire_chars(bytes([RS485_CMD_ECHO, 0]) + bytes(args.size), addressed) * char_us
+
+    arrive = [(i + 1) * request for i in range(args.burst)]
+    quiet = arrive[-1] + TX_GUARD_CHARS * char_us
+    start = [0.0] * args.burst
+    end = [0.0] * args.burst
+
+    t = 0.0
+    i = 0
+    while i < args.burst:
+        limit = FRAME_POOL_SIZE if batch else 1
+        handled = 0
+        while i < args.burst and handled < limit and arrive[i] <= t:
+            t += args.proc_us
+            if i > 0:
+                # 双缓冲: 上一帧开始发送后缓冲区即可用; 单缓冲: 须等上一帧发完
+                t = max(t, start[i - 1] if batch else end[i - 1])
+            if i > 0 and end[i - 1] > t:
+                start[i] = end[i - 1]           # 上一帧还在发送: 结束时接着发送
+            else:
+                start[i] = max(t, quiet) + turnaround
+            end[i] = start[i] + reply
+            i += 1
+            handled += 1
+        t += args.loop_us
+        if handled == 0:
+            t = max(t, arrive[i])
+    return end[-1] + args.host_us
+
+
+def simulate(args):
+    limit = line_limit(args.baud, args.burst, args.size, args.address is not None)
+    print("baud %d, burst %d, payload %d bytes, proc %d us, loop %d us" %
+          (args.baud, args.burst, args.size, args.proc_us, args.loop_us))
+    print("line limit: %.0f req/s" % limit)
+    for name, batch in (("single", False), ("batch", True)):
+        rate = args.burst * 1e6 / simulate_burst(args, batch)
+        print("%-7s %7.0f req/s  %3.0f%% of line limit" % (name, rate, 100.0 * rate / limit))
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description="RS485 back-to-back request throughput")
+    parser.add_argument("--port", help="serial port")
+    parser.add_argument("--baud", type=int, default=RS485_DEFAULT_BAUDRATE)
+    parser.add_argument("--address", type=lambda s: int(s, 0), help="node address prefix (idle-line mode)")
+    parser.add_argument("--burst", type=int, default=FRAME_POOL_SIZE - 2, help="requests sent back-to-back")
+    parser.add_argument("--size", type=int, default=16, help="echo payload bytes")
+    parser.add_argument("--seconds", type=float, default=10.0)
+    parser.add_argument("--simulate", action="store_true", help="device timing model instead of a port")
+    parser.add_argument("--proc-us", type=float, default=30.0, help="model: per-frame handling time")
+    parser.add_argument("--loop-us", type=float, default=50.0, help="model: other main-loop tasks")
+    parser.add_argument("--host-us", type=float, default=0.0, help="model: host turnaround between bursts")
+    args = parser.parse_args()
+
+    if not 1 <= args.burst <= FRAME_POOL_SIZE:
+        parser.error("--burst must be 1..%d (device frame pool)" % FRAME_POOL_SIZE)
+    if args.size < 4:
+        parser.error("--size must be at least 4 (sequence number)")
+    if args.simulate:
+        return simulate(args)
+    if not args.port:
+        parser.error("--port or --simulate required")
+    return bench(args)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,122 @@
+#!/usr/bin/env python3
+"""
+rs485_cmd.py - 按名称调用RS485命令
+
+用法:
+    python3 rs485_cmd.py --port /dev/ttyUSB0 list               # 列出设备支持的命令 (AD)
+    python3 rs485_cmd.py --port /dev/ttyUSB0 beep 2000 100      # 2kHz鸣叫100ms
+    python3 rs485_cmd.py --port /dev/ttyUSB0 ctrl_pins 3 1      # CTRL1高, CTRL2低
+    python3 rs485_cmd.py --port /dev/ttyUSB0 disp_write 0x01 0x55 0xAA
+    python3 rs485_cmd.py --port /dev/ttyUSB0 0xA4               # 直接给命令字
+
+名称到命令字的映射从设备读取 (AD 命令), 参数按下表编码 (小端);
+表中没有的命令参数按字节传递. 回复以十六进制打印, 第2字节为状态 (0成功 1错误 2未定义).
+"""
+
+import argparse
+import struct
+import sys
+
+from fw_update import SerialLink, RS485_DEFAULT_BAUDRATE
+
+RS485_CMD_LIST = 0xAD
+STATUS_NAMES = {0: "ok", 1: "error", 2: "unknown"}
+
+# 参数格式: struct格式字符, "*" 表示其余参数按字节
+ARG_FORMATS = {
+    "baud_set": "I",
+    "address": "BB",
+    "clock": "BB",
+    "config": "B*",
+    "fault": "B",
+    "beep": "HH",
+    "alarm": "B",
+    "disp_write": "B*",
+    "ctrl_pins": "BB",
+    "echo": "*",
+    "ctrl_seq": "H" + "BBH" * 32,   # 重复次数, 然后每步 掩码 电平 时间us
+    "ctrl_pwm": "BH",
+    "disp_speed": "BB",
+    "i2c_mode": "BB",
+    "i2c_bench": "BBBB",
+    "irq_stats": "B",
+    "sniff": "H",
+}
+
+
+def parse_list_reply(reply):
+    """AD 回复: AD 状态 下一个命令字 {命令字 名称长度 名称}..."""
+    commands = {}
+    pos = 3
+    while pos + 2 <= len(reply):
+        cmd_id, name_len = reply[pos], reply[pos + 1]
+        commands[reply[pos + 2:pos + 2 + name_len].decode("ascii", "replace")] = cmd_id
+        pos += 2 + name_len
+    return commands, reply[2]
+
+
+def list_commands(link):
+    commands = {}
+    start = 0xA0
+    while True:
+        link.send(bytes([RS485_CMD_LIST, start]))
+        reply = link.recv(0.5)
+        if not reply or reply[0] != RS485_CMD_LIST:
+            raise RuntimeError("no reply to list")
+        page, start = parse_list_reply(reply)
+        commands.update(page)
+        if start == 0:
+            return commands
+
+
+def encode_args(name, args):
+    fmt = ARG_FORMATS.get(name, "*")
+    values = [int(a, 0) for a in args]
+    out = b""
+    for i, code in enumerate(fmt):
+        if code == "*":
+            return out + bytes(values[i:])
+        if i >= len(values):
+            break
+        out += struct.pack("<" + code, values[i])
+    return out
+
+
+def main():
+    parser = argparse.ArgumentParser(description="call RS485 commands by name")
+    parser.add_argument("--port", required=True, help="serial port")
+    parser.add_argument("--baud", type=int, default=RS485_DEFAULT_BAUDRATE)
+    parser.add_argument("--address", type=lambda s: int(s, 0), help="node address prefix (idle-line mode)")
+    parser.add_argument("command", help="command name, 'list', or command byte")
+    parser.add_argument("args", nargs="*", help="arguments (decimal or 0x hex)")
+    args = parser.parse_args()
+
+    link = SerialLink(args.port, args.baud, args.address)
+    commands = list_commands(link)
+
+    if args.command == "list":
+        for name, cmd_id in sorted(commands.items(), key=lambda item: item[1]):
+            print("%02X  %-12s %s" % (cmd_id, name, ARG_FORMATS.get(name, "")))
+        return 0
+
+    if args.command in commands:
+        cmd_id = commands[args.command]
+    else:
+        try:
+            cmd_id = int(args.command, 0)
+        except ValueError:
+            print("unknown command: %s" % args.command, file=sys.stderr)
+            return 1
+
+    link.send(bytes([cmd_id]) + encode_args(args.command, args.args))
+    reply = link.recv(0.5)
+    if reply is None:
+        print("no reply", file=sys.stderr)
+        return 1
+    status = STATUS_NAMES.get(reply[1], "0x%02x" % reply[1]) if len(reply) > 1 else "-"
+    print("%s  %s" % (status, reply.hex(" ")))
+    return 0 if len(reply) > 1 and reply[1] == 0 else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
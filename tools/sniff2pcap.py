@@ -0,0 +1,220 @@
+#!/usr/bin/env python3
+"""
+sniff2pcap.py - 把RS485总线监听 (RS485_CMD_SNIFF 0xBC) 的输出转换为pcap文件
+
+用法:
+    python3 rs485_cmd.py --port /dev/ttyUSB0 sniff 60                   # 设备开始捕获60秒
+    python3 sniff2pcap.py --port /dev/ttyUSB1 -o bus.pcap --raw bus.bin  # USART1 (PA9) 接收, 同时保存原始流
+    python3 sniff2pcap.py --input bus.bin -o bus.pcap --per-byte         # 离线转换, 每字节一个包
+
+设备输出COBS帧 (以0x00分隔), 每帧含一条或多条记录, 格式见 rs485_sniff.h:
+    01 版本 波特率(u32) 每字符位数
+    02 标志 间隔us(变长) 长度(变长) 数据
+    03 丢失字节数(变长)
+段的时间标记在段的最后一个字节收完时 (带IDLE标志时晚1个字符). 线路上一帧内的字节首尾相接,
+第i个字节的结束时刻 = 标记时刻 - (n-1-i) 个字符时间. 默认每个总线帧 (到IDLE为止) 一个包,
+时间为第一个字节的起始位; 数据链路类型为 USER0 (147), 包内容为线路上的原始字节.
+"""
+
+import argparse
+import struct
+import sys
+import time
+
+from trace_decode import cobs_decode
+
+REC_HEADER = 0x01
+REC_SEGMENT = 0x02
+REC_LOST = 0x03
+SNIFF_VERSION = 1
+
+FLAG_PERR = 0x01
+FLAG_FERR = 0x02
+FLAG_NERR = 0x04
+FLAG_ROERR = 0x08
+FLAG_IDLE = 0x10
+FLAG_MERGED = 0x20
+FLAG_PARTIAL = 0x40
+FLAG_END = 0x80
+ERROR_NAMES = [(FLAG_PERR, "parity"), (FLAG_FERR, "framing"), (FLAG_NERR, "noise"), (FLAG_ROERR, "overrun")]
+
+OUT_BAUDRATE = 3000000
+LINKTYPE_USER0 = 147
+
+
+def get_varint(data, pos):
+    value = 0
+    shift = 0
+    while True:
+        byte = data[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        shift += 7
+        if not byte & 0x80:
+            return value, pos
+
+
+class Decoder:
+    """按记录重建每个字节的时间, 输出包 (时间us, 数据)"""
+
+    def __init__(self, per_byte=False):
+        self.per_byte = per_byte
+        self.baud = 0
+        self.char_us = 0.0
+        self.t_us = 0
+        self.partial = bytearray()
+        self.burst = bytearray()
+        self.burst_start = None
+        self.packets = []
+        self.bytes = 0
+        self.lost = 0
+        self.merged = 0
+        self.errors = {}
+        self.bad_frames = 0
+        self.ended = False
+
+    def feed_frame(self, frame):
+        pos = 0
+        while pos < len(frame):
+            rec = frame[pos]
+            pos += 1
+            if rec == REC_HEADER:
+                version, self.baud, bits = struct.unpack_from("<BIB", frame, pos)
+                pos += 6
+                if version != SNIFF_VERSION:
+                    raise ValueError("unsupported sniff version %d" % version)
+                self.char_us = bits * 1e6 / self.baud
+            elif rec == REC_SEGMENT:
+                flags = frame[pos]
+                gap, pos = get_varint(frame, pos + 1)
+                count, pos = get_varint(frame, pos)
+                data = frame[pos:pos + count]
+                pos += count
+                self.segment(flags, gap, data)
+            elif rec == REC_LOST:
+                count, pos = get_varint(frame, pos)
+                self.lost += count
+                self.partial.clear()
+                self.flush()
+            else:
+                raise ValueError("unknown record 0x%02x" % rec)
+
+    def segment(self, flags, gap, data):
+        if flags & FLAG_PARTIAL:
+            self.partial += data
+            return
+
+        data = bytes(self.partial) + bytes(data)
+        self.partial.clear()
+        self.t_us += gap
+        end = self.t_us - (self.char_us if flags & FLAG_IDLE else 0)
+        n = len(data)
+
+        if flags & FLAG_MERGED:
+            self.merged += 1
+        for bit, name in ERROR_NAMES:
+            if flags & bit:
+                self.errors[name] = self.errors.get(name, 0) + 1
+                print("%12.1f us  %s error after %d bytes" % (end, name, n))
+
+        for i, byte in enumerate(data):
+            start = end - (n - i) * self.char_us
+            if self.per_byte:
+                self.packets.append((start, bytes([byte])))
+            else:
+                if self.burst_start is None:
+                    self.burst_start = start
+                self.burst.append(byte)
+        self.bytes += n
+
+        if flags & (FLAG_IDLE | FLAG_END):
+            self.flush()
+        if flags & FLAG_END:
+            self.ended = True
+
+    def flush(self):
+        if self.burst:
+            self.packets.append((self.burst_start, bytes(self.burst)))
+        self.burst = bytearray()
+        self.burst_start = None
+
+    def feed_stream(self, data):
+        """COBS帧流; 返回未结束的尾部"""
+        frames = data.split(b"\x00")
+        for encoded in frames[:-1]:
+            if not encoded:
+                continue
+            try:
+                self.feed_frame(cobs_decode(encoded))
+            except (ValueError, IndexError, struct.error):
+                self.bad_frames += 1
+        return frames[-1]
+
+
+def write_pcap(path, packets):
+    with open(path, "wb") as f:
+        f.write(struct.pack("<IHHiIII", 0xA1B2C3D4, 2, 4, 0, 0, 65535, LINKTYPE_USER0))
+        for t_us, data in packets:
+            t = max(0, int(round(t_us)))
+            f.write(struct.pack("<IIII", t // 1000000, t % 1000000, len(data), len(data)))
+            f.write(data)
+
+
+def read_serial(port, baud, raw_path, seconds):
+    import serial
+    link = serial.Serial(port, baud, timeout=0.05)
+    decoder = Decoder()
+    captured = bytearray()
+    tail = b""
+    deadline = time.monotonic() + seconds if seconds else None
+    try:
+        while not decoder.ended and (deadline is None or time.monotonic() < deadline):
+            chunk = link.read(4096)
+            if chunk:
+                captured += chunk
+                tail = decoder.feed_stream(tail + chunk)
+    except KeyboardInterrupt:
+        pass
+    if raw_path:
+        with open(raw_path, "wb") as f:
+            f.write(captured)
+    return bytes(captured)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Convert RS485 sniffer output to pcap")
+    source = parser.add_mutually_exclusive_group(required=True)
+    source.add_argument("--port", help="serial port connected to USART1 TX (PA9)")
+    source.add_argument("--input", help="raw sniffer stream saved with --raw")
+    parser.add_argument("--baud", type=int, default=OUT_BAUDRATE)
+    parser.add_argument("--seconds", type=float, default=0, help="stop reading after this time (0: until END)")
+    parser.add_argument("--raw", help="save the raw stream read from --port")
+    parser.add_argument("--per-byte", action="store_true", help="one packet per byte instead of per bus frame")
+    parser.add_argument("-o", "--output", required=True, help="pcap file to write")
+    args = parser.parse_args()
+
+    if args.port:
+        data = read_serial(args.port, args.baud, args.raw, args.seconds)
+    else:
+        with open(args.input, "rb") as f:
+            data = f.read()
+
+    decoder = Decoder(args.per_byte)
+    decoder.feed_stream(data)
+    decoder.flush()
+    if not decoder.baud:
+        print("no header record in stream", file=sys.stderr)
+        return 1
+
+    write_pcap(args.output, decoder.packets)
+    print("bus %d baud, %d bytes, %d packets, %d lost bytes, %d merged segments, %d bad frames%s"
+          % (decoder.baud, decoder.bytes, len(decoder.packets), decoder.lost, decoder.merged,
+             decoder.bad_frames, "" if decoder.ended else " (no END record)"))
+    for name in sorted(decoder.errors):
+        print("  %s errors: %d" % (name, decoder.errors[name]))
+    print("wrote %s" % args.output)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,272 @@
+#!/usr/bin/env python3
+"""
+trace_decode.py - 解析RS485跟踪转储 (RS485_CMD_TRACE_DUMP)
+
+用法:
+    python3 trace_decode.py dump.bin                 # 输出延迟直方图
+    python3 trace_decode.py dump.bin -o trace.json   # 同时生成Chrome trace/Perfetto JSON
+
+转储为若干COBS帧, 每帧以命令字 0xA0 开头; 拼接后为
+16字节头 + N个8字节事件 (小端), 见 trace.c.
+"""
+
+import argparse
+import json
+import struct
+import sys
+from collections import defaultdict
+
+TRACE_DUMP_MAGIC = 0x52545354
+RS485_CMD_TRACE_DUMP = 0xA0
+HEADER = struct.Struct("<IHHIHH")
+EVENT = struct.Struct("<IHH")
+
+EVT_USART_RX = 0x01
+EVT_USART_TX_START = 0x02
+EVT_USART_TX_END = 0x03
+EVT_I2C_XFER_START = 0x10
+EVT_I2C_STATE = 0x11
+EVT_I2C_TIMEOUT = 0x12
+EVT_I2C_XFER_END = 0x13
+EVT_I2C_NACK = 0x14
+EVT_BUZZER_NOTE = 0x20
+EVT_TASK_START = 0x30
+EVT_TASK_STOP = 0x31
+EVT_CLOCK_CHANGE = 0x40
+
+EVENT_NAMES = {
+    EVT_USART_RX: "usart_rx",
+    EVT_USART_TX_START: "usart_tx_start",
+    EVT_USART_TX_END: "usart_tx_end",
+    EVT_I2C_XFER_START: "i2c_xfer_start",
+    EVT_I2C_STATE: "i2c_state",
+    EVT_I2C_TIMEOUT: "i2c_timeout",
+    EVT_I2C_XFER_END: "i2c_xfer_end",
+    EVT_I2C_NACK: "i2c_nack",
+    EVT_BUZZER_NOTE: "buzzer_note",
+    EVT_TASK_START: "task_start",
+    EVT_TASK_STOP: "task_stop",
+    EVT_CLOCK_CHANGE: "clock_change",
+}
+
+TASK_NAMES = {
+    0x01: "rs485_cmd",
+    0x02: "rs485_tx",
+    0x03: "buzzer",
+    0x04: "display",
+    0x05: "ctrl_pins",
+}
+
+
+def cobs_decode(encoded):
+    out = bytearray()
+    i = 0
+    while i < len(encoded):
+        code = encoded[i]
+        if code == 0:
+            raise ValueError("zero byte inside COBS frame")
+        out += encoded[i + 1:i + code]
+        i += code
+        if code != 0xFF and i < len(encoded):
+            out.append(0)
+    return bytes(out)
+
+
+def unframe(data):
+    """把COBS帧流还原为转储数据, 忽略非跟踪帧"""
+    payload = bytearray()
+    for encoded in data.split(b"\x00"):
+        if not encoded:
+            continue
+        try:
+            frame = cobs_decode(encoded)
+        except ValueError:
+            continue
+        if frame and frame[0] == RS485_CMD_TRACE_DUMP:
+            payload += frame[1:]
+    return bytes(payload)
+
+
+def parse_dump(data):
+    """返回 (header, [(cycles, event_id, arg), ...]), 时间戳已展开为单调递增"""
+    offset = data.find(struct.pack("<I", TRACE_DUMP_MAGIC))
+    if offset < 0:
+        raise ValueError("trace dump magic not found")
+
+    magic, version, event_size, core_clock, count, dropped = HEADER.unpack_from(data, offset)
+    if event_size != EVENT.size:
+        raise ValueError("unsupported event size %d" % event_size)
+
+    offset += HEADER.size
+    available = (len(data) - offset) // EVENT.size
+    if available < count:
+        print("warning: dump truncated, %d of %d events" % (available, count), file=sys.stderr)
+        count = available
+
+    events = []
+    wraps = 0
+    last = None
+    for i in range(count):
+        ts, eid, arg = EVENT.unpack_from(data, offset + i * EVENT.size)
+        # DWT->CYCCNT 为32位, 240MHz下约17.9s回绕一次; 后退超过半个范围才是回绕,
+        # 小幅后退 (乱序) 按原值保留, 回绕后紧接着出现的回绕前事件归到上一圈
+        epoch = wraps
+        if last is not None:
+            step = (ts - last) & 0xFFFFFFFF
+            if step < 0x80000000:
+                if ts < last:
+                    wraps += 1
+                    epoch = wraps
+                last = ts
+            elif ts > last:
+                epoch = wraps - 1
+        else:
+            last = ts
+        events.append((ts + (epoch << 32), eid, arg))
+
+    events = normalize_clock(events, core_clock)
+
+    header = {
+        "version": version,
+        "core_clock": core_clock,
+        "count": count,
+        "dropped": dropped,
+    }
+    return header, events
+
+
+def normalize_clock(events, core_clock):
+    """时钟档位切换后时间戳按新频率计数, 统一换算为 core_clock 下的周期数"""
+    changes = [arg for _, eid, arg in events if eid == EVT_CLOCK_CHANGE]
+    if not changes:
+        return events
+
+    target_mhz = core_clock / 1e6
+    cur_mhz = changes[0] >> 8
+    seg_start = events[0][0]
+    seg_base = 0.0
+    out = []
+    for ts, eid, arg in events:
+        if eid == EVT_CLOCK_CHANGE:
+            # 切换事件在新时钟下记录, 之前的周期仍按原频率换算
+            seg_base += (ts - seg_start) * target_mhz / cur_mhz
+            seg_start = ts
+            cur_mhz = arg & 0xFF
+        out.append((int(seg_base + (ts - seg_start) * target_mhz / cur_mhz), eid, arg))
+    return out
+
+
+def pair_intervals(events):
+    """把开始/结束事件配对, 返回 {名称: [(start, end), ...]}"""
+    intervals = defaultdict(list)
+    open_tx = None
+    open_i2c = None
+    open_tasks = {}
+
+    for ts, eid, arg in events:
+        if eid == EVT_USART_TX_START:
+            open_tx = ts
+        elif eid == EVT_USART_TX_END and open_tx is not None:
+            intervals["usart_tx"].append((open_tx, ts))
+            open_tx = None
+        elif eid == EVT_I2C_XFER_START:
+            open_i2c = ts
+        elif eid == EVT_I2C_XFER_END and open_i2c is not None:
+            # arg 为 SUCCESS(1)/ERROR(0), 出错的传输 (超时/无应答) 单独统计
+            name = "i2c_xfer" if arg == 1 else "i2c_xfer_error"
+            intervals[name].append((open_i2c, ts))
+            open_i2c = None
+        elif eid == EVT_TASK_START:
+            open_tasks[arg] = ts
+        elif eid == EVT_TASK_STOP and arg in open_tasks:
+            name = "task_" + TASK_NAMES.get(arg, "%d" % arg)
+            intervals[name].append((open_tasks.pop(arg), ts))
+
+    rx = [ts for ts, eid, _ in events if eid == EVT_USART_RX]
+    intervals["usart_rx_gap"] = list(zip(rx, rx[1:]))
+    return intervals
+
+
+def print_histogram(name, durations_us, buckets=10, width=40):
+    if not durations_us:
+        return
+    durations_us = sorted(durations_us)
+    n = len(durations_us)
+    lo, hi = durations_us[0], durations_us[-1]
+    p50 = durations_us[n // 2]
+    p99 = durations_us[min(n - 1, (n * 99) // 100)]
+    print("%s: n=%d min=%.2fus p50=%.2fus p99=%.2fus max=%.2fus" % (name, n, lo, p50, p99, hi))
+
+    if hi <= lo:
+        print()
+        return
+
+    step = (hi - lo) / buckets
+    counts = [0] * buckets
+    for d in durations_us:
+        counts[min(buckets - 1, int((d - lo) / step))] += 1
+    peak = max(counts)
+    for i, c in enumerate(counts):
+        bar = "#" * (c * width // peak if peak else 0)
+        print("  %10.2f - %10.2f us | %6d %s" % (lo + i * step, lo + (i + 1) * step, c, bar))
+    print()
+
+
+def chrome_trace(header, events, intervals):
+    """生成 Chrome trace / Perfetto 可加载的 JSON"""
+    to_us = 1e6 / header["core_clock"]
+    base = events[0][0] if events else 0
+    out = []
+
+    for name, spans in intervals.items():
+        if name == "usart_rx_gap":
+            continue
+        for start, end in spans:
+            out.append({
+                "name": name,
+                "ph": "X",
+                "ts": (start - base) * to_us,
+                "dur": (end - start) * to_us,
+                "pid": 1,
+                "tid": name,
+            })
+
+    for ts, eid, arg in events:
+        if eid in (EVT_USART_RX, EVT_I2C_STATE, EVT_BUZZER_NOTE, EVT_I2C_TIMEOUT, EVT_I2C_NACK, EVT_CLOCK_CHANGE):
+            out.append({
+                "name": EVENT_NAMES[eid],
+                "ph": "i",
+                "s": "t",
+                "ts": (ts - base) * to_us,
+                "pid": 1,
+                "tid": EVENT_NAMES[eid],
+                "args": {"arg": arg},
+            })
+
+    return {"traceEvents": out, "displayTimeUnit": "ns"}
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode RS485 trace dumps")
+    parser.add_argument("dump", help="binary dump captured from RS485")
+    parser.add_argument("-o", "--output", help="write Chrome trace JSON to this file")
+    args = parser.parse_args()
+
+    with open(args.dump, "rb") as f:
+        header, events = parse_dump(unframe(f.read()))
+
+    print("core clock %d Hz, %d events, %d dropped\n" % (header["core_clock"], header["count"], header["dropped"]))
+
+    to_us = 1e6 / header["core_clock"]
+    intervals = pair_intervals(events)
+    for name in sorted(intervals):
+        print_histogram(name, [(end - start) * to_us for start, end in intervals[name]])
+
+    if args.output:
+        with open(args.output, "w") as f:
+            json.dump(chrome_trace(header, events, intervals), f)
+        print("wrote %s" % args.output)
+
+
+if __name__ == "__main__":
+    main()
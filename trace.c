@@ -0,0 +1,184 @@
+/**
+ * @file trace.c
+ * @brief 运行时事件跟踪模块实现
+ * @author Jason
+ * @date 2026-10-18
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "trace.h"
+#include "main.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/**
+ * @brief  转储数据头 (小端, 16字节)
+ */
+typedef struct
+{
+    uint32_t magic;         /*!< TRACE_DUMP_MAGIC */
+    uint16_t version;       /*!< TRACE_DUMP_VERSION */
+    uint16_t event_size;    /*!< sizeof(trace_event_t) */
+    uint32_t core_clock;    /*!< 时间戳频率 (Hz) */
+    uint16_t count;         /*!< 后续事件数 */
+    uint16_t dropped;       /*!< 已被覆盖的事件数 (饱和到0xFFFF) */
+} trace_dump_header_t;
+
+/* Private define ------------------------------------------------------------*/
+#define TRACE_BUFFER_MASK       (TRACE_BUFFER_SIZE - 1)
+
+/* 每帧事件数, 加1字节命令字不超过 RS485_FRAME_MAX_SIZE */
+#define TRACE_DUMP_EVENTS_PER_FRAME ((RS485_FRAME_MAX_SIZE - 1) / sizeof(trace_event_t))
+
+#if (TRACE_BUFFER_SIZE & TRACE_BUFFER_MASK) != 0
+#error "TRACE_BUFFER_SIZE must be a power of 2"
+#endif
+
+/* Private macro -------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+static trace_event_t trace_buffer[TRACE_BUFFER_SIZE];
+static __IO uint32_t trace_head = 0;     /*!< 累计写入事件数 */
+static __IO uint8_t trace_enabled = 0;
+
+/* Private function prototypes -----------------------------------------------*/
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief  跟踪模块初始化
+ * @param  None
+ * @retval None
+ */
+void trace_init(void)
+{
+    trace_head = 0;
+    trace_enabled = 1;
+}
+
+/**
+ * @brief  记录一个事件 (无锁, 可在中断和任务中调用)
+ * @param  event_id: 事件ID
+ * @param  arg: 事件参数
+ * @retval None
+ */
+RAMFUNC void trace_record(uint16_t event_id, uint16_t arg)
+{
+    uint32_t index;
+    uint32_t timestamp;
+    trace_event_t* event;
+
+    if(!trace_enabled)
+    {
+        return;
+    }
+
+    /* LDREX/STREX 预留槽位, 被中断抢占时重试; 时间戳在预留成功前读取,
+       抢占的中断记录的事件槽位和时间戳都在本事件之前, 缓冲区中时间戳按槽位单调 */
+    do
+    {
+        index = __LDREXW((uint32_t*)&trace_head);
+        timestamp = DWT->CYCCNT;
+    } while(__STREXW(index + 1, (uint32_t*)&trace_head));
+
+    event = &trace_buffer[index & TRACE_BUFFER_MASK];
+    event->timestamp = timestamp;
+    event->event_id = event_id;
+    event->arg = arg;
+}
+
+/**
+ * @brief  使能/暂停事件记录
+ * @param  enable: 1使能, 0暂停
+ * @retval None
+ */
+void trace_enable(uint8_t enable)
+{
+    trace_enabled = enable ? 1 : 0;
+}
+
+/**
+ * @brief  复制最后的若干事件 (按时间先后)
+ * @note   不加锁, 可在故障处理中调用
+ * @param  events: 输出缓冲区
+ * @param  max: 最多复制的事件数
+ * @retval 复制的事件数
+ */
+uint16_t trace_copy_last(trace_event_t* events, uint16_t max)
+{
+    uint32_t head = trace_head;
+    uint32_t count = (head < TRACE_BUFFER_SIZE) ? head : TRACE_BUFFER_SIZE;
+    uint32_t i;
+
+    if(count > max)
+    {
+        count = max;
+    }
+
+    for(i = 0; i < count; i++)
+    {
+        events[i] = trace_buffer[(head - count + i) & TRACE_BUFFER_MASK];
+    }
+
+    return (uint16_t)count;
+}
+
+/**
+ * @brief  通过RS485转储跟踪缓冲区
+ * @note   转储期间暂停记录, 事件按时间先后顺序输出
+ * @param  None
+ * @retval None
+ */
+void trace_dump(void)
+{
+    trace_dump_header_t header;
+    uint32_t head;
+    uint32_t count;
+    uint32_t start;
+    uint32_t chunk;
+    uint8_t cmd = RS485_CMD_TRACE_DUMP;
+    uint8_t enabled = trace_enabled;
+
+    trace_enabled = 0;
+
+    head = trace_head;
+    count = (head < TRACE_BUFFER_SIZE) ? head : TRACE_BUFFER_SIZE;
+    start = head - count;
+
+    header.magic = TRACE_DUMP_MAGIC;
+    header.version = TRACE_DUMP_VERSION;
+    header.event_size = sizeof(trace_event_t);
+    header.core_clock = system_core_clock;
+    header.count = (uint16_t)count;
+    header.dropped = (start > 0xFFFF) ? 0xFFFF : (uint16_t)start;
+
+    rs485_frame_begin();
+    rs485_frame_write(&cmd, 1);
+    rs485_frame_write((uint8_t*)&header, sizeof(header));
+    rs485_frame_end();
+
+    /* 事件按帧分块发送, 每帧以命令字开头; 环形缓冲区回绕处另起一帧 */
+    start &= TRACE_BUFFER_MASK;
+    while(count > 0)
+    {
+        chunk = TRACE_DUMP_EVENTS_PER_FRAME;
+        if(chunk > count)
+        {
+            chunk = count;
+        }
+        if(chunk > TRACE_BUFFER_SIZE - start)
+        {
+            chunk = TRACE_BUFFER_SIZE - start;
+        }
+
+        rs485_frame_begin();
+        rs485_frame_write(&cmd, 1);
+        rs485_frame_write((uint8_t*)&trace_buffer[start], chunk * sizeof(trace_event_t));
+        rs485_frame_end();
+
+        start = (start + chunk) & TRACE_BUFFER_MASK;
+        count -= chunk;
+
+        /* 低波特率下转储需数秒, 每帧报到一次 */
+        WATCHDOG_CHECKIN(WATCHDOG_TASK_COMMAND);
+    }
+
+    trace_enabled = enabled;
+}
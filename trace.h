@@ -0,0 +1,136 @@
+/**
+ * @file trace.h
+ * @brief 运行时事件跟踪模块头文件
+ * @author Jason
+ * @date 2026-10-18
+ */
+
+#ifndef __TRACE_H
+#define __TRACE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "at32f403a_407.h"
+#include "memmap.h"
+
+/* Exported types ------------------------------------------------------------*/
+/**
+ * @brief  跟踪事件记录 (8字节)
+ */
+typedef struct
+{
+    uint32_t timestamp;     /*!< DWT周期计数 */
+    uint16_t event_id;      /*!< 事件ID, 见 trace_event_id_t */
+    uint16_t arg;           /*!< 事件参数 */
+} trace_event_t;
+
+/**
+ * @brief  跟踪事件ID
+ */
+typedef enum
+{
+    TRACE_EVT_NONE              = 0x00,
+
+    /* USART / RS485 */
+    TRACE_EVT_USART_RX          = 0x01, /*!< 接收一个字节, arg = 数据 */
+    TRACE_EVT_USART_TX_START    = 0x02, /*!< 开始发送, arg = 长度, 字符串为0 */
+    TRACE_EVT_USART_TX_END      = 0x03, /*!< 发送完成 */
+
+    /* I2C */
+    TRACE_EVT_I2C_XFER_START    = 0x10, /*!< 传输开始, arg = 设备地址<<8 | 寄存器地址 */
+    TRACE_EVT_I2C_STATE         = 0x11, /*!< 状态转换, arg = 事件低16位 */
+    TRACE_EVT_I2C_TIMEOUT       = 0x12, /*!< 等待超时, arg = 等待的事件/标志低16位 */
+    TRACE_EVT_I2C_XFER_END      = 0x13, /*!< 传输结束, arg = SUCCESS/ERROR */
+    TRACE_EVT_I2C_NACK          = 0x14, /*!< 从机无应答, arg = 等待的事件/标志低16位 */
+
+    /* 蜂鸣器 */
+    TRACE_EVT_BUZZER_NOTE       = 0x20, /*!< 音符变化, arg = 频率(Hz), 0为停止 */
+
+    /* 任务 */
+    TRACE_EVT_TASK_START        = 0x30, /*!< 任务开始, arg = 任务ID */
+    TRACE_EVT_TASK_STOP         = 0x31, /*!< 任务结束, arg = 任务ID */
+
+    /* 时钟 */
+    TRACE_EVT_CLOCK_CHANGE      = 0x40  /*!< 系统时钟切换, arg = 原MHz<<8 | 新MHz, 之后的时间戳按新频率计 */
+} trace_event_id_t;
+
+/**
+ * @brief  任务ID (TRACE_EVT_TASK_START/STOP 的参数)
+ */
+typedef enum
+{
+    TRACE_TASK_RS485_CMD        = 0x01, /*!< RS485命令处理 */
+    TRACE_TASK_RS485_TX         = 0x02, /*!< RS485发送 */
+    TRACE_TASK_BUZZER           = 0x03, /*!< 蜂鸣器 */
+    TRACE_TASK_DISPLAY          = 0x04, /*!< 显示板 */
+    TRACE_TASK_CTRL_PINS        = 0x05  /*!< 控制引脚 */
+} trace_task_id_t;
+
+/* Exported constants --------------------------------------------------------*/
+/* 跟踪功能开关, 置0时所有 TRACE() 调用编译为空 */
+#ifndef TRACE_ENABLE
+#define TRACE_ENABLE            1
+#endif
+
+/* 环形缓冲区事件数, 必须为2的幂 */
+#define TRACE_BUFFER_SIZE       512
+
+/* 转储数据头 */
+#define TRACE_DUMP_MAGIC        0x52545354  /*!< "TSTR" */
+#define TRACE_DUMP_VERSION      1
+
+/* Exported macro ------------------------------------------------------------*/
+#if TRACE_ENABLE
+#define TRACE(id, arg)          trace_record((uint16_t)(id), (uint16_t)(arg))
+#else
+#define TRACE(id, arg)          ((void)0)
+#endif
+
+/* Exported functions prototypes ---------------------------------------------*/
+
+/**
+ * @brief  跟踪模块初始化
+ * @param  None
+ * @retval None
+ */
+void trace_init(void);
+
+/**
+ * @brief  记录一个事件 (无锁, 可在中断和任务中调用)
+ * @param  event_id: 事件ID
+ * @param  arg: 事件参数
+ * @retval None
+ */
+RAMFUNC void trace_record(uint16_t event_id, uint16_t arg);
+
+/**
+ * @brief  使能/暂停事件记录
+ * @param  enable: 1使能, 0暂停
+ * @retval None
+ */
+void trace_enable(uint8_t enable);
+
+/**
+ * @brief  复制最后的若干事件 (按时间先后)
+ * @note   不加锁, 可在故障处理中调用
+ * @param  events: 输出缓冲区
+ * @param  max: 最多复制的事件数
+ * @retval 复制的事件数
+ */
+uint16_t trace_copy_last(trace_event_t* events, uint16_t max);
+
+/**
+ * @brief  通过RS485转储跟踪缓冲区
+ * @param  None
+ * @retval None
+ */
+void trace_dump(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TRACE_H */
@@ -12,194 +12,1494 @@
 /* Private typedef -----------------------------------------------------------*/
 /* Private define ------------------------------------------------------------*/
 #define RS485_RX_BUFFER_SIZE    256
+#define RS485_BITS_PER_CHAR     10      // 起始位 + 8数据位 + 停止位
+#define RS485_USART_DIV_MIN     16      // 16倍过采样, 最高波特率 = pclk / 16
+#define RS485_USART_DIV_MAX     0xFFFF
+#define RS485_AUTOBAUD_EDGES    5       // 0x55的5个下降沿跨越8个位时间
+#define RS485_AUTOBAUD_BITS     8
+#define RS485_AUTOBAUD_SNAP_PCT 3       // 与标准波特率相差3%以内时取标准值
+#define RS485_TX_TIMEOUT_CHARS  4       // 等待发送完成的超时 (字符时间), 超时说明USART停止工作
+#define RS485_TX_GUARD_CHARS_X10 15     // 最后接收字节后空闲1.5字符才回复, 主站连发时字符间无间隔
+#define RS485_TX_DEFER_MAX_CHARS (RS485_TX_BUFFER_SIZE * RS485_FRAME_POOL_SIZE)    // 主站连发时回复最多推迟的时间
+#define RS485_CLOCK_QUIET_MAX_CHARS RS485_TX_BUFFER_SIZE   // 时钟切换后等待总线空闲最长一帧
+
+/* 接收线路错误标志: 帧错误、噪声、校验、溢出 */
+#define RS485_RX_ERROR_FLAGS    (USART_FERR_FLAG | USART_NERR_FLAG | USART_PERR_FLAG | USART_ROERR_FLAG)
 
 /* Private macro -------------------------------------------------------------*/
+#define RS485_MS_TO_CYCLES(ms)  ((system_core_clock / 1000) * (ms))
+
 /* Private variables ---------------------------------------------------------*/
 static uint8_t rs485_rx_buffer[RS485_RX_BUFFER_SIZE];
-static uint16_t rs485_rx_count = 0;
-static uint8_t rs485_rx_flag = 0;
+static __IO uint16_t rs485_rx_count = 0;     // 接收中断写入, 主循环读取和清零时关闭接收中断
+static __IO uint8_t rs485_rx_flag = 0;
+static __IO uint32_t rs485_last_rx_cycles = 0;
+static __IO uint8_t rs485_rx_bad = 0;       // 原始分帧: 当前帧有线路错误, 帧结束时丢弃
+static rs485_sniff_isr_t rs485_sniff_isr = NULL;    // 总线监听中
+
+/* 线路质量: 上一个统计窗口结束时的接收字节数和错误数 */
+static uint32_t rs485_line_bytes_mark = 0;
+static uint32_t rs485_line_errors_mark = 0;
+
+/* 发送互斥锁 (FreeRTOS下多个任务发送时串行化, 裸机为空操作) */
+static os_mutex_t rs485_tx_mutex;
+
+/* 波特率及由其派生的时间参数 */
+static uint32_t rs485_baudrate = RS485_DEFAULT_BAUDRATE;
+static uint32_t rs485_frame_gap_cycles = 0;
+static uint32_t rs485_char_cycles = 0;
+static uint32_t rs485_tx_guard_cycles = 0;
+static uint32_t rs485_turnaround_us = 10;
+static uint32_t rs485_saved_baudrate = 0;       // 等待PLL后应用的保存波特率
+
+/* DMA发送: 双缓冲, 一个由DMA发送时主循环向另一个编码下一帧 */
+DMA_BUFFER static uint8_t rs485_tx_dma_buffer[RS485_TX_BUFFER_NUM][RS485_TX_BUFFER_SIZE];
+static __IO uint8_t rs485_tx_dma_busy = 0;
+static uint8_t rs485_tx_fill = 0;                   // 正在编码的缓冲区
+static uint8_t* rs485_tx_pending_buf = NULL;        // 已编码, 等上一帧发完或主站停止发送后发送
+static __IO uint16_t rs485_tx_pending_len = 0;      // 0为无排队的帧
+
+/* 分帧 */
+static rs485_framing_t rs485_framing = RS485_FRAMING_DEFAULT;
+
+/* 多机寻址 */
+static rs485_addr_mode_t rs485_addr_mode = RS485_ADDR_MODE_OFF;
+static uint8_t rs485_node_address = RS485_DEFAULT_NODE_ADDRESS;
+static __IO uint8_t rs485_addr_expect = 0;      // 下一个字节是地址
+static __IO uint8_t rs485_rx_broadcast = 0;     // 当前帧为广播
+static uint8_t rs485_tx_inhibit = 0;            // 广播帧不回复
+
+/* 协商切换 */
+static uint32_t rs485_prev_baudrate = RS485_DEFAULT_BAUDRATE;
+static uint32_t rs485_switch_start = 0;
+static uint8_t rs485_switch_pending = 0;
+
+/* 自动波特率 */
+static __IO rs485_autobaud_state_t rs485_autobaud_state = RS485_AUTOBAUD_IDLE;
+static uint32_t rs485_autobaud_edges[RS485_AUTOBAUD_EDGES];
+static uint8_t rs485_autobaud_edge_count = 0;
+static uint32_t rs485_autobaud_tmr_clk = 0;
+static uint32_t rs485_autobaud_start_cycles = 0;
+
+static const uint32_t rs485_standard_baudrates[] =
+{
+    9600, 19200, 38400, 57600, 115200, 230400, 460800, 921600,
+    1000000, 1843200, 2000000, 3000000, 4000000
+};
 
 /* Private function prototypes -----------------------------------------------*/
+static void rs485_usart_config(void);
+static void rs485_dma_config(void);
+static void rs485_tx_address(void);
+static void rs485_timing_update(void);
+static error_status rs485_wait_tdc(void);
+static void rs485_tx_wait_idle(void);
+static uint8_t rs485_rx_quiet(void);
+static void rs485_tx_begin(uint8_t* buf, uint16_t len);
+static void rs485_tx_abort(void);
+static RAMFUNC void rs485_tx_dma_kick(uint8_t* buf, uint16_t len);
+static uint8_t rs485_frame_complete(void);
+static RAMFUNC uint8_t rs485_rx_line_error(void);
+static RAMFUNC void rs485_rx_resync(void);
+static uint32_t rs485_line_error_total(void);
+static error_status rs485_clock_wait_quiet(uint8_t* busy);
+static void rs485_autobaud_stop(void);
+static void rs485_autobaud_finish(uint32_t total);
+static uint32_t rs485_autobaud_snap(uint32_t baud);
+static error_status rs485_clock_notify(clock_event_t event, clock_profile_t profile);
+
 /* Private functions ---------------------------------------------------------*/
 
 /**
- * @brief  设置RS485工作模式
- * @param  mode: RS485_MODE_TX 或 RS485_MODE_RX
+ * @brief  USART参数配置 (数据位随寻址模式变化)
+ * @param  None
+ * @retval None
+ */
+static void rs485_usart_config(void)
+{
+    usart_init_type usart_init_struct;
+    
+    usart_default_para_init(&usart_init_struct);
+    usart_init_struct.baudrate = rs485_baudrate;
+    usart_init_struct.data_bit = (rs485_addr_mode == RS485_ADDR_MODE_ADDRESS_MARK) ?
+                                 USART_DATA_9BITS : USART_DATA_8BITS;
+    usart_init_struct.stop_bit = USART_STOP_1_BIT;
+    usart_init_struct.parity = USART_PARITY_NONE;
+    usart_init_struct.hardware_flow_control = USART_HARDWARE_FLOW_NONE;
+    usart_init_struct.mode = USART_MODE_TX | USART_MODE_RX;
+    usart_init(RS485_USART, &usart_init_struct);
+}
+
+/**
+ * @brief  发送DMA配置
+ * @param  None
+ * @retval None
+ */
+static void rs485_dma_config(void)
+{
+    dma_init_type dma_init_struct;
+    
+    crm_periph_clock_enable(RS485_DMA_CLK, TRUE);
+    dma_flexible_config(RS485_TX_DMA, RS485_TX_DMA_FLEX_CHANNEL, RS485_TX_DMA_REQUEST);
+    
+    dma_reset(RS485_TX_DMA_CHANNEL);
+    dma_default_para_init(&dma_init_struct);
+    dma_init_struct.buffer_size = 0;
+    dma_init_struct.direction = DMA_DIR_MEMORY_TO_PERIPHERAL;
+    dma_init_struct.memory_base_addr = (uint32_t)rs485_tx_dma_buffer[0];
+    dma_init_struct.memory_data_width = DMA_MEMORY_DATA_WIDTH_BYTE;
+    dma_init_struct.memory_inc_enable = TRUE;
+    dma_init_struct.peripheral_base_addr = (uint32_t)&RS485_USART->dt;
+    dma_init_struct.peripheral_data_width = DMA_PERIPHERAL_DATA_WIDTH_BYTE;
+    dma_init_struct.peripheral_inc_enable = FALSE;
+    dma_init_struct.priority = DMA_PRIORITY_HIGH;
+    dma_init_struct.loop_mode_enable = FALSE;
+    dma_init(RS485_TX_DMA_CHANNEL, &dma_init_struct);
+    
+    dma_interrupt_enable(RS485_TX_DMA_CHANNEL, DMA_FDT_INT, TRUE);
+    usart_dma_transmitter_enable(RS485_USART, TRUE);
+}
+
+/**
+ * @brief  寻址模式下发送回复帧的地址字节
+ * @note   须在DE切换到发送之后调用
+ * @param  None
+ * @retval None
+ */
+static void rs485_tx_address(void)
+{
+    uint16_t addr = RS485_MASTER_ADDRESS;
+    
+    if(rs485_addr_mode == RS485_ADDR_MODE_OFF)
+    {
+        return;
+    }
+    
+    if(rs485_addr_mode == RS485_ADDR_MODE_ADDRESS_MARK)
+    {
+        addr |= RS485_ADDRESS_MARK_BIT;
+    }
+    
+    if(rs485_wait_tdc() == SUCCESS)
+    {
+        usart_data_transmit(RS485_USART, addr);
+    }
+}
+
+/**
+ * @brief  等待发送完成标志 (有超时)
+ * @param  None
+ * @retval SUCCESS/ERROR (超时)
+ */
+static error_status rs485_wait_tdc(void)
+{
+    uint32_t start = DWT->CYCCNT;
+    
+    while(usart_flag_get(RS485_USART, USART_TDC_FLAG) == RESET)
+    {
+        if((DWT->CYCCNT - start) > rs485_char_cycles * RS485_TX_TIMEOUT_CHARS)
+        {
+            METRIC_INC(METRIC_RS485_TX_TIMEOUT);
+            return ERROR;
+        }
+    }
+    
+    return SUCCESS;
+}
+
+/**
+ * @brief  中止DMA发送 (含排队的帧) 并释放总线
+ * @param  None
+ * @retval None
+ */
+static void rs485_tx_abort(void)
+{
+    dma_channel_enable(RS485_TX_DMA_CHANNEL, FALSE);
+    usart_interrupt_enable(RS485_USART, USART_TDC_INT, FALSE);
+    gpio_bits_reset(RS485_DE_GPIO_PORT, RS485_DE_GPIO_PIN);
+    rs485_tx_pending_len = 0;
+    rs485_tx_dma_busy = 0;
+    METRIC_INC(METRIC_RS485_TX_TIMEOUT);
+    TRACE(TRACE_EVT_USART_TX_END, 0);
+}
+
+/**
+ * @brief  等待DMA发送 (含排队的帧) 结束, 超时则中止发送并释放总线
+ * @param  None
+ * @retval None
+ */
+static void rs485_tx_wait_idle(void)
+{
+    uint32_t start = DWT->CYCCNT;
+    
+    while(rs485_tx_dma_busy || (rs485_tx_pending_len != 0))
+    {
+        rs485_tx_poll();
+        
+        if((DWT->CYCCNT - start) >
+           rs485_char_cycles * (RS485_TX_DEFER_MAX_CHARS + RS485_TX_BUFFER_SIZE * RS485_TX_BUFFER_NUM))
+        {
+            rs485_tx_abort();
+            return;
+        }
+    }
+}
+
+/**
+ * @brief  判断主站是否已停止发送 (最后接收字节后已空闲超过保护时间)
+ * @param  None
+ * @retval 1: 已停止, 0: 仍在发送
+ */
+static uint8_t rs485_rx_quiet(void)
+{
+    return ((DWT->CYCCNT - rs485_last_rx_cycles) >= rs485_tx_guard_cycles) ? 1 : 0;
+}
+
+/**
+ * @brief  切换到发送并启动DMA发送 (调用者已置忙标志)
+ * @param  buf: 发送缓冲区
+ * @param  len: 发送长度
+ * @retval None
+ */
+static void rs485_tx_begin(uint8_t* buf, uint16_t len)
+{
+    TRACE(TRACE_EVT_USART_TX_START, len);
+    
+    rs485_set_mode(RS485_MODE_TX);
+    rs485_tx_address();
+    rs485_tx_dma_kick(buf, len);
+}
+
+/**
+ * @brief  从指定缓冲区启动DMA发送
+ * @note   直接写通道寄存器, 可在中断中调用
+ * @param  buf: 发送缓冲区
+ * @param  len: 发送长度
+ * @retval None
+ */
+static RAMFUNC void rs485_tx_dma_kick(uint8_t* buf, uint16_t len)
+{
+    RS485_TX_DMA_CHANNEL->ctrl_bit.chen = FALSE;
+    RS485_TX_DMA_CHANNEL->maddr = (uint32_t)buf;
+    RS485_TX_DMA_CHANNEL->dtcnt = len;
+    RS485_TX_DMA_CHANNEL->ctrl_bit.chen = TRUE;
+}
+
+/**
+ * @brief  根据当前波特率更新帧间隔和收发切换时间
+ * @param  None
+ * @retval None
+ */
+static void rs485_timing_update(void)
+{
+    uint32_t gap_bits = RS485_FRAME_GAP_CHARS_X10 * RS485_BITS_PER_CHAR / 10;
+    
+    rs485_frame_gap_cycles = (uint32_t)((uint64_t)system_core_clock * gap_bits / rs485_baudrate);
+    
+    /* 9位模式每个字符多1位, 按11位计 */
+    rs485_char_cycles = (uint32_t)((uint64_t)system_core_clock * (RS485_BITS_PER_CHAR + 1) / rs485_baudrate);
+    rs485_tx_guard_cycles = rs485_char_cycles * RS485_TX_GUARD_CHARS_X10 / 10;
+    
+    /* 切换时间取1个位时间, 不小于收发器稳定时间 */
+    rs485_turnaround_us = (1000000 + rs485_baudrate - 1) / rs485_baudrate;
+    if(rs485_turnaround_us < RS485_DE_SETTLE_MIN_US)
+    {
+        rs485_turnaround_us = RS485_DE_SETTLE_MIN_US;
+    }
+}
+
+/**
+ * @brief  判断一帧是否接收完成 (最后一个字节后已空闲超过帧间隔)
+ * @param  None
+ * @retval 1: 完成, 0: 未完成
+ */
+static uint8_t rs485_frame_complete(void)
+{
+    if(!rs485_rx_flag)
+    {
+        return 0;
+    }
+    
+    return ((DWT->CYCCNT - rs485_last_rx_cycles) >= rs485_frame_gap_cycles) ? 1 : 0;
+}
+
+/**
+ * @brief  计数接收线路错误 (接收中断中, 读数据寄存器之前调用)
+ * @note   错误标志在读状态寄存器后读数据寄存器时清除
+ * @param  None
+ * @retval 1: 有错误, 0: 无错误
+ */
+static RAMFUNC uint8_t rs485_rx_line_error(void)
+{
+    uint32_t sts = RS485_USART->sts;
+    
+    if((sts & RS485_RX_ERROR_FLAGS) == 0)
+    {
+        return 0;
+    }
+    
+    if(sts & USART_FERR_FLAG)
+    {
+        METRIC_INC(METRIC_RS485_FRAMING_ERR);
+    }
+    if(sts & USART_NERR_FLAG)
+    {
+        METRIC_INC(METRIC_RS485_NOISE_ERR);
+    }
+    if(sts & USART_PERR_FLAG)
+    {
+        METRIC_INC(METRIC_RS485_PARITY_ERR);
+    }
+    if(sts & USART_ROERR_FLAG)
+    {
+        METRIC_INC(METRIC_RS485_USART_OVERRUN);
+    }
+    
+    return 1;
+}
+
+/**
+ * @brief  线路错误后重新同步到下一帧 (在接收中断中调用)
+ * @note   寻址模式下重新静默, 由硬件在下一帧 (空闲线或地址标记) 唤醒, 解码器从下一个字节重新开始;
+ *         不寻址时COBS解码器丢弃到下一个帧界; 原始分帧时当前帧在帧间隔到达后整帧丢弃
+ * @param  None
+ * @retval None
+ */
+static RAMFUNC void rs485_rx_resync(void)
+{
+    if(rs485_addr_mode != RS485_ADDR_MODE_OFF)
+    {
+        rs485_addr_expect = 1;
+        usart_receiver_mute_enable(RS485_USART, TRUE);
+    }
+    
+    if(rs485_framing == RS485_FRAMING_COBS)
+    {
+        rs485_frame_rx_abort((rs485_addr_mode == RS485_ADDR_MODE_OFF) ? 1 : 0);
+    }
+    else
+    {
+        rs485_rx_bad = 1;
+        rs485_rx_flag = 1;
+    }
+}
+
+/**
+ * @brief  上电以来的线路错误总数
+ * @param  None
+ * @retval 帧错误、噪声、校验错误和USART溢出之和
+ */
+static uint32_t rs485_line_error_total(void)
+{
+    return metrics_counters[METRIC_RS485_FRAMING_ERR] + metrics_counters[METRIC_RS485_NOISE_ERR] +
+           metrics_counters[METRIC_RS485_PARITY_ERR] + metrics_counters[METRIC_RS485_USART_OVERRUN];
+}
+
+/**
+ * @brief  时钟切换后等待总线空闲一个帧间隔 (接收器关闭)
+ * @note   查询RX引脚电平; 总线一直忙时最多等待 RS485_CLOCK_QUIET_MAX_CHARS 个字符
+ * @param  busy: 输出, 1: 等待期间总线上有数据
+ * @retval SUCCESS: 已空闲一个帧间隔, ERROR: 超时, 总线仍忙
+ */
+static error_status rs485_clock_wait_quiet(uint8_t* busy)
+{
+    uint32_t start = DWT->CYCCNT;
+    uint32_t quiet_start = start;
+    uint32_t limit = rs485_char_cycles * RS485_CLOCK_QUIET_MAX_CHARS;
+    
+    *busy = 0;
+    
+    while((DWT->CYCCNT - quiet_start) < rs485_frame_gap_cycles)
+    {
+        if(gpio_input_data_bit_read(RS485_RX_GPIO_PORT, RS485_RX_GPIO_PIN) == RESET)
+        {
+            *busy = 1;
+            quiet_start = DWT->CYCCNT;
+        }
+        
+        if((DWT->CYCCNT - start) >= limit)
+        {
+            return ERROR;
+        }
+    }
+    
+    return SUCCESS;
+}
+
+/**
+ * @brief  系统时钟切换通知
+ * @note   总线忙、自动波特率测量或协商切换进行中, 或新APB1时钟无法产生
+ *         当前波特率时否决. 开始切换时持有发送锁 (DE保持低) 并关闭接收器: HICK和PLL锁定期间
+ *         分频值与时钟不符, 此时到达的字节不接收; 切换后按新APB1时钟重算分频值和帧间隔,
+ *         等总线空闲一个帧间隔再打开接收器, 切换期间开始的帧整帧丢弃 (计入 FRAME_DROPPED), 不会收到半帧
+ * @param  event: 通知事件
+ * @param  profile: 目标档位
+ * @retval SUCCESS/ERROR
+ */
+static error_status rs485_clock_notify(clock_event_t event, clock_profile_t profile)
+{
+    error_status status;
+    uint8_t busy;
+    
+    if(event == CLOCK_EVENT_PRE_CHANGE)
+    {
+        if(!rs485_line_idle() || rs485_switch_pending ||
+           (rs485_autobaud_state == RS485_AUTOBAUD_RUNNING))
+        {
+            return ERROR;
+        }
+        
+        if((clock_profile_apb1_freq(profile) / rs485_baudrate) < RS485_USART_DIV_MIN)
+        {
+            return ERROR;
+        }
+        
+        return SUCCESS;
+    }
+    
+    if(event == CLOCK_EVENT_CHANGE_BEGIN)
+    {
+        rs485_tx_lock();
+        gpio_bits_reset(RS485_DE_GPIO_PORT, RS485_DE_GPIO_PIN);
+        usart_receiver_enable(RS485_USART, FALSE);
+        return SUCCESS;
+    }
+    
+    /* 上电时HICK下无法产生的保存波特率, 在第一次切换后应用 */
+    if((rs485_saved_baudrate != 0) && (rs485_set_baudrate(rs485_saved_baudrate) == SUCCESS))
+    {
+        rs485_saved_baudrate = 0;
+        status = SUCCESS;
+    }
+    else
+    {
+        status = rs485_set_baudrate(rs485_baudrate);
+    }
+    
+    /* 切换期间开始的帧没有收到开头, 等它结束 */
+    if(rs485_clock_wait_quiet(&busy) != SUCCESS)
+    {
+        /* 总线一直忙: 从帧中间开始接收, 与线路错误一样丢弃到下一帧 */
+        rs485_rx_resync();
+    }
+    else if(busy)
+    {
+        METRIC_INC(METRIC_RS485_FRAME_DROPPED);
+    }
+    
+    if(busy)
+    {
+        rs485_last_rx_cycles = DWT->CYCCNT;
+        CLOCK_PROFILE_ACTIVITY();
+    }
+    
+    usart_receiver_enable(RS485_USART, TRUE);
+    rs485_tx_unlock();
+    
+    return status;
+}
+
+/**
+ * @brief  设置RS485工作模式
+ * @param  mode: RS485_MODE_TX 或 RS485_MODE_RX
+ * @retval None
+ */
+void rs485_set_mode(rs485_mode_t mode)
+{
+    if(mode == RS485_MODE_TX)
+    {
+        gpio_bits_set(RS485_DE_GPIO_PORT, RS485_DE_GPIO_PIN);
+    }
+    else
+    {
+        gpio_bits_reset(RS485_DE_GPIO_PORT, RS485_DE_GPIO_PIN);
+    }
+    
+    /* 模式切换延时 */
+    delay_us(rs485_turnaround_us);
+}
+
+/**
+ * @brief  RS485初始化
+ * @param  None
+ * @retval None
+ */
+void rs485_init(void)
+{
+    uint8_t addr;
+    uint8_t mode;
+    uint32_t baud;
+    
+    /* 使能USART2时钟 */
+    crm_periph_clock_enable(RS485_USART_CLK, TRUE);
+    
+    /* 从配置存储恢复本机地址 */
+    if((config_get(CONFIG_KEY_NODE_ADDRESS, &addr, sizeof(addr)) == SUCCESS) &&
+       (addr != RS485_BROADCAST_ADDRESS) && (addr != RS485_MASTER_ADDRESS))
+    {
+        rs485_node_address = addr;
+    }
+    
+    /* USART2配置; 发送等待的超时按字符时间计算, 先按默认波特率算一次 */
+    rs485_usart_config();
+    rs485_timing_update();
+    rs485_dma_config();
+    os_mutex_init(&rs485_tx_mutex);
+    rs485_frame_init();
+    
+    /* 使能USART2接收中断和线路错误中断 */
+    usart_interrupt_enable(RS485_USART, USART_RDBF_INT, TRUE);
+    usart_interrupt_enable(RS485_USART, USART_ERR_INT, TRUE);
+    usart_interrupt_enable(RS485_USART, USART_PERR_INT, TRUE);
+    
+    /* 使能USART2 */
+    usart_enable(RS485_USART, TRUE);
+    
+    /* 按实际时钟重新计算分频值和帧间隔, 时钟切换后自动重算 */
+    rs485_set_baudrate(rs485_baudrate);
+    clock_profile_register(rs485_clock_notify);
+    
+    /* 设置RS485为接收模式 */
+    rs485_set_mode(RS485_MODE_RX);
+    
+    /* 保存的寻址模式和波特率; HICK下无法产生的波特率等切换到PLL后再设置 */
+    if((config_get(CONFIG_KEY_ADDR_MODE, &mode, sizeof(mode)) == SUCCESS) &&
+       (mode <= RS485_ADDR_MODE_ADDRESS_MARK) && (mode != RS485_ADDR_MODE_OFF))
+    {
+        rs485_set_addr_mode((rs485_addr_mode_t)mode);
+    }
+    
+    if((config_get(CONFIG_KEY_BAUDRATE, &baud, sizeof(baud)) == SUCCESS) &&
+       (baud != rs485_baudrate) && (rs485_set_baudrate(baud) != SUCCESS))
+    {
+        rs485_saved_baudrate = baud;
+    }
+}
+
+/**
+ * @brief  发送单个字节
+ * @param  data: 要发送的字节
+ * @retval None
+ */
+void rs485_send_byte(uint8_t data)
+{
+    if(rs485_tx_inhibit)
+    {
+        return;
+    }
+    
+    rs485_tx_lock();
+    
+    /* 等待DMA发送完成 */
+    rs485_tx_wait_idle();
+    
+    TRACE(TRACE_EVT_USART_TX_START, 1);
+    rs485_set_mode(RS485_MODE_TX);
+    rs485_tx_address();
+    
+    /* 等待发送缓冲区空 */
+    if(rs485_wait_tdc() == SUCCESS)
+    {
+        /* 发送数据 */
+        usart_data_transmit(RS485_USART, data);
+        
+        /* 等待发送完成 */
+        rs485_wait_tdc();
+    }
+    
+    TRACE(TRACE_EVT_USART_TX_END, 0);
+    
+    rs485_set_mode(RS485_MODE_RX);
+    
+    rs485_tx_unlock();
+}
+
+/**
+ * @brief  发送字符串
+ * @param  str: 要发送的字符串
+ * @retval None
+ */
+void rs485_send_string(const char* str)
+{
+    if(rs485_tx_inhibit)
+    {
+        return;
+    }
+    
+    rs485_tx_lock();
+    
+    /* 等待DMA发送完成 */
+    rs485_tx_wait_idle();
+    
+    TRACE(TRACE_EVT_USART_TX_START, 0);
+    rs485_set_mode(RS485_MODE_TX);
+    rs485_tx_address();
+    
+    while(*str)
+    {
+        /* 等待发送缓冲区空, 超时放弃剩余数据 */
+        if(rs485_wait_tdc() != SUCCESS)
+        {
+            break;
+        }
+        
+        /* 发送数据 */
+        usart_data_transmit(RS485_USART, *str++);
+    }
+    
+    /* 等待发送完成 */
+    rs485_wait_tdc();
+    
+    TRACE(TRACE_EVT_USART_TX_END, 0);
+    
+    rs485_set_mode(RS485_MODE_RX);
+    
+    rs485_tx_unlock();
+}
+
+/**
+ * @brief  发送数据缓冲区
+ * @param  data: 数据缓冲区指针
+ * @param  len: 数据长度
+ * @retval None
+ */
+void rs485_send_buffer(uint8_t* data, uint16_t len)
+{
+    if(rs485_tx_inhibit)
+    {
+        return;
+    }
+    
+    rs485_tx_lock();
+    
+    /* 等待DMA发送完成 */
+    rs485_tx_wait_idle();
+    
+    TRACE(TRACE_EVT_USART_TX_START, len);
+    rs485_set_mode(RS485_MODE_TX);
+    rs485_tx_address();
+    
+    for(uint16_t i = 0; i < len; i++)
+    {
+        /* 等待发送缓冲区空, 超时放弃剩余数据 */
+        if(rs485_wait_tdc() != SUCCESS)
+        {
+            break;
+        }
+        
+        /* 发送数据 */
+        usart_data_transmit(RS485_USART, data[i]);
+    }
+    
+    /* 等待发送完成 */
+    rs485_wait_tdc();
+    
+    TRACE(TRACE_EVT_USART_TX_END, 0);
+    
+    rs485_set_mode(RS485_MODE_RX);
+    
+    rs485_tx_unlock();
+}
+
+/**
+ * @brief  接收数据
+ * @param  data: 数据缓冲区指针
+ * @param  max_len: 最大接收长度
+ * @retval 实际接收长度
+ */
+uint16_t rs485_receive_data(uint8_t* data, uint16_t max_len)
+{
+    uint16_t len = 0;
+    
+    if(rs485_frame_complete())
+    {
+        /* 与接收中断互斥, 避免复制后、清空前到达的字节被一并清掉 */
+        NVIC_DisableIRQ(RS485_USART_IRQ);
+        len = (rs485_rx_count < max_len) ? rs485_rx_count : max_len;
+        
+        /* 有线路错误的帧整帧丢弃 */
+        if(rs485_rx_bad)
+        {
+            METRIC_INC(METRIC_RS485_FRAME_DROPPED);
+            len = 0;
+        }
+        
+        for(uint16_t i = 0; i < len; i++)
+        {
+            data[i] = rs485_rx_buffer[i];
+        }
+        
+        /* 清空接收缓冲区 */
+        rs485_rx_count = 0;
+        rs485_rx_flag = 0;
+        rs485_rx_bad = 0;
+        NVIC_EnableIRQ(RS485_USART_IRQ);
+        
+        /* 广播帧的处理过程中不回复 */
+        rs485_tx_inhibit = rs485_rx_broadcast;
+    }
+    
+    return len;
+}
+
+/**
+ * @brief  查询等待处理的完整帧数
+ * @note   COBS分帧时为接收队列中的帧数, 原始模式下为0或1
+ * @param  None
+ * @retval 帧数
+ */
+uint8_t rs485_data_available(void)
+{
+    if(rs485_framing == RS485_FRAMING_COBS)
+    {
+        return rs485_frame_count();
+    }
+    
+    return rs485_frame_complete();
+}
+
+/**
+ * @brief  获取接收数据长度
+ * @param  None
+ * @retval 接收数据长度
+ */
+uint16_t rs485_get_rx_length(void)
+{
+    return rs485_rx_count;
+}
+
+/**
+ * @brief  清空接收缓冲区
+ * @param  None
+ * @retval None
+ */
+void rs485_clear_rx_buffer(void)
+{
+    NVIC_DisableIRQ(RS485_USART_IRQ);
+    rs485_rx_count = 0;
+    rs485_rx_flag = 0;
+    rs485_rx_bad = 0;
+    NVIC_EnableIRQ(RS485_USART_IRQ);
+}
+
+/**
+ * @brief  计算波特率分频值及误差
+ * @param  baud: 目标波特率
+ * @param  info: 计算结果
+ * @retval SUCCESS: 分频值可用且误差在允许范围内, ERROR: 超出范围
+ */
+error_status rs485_baud_calc(uint32_t baud, rs485_baud_info_t* info)
+{
+    crm_clocks_freq_type clocks;
+    uint32_t div;
+    
+    crm_clocks_freq_get(&clocks);
+    
+    info->requested = baud;
+    info->pclk = clocks.apb1_freq;
+    info->div = 0;
+    info->actual = 0;
+    info->error_ppm = 0;
+    
+    if(baud == 0)
+    {
+        return ERROR;
+    }
+    
+    /* 四舍五入到最近的分频值, 低4位即为小数分频 */
+    div = (info->pclk + baud / 2) / baud;
+    if((div < RS485_USART_DIV_MIN) || (div > RS485_USART_DIV_MAX))
+    {
+        return ERROR;
+    }
+    
+    info->div = (uint16_t)div;
+    info->actual = (info->pclk + div / 2) / div;
+    info->error_ppm = (int32_t)(((int64_t)info->actual - baud) * 1000000 / baud);
+    
+    if((info->error_ppm > RS485_BAUD_MAX_ERROR_PPM) || (info->error_ppm < -RS485_BAUD_MAX_ERROR_PPM))
+    {
+        return ERROR;
+    }
+    
+    return SUCCESS;
+}
+
+/**
+ * @brief  设置波特率 (等待当前发送完成后生效)
+ * @param  baud: 目标波特率
+ * @retval SUCCESS/ERROR
+ */
+error_status rs485_set_baudrate(uint32_t baud)
+{
+    rs485_baud_info_t info;
+    
+    if(rs485_baud_calc(baud, &info) != SUCCESS)
+    {
+        return ERROR;
+    }
+    
+    /* 等待正在发送的帧和字节完成 */
+    rs485_tx_wait_idle();
+    rs485_wait_tdc();
+    
+    usart_enable(RS485_USART, FALSE);
+    RS485_USART->baudr_bit.div = info.div;
+    usart_enable(RS485_USART, TRUE);
+    
+    rs485_baudrate = baud;
+    rs485_timing_update();
+    
+    return SUCCESS;
+}
+
+/**
+ * @brief  获取当前波特率
+ * @param  None
+ * @retval 当前请求的波特率
+ */
+uint32_t rs485_get_baudrate(void)
+{
+    return rs485_baudrate;
+}
+
+/**
+ * @brief  获取当前波特率的分频信息
+ * @param  info: 输出
+ * @retval None
+ */
+void rs485_get_baud_info(rs485_baud_info_t* info)
+{
+    rs485_baud_calc(rs485_baudrate, info);
+}
+
+/**
+ * @brief  获取线路错误统计
+ * @param  stats: 输出
+ * @retval None
+ */
+void rs485_get_line_stats(rs485_line_stats_t* stats)
+{
+    stats->rx_bytes = metrics_counters[METRIC_RS485_RX_BYTES];
+    stats->framing = metrics_counters[METRIC_RS485_FRAMING_ERR];
+    stats->noise = metrics_counters[METRIC_RS485_NOISE_ERR];
+    stats->parity = metrics_counters[METRIC_RS485_PARITY_ERR];
+    stats->overrun = metrics_counters[METRIC_RS485_USART_OVERRUN];
+    stats->error_rate = metrics_gauges[METRIC_GAUGE_RS485_ERR_RATE];
+}
+
+/**
+ * @brief  线路质量统计, 在主循环中调用
+ * @note   每接收 RS485_LINE_QUALITY_BYTES 字节, 按该窗口内的错误数算出每万字节错误数,
+ *         写入仪表 RS485_ERR_RATE. 按字节数而不是时间分窗口, 通信量低时也不会因样本少而跳变
+ * @param  None
+ * @retval None
+ */
+void rs485_line_poll(void)
+{
+    uint32_t bytes = metrics_counters[METRIC_RS485_RX_BYTES] - rs485_line_bytes_mark;
+    uint32_t errors;
+    
+    if(bytes < RS485_LINE_QUALITY_BYTES)
+    {
+        return;
+    }
+    
+    errors = rs485_line_error_total() - rs485_line_errors_mark;
+    rs485_line_bytes_mark += bytes;
+    rs485_line_errors_mark += errors;
+    
+    METRIC_GAUGE_SET(METRIC_GAUGE_RS485_ERR_RATE, (uint32_t)((uint64_t)errors * 10000 / bytes));
+}
+
+/**
+ * @brief  获取当前波特率下的帧间隔
+ * @param  None
+ * @retval 帧间隔 (us)
+ */
+uint32_t rs485_frame_timeout_us(void)
+{
+    uint32_t gap_bits = RS485_FRAME_GAP_CHARS_X10 * RS485_BITS_PER_CHAR / 10;
+    
+    return (gap_bits * 1000000 + rs485_baudrate - 1) / rs485_baudrate;
+}
+
+/**
+ * @brief  开始协商切换波特率
+ * @note   调用前应已在旧波特率下回复; 切换后在 RS485_BAUD_CONFIRM_TIMEOUT
+ *         内未收到确认则回退
+ * @param  baud: 新波特率
+ * @retval SUCCESS/ERROR
+ */
+error_status rs485_baud_switch_begin(uint32_t baud)
+{
+    uint32_t prev = rs485_baudrate;
+    
+    if(rs485_set_baudrate(baud) != SUCCESS)
+    {
+        return ERROR;
+    }
+    
+    /* 连续切换时保留最初的可用波特率 */
+    if(!rs485_switch_pending)
+    {
+        rs485_prev_baudrate = prev;
+    }
+    
+    rs485_switch_start = DWT->CYCCNT;
+    rs485_switch_pending = 1;
+    
+    return SUCCESS;
+}
+
+/**
+ * @brief  确认波特率切换并保存到配置存储
+ * @param  None
+ * @retval SUCCESS: 有待确认的切换, ERROR: 无
+ */
+error_status rs485_baud_switch_confirm(void)
+{
+    if(!rs485_switch_pending)
+    {
+        return ERROR;
+    }
+    
+    rs485_switch_pending = 0;
+    config_set(CONFIG_KEY_BAUDRATE, &rs485_baudrate, sizeof(rs485_baudrate));
+    
+    return SUCCESS;
+}
+
+/**
+ * @brief  把测得的波特率对齐到最近的标准值
+ * @param  baud: 测量值
+ * @retval 标准波特率, 无接近的标准值时返回测量值
+ */
+static uint32_t rs485_autobaud_snap(uint32_t baud)
+{
+    for(uint8_t i = 0; i < sizeof(rs485_standard_baudrates) / sizeof(rs485_standard_baudrates[0]); i++)
+    {
+        uint32_t std = rs485_standard_baudrates[i];
+        uint32_t diff = (baud > std) ? (baud - std) : (std - baud);
+        
+        if(diff * 100 <= std * RS485_AUTOBAUD_SNAP_PCT)
+        {
+            return std;
+        }
+    }
+    
+    return baud;
+}
+
+/**
+ * @brief  启动自动波特率检测 (PA3输入捕获测量同步字节)
+ * @param  None
+ * @retval None
+ */
+void rs485_autobaud_start(void)
+{
+    tmr_base_init_type tmr_base_struct;
+    tmr_input_config_type tmr_input_struct;
+    crm_clocks_freq_type clocks;
+    
+    /* APB1分频不为1时定时器时钟为APB1的2倍 */
+    crm_clocks_freq_get(&clocks);
+    rs485_autobaud_tmr_clk = (clocks.apb1_freq == clocks.ahb_freq) ? clocks.apb1_freq : clocks.apb1_freq * 2;
+    
+    crm_periph_clock_enable(RS485_AUTOBAUD_TMR_CLK, TRUE);
+    
+    /* 32位自由计数, 不分频 */
+    tmr_base_default_para_init(&tmr_base_struct);
+    tmr_base_struct.tmr_clock_division = TMR_CLOCK_DIV1;
+    tmr_base_struct.tmr_count_direction = TMR_COUNT_UP;
+    tmr_base_struct.tmr_period = 0xFFFFFFFF;
+    tmr_base_struct.tmr_div = 0;
+    tmr_base_init(RS485_AUTOBAUD_TMR, &tmr_base_struct);
+    tmr_32_bit_function_enable(RS485_AUTOBAUD_TMR, TRUE);
+    
+    /* 下降沿捕获 */
+    tmr_input_struct.input_channel_select = RS485_AUTOBAUD_TMR_CHANNEL;
+    tmr_input_struct.input_mapped_select = TMR_CC_CHANNEL_MAPPED_DIRECT;
+    tmr_input_struct.input_polarity_select = TMR_INPUT_FALLING_EDGE;
+    tmr_input_struct.input_filter_value = 0;
+    tmr_input_channel_init(RS485_AUTOBAUD_TMR, &tmr_input_struct, TMR_CHANNEL_INPUT_DIV_1);
+    
+    rs485_autobaud_edge_count = 0;
+    rs485_autobaud_start_cycles = DWT->CYCCNT;
+    rs485_autobaud_state = RS485_AUTOBAUD_RUNNING;
+    
+    /* RX引脚切换到定时器 */
+    gpio_pin_mux_config(RS485_RX_GPIO_PORT, RS485_RX_GPIO_PinSource, RS485_AUTOBAUD_GPIO_AF);
+    
+    tmr_flag_clear(RS485_AUTOBAUD_TMR, RS485_AUTOBAUD_TMR_FLAG);
+    tmr_interrupt_enable(RS485_AUTOBAUD_TMR, RS485_AUTOBAUD_TMR_INT, TRUE);
+    tmr_counter_enable(RS485_AUTOBAUD_TMR, TRUE);
+}
+
+/**
+ * @brief  停止自动波特率检测, RX引脚交还USART
+ * @param  None
  * @retval None
  */
-void rs485_set_mode(rs485_mode_t mode)
+static void rs485_autobaud_stop(void)
 {
-    if(mode == RS485_MODE_TX)
+    tmr_interrupt_enable(RS485_AUTOBAUD_TMR, RS485_AUTOBAUD_TMR_INT, FALSE);
+    tmr_counter_enable(RS485_AUTOBAUD_TMR, FALSE);
+    
+    gpio_pin_mux_config(RS485_RX_GPIO_PORT, RS485_RX_GPIO_PinSource, RS485_RX_GPIO_AF);
+}
+
+/**
+ * @brief  获取自动波特率检测状态
+ * @param  None
+ * @retval rs485_autobaud_state_t
+ */
+rs485_autobaud_state_t rs485_autobaud_get_state(void)
+{
+    return rs485_autobaud_state;
+}
+
+/**
+ * @brief  设置多机寻址模式
+ * @note   寻址模式下接收器静默, 只有发给本机或广播地址的帧产生中断 (地址标记模式见 RS485_ADDR_MARK_GROUP_WAKE);
+ *         帧首的地址字节不放入接收缓冲区, 回复帧自动加上主机地址;
+ *         模式保存到配置存储
+ * @param  mode: rs485_addr_mode_t
+ * @retval SUCCESS/ERROR (模式无效, 或本机地址不能用于地址标记唤醒)
+ */
+error_status rs485_set_addr_mode(rs485_addr_mode_t mode)
+{
+    uint8_t saved = (uint8_t)mode;
+    
+    if((mode > RS485_ADDR_MODE_ADDRESS_MARK) ||
+       ((mode == RS485_ADDR_MODE_ADDRESS_MARK) && !RS485_ADDR_MARK_ADDR_OK(rs485_node_address)))
     {
-        gpio_bits_set(RS485_DE_GPIO_PORT, RS485_DE_GPIO_PIN);
+        return ERROR;
     }
-    else
+    
+    /* 等待当前发送完成 */
+    rs485_tx_wait_idle();
+    rs485_wait_tdc();
+    
+    usart_enable(RS485_USART, FALSE);
+    
+    rs485_addr_mode = mode;
+    config_set(CONFIG_KEY_ADDR_MODE, &saved, sizeof(saved));
+    rs485_usart_config();
+    
+    switch(mode)
     {
-        gpio_bits_reset(RS485_DE_GPIO_PORT, RS485_DE_GPIO_PIN);
+        case RS485_ADDR_MODE_IDLE_LINE:
+            usart_wakeup_mode_set(RS485_USART, USART_WAKEUP_BY_IDLE_FRAME);
+            usart_interrupt_enable(RS485_USART, USART_IDLE_INT, TRUE);
+            break;
+        
+        case RS485_ADDR_MODE_ADDRESS_MARK:
+            /* 硬件只比较低4位, 完整地址在中断中再次检查 */
+            usart_wakeup_mode_set(RS485_USART, USART_WAKEUP_BY_MATCHING_ID);
+            usart_wakeup_id_set(RS485_USART, RS485_ADDR_MARK_WAKE_ID(rs485_node_address));
+            usart_interrupt_enable(RS485_USART, USART_IDLE_INT, FALSE);
+            break;
+        
+        default:
+            usart_interrupt_enable(RS485_USART, USART_IDLE_INT, FALSE);
+            break;
     }
     
-    /* 模式切换延时 */
-    delay_us(10);
+    /* 重新计算分频值并使能USART */
+    rs485_set_baudrate(rs485_baudrate);
+    
+    rs485_rx_broadcast = 0;
+    rs485_tx_inhibit = 0;
+    rs485_addr_expect = (mode != RS485_ADDR_MODE_OFF) ? 1 : 0;
+    usart_receiver_mute_enable(RS485_USART, (mode != RS485_ADDR_MODE_OFF) ? TRUE : FALSE);
+    
+    return SUCCESS;
 }
 
 /**
- * @brief  RS485初始化
+ * @brief  获取多机寻址模式
  * @param  None
- * @retval None
+ * @retval rs485_addr_mode_t
  */
-void rs485_init(void)
+rs485_addr_mode_t rs485_get_addr_mode(void)
 {
-    usart_init_type usart_init_struct;
+    return rs485_addr_mode;
+}
+
+/**
+ * @brief  设置本机地址并保存到配置存储 (后台写入Flash)
+ * @param  addr: 本机地址 (不能为广播地址或主机地址; 地址标记模式下须满足 RS485_ADDR_MARK_ADDR_OK)
+ * @retval SUCCESS/ERROR
+ */
+error_status rs485_set_node_address(uint8_t addr)
+{
+    if((addr == RS485_BROADCAST_ADDRESS) || (addr == RS485_MASTER_ADDRESS) ||
+       ((rs485_addr_mode == RS485_ADDR_MODE_ADDRESS_MARK) && !RS485_ADDR_MARK_ADDR_OK(addr)))
+    {
+        return ERROR;
+    }
     
-    /* 使能USART2时钟 */
-    crm_periph_clock_enable(RS485_USART_CLK, TRUE);
+    rs485_node_address = addr;
+    config_set(CONFIG_KEY_NODE_ADDRESS, &addr, sizeof(addr));
     
-    /* USART2配置 */
-    usart_default_para_init(&usart_init_struct);
-    usart_init_struct.baudrate = 115200;
-    usart_init_struct.data_bit = USART_DATA_8BITS;
-    usart_init_struct.stop_bit = USART_STOP_1_BIT;
-    usart_init_struct.parity = USART_PARITY_NONE;
-    usart_init_struct.hardware_flow_control = USART_HARDWARE_FLOW_NONE;
-    usart_init_struct.mode = USART_MODE_TX | USART_MODE_RX;
-    usart_init(RS485_USART, &usart_init_struct);
+    if(rs485_addr_mode == RS485_ADDR_MODE_ADDRESS_MARK)
+    {
+        usart_wakeup_id_set(RS485_USART, RS485_ADDR_MARK_WAKE_ID(addr));
+    }
     
-    /* 使能USART2接收中断 */
-    usart_interrupt_enable(RS485_USART, USART_RDBF_INT, TRUE);
+    return SUCCESS;
+}
+
+/**
+ * @brief  获取本机地址
+ * @param  None
+ * @retval 本机地址
+ */
+uint8_t rs485_get_node_address(void)
+{
+    return rs485_node_address;
+}
+
+/**
+ * @brief  设置接收分帧方式
+ * @param  framing: rs485_framing_t
+ * @retval None
+ */
+void rs485_set_framing(rs485_framing_t framing)
+{
+    usart_interrupt_enable(RS485_USART, USART_RDBF_INT, FALSE);
     
-    /* 使能USART2 */
-    usart_enable(RS485_USART, TRUE);
+    rs485_framing = framing;
+    rs485_clear_rx_buffer();
+    rs485_frame_rx_reset();
     
-    /* 设置RS485为接收模式 */
-    rs485_set_mode(RS485_MODE_RX);
+    usart_interrupt_enable(RS485_USART, USART_RDBF_INT, TRUE);
 }
 
 /**
- * @brief  发送单个字节
- * @param  data: 要发送的字节
+ * @brief  获取接收分帧方式
+ * @param  None
+ * @retval rs485_framing_t
+ */
+rs485_framing_t rs485_get_framing(void)
+{
+    return rs485_framing;
+}
+
+/**
+ * @brief  进入/退出总线监听
+ * @note   进入前等待发送完成; 监听期间接收器不静默, 收到的所有字节由DMA取走 (调用前配置好接收DMA通道),
+ *         接收中断只调用 isr, 不解码帧也不发送. 退出后按当前寻址和分帧方式恢复接收
+ * @param  isr: 监听中断处理函数, NULL退出监听
  * @retval None
  */
-void rs485_send_byte(uint8_t data)
+void rs485_set_sniff(rs485_sniff_isr_t isr)
 {
-    rs485_set_mode(RS485_MODE_TX);
+    if(isr != NULL)
+    {
+        rs485_tx_wait_idle();
+        rs485_wait_tdc();
+        rs485_set_mode(RS485_MODE_RX);
+        
+        usart_interrupt_enable(RS485_USART, USART_RDBF_INT, FALSE);
+        usart_receiver_mute_enable(RS485_USART, FALSE);
+        rs485_sniff_isr = isr;
+        usart_flag_clear(RS485_USART, USART_IDLEF_FLAG);
+        usart_interrupt_enable(RS485_USART, USART_IDLE_INT, TRUE);
+        usart_dma_receiver_enable(RS485_USART, TRUE);
+        return;
+    }
     
-    /* 等待发送缓冲区空 */
-    while(usart_flag_get(RS485_USART, USART_TDC_FLAG) == RESET);
+    usart_dma_receiver_enable(RS485_USART, FALSE);
+    NVIC_DisableIRQ(RS485_USART_IRQ);
+    rs485_sniff_isr = NULL;
+    NVIC_EnableIRQ(RS485_USART_IRQ);
     
-    /* 发送数据 */
-    usart_data_transmit(RS485_USART, data);
+    usart_interrupt_enable(RS485_USART, USART_IDLE_INT,
+                           (rs485_addr_mode == RS485_ADDR_MODE_IDLE_LINE) ? TRUE : FALSE);
+    rs485_clear_rx_buffer();
+    rs485_frame_rx_reset();
+    rs485_rx_broadcast = 0;
+    rs485_addr_expect = (rs485_addr_mode != RS485_ADDR_MODE_OFF) ? 1 : 0;
+    usart_receiver_mute_enable(RS485_USART, (rs485_addr_mode != RS485_ADDR_MODE_OFF) ? TRUE : FALSE);
+    usart_interrupt_enable(RS485_USART, USART_RDBF_INT, TRUE);
+}
+
+/**
+ * @brief  发送加锁, 与 rs485_tx_unlock 成对调用
+ * @note   FreeRTOS下多个任务发送时串行化 (可递归), 裸机为空操作; 只在任务中调用
+ * @param  None
+ * @retval None
+ */
+void rs485_tx_lock(void)
+{
+    os_mutex_lock(&rs485_tx_mutex);
+}
+
+/**
+ * @brief  发送解锁
+ * @param  None
+ * @retval None
+ */
+void rs485_tx_unlock(void)
+{
+    os_mutex_unlock(&rs485_tx_mutex);
+}
+
+/**
+ * @brief  获取空闲的发送DMA缓冲区
+ * @note   一个缓冲区在发送时立即返回另一个; 两个都占用 (一帧在发送或推迟, 一帧在排队) 时
+ *         等待排队的帧开始发送, 超时则中止发送
+ * @param  None
+ * @retval 缓冲区指针, 大小为 RS485_TX_BUFFER_SIZE
+ */
+uint8_t* rs485_tx_acquire(void)
+{
+    uint32_t start = DWT->CYCCNT;
     
-    /* 等待发送完成 */
-    while(usart_flag_get(RS485_USART, USART_TDC_FLAG) == RESET);
+    while(rs485_tx_pending_len != 0)
+    {
+        rs485_tx_poll();
+        
+        if((DWT->CYCCNT - start) > rs485_char_cycles * (RS485_TX_DEFER_MAX_CHARS + RS485_TX_BUFFER_SIZE))
+        {
+            rs485_tx_abort();
+            break;
+        }
+    }
     
-    rs485_set_mode(RS485_MODE_RX);
+    return rs485_tx_dma_buffer[rs485_tx_fill];
 }
 
 /**
- * @brief  发送字符串
- * @param  str: 要发送的字符串
+ * @brief  启动DMA发送 rs485_tx_acquire 返回的缓冲区
+ * @note   上一帧还在发送时排队, 由USART中断在其最后一个字节移出后接着发送,
+ *         DE保持发送状态, 不再经过收发切换延时. DE在最后一帧结束后由中断切回接收.
+ *         主站仍在连续发送 (批量请求) 时也排队, 由 rs485_tx_poll 在其停止后发送, 避免总线冲突
+ * @param  len: 发送长度
  * @retval None
  */
-void rs485_send_string(const char* str)
+void rs485_tx_start(uint16_t len)
 {
-    rs485_set_mode(RS485_MODE_TX);
+    uint8_t* buf = rs485_tx_dma_buffer[rs485_tx_fill];
     
-    while(*str)
+    if(rs485_tx_inhibit || (len == 0))
     {
-        /* 等待发送缓冲区空 */
-        while(usart_flag_get(RS485_USART, USART_TDC_FLAG) == RESET);
-        
-        /* 发送数据 */
-        usart_data_transmit(RS485_USART, *str++);
+        return;
     }
     
-    /* 等待发送完成 */
-    while(usart_flag_get(RS485_USART, USART_TDC_FLAG) == RESET);
+    rs485_tx_fill = (rs485_tx_fill + 1) % RS485_TX_BUFFER_NUM;
     
-    rs485_set_mode(RS485_MODE_RX);
+    /* 与发送完成中断互斥: 判断忙和排队须是一个整体 */
+    NVIC_DisableIRQ(RS485_USART_IRQ);
+    if(rs485_tx_dma_busy || !rs485_rx_quiet())
+    {
+        rs485_tx_pending_buf = buf;
+        rs485_tx_pending_len = len;
+        NVIC_EnableIRQ(RS485_USART_IRQ);
+        return;
+    }
+    rs485_tx_dma_busy = 1;
+    NVIC_EnableIRQ(RS485_USART_IRQ);
+    
+    rs485_tx_begin(buf, len);
 }
 
 /**
- * @brief  发送数据缓冲区
- * @param  data: 数据缓冲区指针
- * @param  len: 数据长度
+ * @brief  发送因主站连续发送而推迟的帧
+ * @note   主循环中调用; 正在发送时排队的帧由中断接着发送, 这里不处理
+ * @param  None
  * @retval None
  */
-void rs485_send_buffer(uint8_t* data, uint16_t len)
+void rs485_tx_poll(void)
 {
-    rs485_set_mode(RS485_MODE_TX);
+    uint8_t* buf;
+    uint16_t len;
     
-    for(uint16_t i = 0; i < len; i++)
+    if((rs485_tx_pending_len == 0) || rs485_tx_dma_busy || !rs485_rx_quiet())
     {
-        /* 等待发送缓冲区空 */
-        while(usart_flag_get(RS485_USART, USART_TDC_FLAG) == RESET);
-        
-        /* 发送数据 */
-        usart_data_transmit(RS485_USART, data[i]);
+        return;
     }
     
-    /* 等待发送完成 */
-    while(usart_flag_get(RS485_USART, USART_TDC_FLAG) == RESET);
+    NVIC_DisableIRQ(RS485_USART_IRQ);
+    if(rs485_tx_dma_busy || (rs485_tx_pending_len == 0))
+    {
+        NVIC_EnableIRQ(RS485_USART_IRQ);
+        return;
+    }
+    buf = rs485_tx_pending_buf;
+    len = rs485_tx_pending_len;
+    rs485_tx_pending_len = 0;
+    rs485_tx_dma_busy = 1;
+    NVIC_EnableIRQ(RS485_USART_IRQ);
     
-    rs485_set_mode(RS485_MODE_RX);
+    rs485_tx_begin(buf, len);
 }
 
 /**
- * @brief  接收数据
- * @param  data: 数据缓冲区指针
- * @param  max_len: 最大接收长度
- * @retval 实际接收长度
+ * @brief  查询DMA发送是否进行中
+ * @param  None
+ * @retval 1: 发送中或有排队的帧, 0: 空闲
  */
-uint16_t rs485_receive_data(uint8_t* data, uint16_t max_len)
+uint8_t rs485_tx_busy(void)
 {
-    uint16_t len = 0;
-    
-    if(rs485_rx_flag)
+    return (rs485_tx_dma_busy || (rs485_tx_pending_len != 0)) ? 1 : 0;
+}
+
+/**
+ * @brief  查询总线是否空闲 (未在发送且无排队的帧, 距最后接收字节已超过帧间隔)
+ * @note   用于选择切换时钟等会打断收发的操作的时机
+ * @param  None
+ * @retval 1: 空闲, 0: 忙
+ */
+uint8_t rs485_line_idle(void)
+{
+    if(rs485_tx_dma_busy || (rs485_tx_pending_len != 0))
     {
-        len = (rs485_rx_count < max_len) ? rs485_rx_count : max_len;
-        
-        for(uint16_t i = 0; i < len; i++)
-        {
-            data[i] = rs485_rx_buffer[i];
-        }
-        
-        /* 清空接收缓冲区 */
-        rs485_rx_count = 0;
-        rs485_rx_flag = 0;
+        return 0;
     }
     
-    return len;
+    return ((DWT->CYCCNT - rs485_last_rx_cycles) >= rs485_frame_gap_cycles) ? 1 : 0;
 }
 
 /**
- * @brief  检查是否有数据接收
+ * @brief  发送DMA中断服务函数
+ * @note   DMA传输完成时最后一个字节仍在移位, 等USART发送完成中断再切换DE
  * @param  None
- * @retval 1: 有数据, 0: 无数据
+ * @retval None
  */
-uint8_t rs485_data_available(void)
+RAMFUNC void RS485_TX_DMA_IRQHandler(void)
 {
-    return rs485_rx_flag;
+    if(dma_flag_get(RS485_TX_DMA_FDT_FLAG) != RESET)
+    {
+        dma_flag_clear(RS485_TX_DMA_FDT_FLAG);
+        dma_channel_enable(RS485_TX_DMA_CHANNEL, FALSE);
+        usart_interrupt_enable(RS485_USART, USART_TDC_INT, TRUE);
+    }
 }
 
 /**
- * @brief  获取接收数据长度
+ * @brief  开始处理一帧
+ * @note   广播帧处理期间抑制发送, 处理完成后调用 rs485_frame_release
+ * @param  broadcast: 1为广播帧
+ * @retval None
+ */
+void rs485_frame_claim(uint8_t broadcast)
+{
+    rs485_tx_inhibit = broadcast;
+}
+
+/**
+ * @brief  结束当前帧的处理
+ * @note   广播帧处理期间的发送被抑制, 处理完成后调用以恢复发送
  * @param  None
- * @retval 接收数据长度
+ * @retval None
  */
-uint16_t rs485_get_rx_length(void)
+void rs485_frame_release(void)
 {
-    return rs485_rx_count;
+    rs485_tx_inhibit = 0;
 }
 
 /**
- * @brief  清空接收缓冲区
+ * @brief  波特率相关超时处理, 在主循环中调用
  * @param  None
  * @retval None
  */
-void rs485_clear_rx_buffer(void)
+void rs485_baud_poll(void)
 {
-    rs485_rx_count = 0;
-    rs485_rx_flag = 0;
+    /* 未在新波特率下收到确认, 回退 */
+    if(rs485_switch_pending &&
+       (DWT->CYCCNT - rs485_switch_start) > RS485_MS_TO_CYCLES(RS485_BAUD_CONFIRM_TIMEOUT))
+    {
+        rs485_switch_pending = 0;
+        rs485_set_baudrate(rs485_prev_baudrate);
+    }
+    
+    if((rs485_autobaud_state == RS485_AUTOBAUD_RUNNING) &&
+       (DWT->CYCCNT - rs485_autobaud_start_cycles) > RS485_MS_TO_CYCLES(RS485_AUTOBAUD_TIMEOUT))
+    {
+        rs485_autobaud_stop();
+        rs485_autobaud_state = RS485_AUTOBAUD_FAILED;
+    }
+}
+
+/**
+ * @brief  自动波特率定时器中断服务函数
+ * @param  None
+ * @retval None
+ */
+void RS485_AUTOBAUD_TMR_IRQHandler(void)
+{
+    uint32_t total;
+    uint32_t expect;
+    uint8_t i;
+    
+    if(tmr_interrupt_flag_get(RS485_AUTOBAUD_TMR, RS485_AUTOBAUD_TMR_FLAG) == RESET)
+    {
+        return;
+    }
+    
+    rs485_autobaud_edges[rs485_autobaud_edge_count++] =
+        tmr_channel_value_get(RS485_AUTOBAUD_TMR, RS485_AUTOBAUD_TMR_CHANNEL);
+    tmr_flag_clear(RS485_AUTOBAUD_TMR, RS485_AUTOBAUD_TMR_FLAG);
+    
+    if(rs485_autobaud_edge_count < RS485_AUTOBAUD_EDGES)
+    {
+        return;
+    }
+    
+    /* 每两个下降沿间隔应为2个位时间, 偏差超过25%视为噪声, 丢弃最早的沿继续 */
+    total = rs485_autobaud_edges[RS485_AUTOBAUD_EDGES - 1] - rs485_autobaud_edges[0];
+    expect = total / (RS485_AUTOBAUD_EDGES - 1);
+    for(i = 1; i < RS485_AUTOBAUD_EDGES; i++)
+    {
+        uint32_t interval = rs485_autobaud_edges[i] - rs485_autobaud_edges[i - 1];
+        
+        if((interval * 4 < expect * 3) || (interval * 4 > expect * 5))
+        {
+            for(i = 1; i < RS485_AUTOBAUD_EDGES; i++)
+            {
+                rs485_autobaud_edges[i - 1] = rs485_autobaud_edges[i];
+            }
+            rs485_autobaud_edge_count = RS485_AUTOBAUD_EDGES - 1;
+            return;
+        }
+    }
+    
+    rs485_autobaud_stop();
+    
+    /* 除法和重新配置USART交给底半部 */
+    if(irq_defer_post(rs485_autobaud_finish, total) != SUCCESS)
+    {
+        rs485_autobaud_state = RS485_AUTOBAUD_FAILED;
+    }
+}
+
+/**
+ * @brief  自动波特率底半部: 由测得的位时间计算波特率并设置 (PendSV中执行)
+ * @param  total: 首末下降沿间隔 (定时器计数)
+ * @retval None
+ */
+static void rs485_autobaud_finish(uint32_t total)
+{
+    uint32_t baud;
+    
+    if(rs485_autobaud_state != RS485_AUTOBAUD_RUNNING)
+    {
+        return;
+    }
+    
+    baud = (total != 0) ? (uint32_t)((uint64_t)rs485_autobaud_tmr_clk * RS485_AUTOBAUD_BITS / total) : 0;
+    
+    if(rs485_set_baudrate(rs485_autobaud_snap(baud)) == SUCCESS)
+    {
+        rs485_autobaud_state = RS485_AUTOBAUD_DONE;
+    }
+    else
+    {
+        rs485_autobaud_state = RS485_AUTOBAUD_FAILED;
+    }
 }
 
 /**
@@ -207,23 +1507,122 @@ void rs485_clear_rx_buffer(void)
  * @param  None
  * @retval None
  */
-void RS485_USART_IRQHandler(void)
+RAMFUNC void RS485_USART_IRQHandler(void)
 {
-    if(usart_interrupt_flag_get(RS485_USART, USART_RDBF_INT) != RESET)
+    uint32_t t_enter = DWT->CYCCNT;
+    
+    /* 总线监听: 字节由DMA接收, 中断只处理空闲线和线路错误 */
+    if(rs485_sniff_isr != NULL)
     {
-        /* 读取接收数据 */
-        uint8_t data = usart_data_receive(RS485_USART);
+        rs485_sniff_isr();
+        METRIC_ISR_EXIT(t_enter);
+        return;
+    }
+    
+    /* 线路错误: 读数据寄存器清除错误标志 (溢出标志不清除会持续触发中断), 出错字节丢弃并重新同步 */
+    if(rs485_rx_line_error())
+    {
+        (void)usart_data_receive(RS485_USART);
+        METRIC_INC(METRIC_RS485_RX_BYTES);
+        rs485_last_rx_cycles = DWT->CYCCNT;
+        rs485_rx_resync();
+    }
+    else if(usart_interrupt_flag_get(RS485_USART, USART_RDBF_INT) != RESET)
+    {
+        /* 读取接收数据, 9位模式下第9位为地址标记 */
+        uint16_t raw = usart_data_receive(RS485_USART);
+        uint8_t data = (uint8_t)raw;
+        
+        TRACE(TRACE_EVT_USART_RX, data);
+        METRIC_INC(METRIC_RS485_RX_BYTES);
         
-        /* 存储到接收缓冲区 */
-        if(rs485_rx_count < RS485_RX_BUFFER_SIZE)
+        /* 地址字节: 不是发给本机的帧则重新静默, 直到下一帧才会再产生中断 */
+        if((rs485_addr_mode != RS485_ADDR_MODE_OFF) &&
+           (rs485_addr_expect || (raw & RS485_ADDRESS_MARK_BIT)))
         {
-            rs485_rx_buffer[rs485_rx_count++] = data;
+            if((data == rs485_node_address) || (data == RS485_BROADCAST_ADDRESS))
+            {
+                rs485_addr_expect = 0;
+                rs485_rx_broadcast = (data == RS485_BROADCAST_ADDRESS) ? 1 : 0;
+            }
+            else
+            {
+                rs485_addr_expect = 1;
+                usart_receiver_mute_enable(RS485_USART, TRUE);
+            }
+            
+            usart_flag_clear(RS485_USART, USART_RDBF_FLAG);
+            METRIC_ISR_EXIT(t_enter);
+            return;
         }
         
-        /* 设置接收标志 */
-        rs485_rx_flag = 1;
+        rs485_last_rx_cycles = DWT->CYCCNT;
+        CLOCK_PROFILE_ACTIVITY();
+        
+        if(rs485_framing == RS485_FRAMING_COBS)
+        {
+            /* 直接解码到帧缓冲区 */
+            rs485_frame_rx_byte(data, rs485_rx_broadcast);
+        }
+        else
+        {
+            /* 存储到接收缓冲区 */
+            if(rs485_rx_count < RS485_RX_BUFFER_SIZE)
+            {
+                rs485_rx_buffer[rs485_rx_count++] = data;
+            }
+            else
+            {
+                METRIC_INC(METRIC_RS485_RX_OVERRUN);
+            }
+            
+            /* 设置接收标志 */
+            rs485_rx_flag = 1;
+        }
         
         /* 清除中断标志 */
         usart_flag_clear(RS485_USART, USART_RDBF_FLAG);
     }
+    
+    /* DMA发送的最后一个字节已移出: 有排队的帧则接着发送, 否则切回接收 */
+    if(usart_interrupt_flag_get(RS485_USART, USART_TDC_FLAG) != RESET)
+    {
+        usart_interrupt_enable(RS485_USART, USART_TDC_INT, FALSE);
+        TRACE(TRACE_EVT_USART_TX_END, 0);
+        
+        if(rs485_tx_pending_len != 0)
+        {
+            TRACE(TRACE_EVT_USART_TX_START, rs485_tx_pending_len);
+            METRIC_INC(METRIC_RS485_TX_CHAINED);
+            
+            /* 空闲线模式: 重新使能发送器插入一个空闲帧, 其他节点据此识别地址字节 */
+            if(rs485_addr_mode == RS485_ADDR_MODE_IDLE_LINE)
+            {
+                RS485_USART->ctrl1_bit.ten = FALSE;
+                RS485_USART->ctrl1_bit.ten = TRUE;
+            }
+            if(rs485_addr_mode != RS485_ADDR_MODE_OFF)
+            {
+                RS485_USART->dt = RS485_MASTER_ADDRESS |
+                                  ((rs485_addr_mode == RS485_ADDR_MODE_ADDRESS_MARK) ? RS485_ADDRESS_MARK_BIT : 0);
+            }
+            
+            rs485_tx_dma_kick(rs485_tx_pending_buf, rs485_tx_pending_len);
+            rs485_tx_pending_len = 0;
+        }
+        else
+        {
+            gpio_bits_reset(RS485_DE_GPIO_PORT, RS485_DE_GPIO_PIN);
+            rs485_tx_dma_busy = 0;
+        }
+    }
+    
+    /* 空闲线模式下本机帧结束, 下一个字节为地址 */
+    if(usart_interrupt_flag_get(RS485_USART, USART_IDLEF_FLAG) != RESET)
+    {
+        usart_flag_clear(RS485_USART, USART_IDLEF_FLAG);
+        rs485_addr_expect = 1;
+    }
+    
+    METRIC_ISR_EXIT(t_enter);
 }
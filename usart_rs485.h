@@ -22,7 +22,139 @@ typedef enum
     RS485_MODE_RX = 1   /*!< 接收模式 */
 } rs485_mode_t;
 
+/**
+ * @brief  波特率分频结果
+ */
+typedef struct
+{
+    uint32_t requested;     /*!< 请求波特率 */
+    uint32_t actual;        /*!< 实际波特率 = pclk / div */
+    uint32_t pclk;          /*!< USART时钟 (Hz) */
+    uint16_t div;           /*!< 分频值 (低4位为小数部分) */
+    int32_t error_ppm;      /*!< 波特率误差 (ppm) */
+} rs485_baud_info_t;
+
+/**
+ * @brief  多机寻址模式
+ */
+typedef enum
+{
+    RS485_ADDR_MODE_OFF = 0,        /*!< 不寻址, 接收所有字节 */
+    RS485_ADDR_MODE_IDLE_LINE,      /*!< 空闲线唤醒, 每帧首字节为地址 */
+    RS485_ADDR_MODE_ADDRESS_MARK    /*!< 9位地址标记唤醒, 硬件匹配地址低4位 */
+} rs485_addr_mode_t;
+
+/**
+ * @brief  接收分帧方式
+ */
+typedef enum
+{
+    RS485_FRAMING_RAW = 0,      /*!< 按帧间隔分帧, 使用 rs485_receive_data */
+    RS485_FRAMING_COBS          /*!< COBS编码, 0x00为帧界, 使用 rs485_frame_get */
+} rs485_framing_t;
+
+/**
+ * @brief  自动波特率检测状态
+ */
+typedef enum
+{
+    RS485_AUTOBAUD_IDLE = 0,    /*!< 未启动 */
+    RS485_AUTOBAUD_RUNNING,     /*!< 等待同步字节 */
+    RS485_AUTOBAUD_DONE,        /*!< 检测成功, 已切换波特率 */
+    RS485_AUTOBAUD_FAILED       /*!< 超时或测量值无效 */
+} rs485_autobaud_state_t;
+
+/**
+ * @brief  线路错误统计 (上电以来的累计值和最近的错误率)
+ */
+typedef struct
+{
+    uint32_t rx_bytes;      /*!< 接收字节数 (含出错字节) */
+    uint32_t framing;       /*!< 帧错误 (停止位处为低电平) */
+    uint32_t noise;         /*!< 噪声错误 (一位内的采样不一致) */
+    uint32_t parity;        /*!< 校验错误 (使能校验时) */
+    uint32_t overrun;       /*!< USART接收溢出 */
+    uint32_t error_rate;    /*!< 每万字节错误数 (最近 RS485_LINE_QUALITY_BYTES 字节) */
+} rs485_line_stats_t;
+
+/**
+ * @brief  总线监听时的接收中断处理 (空闲线和线路错误, 字节由DMA接收)
+ */
+typedef void (*rs485_sniff_isr_t)(void);
+
 /* Exported constants --------------------------------------------------------*/
+/* RS485命令字 */
+#define RS485_CMD_TRACE_DUMP        0xA0    /*!< 转储跟踪缓冲区 */
+#define RS485_CMD_STATS_QUERY       0xA1    /*!< 查询运行统计快照 */
+#define RS485_CMD_BAUD_SWITCH       0xA2    /*!< 协商切换波特率, 参数: 波特率(u32) */
+#define RS485_CMD_BAUD_CONFIRM      0xA3    /*!< 在新波特率下确认切换 */
+#define RS485_CMD_BAUD_QUERY        0xA4    /*!< 查询当前波特率及分频误差 */
+#define RS485_CMD_AUTOBAUD          0xA5    /*!< 进入自动波特率检测 */
+#define RS485_CMD_SET_ADDRESS       0xA6    /*!< 设置本机地址和寻址模式, 参数: 地址, 模式 */
+#define RS485_CMD_BOOT_TIMELINE     0xA7    /*!< 查询启动各阶段时间戳 */
+#define RS485_CMD_CLOCK_PROFILE     0xA8    /*!< 设置/查询时钟档位, 参数: 档位(0xFF不变), 自动降频 */
+#define RS485_CMD_CONFIG            0xA9    /*!< 读写配置项, 参数: 键, [值] (重启后生效) */
+#define RS485_CMD_RESET_CAUSE       0xAA    /*!< 查询上次复位原因和看门狗记录 */
+#define RS485_CMD_FAULT_DUMP        0xAB    /*!< 读取故障记录, 参数: 0x01读取后清除 */
+#define RS485_CMD_FW_UPDATE         0xAC    /*!< 固件更新, 参数: 操作码 (fw_op_t) ... */
+#define RS485_CMD_LIST              0xAD    /*!< 列出命令字和名称, 参数: 起始命令字 */
+#define RS485_CMD_BUZZER            0xAE    /*!< 蜂鸣器, 参数: 频率(u16, 0停止) 时长(u16 ms, 0一直鸣叫) */
+#define RS485_CMD_ALARM             0xAF    /*!< 报警音, 参数: 循环次数 (0停止) */
+#define RS485_CMD_DISPLAY_WRITE     0xB0    /*!< 写显示板, 参数: 寄存器 数据... */
+#define RS485_CMD_CTRL_PINS         0xB1    /*!< 显示板控制引脚, 参数: 掩码 电平 (bit0=CTRL1, bit1=CTRL2) */
+#define RS485_CMD_ECHO              0xB2    /*!< 原样回送参数, 测试链路 */
+#define RS485_CMD_DISPLAY_UPDATE    0xB3    /*!< 显示帧缓冲区更新, 参数: 标志 偏移(u16) 编码数据 */
+#define RS485_CMD_CTRL_SEQ          0xB4    /*!< 控制引脚波形, 参数: 重复次数(u16) {掩码 电平 时间us(u16)}... */
+#define RS485_CMD_CTRL_PWM          0xB5    /*!< 控制引脚PWM, 参数: 引脚 占空比(u16, 0.1%) */
+#define RS485_CMD_DISPLAY_STATS     0xB6    /*!< 各显示设备的状态和实际刷新率 */
+#define RS485_CMD_DISPLAY_SPEED     0xB7    /*!< 显示设备I2C速率, 参数: 设备 [最高档, 带此参数时执行速率探测] */
+#define RS485_CMD_I2C_MODE          0xB8    /*!< I2C总线硬件/软件模式, 参数: 总线 [模式 0硬件 1软件] */
+#define RS485_CMD_I2C_BENCH         0xB9    /*!< 硬件与软件I2C对比测试, 参数: 总线 地址 寄存器 长度 */
+#define RS485_CMD_IRQ_STATS         0xBA    /*!< 各优先级中断延迟统计, 参数: [01 读后清除] */
+#define RS485_CMD_OS_BENCH          0xBB    /*!< FreeRTOS任务切换和中断到任务延迟测量 */
+#define RS485_CMD_SNIFF             0xBC    /*!< 总线监听, 参数: [时长s(u16), 带此参数时开始捕获] */
+
+/* 波特率 */
+#define RS485_DEFAULT_BAUDRATE      115200
+#define RS485_BAUD_MAX_ERROR_PPM    20000   /*!< 允许的最大分频误差 (2%) */
+#define RS485_BAUD_CONFIRM_TIMEOUT  500     /*!< 切换后等待确认的时间 (ms), 超时回退 */
+
+/* 自动波特率 */
+#define RS485_AUTOBAUD_SYNC_BYTE    0x55    /*!< 同步字节, 起始位后每2位一个下降沿 */
+#define RS485_AUTOBAUD_TIMEOUT      2000    /*!< 等待同步字节的时间 (ms) */
+
+/* 发送DMA缓冲区 (须容纳一个COBS编码后的最大帧); 双缓冲, 一个发送时编码下一帧 */
+#define RS485_TX_BUFFER_SIZE        264
+#define RS485_TX_BUFFER_NUM         2
+
+/* 默认分帧方式 */
+#define RS485_FRAMING_DEFAULT       RS485_FRAMING_COBS
+
+/* 多机寻址 */
+#define RS485_BROADCAST_ADDRESS     0xFF    /*!< 广播地址, 不回复 */
+#define RS485_MASTER_ADDRESS        0x00    /*!< 回复帧的目的地址 */
+#define RS485_DEFAULT_NODE_ADDRESS  0x01
+#define RS485_ADDRESS_MARK_BIT      0x100   /*!< 9位模式下的地址标记位 */
+
+/*
+ * 地址标记模式的唤醒ID: 硬件只比较地址字节低4位, 且只能匹配一个值, 本机地址和广播地址不能同时唤醒.
+ * 1: 所有节点按广播地址低4位 (0xF) 唤醒, 本机地址须为 0x0F, 0x1F ... 0xEF (15个节点);
+ *    总线上每帧的地址字节产生1次中断, 由软件比较完整地址, 数据字节不产生中断, 可以接收广播
+ * 0: 按本机地址低4位唤醒, 其他节点的帧不产生中断, 但收不到广播 (本机地址低4位为0xF时除外)
+ */
+#ifndef RS485_ADDR_MARK_GROUP_WAKE
+#define RS485_ADDR_MARK_GROUP_WAKE  1
+#endif
+
+#define RS485_ADDR_MARK_WAKE_ID(addr)   (RS485_ADDR_MARK_GROUP_WAKE ? (RS485_BROADCAST_ADDRESS & 0x0F) : ((addr) & 0x0F))
+#define RS485_ADDR_MARK_ADDR_OK(addr)   (((addr) & 0x0F) == RS485_ADDR_MARK_WAKE_ID(addr))
+
+/* 帧间隔 (以字符时间计, x10), 3.5个字符 */
+#define RS485_FRAME_GAP_CHARS_X10   35
+
+/* 线路质量统计窗口 (接收字节数) */
+#define RS485_LINE_QUALITY_BYTES    10000
+
 /* Exported macro ------------------------------------------------------------*/
 /* Exported functions prototypes ---------------------------------------------*/
 
@@ -71,9 +203,10 @@ void rs485_send_buffer(uint8_t* data, uint16_t len);
 uint16_t rs485_receive_data(uint8_t* data, uint16_t max_len);
 
 /**
- * @brief  检查是否有数据接收
+ * @brief  查询等待处理的完整帧数
+ * @note   COBS分帧时为接收队列中的帧数, 原始模式下为0或1
  * @param  None
- * @retval 1: 有数据, 0: 无数据
+ * @retval 帧数
  */
 uint8_t rs485_data_available(void);
 
@@ -91,6 +224,217 @@ uint16_t rs485_get_rx_length(void);
  */
 void rs485_clear_rx_buffer(void);
 
+/**
+ * @brief  计算波特率分频值及误差
+ * @param  baud: 目标波特率
+ * @param  info: 计算结果
+ * @retval SUCCESS: 分频值可用且误差在允许范围内, ERROR: 超出范围
+ */
+error_status rs485_baud_calc(uint32_t baud, rs485_baud_info_t* info);
+
+/**
+ * @brief  设置波特率 (等待当前发送完成后生效)
+ * @param  baud: 目标波特率
+ * @retval SUCCESS/ERROR
+ */
+error_status rs485_set_baudrate(uint32_t baud);
+
+/**
+ * @brief  获取当前波特率
+ * @param  None
+ * @retval 当前请求的波特率
+ */
+uint32_t rs485_get_baudrate(void);
+
+/**
+ * @brief  获取当前波特率的分频信息
+ * @param  info: 输出
+ * @retval None
+ */
+void rs485_get_baud_info(rs485_baud_info_t* info);
+
+/**
+ * @brief  获取线路错误统计
+ * @param  stats: 输出
+ * @retval None
+ */
+void rs485_get_line_stats(rs485_line_stats_t* stats);
+
+/**
+ * @brief  线路质量统计, 在主循环中调用
+ * @note   每接收 RS485_LINE_QUALITY_BYTES 字节更新一次每万字节错误数 (仪表 RS485_ERR_RATE)
+ * @param  None
+ * @retval None
+ */
+void rs485_line_poll(void);
+
+/**
+ * @brief  获取当前波特率下的帧间隔
+ * @param  None
+ * @retval 帧间隔 (us)
+ */
+uint32_t rs485_frame_timeout_us(void);
+
+/**
+ * @brief  开始协商切换波特率
+ * @note   调用前应已在旧波特率下回复; 切换后在 RS485_BAUD_CONFIRM_TIMEOUT
+ *         内未收到确认则回退
+ * @param  baud: 新波特率
+ * @retval SUCCESS/ERROR
+ */
+error_status rs485_baud_switch_begin(uint32_t baud);
+
+/**
+ * @brief  确认波特率切换并保存到配置存储
+ * @param  None
+ * @retval SUCCESS: 有待确认的切换, ERROR: 无
+ */
+error_status rs485_baud_switch_confirm(void);
+
+/**
+ * @brief  启动自动波特率检测 (PA3输入捕获测量同步字节)
+ * @param  None
+ * @retval None
+ */
+void rs485_autobaud_start(void);
+
+/**
+ * @brief  获取自动波特率检测状态
+ * @param  None
+ * @retval rs485_autobaud_state_t
+ */
+rs485_autobaud_state_t rs485_autobaud_get_state(void);
+
+/**
+ * @brief  设置多机寻址模式
+ * @note   寻址模式下接收器静默, 只有发给本机或广播地址的帧产生中断 (地址标记模式见 RS485_ADDR_MARK_GROUP_WAKE);
+ *         帧首的地址字节不放入接收缓冲区, 回复帧自动加上主机地址;
+ *         模式保存到配置存储
+ * @param  mode: rs485_addr_mode_t
+ * @retval SUCCESS/ERROR (模式无效, 或本机地址不能用于地址标记唤醒)
+ */
+error_status rs485_set_addr_mode(rs485_addr_mode_t mode);
+
+/**
+ * @brief  获取多机寻址模式
+ * @param  None
+ * @retval rs485_addr_mode_t
+ */
+rs485_addr_mode_t rs485_get_addr_mode(void);
+
+/**
+ * @brief  设置本机地址并保存到配置存储 (后台写入Flash)
+ * @param  addr: 本机地址 (不能为广播地址或主机地址; 地址标记模式下须满足 RS485_ADDR_MARK_ADDR_OK)
+ * @retval SUCCESS/ERROR
+ */
+error_status rs485_set_node_address(uint8_t addr);
+
+/**
+ * @brief  获取本机地址
+ * @param  None
+ * @retval 本机地址
+ */
+uint8_t rs485_get_node_address(void);
+
+/**
+ * @brief  设置接收分帧方式
+ * @param  framing: rs485_framing_t
+ * @retval None
+ */
+void rs485_set_framing(rs485_framing_t framing);
+
+/**
+ * @brief  获取接收分帧方式
+ * @param  None
+ * @retval rs485_framing_t
+ */
+rs485_framing_t rs485_get_framing(void);
+
+/**
+ * @brief  进入/退出总线监听
+ * @note   进入前等待发送完成; 监听期间接收器不静默, 收到的所有字节由DMA取走 (调用前配置好接收DMA通道),
+ *         接收中断只调用 isr, 不解码帧也不发送. 退出后按当前寻址和分帧方式恢复接收
+ * @param  isr: 监听中断处理函数, NULL退出监听
+ * @retval None
+ */
+void rs485_set_sniff(rs485_sniff_isr_t isr);
+
+/**
+ * @brief  发送加锁, 与 rs485_tx_unlock 成对调用
+ * @note   FreeRTOS下多个任务发送时串行化 (可递归), 裸机为空操作; 只在任务中调用
+ * @param  None
+ * @retval None
+ */
+void rs485_tx_lock(void);
+
+/**
+ * @brief  发送解锁
+ * @param  None
+ * @retval None
+ */
+void rs485_tx_unlock(void);
+
+/**
+ * @brief  获取空闲的发送DMA缓冲区
+ * @note   一个缓冲区在发送时立即返回另一个; 两个都占用时等待排队的一帧开始发送
+ * @param  None
+ * @retval 缓冲区指针, 大小为 RS485_TX_BUFFER_SIZE
+ */
+uint8_t* rs485_tx_acquire(void);
+
+/**
+ * @brief  启动DMA发送 rs485_tx_acquire 返回的缓冲区
+ * @note   上一帧还在发送时排队, 由中断在其结束后接着发送, DE保持发送状态;
+ *         DE在最后一个字节移出后由中断切回接收. 主站仍在连续发送时推迟到其停止后
+ * @param  len: 发送长度
+ * @retval None
+ */
+void rs485_tx_start(uint16_t len);
+
+/**
+ * @brief  发送因主站连续发送而推迟的帧 (主循环中调用)
+ * @param  None
+ * @retval None
+ */
+void rs485_tx_poll(void);
+
+/**
+ * @brief  查询DMA发送是否进行中
+ * @param  None
+ * @retval 1: 发送中或有排队的帧, 0: 空闲
+ */
+uint8_t rs485_tx_busy(void);
+
+/**
+ * @brief  查询总线是否空闲 (未在发送且无排队的帧, 距最后接收字节已超过帧间隔)
+ * @param  None
+ * @retval 1: 空闲, 0: 忙
+ */
+uint8_t rs485_line_idle(void);
+
+/**
+ * @brief  开始处理一帧
+ * @note   广播帧处理期间抑制发送, 处理完成后调用 rs485_frame_release
+ * @param  broadcast: 1为广播帧
+ * @retval None
+ */
+void rs485_frame_claim(uint8_t broadcast);
+
+/**
+ * @brief  结束当前帧的处理
+ * @note   广播帧处理期间的发送被抑制, 处理完成后调用以恢复发送
+ * @param  None
+ * @retval None
+ */
+void rs485_frame_release(void);
+
+/**
+ * @brief  波特率相关超时处理, 在主循环中调用
+ * @param  None
+ * @retval None
+ */
+void rs485_baud_poll(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,262 @@
+/**
+ * @file watchdog.c
+ * @brief 看门狗监控模块实现 (任务报到、复位原因记录)
+ * @author Jason
+ * @date 2026-10-18
+ *
+ * 硬件看门狗 (WDT, LICK时钟) 只由SysTick中断喂: 主循环卡死时SysTick仍在运行,
+ * 检查到任务超时后先把任务ID和时间写入 .noinit 记录再停止喂狗, 复位后从记录中
+ * 读出原因. 中断被长时间关闭或卡在更高优先级中断时SysTick也停止, 此时没有记录,
+ * 复位原因仍为看门狗.
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "watchdog.h"
+#include "main.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/**
+ * @brief  复位后保留的记录
+ */
+typedef struct
+{
+    uint32_t magic;                 /*!< WATCHDOG_RECORD_MAGIC */
+    uint32_t task;                  /*!< 超时的任务, 无为 WATCHDOG_TASK_NONE */
+    uint32_t uptime_ms;
+    uint32_t age_ms;
+    uint32_t watchdog_resets;
+    uint32_t check;                 /*!< 以上各字的校验 */
+} watchdog_record_t;
+
+/* Private define ------------------------------------------------------------*/
+#define WATCHDOG_RECORD_MAGIC   0x474F4457  // "WDOG"
+
+/* Private macro -------------------------------------------------------------*/
+#define WATCHDOG_RECORD_CHECK(r) (~((r)->magic ^ (r)->task ^ (r)->uptime_ms ^ \
+                                    (r)->age_ms ^ (r)->watchdog_resets))
+
+/* Private variables ---------------------------------------------------------*/
+__IO uint32_t watchdog_ticks = 1;
+__IO uint32_t watchdog_checkin_ticks[WATCHDOG_TASK_NUM];
+
+NOINIT static watchdog_record_t watchdog_record;
+
+static uint32_t watchdog_deadline[WATCHDOG_TASK_NUM];
+static __IO uint32_t watchdog_task_mask = 0;
+static uint8_t watchdog_started = 0;
+static uint8_t watchdog_expired = 0;
+static uint16_t watchdog_countdown = WATCHDOG_CHECK_MS;
+
+static watchdog_report_t watchdog_report;
+
+/* Private function prototypes -----------------------------------------------*/
+static watchdog_reset_t watchdog_reset_cause(void);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief  读取并清除复位标志
+ * @note   任何复位都会拉低NRST, 引脚标志最后判断
+ * @param  None
+ * @retval 复位原因
+ */
+static watchdog_reset_t watchdog_reset_cause(void)
+{
+    watchdog_reset_t cause;
+
+    if(crm_flag_get(CRM_WDT_RESET_FLAG) != RESET)
+    {
+        cause = WATCHDOG_RESET_WATCHDOG;
+    }
+    else if(crm_flag_get(CRM_SW_RESET_FLAG) != RESET)
+    {
+        cause = WATCHDOG_RESET_SOFTWARE;
+    }
+    else if(crm_flag_get(CRM_POR_RESET_FLAG) != RESET)
+    {
+        cause = WATCHDOG_RESET_POWER_ON;
+    }
+    else if((crm_flag_get(CRM_WWDT_RESET_FLAG) != RESET) ||
+            (crm_flag_get(CRM_LOWPOWER_RESET_FLAG) != RESET))
+    {
+        cause = WATCHDOG_RESET_OTHER;
+    }
+    else
+    {
+        cause = WATCHDOG_RESET_PIN;
+    }
+
+    crm_flag_clear(CRM_ALL_RESET_FLAG);
+
+    return cause;
+}
+
+/**
+ * @brief  读取复位原因和上次看门狗记录, 启动硬件看门狗
+ * @note   调试器暂停内核时看门狗同时暂停
+ * @param  None
+ * @retval None
+ */
+void watchdog_init(void)
+{
+    watchdog_reset_t cause = watchdog_reset_cause();
+
+    /* 上电后记录为随机值 */
+    if((cause == WATCHDOG_RESET_POWER_ON) || (watchdog_record.magic != WATCHDOG_RECORD_MAGIC) ||
+       (watchdog_record.check != WATCHDOG_RECORD_CHECK(&watchdog_record)))
+    {
+        watchdog_record.task = WATCHDOG_TASK_NONE;
+        watchdog_record.uptime_ms = 0;
+        watchdog_record.age_ms = 0;
+        watchdog_record.watchdog_resets = 0;
+    }
+
+    if(cause == WATCHDOG_RESET_WATCHDOG)
+    {
+        watchdog_record.watchdog_resets++;
+    }
+
+    /* 超时任务只在看门狗复位时有意义 */
+    watchdog_report.reset = (uint8_t)cause;
+    watchdog_report.task = (cause == WATCHDOG_RESET_WATCHDOG) ? (uint8_t)watchdog_record.task : WATCHDOG_TASK_NONE;
+    watchdog_report.uptime_ms = watchdog_record.uptime_ms;
+    watchdog_report.age_ms = watchdog_record.age_ms;
+    watchdog_report.watchdog_resets = watchdog_record.watchdog_resets;
+
+    /* 清除本次记录, 保留复位计数 */
+    watchdog_record.magic = WATCHDOG_RECORD_MAGIC;
+    watchdog_record.task = WATCHDOG_TASK_NONE;
+    watchdog_record.uptime_ms = 0;
+    watchdog_record.age_ms = 0;
+    watchdog_record.check = WATCHDOG_RECORD_CHECK(&watchdog_record);
+
+    debug_periph_mode_set(DEBUG_WDT_PAUSE, TRUE);
+
+    wdt_register_write_enable(TRUE);
+    wdt_divider_set(WATCHDOG_WDT_DIVIDER);
+    wdt_reload_value_set(WATCHDOG_WDT_RELOAD);
+    wdt_counter_reload();
+    wdt_enable();
+
+    watchdog_started = 1;
+}
+
+/**
+ * @brief  注册受监控的任务
+ * @note   第一次报到后才开始计时, 主循环中稍后才运行的任务可以提前注册
+ * @param  task: 任务
+ * @param  deadline_ms: 两次报到之间的最长时间 (ms)
+ * @retval None
+ */
+void watchdog_register(watchdog_task_t task, uint32_t deadline_ms)
+{
+    watchdog_deadline[task] = deadline_ms;
+    watchdog_checkin_ticks[task] = 0;
+    watchdog_task_mask |= (1UL << task);
+}
+
+/**
+ * @brief  注销任务 (不再运行的任务)
+ * @param  task: 任务
+ * @retval None
+ */
+void watchdog_unregister(watchdog_task_t task)
+{
+    watchdog_task_mask &= ~(1UL << task);
+}
+
+/**
+ * @brief  1ms节拍, 由SysTick中断调用
+ * @note   每 WATCHDOG_CHECK_MS 检查一次: 全部任务按期报到才喂狗;
+ *         有任务超时则记录距上次报到最久的任务 (各任务在自己的步骤结束后报到,
+ *         卡住的任务报到最早) 并停止喂狗, 等待硬件复位
+ * @param  None
+ * @retval None
+ */
+RAMFUNC void watchdog_tick(void)
+{
+    uint32_t age;
+    uint32_t oldest_age = 0;
+    uint8_t oldest = WATCHDOG_TASK_NONE;
+    uint8_t expired = 0;
+    uint8_t i;
+
+    /* 报到时刻0表示尚未报到, 计数跳过0 */
+    if(++watchdog_ticks == 0)
+    {
+        watchdog_ticks = 1;
+    }
+
+    if(!watchdog_started || (--watchdog_countdown != 0))
+    {
+        return;
+    }
+    watchdog_countdown = WATCHDOG_CHECK_MS;
+
+    if(watchdog_expired)
+    {
+        return;
+    }
+
+    for(i = 0; i < WATCHDOG_TASK_NUM; i++)
+    {
+        if(!(watchdog_task_mask & (1UL << i)) || (watchdog_checkin_ticks[i] == 0))
+        {
+            continue;
+        }
+
+        age = watchdog_ticks - watchdog_checkin_ticks[i];
+        if(age > watchdog_deadline[i])
+        {
+            expired = 1;
+        }
+        if(age > oldest_age)
+        {
+            oldest_age = age;
+            oldest = i;
+        }
+    }
+
+    if(expired)
+    {
+        watchdog_record.task = oldest;
+        watchdog_record.uptime_ms = watchdog_ticks;
+        watchdog_record.age_ms = oldest_age;
+        watchdog_record.check = WATCHDOG_RECORD_CHECK(&watchdog_record);
+        watchdog_expired = 1;
+        return;
+    }
+
+    wdt_counter_reload();
+}
+
+/**
+ * @brief  获取上次复位的原因和看门狗记录
+ * @param  report: 输出
+ * @retval None
+ */
+void watchdog_get_report(watchdog_report_t* report)
+{
+    *report = watchdog_report;
+}
+
+/**
+ * @brief  通过RS485发送复位原因 (单帧)
+ * @note   帧格式: 命令字, 版本, 原因, 任务, 运行时间, 距报到时间, 看门狗复位次数 (u32 LE)
+ * @param  None
+ * @retval None
+ */
+void watchdog_send_report(void)
+{
+    uint8_t frame[16];
+
+    frame[0] = RS485_CMD_RESET_CAUSE;
+    frame[1] = WATCHDOG_REPORT_VERSION;
+    frame[2] = watchdog_report.reset;
+    frame[3] = watchdog_report.task;
+    rs485_put_u32(&frame[4], watchdog_report.uptime_ms);
+    rs485_put_u32(&frame[8], watchdog_report.age_ms);
+    rs485_put_u32(&frame[12], watchdog_report.watchdog_resets);
+
+    rs485_frame_send(frame, sizeof(frame));
+}
@@ -0,0 +1,139 @@
+/**
+ * @file watchdog.h
+ * @brief 看门狗监控模块头文件 (任务报到、复位原因记录)
+ * @author Jason
+ * @date 2026-10-18
+ */
+
+#ifndef __WATCHDOG_H
+#define __WATCHDOG_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "at32f403a_407.h"
+#include "memmap.h"
+
+/* Exported types ------------------------------------------------------------*/
+/**
+ * @brief  受监控的任务 (主循环各阶段)
+ */
+typedef enum
+{
+    WATCHDOG_TASK_COMMAND = 0,      /*!< RS485命令处理 */
+    WATCHDOG_TASK_BOOT,             /*!< 后台启动 (完成后注销) */
+    WATCHDOG_TASK_DEMO,             /*!< 蜂鸣器/显示板/控制引脚 */
+    WATCHDOG_TASK_CLOCK,            /*!< 时钟档位 */
+    WATCHDOG_TASK_CONFIG,           /*!< 配置存储写入 */
+    WATCHDOG_TASK_NUM
+} watchdog_task_t;
+
+/**
+ * @brief  上次复位原因
+ */
+typedef enum
+{
+    WATCHDOG_RESET_POWER_ON = 0,    /*!< 上电/掉电复位 */
+    WATCHDOG_RESET_PIN,             /*!< NRST引脚复位 */
+    WATCHDOG_RESET_SOFTWARE,        /*!< 软件复位 */
+    WATCHDOG_RESET_WATCHDOG,        /*!< 看门狗复位 */
+    WATCHDOG_RESET_OTHER            /*!< 窗口看门狗/低功耗复位 */
+} watchdog_reset_t;
+
+/**
+ * @brief  上次复位的原因和看门狗记录
+ */
+typedef struct
+{
+    uint8_t reset;                  /*!< watchdog_reset_t */
+    uint8_t task;                   /*!< 超时的任务, 中断长时间阻塞导致的复位为 WATCHDOG_TASK_NONE */
+    uint32_t uptime_ms;             /*!< 检测到超时时的运行时间 (ms) */
+    uint32_t age_ms;                /*!< 该任务距上次报到的时间 (ms) */
+    uint32_t watchdog_resets;       /*!< 上电以来看门狗复位次数 */
+} watchdog_report_t;
+
+/* Exported constants --------------------------------------------------------*/
+#define WATCHDOG_TASK_NONE          0xFF
+
+/* 复位原因帧格式版本 */
+#define WATCHDOG_REPORT_VERSION     1
+
+/* 检查各任务并喂狗的周期 (ms) */
+#define WATCHDOG_CHECK_MS           100
+
+/* 硬件看门狗超时约1s (LICK 40kHz / 64 / 625), LICK偏差下不短于 WATCHDOG_CHECK_MS 的数倍 */
+#define WATCHDOG_WDT_DIVIDER        WDT_CLK_DIV_64
+#define WATCHDOG_WDT_RELOAD         625
+
+/*
+ * 主循环任务的报到期限 (ms). 任一步骤阻塞都会推迟所有任务, 所以期限取主循环
+ * 最长的正常阻塞 (I2C每步等待最长1s, 显示刷新含多次传输) 再留余量
+ */
+#define WATCHDOG_DEADLINE_LOOP      3000
+
+/* Exported macro ------------------------------------------------------------*/
+/* 任务报到: 只写一个字, 可在主循环热路径中调用 */
+#define WATCHDOG_CHECKIN(task)      (watchdog_checkin_ticks[(task)] = watchdog_ticks)
+
+/* Exported variables --------------------------------------------------------*/
+extern __IO uint32_t watchdog_ticks;
+extern __IO uint32_t watchdog_checkin_ticks[WATCHDOG_TASK_NUM];
+
+/* Exported functions prototypes ---------------------------------------------*/
+
+/**
+ * @brief  读取复位原因和上次看门狗记录, 启动硬件看门狗
+ * @note   调试器暂停内核时看门狗同时暂停
+ * @param  None
+ * @retval None
+ */
+void watchdog_init(void);
+
+/**
+ * @brief  注册受监控的任务
+ * @note   第一次报到后才开始计时, 主循环中稍后才运行的任务可以提前注册
+ * @param  task: 任务
+ * @param  deadline_ms: 两次报到之间的最长时间 (ms)
+ * @retval None
+ */
+void watchdog_register(watchdog_task_t task, uint32_t deadline_ms);
+
+/**
+ * @brief  注销任务 (不再运行的任务)
+ * @param  task: 任务
+ * @retval None
+ */
+void watchdog_unregister(watchdog_task_t task);
+
+/**
+ * @brief  1ms节拍, 由SysTick中断调用
+ * @note   每 WATCHDOG_CHECK_MS 检查一次: 全部任务按期报到才喂狗;
+ *         有任务超时则记录距上次报到最久的任务 (各任务在自己的步骤结束后报到,
+ *         卡住的任务报到最早) 并停止喂狗, 等待硬件复位
+ * @param  None
+ * @retval None
+ */
+RAMFUNC void watchdog_tick(void);
+
+/**
+ * @brief  获取上次复位的原因和看门狗记录
+ * @param  report: 输出
+ * @retval None
+ */
+void watchdog_get_report(watchdog_report_t* report);
+
+/**
+ * @brief  通过RS485发送复位原因 (单帧)
+ * @note   帧格式: 命令字, 版本, 原因, 任务, 运行时间, 距报到时间, 看门狗复位次数 (u32 LE)
+ * @param  None
+ * @retval None
+ */
+void watchdog_send_report(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __WATCHDOG_H */